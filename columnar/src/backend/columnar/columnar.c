@@ -49,7 +49,16 @@ bool columnar_enable_vectorization = true;
 bool columnar_enable_dml = true;
 bool columnar_enable_page_cache = false;
 int columnar_page_cache_size = 200U;
+int columnar_compressed_column_cache_size = 0;
 bool columnar_index_scan = false;
+bool columnar_enable_encoding = true;
+double columnar_auto_compression_decode_weight = 0.1;
+int columnar_zstd_dictionary_size = 0;
+int columnar_zstd_compression_workers = 0;
+bool columnar_enable_late_materialization = true;
+int columnar_shared_column_cache_size = 0;
+bool columnar_enable_cache_warm_set = false;
+int columnar_cache_warm_set_interval = 300;
 
 static const struct config_enum_entry columnar_compression_options[] =
 {
@@ -61,6 +70,7 @@ static const struct config_enum_entry columnar_compression_options[] =
 #if HAVE_LIBZSTD
 	{ "zstd", COMPRESSION_ZSTD, false },
 #endif
+	{ "auto", COMPRESSION_AUTO, false },
 	{ NULL, 0, false }
 };
 
@@ -68,6 +78,8 @@ void
 columnar_init(void)
 {
 	columnar_guc_init();
+	ColumnarSharedCacheInit();
+	ColumnarWarmSetInit();
 	columnar_tableam_init();
 	columnar_planner_init();
 }
@@ -197,6 +209,65 @@ columnar_guc_init()
 							NULL,
 							NULL);
 
+	DefineCustomIntVariable("columnar.compressed_column_cache_size",
+							"Size of the compressed tier of the column cache in megabytes",
+							"When set, and the column cache is enabled, chunks are "
+							"also cached as they are stored, so that reading them "
+							"again skips the buffer manager but not decompression. "
+							"0 disables the compressed tier.",
+							&columnar_compressed_column_cache_size,
+							0,
+							0,
+							20000U,
+							PGC_USERSET,
+							GUC_UNIT_MB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("columnar.shared_column_cache_size",
+							"Size of the column cache shared by all backends",
+							"When set, and columnar is loaded with "
+							"shared_preload_libraries, the column cache is kept in "
+							"shared memory of this size, where it is used by all "
+							"backends and outlives scans. 0 keeps a cache in each "
+							"backend instead.",
+							&columnar_shared_column_cache_size,
+							0,
+							0,
+							SHARED_COLUMN_CACHE_SIZE_MAX,
+							PGC_POSTMASTER,
+							GUC_UNIT_MB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("columnar.enable_cache_warm_set",
+							 "Keeps the shared column cache warm across restarts",
+							 "A background worker records the chunks in the shared "
+							 "column cache to a file, and loads them back into the "
+							 "cache at startup.",
+							 &columnar_enable_cache_warm_set,
+							 false,
+							 PGC_POSTMASTER,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("columnar.cache_warm_set_interval",
+							"Interval between records of the shared column cache",
+							"0 only records the chunks in the cache at shutdown.",
+							&columnar_cache_warm_set_interval,
+							300,
+							0,
+							INT_MAX / 1000,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
 	DefineCustomBoolVariable("columnar.enable_columnar_index_scan",
 							 "Enables custom columnar index scan",
 							 NULL,
@@ -207,6 +278,79 @@ columnar_guc_init()
 							 NULL, 
 							 NULL, 
 							 NULL);
+
+	DefineCustomBoolVariable("columnar.enable_encoding",
+							 "Enables lightweight encodings of column chunks",
+							 "Chunks are encoded (e.g. with a dictionary) before "
+							 "compression when that makes them smaller.",
+							 &columnar_enable_encoding,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomRealVariable("columnar.auto_compression_decode_weight",
+							 "Weight of decompression time when compression is auto",
+							 "With compression set to auto every chunk is stored with "
+							 "the codec that minimizes its compressed size plus this "
+							 "many bytes per expected nanosecond of decompression.",
+							 &columnar_auto_compression_decode_weight,
+							 0.1,
+							 0.0,
+							 1000000.0,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("columnar.zstd_dictionary_size",
+							"Size of the zstd dictionaries trained for new tables",
+							"When set, the first stripe written to a zstd compressed "
+							"column without a dictionary is used to train one, and "
+							"the column's chunks are compressed with it from then on. "
+							"0 disables training.",
+							&columnar_zstd_dictionary_size,
+							0,
+							0,
+							ZSTD_DICTIONARY_SIZE_MAX,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("columnar.zstd_compression_workers",
+							"Number of threads zstd compresses large chunks with",
+							"Chunks of at least 1MB are split into jobs that this "
+							"many zstd worker threads compress in parallel. Each "
+							"chunk is compressed on its own, so columns with "
+							"narrow values need a larger chunk_group_row_limit "
+							"to reach that size. 0 compresses on the backend only.",
+							&columnar_zstd_compression_workers,
+							0,
+							0,
+							ZSTD_COMPRESSION_WORKERS_MAX,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("columnar.enable_late_materialization",
+							 "Enables late materialization of vectorized scans",
+							 "Columns that the vectorized filter doesn't read are "
+							 "only decoded for the rows that pass it, and not at all "
+							 "for chunk groups without such rows.",
+							 &columnar_enable_late_materialization,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
 }
 
 
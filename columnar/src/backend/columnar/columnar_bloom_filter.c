@@ -0,0 +1,113 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_bloom_filter.c
+ *
+ * This file contains the bloom filters that are stored with the skip nodes
+ * of columns that have bloom_filter enabled. A filter holds the hashes of the
+ * values of a single chunk, computed with the standard hash function of the
+ * column type's default hash operator class, so that chunks can be skipped
+ * for equality quals whose constant is not in the chunk.
+ *
+ * Copyright (c) Hydra, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "pg_version_compat.h"
+
+#include "common/hashfn.h"
+
+#include "columnar/columnar_bloom_filter.h"
+
+#if PG_VERSION_NUM >= PG_VERSION_16
+#include "varatt.h"
+#endif
+
+/*
+ * BloomFilterData is the on-disk representation of a filter, stored as the
+ * bloom_filter bytea of columnar.chunk.
+ */
+typedef struct BloomFilterData
+{
+	int32 vl_len_;      /* varlena header (do not touch directly!) */
+	uint32 bitCount;
+	uint64 words[FLEXIBLE_ARRAY_MEMBER];
+} BloomFilterData;
+
+static inline uint32 BloomFilterBitIndex(BloomFilterData *filter, uint32 hash,
+										 int probeIndex);
+
+
+/*
+ * CreateBloomFilter returns an empty filter sized for the given number of
+ * values.
+ */
+bytea *
+CreateBloomFilter(uint32 valueCount)
+{
+	uint64 bitCount = (uint64) valueCount * BLOOM_FILTER_BITS_PER_VALUE;
+	bitCount = Max(bitCount, BLOOM_FILTER_MIN_BITS);
+	bitCount = Min(bitCount, BLOOM_FILTER_MAX_BITS);
+
+	uint32 wordCount = (bitCount + 63) / 64;
+	Size filterSize = offsetof(BloomFilterData, words) + wordCount * sizeof(uint64);
+
+	BloomFilterData *filter = palloc0(filterSize);
+	SET_VARSIZE(filter, filterSize);
+	filter->bitCount = wordCount * 64;
+
+	return (bytea *) filter;
+}
+
+
+/*
+ * BloomFilterAddHash sets the bits of the given value hash.
+ */
+void
+BloomFilterAddHash(bytea *bloomFilter, uint32 hash)
+{
+	BloomFilterData *filter = (BloomFilterData *) bloomFilter;
+
+	for (int probeIndex = 0; probeIndex < BLOOM_FILTER_HASH_COUNT; probeIndex++)
+	{
+		uint32 bitIndex = BloomFilterBitIndex(filter, hash, probeIndex);
+		filter->words[bitIndex / 64] |= UINT64CONST(1) << (bitIndex % 64);
+	}
+}
+
+
+/*
+ * BloomFilterMightContainHash returns false if no value with the given hash
+ * was added to the filter. A true result may be a false positive.
+ */
+bool
+BloomFilterMightContainHash(bytea *bloomFilter, uint32 hash)
+{
+	BloomFilterData *filter = (BloomFilterData *) bloomFilter;
+
+	for (int probeIndex = 0; probeIndex < BLOOM_FILTER_HASH_COUNT; probeIndex++)
+	{
+		uint32 bitIndex = BloomFilterBitIndex(filter, hash, probeIndex);
+		if ((filter->words[bitIndex / 64] & (UINT64CONST(1) << (bitIndex % 64))) == 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * BloomFilterBitIndex returns the bit the given probe of a hash maps to. The
+ * probes are derived from the value hash and a remix of it by double hashing.
+ */
+static inline uint32
+BloomFilterBitIndex(BloomFilterData *filter, uint32 hash, int probeIndex)
+{
+	uint32 secondHash = murmurhash32(hash) | 1;
+
+	return (uint32) (((uint64) hash + (uint64) probeIndex * secondHash) %
+					 filter->bitCount);
+}
@@ -18,6 +18,7 @@
 #include "funcapi.h"
 #include "lib/ilist.h"
 #include "lib/stringinfo.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 #include "utils/palloc.h"
 
@@ -26,43 +27,72 @@
 
 
 /*
- * Main caching MemoryContext.
+ * Cache key.
  *
- * This MemoryContext is created at initialization, below 
- * TopMemoryContext, where all cache entries are stored.
+ * Identifies the cached data of a column of a chunk group.
  */
-static MemoryContext columnarCacheContext = NULL;
+typedef struct ColumnarCacheKey
+{
+	uint64 storageId;
+	uint64 stripeId;
+	uint64 chunkId;
+	uint32 columnId;
+	uint32 padding;     /* always zero, so that keys can be hashed as blobs */
+} ColumnarCacheKey;
 
 /*
  * Cache entry.
  *
- * An entry for caching a column.
+ * An entry for caching a column, stored in the hash table of its tier and
+ * linked into the tier's LRU list.
  */
-typedef struct ColumnarCacheEntry ColumnarCacheEntry;
-
-struct ColumnarCacheEntry
+typedef struct ColumnarCacheEntry
 {
+	ColumnarCacheKey key;
 	dlist_node list_node;
-	uint64 relId;
-	uint64 stripeId;
-	uint64 chunkId;
 	uint64 readCount;
 	uint64 length;
 	time_t creationTime;
 	time_t lastAccessTime;
 	void *store;
-	uint32 columnId;
-};
 
-/*
- * Storage for the ColumnarCacheEntry linked list.
- */
-static dlist_head *head = NULL;
+	/* number of chunk groups in use that the entry belongs to */
+	uint32 pinCount;
+} ColumnarCacheEntry;
 
 /*
- * Storage for total length allocated.
+ * Cache tier.
+ *
+ * The cache has two tiers, each with its own MemoryContext, created below
+ * TopMemoryContext on first use, where all of the tier's entries are stored.
+ * The decompressed tier keeps the decompressed value streams of chunks, and
+ * hands them out as is. It is emptied when a scan ends. The compressed tier
+ * keeps the streams of chunks as they are stored, and copies them out, so
+ * that a hit only saves reading the chunk from the buffer manager and
+ * decompression still happens. It is kept across scans for the lifetime of
+ * the backend: stripes are never rewritten in place, and storage ids are never
+ * reused, so its entries can't go stale. The entries of storage and stripes
+ * that are removed are invalidated to free their memory.
  */
-static uint64 totalAllocationLength = 0;
+typedef struct ColumnarCacheTier
+{
+	const char *name;
+	int *sizeMB;
+	MemoryContext context;
+
+	/* hash table of the entries, allocated in the tier's MemoryContext */
+	HTAB *hash;
+
+	/* LRU list of the entries, least recently used first */
+	dlist_head lruList;
+
+	/* storage for total length allocated */
+	uint64 totalAllocationLength;
+
+	/* statistics of the tier kept in the cache statistics */
+	uint64 *evictions;
+	uint64 *maximumCacheSize;
+} ColumnarCacheTier;
 
 /*
  * Cache statistics.
@@ -71,202 +101,344 @@ static uint64 totalAllocationLength = 0;
  */
 static ColumnarCacheStatistics statistics = { 0 };
 
+static ColumnarCacheTier decompressedTier = {
+	.name = "Columnar Decompression Cache",
+	.sizeMB = &columnar_page_cache_size,
+	.evictions = &statistics.evictions,
+	.maximumCacheSize = &statistics.maximumCacheSize
+};
+
+static ColumnarCacheTier compressedTier = {
+	.name = "Columnar Compressed Cache",
+	.sizeMB = &columnar_compressed_column_cache_size,
+	.evictions = &statistics.compressedEvictions,
+	.maximumCacheSize = &statistics.compressedMaximumCacheSize
+};
+
 /*
- * Housekeeping of current chunk in use - so they are not evicted.
+ * Housekeeping of current chunk in use - so they are not evicted. The
+ * entries of a chunk group in use are pinned when they are read or written,
+ * and unpinned when another chunk group of the same storage is marked in use.
+ * Only entries of the decompressed tier are pinned, as those of the compressed
+ * tier are copied out.
  */
 typedef struct ColumarCacheChunkGroupInUse
 {
-	uint64 relId;
+	uint64 storageId;
 	uint64 stripeId;
 	uint64 chunkId;
+	List *pinnedEntryList;
 } ColumarCacheChunkGroupInUse;
 
 static List * ChunkGroupsInUse = NIL;
 
+static MemoryContext ColumnarCacheTierMemoryContext(ColumnarCacheTier *tier);
+static void ColumnarResetCacheTier(ColumnarCacheTier *tier);
+static void ColumnarInitCacheKey(ColumnarCacheKey *key, uint64 storageId,
+								 uint64 stripeId, uint64 chunkId, uint32 columnId);
+static ColumnarCacheEntry * ColumnarFindInCache(ColumnarCacheTier *tier,
+												uint64 storageId, uint64 stripeId,
+												uint64 chunkId, uint32 columnId);
+static ColumnarCacheEntry * ColumnarStoreInCache(ColumnarCacheTier *tier,
+												 uint64 storageId, uint64 stripeId,
+												 uint64 chunkId, uint32 columnId,
+												 StringInfo data);
+static void ColumnarPinIfInUse(ColumnarCacheEntry *entry);
+static void ColumnarRemoveCacheEntry(ColumnarCacheTier *tier, ColumnarCacheEntry *entry);
+static void EvictCache(ColumnarCacheTier *tier, uint64 size);
+
+/*
+ * ColumnarCacheTierMemoryContext
+ *
+ * Returns the MemoryContext of a tier, initializing it as a child of
+ * TopMemoryContext if it does not exist.
+ */
+static MemoryContext
+ColumnarCacheTierMemoryContext(ColumnarCacheTier *tier)
+{
+	if (tier->context == NULL)
+	{
+		tier->context = 
+			AllocSetContextCreate(TopMemoryContext, 
+								  tier->name, 
+								  0, (uint64) (*tier->sizeMB * 1024 * 1024 * .1), 
+								  *tier->sizeMB * 1024 * 1024);
+
+		HASHCTL info;
+		memset(&info, 0, sizeof(info));
+		info.keysize = sizeof(ColumnarCacheKey);
+		info.entrysize = sizeof(ColumnarCacheEntry);
+		info.hcxt = tier->context;
+
+		tier->hash = hash_create(tier->name, 1024, &info,
+								 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+		dlist_init(&tier->lruList);
+	}
+
+	return tier->context;
+}
+
 /*
  * ColumnarCacheMemoryContext
  *
- * Returns the cache MemoryContext, initializing the cache MemoryContext
- * as a child of TopMemoryContext if it does not exist, also clears any
- * statistics gathered.
+ * Returns the MemoryContext of the decompressed tier, where the data added
+ * to the per-backend cache must be allocated.
  */
 MemoryContext
 ColumnarCacheMemoryContext(void)
 {
-	if (columnarCacheContext == NULL)
+	return ColumnarCacheTierMemoryContext(&decompressedTier);
+}
+
+/*
+ * ColumnarCompressedCacheEnabled
+ *
+ * Returns true if chunks are kept in the compressed tier.
+ */
+bool
+ColumnarCompressedCacheEnabled(void)
+{
+	return columnar_enable_page_cache && columnar_compressed_column_cache_size > 0;
+}
+
+/*
+ * ColumnarResetCacheTier
+ *
+ * Deletes the MemoryContext of a tier and sets it to NULL, thus removing
+ * all of the tier's entries.
+ */
+static void
+ColumnarResetCacheTier(ColumnarCacheTier *tier)
+{
+	if (tier->context != NULL)
 	{
-		columnarCacheContext = 
-			AllocSetContextCreate(TopMemoryContext, 
-								  "Columnar Decompression Cache", 
-								  0, (uint64) (columnar_page_cache_size * 1024 * 1024 * .1), 
-								  columnar_page_cache_size * 1024 * 1024);
-		memset(&statistics, 0, sizeof(ColumnarCacheStatistics));
-		head = NULL;
+		MemoryContextDelete(tier->context);
+		tier->context = NULL;
 	}
 
-	return columnarCacheContext;
+	tier->totalAllocationLength = 0U;
+	tier->hash = NULL;
+	dlist_init(&tier->lruList);
 }
 
 /*
 * ColumnarResetCache
 *
-* Deletes the caching memory context and sets it to NULL, thus removing the
-* cache and all of its entries.
+* Called when a scan ends. Deletes the memory context of the decompressed
+* tier, thus removing all of its entries, and clears the statistics of the
+* scan. The compressed tier is kept, unless it has been disabled.
 */
 void
 ColumnarResetCache(void)
 {
-	if (columnarCacheContext != NULL)
+	memset(&statistics, 0, sizeof(ColumnarCacheStatistics));
+
+	if (decompressedTier.context != NULL)
 	{
-		MemoryContextDelete(columnarCacheContext);
-		columnarCacheContext = NULL;
 		ChunkGroupsInUse = NIL;
 	}
 
-	totalAllocationLength = 0U;
-	head = NULL;
+	ColumnarResetCacheTier(&decompressedTier);
+
+	if (!ColumnarCompressedCacheEnabled())
+	{
+		ColumnarResetCacheTier(&compressedTier);
+	}
+}
+
+/*
+ * ColumnarInitCacheKey
+ *
+ * Fills in a cache key, including its padding.
+ */
+static void
+ColumnarInitCacheKey(ColumnarCacheKey *key, uint64 storageId, uint64 stripeId,
+					 uint64 chunkId, uint32 columnId)
+{
+	memset(key, 0, sizeof(ColumnarCacheKey));
+	key->storageId = storageId;
+	key->stripeId = stripeId;
+	key->chunkId = chunkId;
+	key->columnId = columnId;
 }
 
 /*
  * ColumnarFindInCache
  *
- * Searches the cache for an entry for a relation ID and a chunk ID.
- * If found, it increments the readCount, and returns the entry.	If
- * none are found, NULL is returned instead.
+ * Searches a tier for an entry for a storage ID and a chunk ID.
+ * If found, it increments the readCount, moves the entry to the most
+ * recently used end of the LRU list, and returns the entry. If none are
+ * found, NULL is returned instead.
  */
 static ColumnarCacheEntry *
-ColumnarFindInCache(uint64 relId, uint64 stripeId, uint64 chunkId, uint32 columnId)
+ColumnarFindInCache(ColumnarCacheTier *tier, uint64 storageId, uint64 stripeId,
+					uint64 chunkId, uint32 columnId)
 {
-	if (head == NULL)
+	if (tier->hash == NULL)
 	{
 		return NULL;
 	}
 
-	dlist_iter iter;
-	dlist_foreach(iter, head)
+	ColumnarCacheKey key;
+	ColumnarInitCacheKey(&key, storageId, stripeId, chunkId, columnId);
+
+	ColumnarCacheEntry *entry = hash_search(tier->hash, &key, HASH_FIND, NULL);
+
+	if (entry != NULL)
 	{
-		ColumnarCacheEntry *entry = dlist_container(ColumnarCacheEntry, list_node, iter.cur);
+		entry->readCount++;
+		entry->lastAccessTime = time(NULL);
+		dlist_move_tail(&tier->lruList, &entry->list_node);
+	}
 
-		if (entry->relId == relId && entry->stripeId == stripeId &&
-			entry->chunkId == chunkId && entry->columnId == columnId)
-		{
-			entry->readCount++;
+	return entry;
+}
 
-			return entry;
-		}
+/*
+ * ColumnarRemoveCacheEntry
+ *
+ * Removes an entry from a tier, and frees the memory associated with it.
+ */
+static void
+ColumnarRemoveCacheEntry(ColumnarCacheTier *tier, ColumnarCacheEntry *entry)
+{
+	StringInfo str = entry->store;
+	if (str->data)
+	{
+		pfree(str->data);
 	}
 
-	return NULL;
+	pfree(str);
+
+	tier->totalAllocationLength -= entry->length;
+	(*tier->evictions)++;
+
+	dlist_delete(&entry->list_node);
+	hash_search(tier->hash, &entry->key, HASH_REMOVE, NULL);
 }
 
 /*
  * ColumnarInvalidateCacheEntry
  *
- * Searches for a cache entry for a relation ID and a chunk ID.
+ * Searches for a cache entry for a storage ID and a chunk ID.
  * If found, removes the cache entry, and frees memory associated with
- * it. If not found, nothing is done.
+ * it. If not found, nothing is done. With the shared cache, the entry is
+ * removed from it for all backends.
  *
- * Returns boolean.
+ * Returns true if an entry was removed.
  */
 static bool
-ColumnarInvalidateCacheEntry(uint64 relId, uint64 stripeId, uint64 chunkId, uint32 columnId)
+ColumnarInvalidateCacheEntry(uint64 storageId, uint64 stripeId, uint64 chunkId, uint32 columnId)
 {
-	dlist_mutable_iter miter;
+	bool removed = false;
 
-	dlist_foreach_modify(miter, head)
+	if (ColumnarSharedCacheEnabled())
 	{
-		ColumnarCacheEntry *entry = dlist_container(ColumnarCacheEntry, list_node, miter.cur);
-
-		if (entry->relId == relId && entry->stripeId == stripeId &&
-			entry->chunkId == chunkId && entry->columnId == columnId)
+		removed = ColumnarSharedCacheRemove(storageId, stripeId, chunkId, columnId);
+		if (removed)
 		{
-			dlist_delete(miter.cur);
-
-			totalAllocationLength -= entry->length;
 			statistics.evictions++;
-
-			return true;
 		}
 	}
 
-	return true;
+	ColumnarCacheEntry *entry = ColumnarFindInCache(&decompressedTier, storageId,
+													stripeId, chunkId, columnId);
+
+	if (entry != NULL && entry->pinCount == 0)
+	{
+		ColumnarRemoveCacheEntry(&decompressedTier, entry);
+		removed = true;
+	}
+
+	entry = ColumnarFindInCache(&compressedTier, storageId, stripeId, chunkId,
+								columnId);
+
+	if (entry != NULL)
+	{
+		ColumnarRemoveCacheEntry(&compressedTier, entry);
+		removed = true;
+	}
+
+	return removed;
 }
 
+/*
+ * EvictCache
+ *
+ * Evicts least recently used entries of a tier until at least size bytes are
+ * freed, skipping entries of chunk groups in use.
+ */
 static void
-EvictCache(uint64 size)
+EvictCache(ColumnarCacheTier *tier, uint64 size)
 {
-	uint64 lastCount = 0;
-	uint64 nextLowestCount = PG_UINT64_MAX;
+	dlist_mutable_iter miter;
 
-	while (size > 0)
+	dlist_foreach_modify(miter, &tier->lruList)
 	{
-		dlist_mutable_iter miter;
+		ColumnarCacheEntry *entry = dlist_container(ColumnarCacheEntry, list_node, miter.cur);
 
-		dlist_foreach_modify(miter, head)
+		if (entry->pinCount > 0)
 		{
-			ColumnarCacheEntry *entry = dlist_container(ColumnarCacheEntry, list_node, miter.cur);
+			continue;
+		}
 
-			if (entry->readCount != lastCount && entry->readCount < nextLowestCount)
-			{
-				nextLowestCount = entry->readCount;
-			}
+		uint64 length = entry->length;
 
-			if (entry->readCount == lastCount)
-			{
-				bool skipCacheEntry = false;
-				ListCell *lc;
-				foreach(lc, ChunkGroupsInUse)
-				{
-					ColumarCacheChunkGroupInUse *chunkGroupInUse =
-						(ColumarCacheChunkGroupInUse *) lfirst(lc);
-
-					if (chunkGroupInUse->relId == entry->relId &&
-						chunkGroupInUse->stripeId == entry->stripeId &&
-						chunkGroupInUse->chunkId == entry->chunkId)
-					{
-						skipCacheEntry = true;
-						break;
-					}
-				}
+		ColumnarRemoveCacheEntry(tier, entry);
 
-				if (skipCacheEntry)
-					continue;
+		if (size <= length)
+		{
+			return;
+		}
 
-				dlist_delete(miter.cur);
+		size -= length;
+	}
+}
 
-				totalAllocationLength -= entry->length;
-				statistics.evictions++;
+/*
+ * ColumnarPinIfInUse
+ *
+ * Pins an entry of the decompressed tier if its chunk group is in use, so
+ * that it isn't evicted while the chunk group is read.
+ */
+static void
+ColumnarPinIfInUse(ColumnarCacheEntry *entry)
+{
+	ListCell *lc;
 
-				StringInfo str = entry->store;
-				if (str->data) {
-					pfree(str->data);
-				}
+	foreach(lc, ChunkGroupsInUse)
+	{
+		ColumarCacheChunkGroupInUse *chunkGroupInUse =
+			(ColumarCacheChunkGroupInUse *) lfirst(lc);
 
-				pfree(str);
+		if (chunkGroupInUse->storageId == entry->key.storageId &&
+			chunkGroupInUse->stripeId == entry->key.stripeId &&
+			chunkGroupInUse->chunkId == entry->key.chunkId &&
+			!list_member_ptr(chunkGroupInUse->pinnedEntryList, entry))
+		{
+			MemoryContext ctx = MemoryContextSwitchTo(ColumnarCacheMemoryContext());
 
-				if (size < entry->length)
-				{
-					pfree(entry);
-					return;
-				}
-				else {
-					size -= entry->length;
-					pfree(entry);
-				}
-			}
-		}
+			chunkGroupInUse->pinnedEntryList =
+				lappend(chunkGroupInUse->pinnedEntryList, entry);
+			entry->pinCount++;
 
-		lastCount = nextLowestCount;
-		nextLowestCount = PG_UINT64_MAX;
+			MemoryContextSwitchTo(ctx);
+		}
 	}
 }
 
 void
-ColumnarMarkChunkGroupInUse(uint64 relId, uint64 stripeId, uint32 chunkId)
+ColumnarMarkChunkGroupInUse(uint64 storageId, uint64 stripeId, uint32 chunkId)
 {
 	bool found = false;
 	ListCell *lc;
 
+	/* entries are copied out of the shared cache, so they can't be in use */
+	if (ColumnarSharedCacheEnabled())
+	{
+		return;
+	}
+
 	MemoryContext ctx = MemoryContextSwitchTo(ColumnarCacheMemoryContext());
 
 	foreach(lc, ChunkGroupsInUse)
@@ -274,8 +446,24 @@ ColumnarMarkChunkGroupInUse(uint64 relId, uint64 stripeId, uint32 chunkId)
 		ColumarCacheChunkGroupInUse *chunkGroupInUse =
 			(ColumarCacheChunkGroupInUse *) lfirst(lc);
 
-		if (chunkGroupInUse->relId == relId)
+		if (chunkGroupInUse->storageId == storageId)
 		{
+			if (chunkGroupInUse->stripeId != stripeId ||
+				chunkGroupInUse->chunkId != chunkId)
+			{
+				ListCell *entryCell;
+
+				/* the previous chunk group of the storage is done with */
+				foreach(entryCell, chunkGroupInUse->pinnedEntryList)
+				{
+					ColumnarCacheEntry *entry = lfirst(entryCell);
+					entry->pinCount--;
+				}
+
+				list_free(chunkGroupInUse->pinnedEntryList);
+				chunkGroupInUse->pinnedEntryList = NIL;
+			}
+
 			chunkGroupInUse->stripeId = stripeId;
 			chunkGroupInUse->chunkId = chunkId;
 			found = true;
@@ -287,9 +475,10 @@ ColumnarMarkChunkGroupInUse(uint64 relId, uint64 stripeId, uint32 chunkId)
 		ColumarCacheChunkGroupInUse *newChunkGroupInUse =
 			palloc0(sizeof(ColumarCacheChunkGroupInUse));
 
-		newChunkGroupInUse->relId = relId;
+		newChunkGroupInUse->storageId = storageId;
 		newChunkGroupInUse->stripeId = stripeId;
 		newChunkGroupInUse->chunkId = chunkId;
+		newChunkGroupInUse->pinnedEntryList = NIL;
 
 		ChunkGroupsInUse = lappend(ChunkGroupsInUse, newChunkGroupInUse);
 	}
@@ -298,29 +487,26 @@ ColumnarMarkChunkGroupInUse(uint64 relId, uint64 stripeId, uint32 chunkId)
 }
 
 /*
- * ColumnarAddCacheEntry
+ * ColumnarStoreInCache
  *
- * Adds a cache entry, or updates an existing entry.
+ * Adds an entry to a tier, or updates an existing entry, and returns it. The
+ * tier takes ownership of the data, which must have been allocated in the
+ * tier's MemoryContext. Least recently used entries are evicted if the tier
+ * grows over its size.
  */
-void
-ColumnarAddCacheEntry(uint64 relId, uint64 stripeId, uint64 chunkId, 
-					  uint32 columnId, void *data)
+static ColumnarCacheEntry *
+ColumnarStoreInCache(ColumnarCacheTier *tier, uint64 storageId, uint64 stripeId,
+					 uint64 chunkId, uint32 columnId, StringInfo data)
 {
-	if (columnar_enable_page_cache == false)
-	{
-		return;
-	}
+	MemoryContext oldContext = MemoryContextSwitchTo(ColumnarCacheTierMemoryContext(tier));
 
-	MemoryContext oldContext = MemoryContextSwitchTo(ColumnarCacheMemoryContext());
+	ColumnarCacheKey key;
+	ColumnarInitCacheKey(&key, storageId, stripeId, chunkId, columnId);
 
-	if (head == NULL)
-	{
-		head = palloc0(sizeof(dlist_head));
-	}
-
-	ColumnarCacheEntry *entry = ColumnarFindInCache(relId, stripeId, chunkId, columnId);
+	bool found = false;
+	ColumnarCacheEntry *entry = hash_search(tier->hash, &key, HASH_ENTER, &found);
 
-	if (entry != NULL)
+	if (found)
 	{
 		/* Free up any existing stored data, everything else will be overwritten. */
 		StringInfo str = entry->store;
@@ -331,62 +517,120 @@ ColumnarAddCacheEntry(uint64 relId, uint64 stripeId, uint64 chunkId,
 
 		pfree(str);
 
-		totalAllocationLength -= entry->length;
+		tier->totalAllocationLength -= entry->length;
+		dlist_move_tail(&tier->lruList, &entry->list_node);
 	}
 	else
 	{
-		entry = palloc0(sizeof(ColumnarCacheEntry));
-
-		entry->relId = relId;
-		entry->stripeId = stripeId;
-		entry->chunkId = chunkId;
-		entry->columnId = columnId;
 		entry->creationTime = entry->lastAccessTime = time(NULL);
 		entry->readCount = 0;
+		entry->pinCount = 0;
 
 		/* Add the entry into the list. */
-		dlist_push_tail(head, &(entry->list_node));
+		dlist_push_tail(&tier->lruList, &(entry->list_node));
 	}
 
-	uint64 size = ((StringInfo) data)->len;
+	uint64 size = data->len;
 
 	entry->store = data;
 	entry->length = size;
 
-	totalAllocationLength += size;
+	tier->totalAllocationLength += size;
 
-	if (totalAllocationLength >= statistics.maximumCacheSize)
+	if (tier->totalAllocationLength >= *tier->maximumCacheSize)
 	{
-		statistics.maximumCacheSize = totalAllocationLength;
+		*tier->maximumCacheSize = tier->totalAllocationLength;
 	}
 
-	/* If we are over our cache allocation, clear until we are at 90%. */
-	if (totalAllocationLength >= (columnar_page_cache_size * 1024 * 1024))
+	if (tier == &decompressedTier)
 	{
-		EvictCache((columnar_page_cache_size * 1024 * 1024 * .1) + 
-					(totalAllocationLength - (columnar_page_cache_size * 1024 * 1024)));
+		ColumnarPinIfInUse(entry);
 	}
 
-	statistics.writes++;
+	/* If we are over our cache allocation, clear until we are at 90%. */
+	uint64 tierSize = (uint64) *tier->sizeMB * 1024 * 1024;
+	if (tier->totalAllocationLength >= tierSize)
+	{
+		EvictCache(tier, (tierSize * .1) + (tier->totalAllocationLength - tierSize));
+	}
 
 	MemoryContextSwitchTo(oldContext);
+
+	return entry;
+}
+
+/*
+ * ColumnarAddCacheEntry
+ *
+ * Adds a cache entry, or updates an existing entry. The per-backend cache
+ * takes ownership of the data, which must have been allocated in the cache
+ * MemoryContext, while the shared cache stores a copy of it.
+ */
+void
+ColumnarAddCacheEntry(uint64 storageId, uint64 stripeId, uint64 chunkId, 
+					  uint32 columnId, void *data)
+{
+	if (columnar_enable_page_cache == false)
+	{
+		return;
+	}
+
+	if (ColumnarSharedCacheEnabled())
+	{
+		int evictedCount = 0;
+
+		if (ColumnarSharedCacheAdd(storageId, stripeId, chunkId, columnId, data,
+								   &evictedCount))
+		{
+			statistics.writes++;
+		}
+
+		statistics.evictions += evictedCount;
+
+		return;
+	}
+
+	ColumnarStoreInCache(&decompressedTier, storageId, stripeId, chunkId, columnId,
+						 (StringInfo) data);
+
+	statistics.writes++;
 }
 
 /*
  * ColumnarRetrieveCache
  *
- * Search for a cache entry, returning NULL if not found.	If found,
- * make a copy in the current memory context and return it.
+ * Search for a cache entry, returning NULL if not found. Entries of the
+ * per-backend cache are returned as is, and stay pinned while their chunk
+ * group is in use, while entries of the shared cache are copied into the
+ * current memory context.
  */
 void *
-ColumnarRetrieveCache(uint64 relId, uint64 stripeId, uint64 chunkId, uint32 columnId)
+ColumnarRetrieveCache(uint64 storageId, uint64 stripeId, uint64 chunkId, uint32 columnId)
 {
 	if (columnar_enable_page_cache == false)
 	{
 		return NULL;
 	}
 
-	ColumnarCacheEntry *entry = ColumnarFindInCache(relId, stripeId, chunkId, columnId);
+	if (ColumnarSharedCacheEnabled())
+	{
+		StringInfo data = ColumnarSharedCacheRetrieve(storageId, stripeId, chunkId,
+													  columnId);
+
+		if (data == NULL)
+		{
+			statistics.misses++;
+		}
+		else
+		{
+			statistics.hits++;
+		}
+
+		return data;
+	}
+
+	ColumnarCacheEntry *entry = ColumnarFindInCache(&decompressedTier, storageId,
+													stripeId, chunkId, columnId);
 
 	if (entry == NULL)
 	{
@@ -397,40 +641,159 @@ ColumnarRetrieveCache(uint64 relId, uint64 stripeId, uint64 chunkId, uint32 colu
 
 	statistics.hits++;
 
+	ColumnarPinIfInUse(entry);
+
 	void *chunkCopy = entry->store;
 
 	return chunkCopy;
 }
 
 /*
- * ColumnarCacheLength
+ * ColumnarAddCompressedCacheEntry
+ *
+ * Adds a copy of the exists and value streams of a chunk, as they are stored,
+ * to the compressed tier.
+ */
+void
+ColumnarAddCompressedCacheEntry(uint64 storageId, uint64 stripeId, uint64 chunkId,
+								uint32 columnId, StringInfo existsBuffer,
+								StringInfo valueBuffer)
+{
+	if (!ColumnarCompressedCacheEnabled())
+	{
+		return;
+	}
+
+	MemoryContext oldContext =
+		MemoryContextSwitchTo(ColumnarCacheTierMemoryContext(&compressedTier));
+
+	StringInfo data = makeStringInfo();
+	enlargeStringInfo(data, existsBuffer->len + valueBuffer->len);
+	appendBinaryStringInfo(data, existsBuffer->data, existsBuffer->len);
+	appendBinaryStringInfo(data, valueBuffer->data, valueBuffer->len);
+
+	MemoryContextSwitchTo(oldContext);
+
+	ColumnarStoreInCache(&compressedTier, storageId, stripeId, chunkId, columnId,
+						 data);
+
+	statistics.compressedWrites++;
+}
+
+/*
+ * ColumnarRetrieveCompressedCache
+ *
+ * Searches the compressed tier for the streams of a chunk, and copies them
+ * into the given buffers, whose lengths must already be set to those of the
+ * streams. Returns false if the chunk isn't cached.
+ */
+bool
+ColumnarRetrieveCompressedCache(uint64 storageId, uint64 stripeId, uint64 chunkId,
+								uint32 columnId, StringInfo existsBuffer,
+								StringInfo valueBuffer)
+{
+	if (!ColumnarCompressedCacheEnabled())
+	{
+		return false;
+	}
+
+	ColumnarCacheEntry *entry = ColumnarFindInCache(&compressedTier, storageId,
+													stripeId, chunkId, columnId);
+
+	if (entry == NULL)
+	{
+		statistics.compressedMisses++;
+
+		return false;
+	}
+
+	StringInfo data = entry->store;
+
+	if (data->len != existsBuffer->len + valueBuffer->len)
+	{
+		elog(ERROR, "unexpected length of cached chunk, expected %d bytes, got %d",
+			 existsBuffer->len + valueBuffer->len, data->len);
+	}
+
+	memcpy(existsBuffer->data, data->data, existsBuffer->len);
+	memcpy(valueBuffer->data, data->data + existsBuffer->len, valueBuffer->len);
+
+	statistics.compressedHits++;
+
+	return true;
+}
+
+/*
+ * ColumnarInvalidateCompressedEntries
  *
- * Returns how large our cache is, used for accounting.
+ * Removes the entries of a storage from the compressed tier, only those of the
+ * given stripe unless allStripes is set.
  */
-static uint64
-ColumnarCacheLength()
+static void
+ColumnarInvalidateCompressedEntries(uint64 storageId, uint64 stripeId, bool allStripes)
 {
-	uint64 count = 0;
+	dlist_mutable_iter miter;
 
-	if (head == NULL)
+	if (compressedTier.hash == NULL)
 	{
-		return 0;
+		return;
 	}
 
-	dlist_iter iter;
-	dlist_foreach(iter, head)
+	dlist_foreach_modify(miter, &compressedTier.lruList)
 	{
-		count++;
+		ColumnarCacheEntry *entry = dlist_container(ColumnarCacheEntry, list_node, miter.cur);
+
+		if (entry->key.storageId == storageId &&
+			(allStripes || entry->key.stripeId == stripeId))
+		{
+			ColumnarRemoveCacheEntry(&compressedTier, entry);
+		}
 	}
+}
 
-	return count;
+/*
+ * ColumnarInvalidateCompressedCache
+ *
+ * Removes the entries of a storage that is being removed from the compressed
+ * tier.
+ */
+void
+ColumnarInvalidateCompressedCache(uint64 storageId)
+{
+	ColumnarInvalidateCompressedEntries(storageId, 0, true);
+}
+
+/*
+ * ColumnarInvalidateCompressedCacheStripe
+ *
+ * Removes the entries of a stripe that is being removed from the compressed
+ * tier.
+ */
+void
+ColumnarInvalidateCompressedCacheStripe(uint64 storageId, uint64 stripeId)
+{
+	ColumnarInvalidateCompressedEntries(storageId, stripeId, false);
 }
 
 ColumnarCacheStatistics *
 ColumnarGetCacheStatistics(void)
 {
-	statistics.endingCacheSize = totalAllocationLength;
-	statistics.entries = ColumnarCacheLength();
+	statistics.compressedEndingCacheSize = compressedTier.totalAllocationLength;
+	statistics.compressedEntries =
+		compressedTier.hash != NULL ? hash_get_num_entries(compressedTier.hash) : 0;
+
+	if (ColumnarSharedCacheEnabled())
+	{
+		ColumnarSharedCacheUsage(&statistics.entries, &statistics.endingCacheSize);
+		statistics.maximumCacheSize = Max(statistics.maximumCacheSize,
+										  statistics.endingCacheSize);
+
+		return &statistics;
+	}
+
+	statistics.endingCacheSize = decompressedTier.totalAllocationLength;
+	statistics.entries =
+		decompressedTier.hash != NULL ? hash_get_num_entries(decompressedTier.hash) : 0;
 
 	return &statistics;
 }
@@ -454,15 +817,16 @@ PG_FUNCTION_INFO_V1(cache_evict);
 /*
  * Also used for debugging, with the same constraints that it would only
  * work in a transaction of if the clearing mechanism is explicitly disabled.
+ * Entries of the shared cache are evicted at any time.
  */
 Datum cache_evict(PG_FUNCTION_ARGS)
 {
-	uint64 relId =PG_GETARG_INT64(0);
+	uint64 storageId =PG_GETARG_INT64(0);
 	uint64 stripeId = PG_GETARG_INT64(1);
-	uint64 chunkId = PG_GETARG_INT16(2);
+	uint64 chunkId = PG_GETARG_INT64(2);
 	uint32 columnId = PG_GETARG_UINT32(3);
 
-	bool result = ColumnarInvalidateCacheEntry(relId, stripeId, chunkId, columnId);
+	bool result = ColumnarInvalidateCacheEntry(storageId, stripeId, chunkId, columnId);
 
 	PG_RETURN_BOOL(result);
 }
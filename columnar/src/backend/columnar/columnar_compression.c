@@ -19,6 +19,7 @@
 #include "common/pg_lzcompress.h"
 #include "lib/stringinfo.h"
 
+#include "columnar/columnar.h"
 #include "columnar/columnar_compression.h"
 
 #if HAVE_CITUS_LIBLZ4
@@ -26,7 +27,10 @@
 #endif
 
 #if HAVE_LIBZSTD
+#include <pthread.h>
+#include <signal.h>
 #include <zstd.h>
+#include <zdict.h>
 #endif
 
 #if PG_VERSION_NUM >= PG_VERSION_16
@@ -53,6 +57,35 @@ typedef struct ColumnarCompressHeader
 									  len) (((ColumnarCompressHeader *) (ptr))->rawsize = \
 												(len))
 
+static void ZstdDictionaryReset(void *arg);
+
+#if HAVE_LIBZSTD
+
+/* size of the jobs a buffer is split into for zstd worker threads */
+#define ZSTD_WORKERS_JOB_SIZE (512 * 1024)
+
+/*
+ * Buffers smaller than this are compressed without zstd worker threads. zstd
+ * does not split a buffer into jobs smaller than 512kB, so smaller buffers would
+ * be compressed by a single worker while the backend waits for it. Since every
+ * chunk is compressed on its own, whether workers engage depends on the chunk
+ * size: with the default chunk_group_row_limit of 10000 rows, only columns whose
+ * values average more than ~100 bytes reach it. Narrower columns need a larger
+ * chunk_group_row_limit, e.g. 131072 rows for a bigint column.
+ */
+#define ZSTD_WORKERS_MIN_INPUT_SIZE (2 * ZSTD_WORKERS_JOB_SIZE)
+
+/*
+ * Compression context used when columnar.zstd_compression_workers is set. It is
+ * kept for the lifetime of the backend, so that its worker threads are not
+ * started again for every chunk. The threads only run zstd code.
+ */
+static ZSTD_CCtx *ZstdWorkersContext = NULL;
+static bool ZstdWorkersUnsupported = false;
+
+static ZSTD_CCtx * GetZstdWorkersContext(int compressionLevel);
+#endif
+
 
 /*
  * CompressBuffer compresses the given buffer with the given compression type
@@ -103,11 +136,45 @@ CompressBuffer(StringInfo inputBuffer,
 			resetStringInfo(outputBuffer);
 			enlargeStringInfo(outputBuffer, maximumLength);
 
-			size_t compressedSize = ZSTD_compress(outputBuffer->data,
-												  outputBuffer->maxlen,
-												  inputBuffer->data,
-												  inputBuffer->len,
-												  compressionLevel);
+			ZSTD_CCtx *workersContext = NULL;
+			if (columnar_zstd_compression_workers > 0 &&
+				inputBuffer->len >= ZSTD_WORKERS_MIN_INPUT_SIZE)
+			{
+				workersContext = GetZstdWorkersContext(compressionLevel);
+			}
+
+			size_t compressedSize = 0;
+			if (workersContext != NULL)
+			{
+				/*
+				 * zstd starts its worker threads on demand. Block signals while
+				 * it runs, so that the threads inherit a mask that keeps signals
+				 * meant for this backend on the backend's own thread.
+				 */
+				sigset_t allSignals;
+				sigset_t savedSignals;
+				sigfillset(&allSignals);
+				pthread_sigmask(SIG_SETMASK, &allSignals, &savedSignals);
+
+				compressedSize = ZSTD_compress2(workersContext,
+												outputBuffer->data,
+												outputBuffer->maxlen,
+												inputBuffer->data,
+												inputBuffer->len);
+
+				pthread_sigmask(SIG_SETMASK, &savedSignals, NULL);
+
+				elog(DEBUG1, "compressed chunk with %d zstd workers",
+					 columnar_zstd_compression_workers);
+			}
+			else
+			{
+				compressedSize = ZSTD_compress(outputBuffer->data,
+											   outputBuffer->maxlen,
+											   inputBuffer->data,
+											   inputBuffer->len,
+											   compressionLevel);
+			}
 
 			if (ZSTD_isError(compressedSize))
 			{
@@ -159,6 +226,142 @@ CompressBuffer(StringInfo inputBuffer,
 }
 
 
+#if HAVE_LIBZSTD
+
+/*
+ * GetZstdWorkersContext returns the compression context that splits buffers
+ * across columnar.zstd_compression_workers threads, set up for the given level.
+ * Returns NULL when libzstd was built without multithreading support, in which
+ * case buffers are compressed on the calling thread.
+ */
+static ZSTD_CCtx *
+GetZstdWorkersContext(int compressionLevel)
+{
+	if (ZstdWorkersUnsupported)
+	{
+		return NULL;
+	}
+
+	if (ZstdWorkersContext == NULL)
+	{
+		ZstdWorkersContext = ZSTD_createCCtx();
+		if (ZstdWorkersContext == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	size_t result = ZSTD_CCtx_setParameter(ZstdWorkersContext, ZSTD_c_nbWorkers,
+										   columnar_zstd_compression_workers);
+	if (ZSTD_isError(result))
+	{
+		ereport(DEBUG1, (errmsg("zstd compression workers are not available"),
+						 errdetail("%s", ZSTD_getErrorName(result))));
+		ZstdWorkersUnsupported = true;
+		return NULL;
+	}
+
+	ZSTD_CCtx_setParameter(ZstdWorkersContext, ZSTD_c_compressionLevel,
+						   compressionLevel);
+	ZSTD_CCtx_setParameter(ZstdWorkersContext, ZSTD_c_jobSize, ZSTD_WORKERS_JOB_SIZE);
+
+	return ZstdWorkersContext;
+}
+#endif
+
+
+/* only this many bytes of a buffer are compressed to estimate a codec's ratio */
+#define COMPRESSION_SAMPLE_SIZE (64 * 1024)
+
+/*
+ * Expected decompression cost of each codec in nanoseconds per decompressed byte,
+ * roughly their single core decompression throughput. Used by ChooseCompression.
+ */
+static const double CompressionDecodeNsPerByte[COMPRESSION_COUNT] = {
+	[COMPRESSION_NONE] = 0.0,
+	[COMPRESSION_PG_LZ] = 2.0,
+	[COMPRESSION_LZ4] = 0.25,
+	[COMPRESSION_ZSTD] = 1.0,
+	[COMPRESSION_AUTO] = 0.0
+};
+
+/* a codec and level ChooseCompression tries */
+typedef struct CompressionCandidate
+{
+	CompressionType compressionType;
+	int compressionLevel;
+} CompressionCandidate;
+
+
+/*
+ * ChooseCompression returns the codec with the lowest cost for the given buffer,
+ * and sets compressionLevel and cost accordingly. The cost of a codec is the size
+ * the buffer compresses to, plus decodeCostWeight bytes for every nanosecond its
+ * decompression is expected to take. Uncompressed storage costs the buffer size.
+ *
+ * zstd is tried both at level 1 and at maxCompressionLevel. Buffers larger than
+ * COMPRESSION_SAMPLE_SIZE are only partially compressed and their compressed size
+ * extrapolated from the sample. outputBuffer is used as scratch space.
+ */
+CompressionType
+ChooseCompression(StringInfo inputBuffer, StringInfo outputBuffer,
+				  int maxCompressionLevel, double decodeCostWeight,
+				  int *compressionLevel, double *cost)
+{
+	CompressionCandidate candidates[] = {
+		{ COMPRESSION_PG_LZ, maxCompressionLevel },
+#if HAVE_CITUS_LIBLZ4
+		{ COMPRESSION_LZ4, maxCompressionLevel },
+#endif
+#if HAVE_LIBZSTD
+		{ COMPRESSION_ZSTD, 1 },
+		{ COMPRESSION_ZSTD, maxCompressionLevel },
+#endif
+	};
+
+	CompressionType bestCompressionType = COMPRESSION_NONE;
+	*compressionLevel = maxCompressionLevel;
+	*cost = inputBuffer->len;
+
+	if (inputBuffer->len == 0)
+	{
+		return bestCompressionType;
+	}
+
+	StringInfoData sampleBuffer = { 0 };
+	sampleBuffer.data = inputBuffer->data;
+	sampleBuffer.len = Min(inputBuffer->len, COMPRESSION_SAMPLE_SIZE);
+	sampleBuffer.maxlen = sampleBuffer.len;
+
+	double sampleScale = (double) inputBuffer->len / sampleBuffer.len;
+
+	for (int candidateIndex = 0; candidateIndex < (int) lengthof(candidates); candidateIndex++)
+	{
+		CompressionCandidate *candidate = &candidates[candidateIndex];
+
+		if (!CompressBuffer(&sampleBuffer, outputBuffer, candidate->compressionType,
+							candidate->compressionLevel))
+		{
+			continue;
+		}
+
+		double decodeNs = CompressionDecodeNsPerByte[candidate->compressionType] *
+						  inputBuffer->len;
+		double candidateCost = outputBuffer->len * sampleScale +
+							   decodeCostWeight * decodeNs;
+
+		if (candidateCost < *cost)
+		{
+			bestCompressionType = candidate->compressionType;
+			*compressionLevel = candidate->compressionLevel;
+			*cost = candidateCost;
+		}
+	}
+
+	return bestCompressionType;
+}
+
+
 /*
  * DecompressBuffer decompresses the given buffer with the given compression
  * type. This function returns the buffer as-is when no compression is applied.
@@ -269,3 +472,239 @@ DecompressBuffer(StringInfo buffer,
 		}
 	}
 }
+
+
+/*
+ * CreateZstdDictionary wraps a stored dictionary for use with CompressBuffer-
+ * WithZstdDictionary and DecompressBufferWithZstdDictionary. The dictionary is
+ * allocated in the current memory context, and the zstd objects built from it
+ * are released when that context is reset or deleted.
+ */
+ZstdDictionary *
+CreateZstdDictionary(int32 attrNum, bytea *dictionaryData)
+{
+	ZstdDictionary *dictionary = palloc0(sizeof(ZstdDictionary));
+	dictionary->attrNum = attrNum;
+	dictionary->dictionaryData = dictionaryData;
+
+#if HAVE_LIBZSTD
+	dictionary->dictionaryId = ZSTD_getDictID_fromDict(VARDATA_ANY(dictionaryData),
+													   VARSIZE_ANY_EXHDR(dictionaryData));
+#endif
+
+	dictionary->resetCallback.func = ZstdDictionaryReset;
+	dictionary->resetCallback.arg = dictionary;
+	MemoryContextRegisterResetCallback(CurrentMemoryContext,
+									   &dictionary->resetCallback);
+
+	return dictionary;
+}
+
+
+/*
+ * ZstdDictionaryReset frees the zstd objects of a dictionary, which zstd
+ * allocates outside of postgres memory contexts.
+ */
+static void
+ZstdDictionaryReset(void *arg)
+{
+#if HAVE_LIBZSTD
+	ZstdDictionary *dictionary = (ZstdDictionary *) arg;
+
+	ZSTD_freeCDict(dictionary->compressionDictionary);
+	ZSTD_freeCCtx(dictionary->compressionContext);
+	ZSTD_freeDDict(dictionary->decompressionDictionary);
+	ZSTD_freeDCtx(dictionary->decompressionContext);
+
+	dictionary->compressionDictionary = NULL;
+	dictionary->compressionContext = NULL;
+	dictionary->decompressionDictionary = NULL;
+	dictionary->decompressionContext = NULL;
+#endif
+}
+
+
+/*
+ * TrainZstdDictionary trains a zstd dictionary of at most dictionarySize bytes on
+ * the given sample buffers. Returns NULL when zstd is not available or when the
+ * samples are not enough to train a dictionary.
+ */
+bytea *
+TrainZstdDictionary(List *sampleList, int dictionarySize)
+{
+#if HAVE_LIBZSTD
+	size_t *sampleSizeArray = palloc0(list_length(sampleList) * sizeof(size_t));
+	unsigned sampleCount = 0;
+	StringInfo sampleBuffer = makeStringInfo();
+
+	ListCell *sampleCell = NULL;
+	foreach(sampleCell, sampleList)
+	{
+		StringInfo sample = (StringInfo) lfirst(sampleCell);
+		if (sample->len == 0)
+		{
+			continue;
+		}
+
+		appendBinaryStringInfo(sampleBuffer, sample->data, sample->len);
+		sampleSizeArray[sampleCount++] = sample->len;
+	}
+
+	if (sampleCount == 0)
+	{
+		return NULL;
+	}
+
+	bytea *dictionaryData = palloc(VARHDRSZ + dictionarySize);
+	size_t dictionaryLength = ZDICT_trainFromBuffer(VARDATA(dictionaryData),
+													dictionarySize,
+													sampleBuffer->data,
+													sampleSizeArray, sampleCount);
+	if (ZDICT_isError(dictionaryLength))
+	{
+		elog(DEBUG1, "zstd dictionary training failed: %s",
+			 ZDICT_getErrorName(dictionaryLength));
+		return NULL;
+	}
+
+	SET_VARSIZE(dictionaryData, VARHDRSZ + dictionaryLength);
+
+	return dictionaryData;
+#else
+	return NULL;
+#endif
+}
+
+
+/*
+ * ZstdFrameDictionaryId returns the id of the dictionary the given zstd frame was
+ * compressed with, or 0 when it was compressed without one.
+ */
+uint32
+ZstdFrameDictionaryId(StringInfo buffer)
+{
+#if HAVE_LIBZSTD
+	return ZSTD_getDictID_fromFrame(buffer->data, buffer->len);
+#else
+	return 0;
+#endif
+}
+
+
+/*
+ * CompressBufferWithZstdDictionary is CompressBuffer for zstd, using the given
+ * dictionary.
+ */
+bool
+CompressBufferWithZstdDictionary(StringInfo inputBuffer, StringInfo outputBuffer,
+								 int compressionLevel, ZstdDictionary *dictionary)
+{
+#if HAVE_LIBZSTD
+	if (dictionary->compressionDictionary == NULL ||
+		dictionary->compressionLevel != compressionLevel)
+	{
+		ZSTD_freeCDict(dictionary->compressionDictionary);
+		dictionary->compressionDictionary =
+			ZSTD_createCDict(VARDATA_ANY(dictionary->dictionaryData),
+							 VARSIZE_ANY_EXHDR(dictionary->dictionaryData),
+							 compressionLevel);
+		dictionary->compressionLevel = compressionLevel;
+	}
+
+	if (dictionary->compressionContext == NULL)
+	{
+		dictionary->compressionContext = ZSTD_createCCtx();
+	}
+
+	if (dictionary->compressionDictionary == NULL ||
+		dictionary->compressionContext == NULL)
+	{
+		ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+						errmsg("out of memory"),
+						errdetail("Failed to set up zstd dictionary compression.")));
+	}
+
+	int maximumLength = ZSTD_compressBound(inputBuffer->len);
+
+	resetStringInfo(outputBuffer);
+	enlargeStringInfo(outputBuffer, maximumLength);
+
+	size_t compressedSize =
+		ZSTD_compress_usingCDict(dictionary->compressionContext,
+								 outputBuffer->data, outputBuffer->maxlen,
+								 inputBuffer->data, inputBuffer->len,
+								 dictionary->compressionDictionary);
+
+	if (ZSTD_isError(compressedSize))
+	{
+		ereport(WARNING, (errmsg("zstd compression failed"),
+						  (errdetail("%s", ZSTD_getErrorName(compressedSize)))));
+		return false;
+	}
+
+	outputBuffer->len = compressedSize;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+/*
+ * DecompressBufferWithZstdDictionary decompresses a zstd buffer that was
+ * compressed with the given dictionary.
+ */
+StringInfo
+DecompressBufferWithZstdDictionary(StringInfo buffer, uint64 decompressedSize,
+								   ZstdDictionary *dictionary)
+{
+#if HAVE_LIBZSTD
+	if (dictionary->decompressionDictionary == NULL)
+	{
+		dictionary->decompressionDictionary =
+			ZSTD_createDDict(VARDATA_ANY(dictionary->dictionaryData),
+							 VARSIZE_ANY_EXHDR(dictionary->dictionaryData));
+	}
+
+	if (dictionary->decompressionContext == NULL)
+	{
+		dictionary->decompressionContext = ZSTD_createDCtx();
+	}
+
+	if (dictionary->decompressionDictionary == NULL ||
+		dictionary->decompressionContext == NULL)
+	{
+		ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+						errmsg("out of memory"),
+						errdetail("Failed to set up zstd dictionary decompression.")));
+	}
+
+	StringInfo decompressedBuffer = makeStringInfo();
+	enlargeStringInfo(decompressedBuffer, decompressedSize);
+
+	size_t zstdDecompressSize =
+		ZSTD_decompress_usingDDict(dictionary->decompressionContext,
+								   decompressedBuffer->data, decompressedSize,
+								   buffer->data, buffer->len,
+								   dictionary->decompressionDictionary);
+	if (ZSTD_isError(zstdDecompressSize))
+	{
+		ereport(ERROR, (errmsg("zstd decompression failed"),
+						(errdetail("%s", ZSTD_getErrorName(zstdDecompressSize)))));
+	}
+
+	if (zstdDecompressSize != decompressedSize)
+	{
+		ereport(ERROR, (errmsg("unexpected decompressed size"),
+						errdetail("Expected %ld, received %ld", decompressedSize,
+								  zstdDecompressSize)));
+	}
+
+	decompressedBuffer->len = decompressedSize;
+
+	return decompressedBuffer;
+#else
+	ereport(ERROR, (errmsg("cannot decompress the buffer"),
+					errdetail("zstd support is not compiled in.")));
+#endif
+}
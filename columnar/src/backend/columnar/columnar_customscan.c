@@ -92,6 +92,8 @@ typedef struct ColumnarScanState
 		List *vectorizedQualList;
 		List *constructedVectorizedQualList;
 		List *attrNeededList;
+		/* attributes read by the vectorized quals, if others are read late */
+		Bitmapset *attrFilter;
 	} vectorization;
 
 	/* Scan snapshot*/
@@ -730,6 +732,27 @@ CheckVarStats(PlannerInfo *root, Var *var, Oid sortop, float4 *absVarCorrelation
 }
 
 
+/*
+ * ColumnHasBloomFilter returns true if bloom_filter is enabled for the given
+ * column of a columnar table.
+ */
+static bool
+ColumnHasBloomFilter(Oid relationId, AttrNumber attrNum)
+{
+	ListCell *columnOptionsCell = NULL;
+	foreach(columnOptionsCell, ReadColumnarColumnOptions(relationId))
+	{
+		ColumnarColumnOptions *columnOptions = lfirst(columnOptionsCell);
+		if (columnOptions->attrNum == attrNum)
+		{
+			return columnOptions->bloomFilter;
+		}
+	}
+
+	return false;
+}
+
+
 /*
  * ExprReferencesRelid returns true if any of the Expr's Vars refer to the
  * given relid; false otherwise.
@@ -883,17 +906,35 @@ ExtractPushdownClause(PlannerInfo *root, RelOptInfo *rel, Node *node)
 		}
 	}
 
-	if (!IsA(node, OpExpr) || list_length(((OpExpr *) node)->args) != 2)
+	/*
+	 * "Var = ANY(Expr)" is pushed down as well, min/max filtering handles it
+	 * as an OR of equalities and bloom filters probe each array element.
+	 */
+	Oid opno = InvalidOid;
+	List *opArgs = NIL;
+	bool isArrayOp = false;
+
+	if (IsA(node, OpExpr) && list_length(((OpExpr *) node)->args) == 2)
+	{
+		opno = ((OpExpr *) node)->opno;
+		opArgs = ((OpExpr *) node)->args;
+	}
+	else if (IsA(node, ScalarArrayOpExpr) && ((ScalarArrayOpExpr *) node)->useOr)
+	{
+		opno = ((ScalarArrayOpExpr *) node)->opno;
+		opArgs = ((ScalarArrayOpExpr *) node)->args;
+		isArrayOp = true;
+	}
+	else
 	{
 		ereport(ColumnarPlannerDebugLevel,
 				(errmsg("columnar planner: cannot push down clause: "
-						"must be binary operator expression")));
+						"must be binary operator expression or ANY over an array")));
 		return NULL;
 	}
 
-	OpExpr *opExpr = castNode(OpExpr, node);
-	Expr *lhs = list_nth(opExpr->args, 0);
-	Expr *rhs = list_nth(opExpr->args, 1);
+	Expr *lhs = list_nth(opArgs, 0);
+	Expr *rhs = list_nth(opArgs, 1);
 
 	Var *varSide;
 	Expr *exprSide;
@@ -904,7 +945,7 @@ ExtractPushdownClause(PlannerInfo *root, RelOptInfo *rel, Node *node)
 		varSide = castNode(Var, lhs);
 		exprSide = rhs;
 	}
-	else if (IsA(rhs, Var) && ((Var *) rhs)->varno == rel->relid &&
+	else if (!isArrayOp && IsA(rhs, Var) && ((Var *) rhs)->varno == rel->relid &&
 			 !ExprReferencesRelid((Expr *) lhs, rel->relid))
 	{
 		varSide = castNode(Var, rhs);
@@ -952,15 +993,26 @@ ExtractPushdownClause(PlannerInfo *root, RelOptInfo *rel, Node *node)
 		return NULL;
 	}
 
-	if (!op_in_opfamily(opExpr->opno, varOpFamily))
+	if (!op_in_opfamily(opno, varOpFamily))
 	{
 		ereport(ColumnarPlannerDebugLevel,
 				(errmsg("columnar planner: cannot push down clause: "
 						"operator %d not a member of opfamily %d",
-						opExpr->opno, varOpFamily)));
+						opno, varOpFamily)));
 		return NULL;
 	}
 
+	/*
+	 * Bloom filters don't depend on the order of the data, so equality quals
+	 * on columns that have them are useful regardless of the correlation.
+	 */
+	if (get_op_opfamily_strategy(opno, varOpFamily) == BTEqualStrategyNumber &&
+		ColumnHasBloomFilter(planner_rt_fetch(varSide->varno, root)->relid,
+							 varSide->varattno))
+	{
+		return (Expr *) node;
+	}
+
 	Oid sortop = get_opfamily_member(varOpFamily, varOpcInType,
 									 varOpcInType, BTLessStrategyNumber);
 	Assert(OidIsValid(sortop));
@@ -1978,6 +2030,30 @@ ColumnarScan_BeginCustomScan(CustomScanState *cscanstate, EState *estate, int ef
 			lappend_int(columnarScanState->vectorization.attrNeededList, bmsMember);
 	}
 
+	/*
+	 * With late materialization vectors are read with the columns of the
+	 * vectorized quals only, and the other columns are filled in for the rows
+	 * that pass them.
+	 */
+	if (columnarScanState->vectorization.vectorizationEnabled &&
+		columnarScanState->vectorization.vectorizedQualList != NIL &&
+		columnar_enable_late_materialization)
+	{
+		List *filterVarList =
+			pull_var_clause((Node *) columnarScanState->vectorization.vectorizedQualList,
+							0);
+
+		ListCell *filterVarCell;
+		foreach(filterVarCell, filterVarList)
+		{
+			Var *filterVar = lfirst(filterVarCell);
+
+			columnarScanState->vectorization.attrFilter =
+				bms_add_member(columnarScanState->vectorization.attrFilter,
+							   filterVar->varattno - 1);
+		}
+	}
+
 	/*
 	 * If we have pending changes that need to be flushed (row_mask after update/delete)
 	 * or new stripe we need to to them here because sequential columnar scan 
@@ -2294,6 +2370,9 @@ CustomExecScan(ColumnarScanState *columnarScanState,
 										AND_EXPR, econtext);
 
 				memcpy(vectorSlot->keep, resultQual, COLUMNAR_VECTOR_COLUMN_SIZE);
+
+				ColumnarScanMaterializeVector((ColumnarScanDesc) node->ss_currentScanDesc,
+											  slot);
 			}
 			/*
 			 * No qual, no vectorized qual, no projection but we need to return vector
@@ -2431,7 +2510,8 @@ ColumnarScanNext(ColumnarScanState *columnarScanState)
 											   columnarScanState->attrNeeded,
 											   columnarScanState->qual,
 											   columnarScanState->parallelColumnarScan,
-											   vectorizationEnabled);
+											   vectorizationEnabled,
+											   columnarScanState->vectorization.attrFilter);
 
 		node->ss.ss_currentScanDesc = scandesc;
 	}
@@ -2448,6 +2528,7 @@ ColumnarScanNext(ColumnarScanState *columnarScanState)
 			VectorColumn *column = (VectorColumn *) vectorSlot->tts.tts_values[attrIndex];
 			memset(column->isnull, true, COLUMNAR_VECTOR_COLUMN_SIZE);
 			column->dimension = 0;
+			column->hasRuns = false;
 		}
 		vectorSlot->dimension = 0;
 	}
@@ -2643,6 +2724,51 @@ ColumnarScan_ExplainCustomScan(CustomScanState *node, List *ancestors,
 			statistics->entries,
 			es
 		);
+
+		if (ColumnarCompressedCacheEnabled())
+		{
+			ExplainPropertyUInteger(
+				"Compressed Cache Hits",
+				NULL,
+				statistics->compressedHits,
+				es);
+
+			ExplainPropertyUInteger(
+				"Compressed Cache Misses",
+				NULL,
+				statistics->compressedMisses,
+				es);
+
+			ExplainPropertyUInteger(
+				"Compressed Cache Evictions",
+				NULL,
+				statistics->compressedEvictions,
+				es);
+
+			ExplainPropertyUInteger(
+				"Compressed Cache Writes",
+				NULL,
+				statistics->compressedWrites,
+				es);
+
+			ExplainPropertyUInteger(
+				"Compressed Cache Maximum Size",
+				NULL,
+				statistics->compressedMaximumCacheSize,
+				es);
+
+			ExplainPropertyUInteger(
+				"Compressed Cache Ending Size",
+				NULL,
+				statistics->compressedEndingCacheSize,
+				es);
+
+			ExplainPropertyUInteger(
+				"Total Compressed Cache Entries",
+				NULL,
+				statistics->compressedEntries,
+				es);
+		}
 	}
 }
 
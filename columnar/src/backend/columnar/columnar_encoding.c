@@ -0,0 +1,1839 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_encoding.c
+ *
+ * This file contains lightweight encodings that are applied to a chunk's
+ * serialized value stream before block compression. Encoded chunks are
+ * decoded straight into the reader's value arrays.
+ *
+ * Copyright (c) Hydra, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "pg_version_compat.h"
+
+#include "access/tupmacs.h"
+#include "catalog/pg_type.h"
+#include "common/hashfn.h"
+#include "port/pg_bitutils.h"
+
+#include "columnar/columnar.h"
+#include "columnar/columnar_encoding.h"
+
+#if PG_VERSION_NUM >= PG_VERSION_16
+#include "varatt.h"
+#endif
+
+/*
+ * A dictionary encoded chunk starts with a DictionaryEncodingHeader, followed
+ * by the distinct values serialized the same way as a plain chunk, followed by
+ * one 1- or 2-byte code per non-null value. Both the entries and the codes
+ * start at MAXALIGN'd offsets so that values can be fetched in place.
+ */
+typedef struct DictionaryEncodingHeader
+{
+	uint32 entryCount;
+	uint32 entriesLength;
+	uint32 codeWidth;
+	uint32 valueCount;
+} DictionaryEncodingHeader;
+
+#define DICTIONARY_HEADER_SIZE MAXALIGN(sizeof(DictionaryEncodingHeader))
+#define DICTIONARY_MAX_ENTRIES (PG_UINT16_MAX + 1)
+
+/*
+ * A run-length encoded chunk starts with a RunLengthEncodingHeader, followed
+ * by one serialized value per run, followed by the uint32 length of each run
+ * (counted in non-null values) at a MAXALIGN'd offset.
+ */
+typedef struct RunLengthEncodingHeader
+{
+	uint32 runCount;
+	uint32 runValuesLength;
+	uint32 valueCount;
+} RunLengthEncodingHeader;
+
+#define RLE_HEADER_SIZE MAXALIGN(sizeof(RunLengthEncodingHeader))
+
+/* RLE is only picked when values repeat at least this many times on average */
+#define RLE_MIN_AVERAGE_RUN_LENGTH 16
+
+/*
+ * Frame-of-reference and delta encoded chunks start with a BitPackingHeader,
+ * followed by one bitWidth-bit offset per non-null value packed into uint64
+ * words. With ENCODING_FOR, each value is base plus its offset. With
+ * ENCODING_DELTA, base is the first value and each following value is the
+ * previous one plus minDelta plus its offset, so a series with a constant
+ * stride packs into zero bits per value.
+ */
+typedef struct BitPackingHeader
+{
+	uint32 valueCount;
+	uint32 bitWidth;
+	int64 base;
+	int64 minDelta;
+} BitPackingHeader;
+
+#define BITPACKING_HEADER_SIZE MAXALIGN(sizeof(BitPackingHeader))
+
+/*
+ * A float XOR encoded chunk starts with a FloatXorHeader, followed by a bit
+ * stream in uint64 words. Following the Gorilla scheme, the first value is
+ * stored in full and every other value as the XOR with its predecessor: a
+ * single 0 bit if both are equal, otherwise 1 followed by either 0 and the
+ * meaningful bits within the previous leading/trailing zero window, or 1, the
+ * 6-bit leading zero count, the 6-bit meaningful length minus one and the
+ * meaningful bits. float4 values are handled in the upper half of a 64-bit
+ * word so that both widths share the same stream format.
+ */
+typedef struct FloatXorHeader
+{
+	uint32 valueCount;
+	uint32 bitCount;
+} FloatXorHeader;
+
+#define FLOAT_XOR_HEADER_SIZE MAXALIGN(sizeof(FloatXorHeader))
+
+/* longest encoding of a single value: control bits, window and 64 bits */
+#define FLOAT_XOR_MAX_VALUE_BITS (2 + 6 + 6 + 64)
+
+/*
+ * An FSST encoded chunk starts with an FsstEncodingHeader, followed by a table
+ * of up to 255 symbols of 1 to 8 bytes, the offset of each value's codes, and
+ * the codes themselves. Each serialized value (including its varlena header
+ * and alignment padding) is replaced by a sequence of one-byte symbol codes,
+ * where FSST_ESCAPE is followed by a literal byte. Since every value has its
+ * own codes, any value can be decoded without decoding the rest of the chunk.
+ */
+typedef struct FsstEncodingHeader
+{
+	uint32 valueCount;
+	uint32 symbolCount;
+	uint32 codesLength;
+	uint32 decodedLength;
+} FsstEncodingHeader;
+
+#define FSST_HEADER_SIZE MAXALIGN(sizeof(FsstEncodingHeader))
+#define FSST_MAX_SYMBOL_LENGTH 8
+#define FSST_MAX_SYMBOLS 255
+#define FSST_ESCAPE 255
+
+/* the symbol table is trained on this many bytes sampled across the chunk */
+#define FSST_SAMPLE_SIZE 16384
+#define FSST_TRAINING_ROUNDS 5
+
+typedef struct FsstSymbol
+{
+	char bytes[FSST_MAX_SYMBOL_LENGTH];
+} FsstSymbol;
+
+/*
+ * In-memory symbol table. Symbols are ordered by their first byte and then by
+ * decreasing length, so the first match within a bucket is the longest one.
+ */
+typedef struct FsstSymbolTable
+{
+	uint32 symbolCount;
+	FsstSymbol symbols[FSST_MAX_SYMBOLS];
+	uint8 lengths[FSST_MAX_SYMBOLS];
+	uint16 bucketStart[PG_UINT8_MAX + 2];
+} FsstSymbolTable;
+
+/* symbol candidate counted while training a symbol table */
+typedef struct FsstCandidate
+{
+	FsstSymbol symbol;
+	uint8 length;
+	uint32 count;
+} FsstCandidate;
+
+/* distinct value seen while building a dictionary */
+typedef struct DictionaryEntry
+{
+	uint32 offset;
+	uint32 length;
+	uint32 hash;
+} DictionaryEntry;
+
+static bool DictionaryEncode(StringInfo valueBuffer, uint32 valueCount,
+							 Form_pg_attribute attributeForm,
+							 StringInfo encodedBuffer);
+static void WriteDictionaryEncoding(StringInfo valueBuffer, DictionaryEntry *entries,
+									uint32 entryCount, uint32 entriesLength,
+									uint16 *codes, uint32 valueCount, uint32 codeWidth,
+									StringInfo encodedBuffer);
+static void DictionaryDecode(StringInfo encodedBuffer, bool *existsArray,
+							 uint32 rowCount, Form_pg_attribute attributeForm,
+							 Datum *valueArray);
+static bool ConstantEncode(StringInfo valueBuffer, uint32 valueCount,
+						   Form_pg_attribute attributeForm, StringInfo encodedBuffer);
+static void ConstantDecode(StringInfo encodedBuffer, bool *existsArray,
+						   uint32 rowCount, Form_pg_attribute attributeForm,
+						   Datum *valueArray, bool *runStartArray);
+static bool RunLengthEncode(StringInfo valueBuffer, uint32 valueCount,
+							Form_pg_attribute attributeForm,
+							StringInfo encodedBuffer);
+static void RunLengthDecode(StringInfo encodedBuffer, bool *existsArray,
+							uint32 rowCount, Form_pg_attribute attributeForm,
+							Datum *valueArray, bool *runStartArray);
+static bool IntegerEncode(StringInfo valueBuffer, uint32 valueCount,
+						  Form_pg_attribute attributeForm, StringInfo encodedBuffer,
+						  EncodingType *encodingType);
+static void WriteBitPackedEncoding(int64 *values, uint32 valueCount, int64 base,
+								   int64 minDelta, bool delta, uint32 bitWidth,
+								   StringInfo encodedBuffer);
+static void IntegerDecode(StringInfo encodedBuffer, EncodingType encodingType,
+						  bool *existsArray, uint32 rowCount,
+						  Form_pg_attribute attributeForm, Datum *valueArray);
+static bool IsIntegerEncodable(Form_pg_attribute attributeForm);
+static bool FloatXorEncode(StringInfo valueBuffer, uint32 valueCount,
+						   Form_pg_attribute attributeForm, StringInfo encodedBuffer);
+static void FloatXorDecode(StringInfo encodedBuffer, bool *existsArray,
+						   uint32 rowCount, Form_pg_attribute attributeForm,
+						   Datum *valueArray);
+static bool IsFloatEncodable(Form_pg_attribute attributeForm);
+static bool FsstEncode(StringInfo valueBuffer, uint32 valueCount,
+					   Form_pg_attribute attributeForm, StringInfo encodedBuffer);
+static void FsstTrain(StringInfo valueBuffer, uint32 *valueOffsets, uint32 valueCount,
+					  FsstSymbolTable *table);
+static void FsstCountCandidate(FsstCandidate *candidates, uint32 slotCount,
+							   const char *bytes, uint32 length);
+static int FsstCandidateGainCompare(const void *left, const void *right);
+static int FsstCandidateOrderCompare(const void *left, const void *right);
+static void FsstBuildTable(FsstCandidate *candidates, uint32 candidateCount,
+						   FsstSymbolTable *table);
+static inline int FsstFindSymbol(FsstSymbolTable *table, const char *data,
+								 uint32 remaining);
+static StringInfo FsstDecode(StringInfo encodedBuffer, bool *existsArray,
+							 uint32 rowCount, Form_pg_attribute attributeForm,
+							 Datum *valueArray);
+static uint32 FsstDecodeValue(StringInfo encodedBuffer, uint32 valueIndex,
+							  char *output);
+static inline uint64 ReadFloatXorBits(uint64 *words, uint64 *bitPosition,
+									  uint64 bitCount, uint32 bitWidth);
+static inline uint32 BitWidth(uint64 range);
+static inline void WritePackedBits(uint64 *words, uint64 bitPosition, uint32 bitWidth,
+								   uint64 value);
+static inline uint64 ReadPackedBits(uint64 *words, uint64 bitPosition, uint32 bitWidth);
+static inline uint32 NextValueOffset(StringInfo valueBuffer, uint32 currentOffset,
+									 Form_pg_attribute attributeForm);
+
+
+/*
+ * EncodeChunkValues tries to encode the given plain value stream, which holds
+ * valueCount serialized non-null values of the given attribute. If an encoding
+ * that is smaller than the plain stream is found, encodedBuffer is filled and
+ * the encoding type is returned. Otherwise ENCODING_NONE is returned and
+ * encodedBuffer should not be used.
+ */
+EncodingType
+EncodeChunkValues(StringInfo valueBuffer, uint32 valueCount,
+				  Form_pg_attribute attributeForm, StringInfo encodedBuffer)
+{
+	if (!columnar_enable_encoding || attributeForm->attisdropped ||
+		valueCount < ENCODING_MIN_VALUE_COUNT)
+	{
+		return ENCODING_NONE;
+	}
+
+	if (ConstantEncode(valueBuffer, valueCount, attributeForm, encodedBuffer))
+	{
+		return ENCODING_CONSTANT;
+	}
+
+	if (RunLengthEncode(valueBuffer, valueCount, attributeForm, encodedBuffer))
+	{
+		return ENCODING_RLE;
+	}
+
+	EncodingType integerEncodingType = ENCODING_NONE;
+	if (IsIntegerEncodable(attributeForm) &&
+		IntegerEncode(valueBuffer, valueCount, attributeForm, encodedBuffer,
+					  &integerEncodingType))
+	{
+		return integerEncodingType;
+	}
+
+	if (IsFloatEncodable(attributeForm) &&
+		FloatXorEncode(valueBuffer, valueCount, attributeForm, encodedBuffer))
+	{
+		return ENCODING_FLOAT_XOR;
+	}
+
+	if (!attributeForm->attbyval &&
+		DictionaryEncode(valueBuffer, valueCount, attributeForm, encodedBuffer))
+	{
+		return ENCODING_DICTIONARY;
+	}
+
+	if (attributeForm->attlen == -1 &&
+		FsstEncode(valueBuffer, valueCount, attributeForm, encodedBuffer))
+	{
+		return ENCODING_FSST;
+	}
+
+	return ENCODING_NONE;
+}
+
+
+/*
+ * DecodeChunkValues decodes the given encoded value stream into valueArray.
+ * Only the rows marked as existing in existsArray are filled. By-reference
+ * values point into the returned buffer, which is either encodedBuffer or a
+ * newly allocated buffer, so it must outlive valueArray.
+ *
+ * For run-length encoded and constant chunks, runStartArray (if not NULL) is set
+ * to true for each row that starts a run of identical values or nullness.
+ */
+StringInfo
+DecodeChunkValues(StringInfo encodedBuffer, EncodingType encodingType,
+				  bool *existsArray, uint32 rowCount,
+				  Form_pg_attribute attributeForm, Datum *valueArray,
+				  bool *runStartArray)
+{
+	switch (encodingType)
+	{
+		case ENCODING_DICTIONARY:
+		{
+			DictionaryDecode(encodedBuffer, existsArray, rowCount, attributeForm,
+							 valueArray);
+			break;
+		}
+
+		case ENCODING_RLE:
+		{
+			RunLengthDecode(encodedBuffer, existsArray, rowCount, attributeForm,
+							valueArray, runStartArray);
+			break;
+		}
+
+		case ENCODING_CONSTANT:
+		{
+			ConstantDecode(encodedBuffer, existsArray, rowCount, attributeForm,
+						   valueArray, runStartArray);
+			break;
+		}
+
+		case ENCODING_FOR:
+		case ENCODING_DELTA:
+		{
+			IntegerDecode(encodedBuffer, encodingType, existsArray, rowCount,
+						  attributeForm, valueArray);
+			break;
+		}
+
+		case ENCODING_FLOAT_XOR:
+		{
+			FloatXorDecode(encodedBuffer, existsArray, rowCount, attributeForm,
+						   valueArray);
+			break;
+		}
+
+		case ENCODING_FSST:
+		{
+			return FsstDecode(encodedBuffer, existsArray, rowCount, attributeForm,
+							  valueArray);
+		}
+
+		default:
+		{
+			ereport(ERROR, (errmsg("unexpected encoding type: %d", encodingType)));
+		}
+	}
+
+	return encodedBuffer;
+}
+
+
+/*
+ * EncodingSupportsRandomAccess returns true if single values of chunks with
+ * the given encoding can be decoded with DecodeChunkValue.
+ */
+bool
+EncodingSupportsRandomAccess(EncodingType encodingType)
+{
+	return encodingType == ENCODING_FSST;
+}
+
+
+/*
+ * DecodeChunkValue decodes the valueIndex'th non-null value of the given
+ * encoded value stream into memory allocated in the current memory context.
+ */
+Datum
+DecodeChunkValue(StringInfo encodedBuffer, EncodingType encodingType,
+				 uint32 valueIndex)
+{
+	if (encodingType != ENCODING_FSST)
+	{
+		ereport(ERROR, (errmsg("unexpected encoding type for random access: %d",
+							   encodingType)));
+	}
+
+	uint32 valueLength = FsstDecodeValue(encodedBuffer, valueIndex, NULL);
+	char *value = palloc(Max(valueLength, 1));
+	FsstDecodeValue(encodedBuffer, valueIndex, value);
+
+	return PointerGetDatum(value);
+}
+
+
+/*
+ * DictionaryEncode builds a dictionary of the distinct values in the given
+ * plain value stream. Values are compared by their serialized bytes, which
+ * is exact since SerializeSingleDatum zeroes alignment padding. Building is
+ * abandoned as soon as the dictionary grows beyond half of the value count,
+ * or when the encoded stream wouldn't be smaller than the plain one.
+ */
+static bool
+DictionaryEncode(StringInfo valueBuffer, uint32 valueCount,
+				 Form_pg_attribute attributeForm, StringInfo encodedBuffer)
+{
+	uint32 maxEntryCount = Min(valueCount / 2, DICTIONARY_MAX_ENTRIES);
+	uint32 slotCount = pg_nextpower2_32(maxEntryCount * 2);
+	uint32 *slots = palloc0(slotCount * sizeof(uint32));
+	DictionaryEntry *entries = palloc(maxEntryCount * sizeof(DictionaryEntry));
+	uint16 *codes = palloc(valueCount * sizeof(uint16));
+	uint32 entryCount = 0;
+	uint32 entriesLength = 0;
+	uint32 currentOffset = 0;
+	bool dictionaryFull = false;
+	bool encoded = false;
+
+	for (uint32 valueIndex = 0; valueIndex < valueCount; valueIndex++)
+	{
+		char *valuePointer = valueBuffer->data + currentOffset;
+		uint32 nextOffset = NextValueOffset(valueBuffer, currentOffset, attributeForm);
+		uint32 valueLength = nextOffset - currentOffset;
+		uint32 valueHash = hash_bytes((const unsigned char *) valuePointer,
+									  valueLength);
+		uint32 slot = valueHash & (slotCount - 1);
+
+		while (slots[slot] != 0)
+		{
+			DictionaryEntry *entry = &entries[slots[slot] - 1];
+
+			if (entry->hash == valueHash && entry->length == valueLength &&
+				memcmp(valueBuffer->data + entry->offset, valuePointer,
+					   valueLength) == 0)
+			{
+				break;
+			}
+
+			slot = (slot + 1) & (slotCount - 1);
+		}
+
+		if (slots[slot] == 0)
+		{
+			if (entryCount == maxEntryCount)
+			{
+				dictionaryFull = true;
+				break;
+			}
+
+			entries[entryCount].offset = currentOffset;
+			entries[entryCount].length = valueLength;
+			entries[entryCount].hash = valueHash;
+			entriesLength += valueLength;
+			slots[slot] = ++entryCount;
+		}
+
+		codes[valueIndex] = slots[slot] - 1;
+		currentOffset = nextOffset;
+	}
+
+	uint32 codeWidth = (entryCount <= PG_UINT8_MAX + 1) ? 1 : 2;
+	uint32 codesOffset = DICTIONARY_HEADER_SIZE + MAXALIGN(entriesLength);
+	uint32 encodedSize = codesOffset + valueCount * codeWidth;
+
+	if (!dictionaryFull && encodedSize < valueBuffer->len)
+	{
+		WriteDictionaryEncoding(valueBuffer, entries, entryCount, entriesLength,
+								codes, valueCount, codeWidth, encodedBuffer);
+		encoded = true;
+	}
+
+	pfree(slots);
+	pfree(entries);
+	pfree(codes);
+
+	return encoded;
+}
+
+
+/*
+ * WriteDictionaryEncoding writes the header, the dictionary entries and the
+ * codes of a dictionary encoded value stream into encodedBuffer.
+ */
+static void
+WriteDictionaryEncoding(StringInfo valueBuffer, DictionaryEntry *entries,
+						uint32 entryCount, uint32 entriesLength, uint16 *codes,
+						uint32 valueCount, uint32 codeWidth, StringInfo encodedBuffer)
+{
+	uint32 codesOffset = DICTIONARY_HEADER_SIZE + MAXALIGN(entriesLength);
+	uint32 encodedSize = codesOffset + valueCount * codeWidth;
+
+	resetStringInfo(encodedBuffer);
+	enlargeStringInfo(encodedBuffer, encodedSize);
+	memset(encodedBuffer->data, 0, encodedSize);
+
+	DictionaryEncodingHeader *header = (DictionaryEncodingHeader *) encodedBuffer->data;
+	header->entryCount = entryCount;
+	header->entriesLength = entriesLength;
+	header->codeWidth = codeWidth;
+	header->valueCount = valueCount;
+
+	char *entriesPointer = encodedBuffer->data + DICTIONARY_HEADER_SIZE;
+	for (uint32 entryIndex = 0; entryIndex < entryCount; entryIndex++)
+	{
+		memcpy(entriesPointer, valueBuffer->data + entries[entryIndex].offset,
+			   entries[entryIndex].length);
+		entriesPointer += entries[entryIndex].length;
+	}
+
+	char *codesPointer = encodedBuffer->data + codesOffset;
+	for (uint32 valueIndex = 0; valueIndex < valueCount; valueIndex++)
+	{
+		if (codeWidth == 1)
+		{
+			((uint8 *) codesPointer)[valueIndex] = (uint8) codes[valueIndex];
+		}
+		else
+		{
+			((uint16 *) codesPointer)[valueIndex] = codes[valueIndex];
+		}
+	}
+
+	encodedBuffer->len = encodedSize;
+}
+
+
+/*
+ * DictionaryDecode expands a dictionary encoded value stream into valueArray.
+ * All rows holding the same value share the Datum of its dictionary entry.
+ */
+static void
+DictionaryDecode(StringInfo encodedBuffer, bool *existsArray, uint32 rowCount,
+				 Form_pg_attribute attributeForm, Datum *valueArray)
+{
+	if (encodedBuffer->len < DICTIONARY_HEADER_SIZE)
+	{
+		ereport(ERROR, (errmsg("insufficient data for reading dictionary header")));
+	}
+
+	DictionaryEncodingHeader *header = (DictionaryEncodingHeader *) encodedBuffer->data;
+	uint32 codesOffset = DICTIONARY_HEADER_SIZE + MAXALIGN(header->entriesLength);
+
+	if ((uint64) codesOffset + (uint64) header->valueCount * header->codeWidth >
+		encodedBuffer->len)
+	{
+		ereport(ERROR, (errmsg("insufficient data left in dictionary buffer: %d",
+							   encodedBuffer->len)));
+	}
+
+	Datum *entryArray = palloc(Max(header->entryCount, 1) * sizeof(Datum));
+	char *entriesPointer = encodedBuffer->data + DICTIONARY_HEADER_SIZE;
+	uint32 currentOffset = 0;
+
+	for (uint32 entryIndex = 0; entryIndex < header->entryCount; entryIndex++)
+	{
+		entryArray[entryIndex] = fetch_att(entriesPointer + currentOffset,
+										   attributeForm->attbyval,
+										   attributeForm->attlen);
+		currentOffset = att_addlength_datum(currentOffset, attributeForm->attlen,
+											entryArray[entryIndex]);
+		currentOffset = att_align_nominal(currentOffset, attributeForm->attalign);
+
+		if (currentOffset > header->entriesLength)
+		{
+			ereport(ERROR, (errmsg("insufficient data left in dictionary: %d, %d",
+								   currentOffset, header->entriesLength)));
+		}
+	}
+
+	char *codesPointer = encodedBuffer->data + codesOffset;
+	uint32 valueIndex = 0;
+
+	for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+	{
+		if (!existsArray[rowIndex])
+		{
+			continue;
+		}
+
+		if (valueIndex >= header->valueCount)
+		{
+			ereport(ERROR, (errmsg("insufficient codes in dictionary encoded chunk")));
+		}
+
+		uint32 code = (header->codeWidth == 1) ?
+					  ((uint8 *) codesPointer)[valueIndex] :
+					  ((uint16 *) codesPointer)[valueIndex];
+
+		if (code >= header->entryCount)
+		{
+			ereport(ERROR, (errmsg("invalid dictionary code: %u", code)));
+		}
+
+		valueArray[rowIndex] = entryArray[code];
+		valueIndex++;
+	}
+
+	pfree(entryArray);
+}
+
+
+/*
+ * ConstantEncode stores a single value for chunks whose values all have the
+ * same serialized bytes.
+ */
+static bool
+ConstantEncode(StringInfo valueBuffer, uint32 valueCount,
+			   Form_pg_attribute attributeForm, StringInfo encodedBuffer)
+{
+	uint32 valueLength = NextValueOffset(valueBuffer, 0, attributeForm);
+	uint32 currentOffset = valueLength;
+
+	for (uint32 valueIndex = 1; valueIndex < valueCount; valueIndex++)
+	{
+		uint32 nextOffset = NextValueOffset(valueBuffer, currentOffset, attributeForm);
+
+		if (nextOffset - currentOffset != valueLength ||
+			memcmp(valueBuffer->data, valueBuffer->data + currentOffset,
+				   valueLength) != 0)
+		{
+			return false;
+		}
+
+		currentOffset = nextOffset;
+	}
+
+	resetStringInfo(encodedBuffer);
+	appendBinaryStringInfo(encodedBuffer, valueBuffer->data, valueLength);
+
+	return true;
+}
+
+
+/*
+ * ConstantDecode points every existing row at the single value of a constant
+ * chunk, which makes each stretch of existing rows a single run.
+ */
+static void
+ConstantDecode(StringInfo encodedBuffer, bool *existsArray, uint32 rowCount,
+			   Form_pg_attribute attributeForm, Datum *valueArray,
+			   bool *runStartArray)
+{
+	Datum constantValue = fetch_att(encodedBuffer->data, attributeForm->attbyval,
+									attributeForm->attlen);
+
+	uint32 valueLength = att_addlength_datum(0, attributeForm->attlen, constantValue);
+	if (valueLength > encodedBuffer->len)
+	{
+		ereport(ERROR, (errmsg("insufficient data for reading constant value: %d, %d",
+							   valueLength, encodedBuffer->len)));
+	}
+
+	for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+	{
+		if (existsArray[rowIndex])
+		{
+			valueArray[rowIndex] = constantValue;
+		}
+
+		if (runStartArray != NULL)
+		{
+			runStartArray[rowIndex] =
+				rowIndex == 0 || existsArray[rowIndex] != existsArray[rowIndex - 1];
+		}
+	}
+}
+
+
+/*
+ * RunLengthEncode collapses consecutive values with identical serialized bytes
+ * into runs. Encoding is abandoned when the values repeat less than
+ * RLE_MIN_AVERAGE_RUN_LENGTH times on average, or when the encoded stream
+ * wouldn't be smaller than the plain one.
+ */
+static bool
+RunLengthEncode(StringInfo valueBuffer, uint32 valueCount,
+				Form_pg_attribute attributeForm, StringInfo encodedBuffer)
+{
+	uint32 maxRunCount = valueCount / RLE_MIN_AVERAGE_RUN_LENGTH;
+	uint32 *runOffsets = palloc(maxRunCount * sizeof(uint32));
+	uint32 *runLengths = palloc(maxRunCount * sizeof(uint32));
+	uint32 runCount = 0;
+	uint32 runValuesLength = 0;
+	uint32 currentOffset = 0;
+	uint32 previousOffset = 0;
+	uint32 previousLength = 0;
+	bool tooManyRuns = false;
+	bool encoded = false;
+
+	for (uint32 valueIndex = 0; valueIndex < valueCount; valueIndex++)
+	{
+		uint32 nextOffset = NextValueOffset(valueBuffer, currentOffset, attributeForm);
+		uint32 valueLength = nextOffset - currentOffset;
+
+		if (runCount > 0 && valueLength == previousLength &&
+			memcmp(valueBuffer->data + previousOffset,
+				   valueBuffer->data + currentOffset, valueLength) == 0)
+		{
+			runLengths[runCount - 1]++;
+		}
+		else
+		{
+			if (runCount == maxRunCount)
+			{
+				tooManyRuns = true;
+				break;
+			}
+
+			runOffsets[runCount] = currentOffset;
+			runLengths[runCount] = 1;
+			runValuesLength += valueLength;
+			runCount++;
+
+			previousOffset = currentOffset;
+			previousLength = valueLength;
+		}
+
+		currentOffset = nextOffset;
+	}
+
+	uint32 runLengthsOffset = RLE_HEADER_SIZE + MAXALIGN(runValuesLength);
+	uint32 encodedSize = runLengthsOffset + runCount * sizeof(uint32);
+
+	if (!tooManyRuns && encodedSize < valueBuffer->len)
+	{
+		resetStringInfo(encodedBuffer);
+		enlargeStringInfo(encodedBuffer, encodedSize);
+		memset(encodedBuffer->data, 0, encodedSize);
+
+		RunLengthEncodingHeader *header =
+			(RunLengthEncodingHeader *) encodedBuffer->data;
+		header->runCount = runCount;
+		header->runValuesLength = runValuesLength;
+		header->valueCount = valueCount;
+
+		char *runValuesPointer = encodedBuffer->data + RLE_HEADER_SIZE;
+		for (uint32 runIndex = 0; runIndex < runCount; runIndex++)
+		{
+			uint32 runValueLength = NextValueOffset(valueBuffer, runOffsets[runIndex],
+													attributeForm) -
+									runOffsets[runIndex];
+
+			memcpy(runValuesPointer, valueBuffer->data + runOffsets[runIndex],
+				   runValueLength);
+			runValuesPointer += runValueLength;
+		}
+
+		memcpy(encodedBuffer->data + runLengthsOffset, runLengths,
+			   runCount * sizeof(uint32));
+
+		encodedBuffer->len = encodedSize;
+		encoded = true;
+	}
+
+	pfree(runOffsets);
+	pfree(runLengths);
+
+	return encoded;
+}
+
+
+/*
+ * RunLengthDecode expands a run-length encoded value stream into valueArray.
+ * Each run's value is fetched once and repeated for the run's rows; NULL rows
+ * in between don't consume run values.
+ */
+static void
+RunLengthDecode(StringInfo encodedBuffer, bool *existsArray, uint32 rowCount,
+				Form_pg_attribute attributeForm, Datum *valueArray,
+				bool *runStartArray)
+{
+	if (encodedBuffer->len < RLE_HEADER_SIZE)
+	{
+		ereport(ERROR, (errmsg("insufficient data for reading run-length header")));
+	}
+
+	RunLengthEncodingHeader *header = (RunLengthEncodingHeader *) encodedBuffer->data;
+	uint32 runLengthsOffset = RLE_HEADER_SIZE + MAXALIGN(header->runValuesLength);
+
+	if ((uint64) runLengthsOffset + (uint64) header->runCount * sizeof(uint32) >
+		encodedBuffer->len)
+	{
+		ereport(ERROR, (errmsg("insufficient data left in run-length buffer: %d",
+							   encodedBuffer->len)));
+	}
+
+	char *runValuesPointer = encodedBuffer->data + RLE_HEADER_SIZE;
+	uint32 *runLengths = (uint32 *) (encodedBuffer->data + runLengthsOffset);
+	uint32 runIndex = 0;
+	uint32 runRemaining = 0;
+	uint32 currentOffset = 0;
+	Datum runValue = 0;
+	bool previousExists = false;
+
+	for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+	{
+		bool runStart = (rowIndex == 0 || existsArray[rowIndex] != previousExists);
+
+		if (existsArray[rowIndex])
+		{
+			if (runRemaining == 0)
+			{
+				if (runIndex >= header->runCount)
+				{
+					ereport(ERROR, (errmsg("insufficient runs in run-length "
+										   "encoded chunk")));
+				}
+
+				runValue = fetch_att(runValuesPointer + currentOffset,
+									 attributeForm->attbyval, attributeForm->attlen);
+				currentOffset = att_addlength_datum(currentOffset, attributeForm->attlen,
+													runValue);
+				currentOffset = att_align_nominal(currentOffset, attributeForm->attalign);
+
+				if (currentOffset > header->runValuesLength)
+				{
+					ereport(ERROR, (errmsg("insufficient data left in run values: "
+										   "%d, %d", currentOffset,
+										   header->runValuesLength)));
+				}
+
+				runRemaining = runLengths[runIndex++];
+				runStart = true;
+
+				if (runRemaining == 0)
+				{
+					ereport(ERROR, (errmsg("invalid empty run in run-length "
+										   "encoded chunk")));
+				}
+			}
+
+			valueArray[rowIndex] = runValue;
+			runRemaining--;
+		}
+
+		if (runStartArray != NULL)
+		{
+			runStartArray[rowIndex] = runStart;
+		}
+
+		previousExists = existsArray[rowIndex];
+	}
+}
+
+
+/*
+ * IsIntegerEncodable returns true for the pass-by-value integer, date and time
+ * types whose values can be bit-packed as offsets from a base value.
+ */
+static bool
+IsIntegerEncodable(Form_pg_attribute attributeForm)
+{
+	if (!attributeForm->attbyval)
+	{
+		return false;
+	}
+
+	switch (attributeForm->atttypid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		{
+			return true;
+		}
+
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+
+/*
+ * IntegerEncode bit-packs the values of an integer-like chunk either as
+ * offsets from the chunk minimum (frame-of-reference), or as offsets from the
+ * smallest delta between consecutive values, whichever is narrower. Offsets
+ * are computed with wrapping unsigned arithmetic, so any int64 range round
+ * trips exactly.
+ */
+static bool
+IntegerEncode(StringInfo valueBuffer, uint32 valueCount,
+			  Form_pg_attribute attributeForm, StringInfo encodedBuffer,
+			  EncodingType *encodingType)
+{
+	int64 *values = palloc(valueCount * sizeof(int64));
+	uint32 currentOffset = 0;
+
+	for (uint32 valueIndex = 0; valueIndex < valueCount; valueIndex++)
+	{
+		uint32 nextOffset = NextValueOffset(valueBuffer, currentOffset, attributeForm);
+		Datum value = fetch_att(valueBuffer->data + currentOffset, true,
+								attributeForm->attlen);
+
+		switch (attributeForm->attlen)
+		{
+			case sizeof(int16):
+			{
+				values[valueIndex] = DatumGetInt16(value);
+				break;
+			}
+
+			case sizeof(int32):
+			{
+				values[valueIndex] = DatumGetInt32(value);
+				break;
+			}
+
+			default:
+			{
+				values[valueIndex] = DatumGetInt64(value);
+				break;
+			}
+		}
+
+		currentOffset = nextOffset;
+	}
+
+	int64 minValue = values[0];
+	int64 maxValue = values[0];
+	int64 minDelta = 0;
+	int64 maxDelta = 0;
+
+	for (uint32 valueIndex = 1; valueIndex < valueCount; valueIndex++)
+	{
+		int64 delta = (int64) ((uint64) values[valueIndex] -
+							   (uint64) values[valueIndex - 1]);
+
+		minValue = Min(minValue, values[valueIndex]);
+		maxValue = Max(maxValue, values[valueIndex]);
+
+		if (valueIndex == 1)
+		{
+			minDelta = maxDelta = delta;
+		}
+		else
+		{
+			minDelta = Min(minDelta, delta);
+			maxDelta = Max(maxDelta, delta);
+		}
+	}
+
+	uint32 forBitWidth = BitWidth((uint64) maxValue - (uint64) minValue);
+	uint32 deltaBitWidth = BitWidth((uint64) maxDelta - (uint64) minDelta);
+	bool useDelta = deltaBitWidth < forBitWidth;
+	uint32 bitWidth = useDelta ? deltaBitWidth : forBitWidth;
+	uint64 packedBits = (uint64) valueCount * bitWidth;
+	uint64 encodedSize = BITPACKING_HEADER_SIZE +
+						 ((packedBits + 63) / 64) * sizeof(uint64);
+	bool encoded = false;
+
+	if (encodedSize < valueBuffer->len)
+	{
+		WriteBitPackedEncoding(values, valueCount, useDelta ? values[0] : minValue,
+							   minDelta, useDelta, bitWidth, encodedBuffer);
+		*encodingType = useDelta ? ENCODING_DELTA : ENCODING_FOR;
+		encoded = true;
+	}
+
+	pfree(values);
+
+	return encoded;
+}
+
+
+/*
+ * WriteBitPackedEncoding writes the header and the packed offsets of a
+ * frame-of-reference or delta encoded value stream into encodedBuffer.
+ */
+static void
+WriteBitPackedEncoding(int64 *values, uint32 valueCount, int64 base, int64 minDelta,
+					   bool delta, uint32 bitWidth, StringInfo encodedBuffer)
+{
+	uint64 wordCount = ((uint64) valueCount * bitWidth + 63) / 64;
+	uint32 encodedSize = BITPACKING_HEADER_SIZE + wordCount * sizeof(uint64);
+
+	resetStringInfo(encodedBuffer);
+	enlargeStringInfo(encodedBuffer, encodedSize);
+	memset(encodedBuffer->data, 0, encodedSize);
+
+	BitPackingHeader *header = (BitPackingHeader *) encodedBuffer->data;
+	header->valueCount = valueCount;
+	header->bitWidth = bitWidth;
+	header->base = base;
+	header->minDelta = delta ? minDelta : 0;
+
+	uint64 *words = (uint64 *) (encodedBuffer->data + BITPACKING_HEADER_SIZE);
+
+	for (uint32 valueIndex = 0; valueIndex < valueCount && bitWidth > 0; valueIndex++)
+	{
+		uint64 offset;
+
+		if (delta)
+		{
+			offset = (valueIndex == 0) ? 0 :
+					 (uint64) values[valueIndex] - (uint64) values[valueIndex - 1] -
+					 (uint64) minDelta;
+		}
+		else
+		{
+			offset = (uint64) values[valueIndex] - (uint64) base;
+		}
+
+		WritePackedBits(words, (uint64) valueIndex * bitWidth, bitWidth, offset);
+	}
+
+	encodedBuffer->len = encodedSize;
+}
+
+
+/*
+ * IntegerDecode unpacks a frame-of-reference or delta encoded value stream
+ * into valueArray.
+ */
+static void
+IntegerDecode(StringInfo encodedBuffer, EncodingType encodingType, bool *existsArray,
+			  uint32 rowCount, Form_pg_attribute attributeForm, Datum *valueArray)
+{
+	if (encodedBuffer->len < BITPACKING_HEADER_SIZE)
+	{
+		ereport(ERROR, (errmsg("insufficient data for reading bit-packing header")));
+	}
+
+	BitPackingHeader *header = (BitPackingHeader *) encodedBuffer->data;
+	uint32 bitWidth = header->bitWidth;
+	uint64 wordCount = ((uint64) header->valueCount * bitWidth + 63) / 64;
+
+	if (bitWidth > 64 ||
+		BITPACKING_HEADER_SIZE + wordCount * sizeof(uint64) > encodedBuffer->len)
+	{
+		ereport(ERROR, (errmsg("insufficient data left in bit-packed buffer: %d",
+							   encodedBuffer->len)));
+	}
+
+	uint64 *words = (uint64 *) (encodedBuffer->data + BITPACKING_HEADER_SIZE);
+	uint64 previousValue = (uint64) header->base;
+	uint32 valueIndex = 0;
+
+	for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+	{
+		if (!existsArray[rowIndex])
+		{
+			continue;
+		}
+
+		if (valueIndex >= header->valueCount)
+		{
+			ereport(ERROR, (errmsg("insufficient values in bit-packed chunk")));
+		}
+
+		uint64 offset = ReadPackedBits(words, (uint64) valueIndex * bitWidth, bitWidth);
+		uint64 value;
+
+		if (encodingType == ENCODING_DELTA)
+		{
+			value = (valueIndex == 0) ? previousValue :
+					previousValue + (uint64) header->minDelta + offset;
+			previousValue = value;
+		}
+		else
+		{
+			value = (uint64) header->base + offset;
+		}
+
+		switch (attributeForm->attlen)
+		{
+			case sizeof(int16):
+			{
+				valueArray[rowIndex] = Int16GetDatum((int16) value);
+				break;
+			}
+
+			case sizeof(int32):
+			{
+				valueArray[rowIndex] = Int32GetDatum((int32) value);
+				break;
+			}
+
+			default:
+			{
+				valueArray[rowIndex] = Int64GetDatum((int64) value);
+				break;
+			}
+		}
+
+		valueIndex++;
+	}
+}
+
+
+/*
+ * IsFloatEncodable returns true for the pass-by-value floating point types.
+ */
+static bool
+IsFloatEncodable(Form_pg_attribute attributeForm)
+{
+	return attributeForm->attbyval &&
+		   (attributeForm->atttypid == FLOAT4OID ||
+			attributeForm->atttypid == FLOAT8OID);
+}
+
+
+/*
+ * FloatXorEncode encodes the bit patterns of a float4 or float8 chunk as XORs
+ * of consecutive values, which are mostly zero bits when neighbouring values
+ * are close or share their exponent. Since only bit patterns are compared,
+ * NaNs, infinities and negative zeros round trip exactly. Encoding is
+ * abandoned as soon as the stream grows beyond the plain one.
+ */
+static bool
+FloatXorEncode(StringInfo valueBuffer, uint32 valueCount,
+			   Form_pg_attribute attributeForm, StringInfo encodedBuffer)
+{
+	uint64 maxBitCount = (uint64) valueBuffer->len * 8;
+	uint64 wordCount = (maxBitCount + FLOAT_XOR_MAX_VALUE_BITS) / 64 + 1;
+	uint64 *words = palloc0(wordCount * sizeof(uint64));
+	uint64 bitPosition = 0;
+	uint64 previousBits = 0;
+	uint32 previousLeading = 0;
+	uint32 previousTrailing = 0;
+	bool hasWindow = false;
+	uint32 currentOffset = 0;
+	bool encoded = false;
+
+	for (uint32 valueIndex = 0; valueIndex < valueCount; valueIndex++)
+	{
+		uint32 nextOffset = NextValueOffset(valueBuffer, currentOffset, attributeForm);
+		Datum value = fetch_att(valueBuffer->data + currentOffset, true,
+								attributeForm->attlen);
+		uint64 bits = (attributeForm->attlen == sizeof(float4)) ?
+					  ((uint64) DatumGetUInt32(value)) << 32 :
+					  DatumGetUInt64(value);
+
+		currentOffset = nextOffset;
+
+		if (bitPosition > maxBitCount)
+		{
+			break;
+		}
+
+		if (valueIndex == 0)
+		{
+			WritePackedBits(words, bitPosition, 64, bits);
+			bitPosition += 64;
+			previousBits = bits;
+			continue;
+		}
+
+		uint64 xorBits = bits ^ previousBits;
+		previousBits = bits;
+
+		if (xorBits == 0)
+		{
+			WritePackedBits(words, bitPosition++, 1, 0);
+			continue;
+		}
+
+		WritePackedBits(words, bitPosition++, 1, 1);
+
+		uint32 leading = 63 - pg_leftmost_one_pos64(xorBits);
+		uint32 trailing = pg_rightmost_one_pos64(xorBits);
+
+		if (hasWindow && leading >= previousLeading && trailing >= previousTrailing)
+		{
+			uint32 length = 64 - previousLeading - previousTrailing;
+
+			WritePackedBits(words, bitPosition++, 1, 0);
+			WritePackedBits(words, bitPosition, length, xorBits >> previousTrailing);
+			bitPosition += length;
+		}
+		else
+		{
+			uint32 length = 64 - leading - trailing;
+
+			WritePackedBits(words, bitPosition++, 1, 1);
+			WritePackedBits(words, bitPosition, 6, leading);
+			bitPosition += 6;
+			WritePackedBits(words, bitPosition, 6, length - 1);
+			bitPosition += 6;
+			WritePackedBits(words, bitPosition, length, xorBits >> trailing);
+			bitPosition += length;
+
+			previousLeading = leading;
+			previousTrailing = trailing;
+			hasWindow = true;
+		}
+	}
+
+	uint64 encodedSize = FLOAT_XOR_HEADER_SIZE + ((bitPosition + 63) / 64) * sizeof(uint64);
+
+	if (bitPosition <= maxBitCount && encodedSize < valueBuffer->len)
+	{
+		resetStringInfo(encodedBuffer);
+		enlargeStringInfo(encodedBuffer, encodedSize);
+
+		FloatXorHeader *header = (FloatXorHeader *) encodedBuffer->data;
+		header->valueCount = valueCount;
+		header->bitCount = bitPosition;
+
+		memcpy(encodedBuffer->data + FLOAT_XOR_HEADER_SIZE, words,
+			   encodedSize - FLOAT_XOR_HEADER_SIZE);
+
+		encodedBuffer->len = encodedSize;
+		encoded = true;
+	}
+
+	pfree(words);
+
+	return encoded;
+}
+
+
+/*
+ * FloatXorDecode expands a float XOR encoded value stream into valueArray.
+ */
+static void
+FloatXorDecode(StringInfo encodedBuffer, bool *existsArray, uint32 rowCount,
+			   Form_pg_attribute attributeForm, Datum *valueArray)
+{
+	if (encodedBuffer->len < FLOAT_XOR_HEADER_SIZE)
+	{
+		ereport(ERROR, (errmsg("insufficient data for reading float XOR header")));
+	}
+
+	FloatXorHeader *header = (FloatXorHeader *) encodedBuffer->data;
+	uint64 bitCount = header->bitCount;
+
+	if (FLOAT_XOR_HEADER_SIZE + ((bitCount + 63) / 64) * sizeof(uint64) >
+		encodedBuffer->len)
+	{
+		ereport(ERROR, (errmsg("insufficient data left in float XOR buffer: %d",
+							   encodedBuffer->len)));
+	}
+
+	uint64 *words = (uint64 *) (encodedBuffer->data + FLOAT_XOR_HEADER_SIZE);
+	uint64 bitPosition = 0;
+	uint64 bits = 0;
+	uint32 leading = 0;
+	uint32 trailing = 0;
+	uint32 valueIndex = 0;
+
+	for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+	{
+		if (!existsArray[rowIndex])
+		{
+			continue;
+		}
+
+		if (valueIndex >= header->valueCount)
+		{
+			ereport(ERROR, (errmsg("insufficient values in float XOR encoded chunk")));
+		}
+
+		if (valueIndex == 0)
+		{
+			bits = ReadFloatXorBits(words, &bitPosition, bitCount, 64);
+		}
+		else if (ReadFloatXorBits(words, &bitPosition, bitCount, 1) != 0)
+		{
+			if (ReadFloatXorBits(words, &bitPosition, bitCount, 1) != 0)
+			{
+				leading = ReadFloatXorBits(words, &bitPosition, bitCount, 6);
+				uint32 length = ReadFloatXorBits(words, &bitPosition, bitCount, 6) + 1;
+
+				if (leading + length > 64)
+				{
+					ereport(ERROR, (errmsg("invalid float XOR window: %u, %u",
+										   leading, length)));
+				}
+
+				trailing = 64 - leading - length;
+			}
+
+			uint64 xorBits = ReadFloatXorBits(words, &bitPosition, bitCount,
+											  64 - leading - trailing);
+			bits ^= xorBits << trailing;
+		}
+
+		if (attributeForm->attlen == sizeof(float4))
+		{
+			valueArray[rowIndex] = Int32GetDatum((int32) (bits >> 32));
+		}
+		else
+		{
+			valueArray[rowIndex] = UInt64GetDatum(bits);
+		}
+
+		valueIndex++;
+	}
+}
+
+
+/*
+ * FsstEncode compresses each value of a varlena chunk with a symbol table of
+ * frequent byte sequences trained on a sample of the chunk. It is meant for
+ * high-cardinality strings that dictionary encoding gives up on, and is
+ * abandoned when the result wouldn't be smaller than the plain stream.
+ */
+static bool
+FsstEncode(StringInfo valueBuffer, uint32 valueCount,
+		   Form_pg_attribute attributeForm, StringInfo encodedBuffer)
+{
+	uint32 *valueOffsets = palloc((valueCount + 1) * sizeof(uint32));
+	uint32 currentOffset = 0;
+
+	for (uint32 valueIndex = 0; valueIndex < valueCount; valueIndex++)
+	{
+		valueOffsets[valueIndex] = currentOffset;
+		currentOffset = NextValueOffset(valueBuffer, currentOffset, attributeForm);
+	}
+	valueOffsets[valueCount] = currentOffset;
+
+	FsstSymbolTable *table = palloc0(sizeof(FsstSymbolTable));
+	FsstTrain(valueBuffer, valueOffsets, valueCount, table);
+
+	uint32 tableSize = MAXALIGN(table->symbolCount * sizeof(FsstSymbol)) +
+					   MAXALIGN(table->symbolCount * sizeof(uint8));
+	uint32 offsetsSize = MAXALIGN((valueCount + 1) * sizeof(uint32));
+	uint32 codesOffset = FSST_HEADER_SIZE + tableSize + offsetsSize;
+	uint32 *codeOffsets = palloc((valueCount + 1) * sizeof(uint32));
+	StringInfo codes = makeStringInfo();
+	bool encoded = false;
+
+	for (uint32 valueIndex = 0; valueIndex < valueCount; valueIndex++)
+	{
+		const char *value = valueBuffer->data + valueOffsets[valueIndex];
+		uint32 valueLength = valueOffsets[valueIndex + 1] - valueOffsets[valueIndex];
+		uint32 position = 0;
+
+		codeOffsets[valueIndex] = codes->len;
+
+		if (codesOffset + codes->len >= valueBuffer->len)
+		{
+			break;
+		}
+
+		enlargeStringInfo(codes, valueLength * 2);
+
+		while (position < valueLength)
+		{
+			int code = FsstFindSymbol(table, value + position, valueLength - position);
+
+			if (code >= 0)
+			{
+				codes->data[codes->len++] = (char) code;
+				position += table->lengths[code];
+			}
+			else
+			{
+				codes->data[codes->len++] = (char) FSST_ESCAPE;
+				codes->data[codes->len++] = value[position];
+				position++;
+			}
+		}
+	}
+	codeOffsets[valueCount] = codes->len;
+
+	if (codesOffset + codes->len < valueBuffer->len)
+	{
+		uint32 encodedSize = codesOffset + codes->len;
+
+		resetStringInfo(encodedBuffer);
+		enlargeStringInfo(encodedBuffer, encodedSize);
+		memset(encodedBuffer->data, 0, codesOffset);
+
+		FsstEncodingHeader *header = (FsstEncodingHeader *) encodedBuffer->data;
+		header->valueCount = valueCount;
+		header->symbolCount = table->symbolCount;
+		header->codesLength = codes->len;
+		header->decodedLength = valueBuffer->len;
+
+		char *symbolsPointer = encodedBuffer->data + FSST_HEADER_SIZE;
+		char *lengthsPointer = symbolsPointer +
+							   MAXALIGN(table->symbolCount * sizeof(FsstSymbol));
+		memcpy(symbolsPointer, table->symbols, table->symbolCount * sizeof(FsstSymbol));
+		memcpy(lengthsPointer, table->lengths, table->symbolCount * sizeof(uint8));
+		memcpy(encodedBuffer->data + FSST_HEADER_SIZE + tableSize, codeOffsets,
+			   (valueCount + 1) * sizeof(uint32));
+		memcpy(encodedBuffer->data + codesOffset, codes->data, codes->len);
+
+		encodedBuffer->len = encodedSize;
+		encoded = true;
+	}
+
+	pfree(valueOffsets);
+	pfree(codeOffsets);
+	pfree(table);
+	pfree(codes->data);
+	pfree(codes);
+
+	return encoded;
+}
+
+
+/*
+ * FsstTrain builds a symbol table for the given values, following the FSST
+ * training loop: a sample of the chunk is compressed with the current table,
+ * each emitted symbol and each concatenation of two consecutive symbols that
+ * fits in a symbol is counted, and the candidates covering the most bytes
+ * form the next table.
+ */
+static void
+FsstTrain(StringInfo valueBuffer, uint32 *valueOffsets, uint32 valueCount,
+		  FsstSymbolTable *table)
+{
+	uint32 sampleStride = Max(valueBuffer->len / FSST_SAMPLE_SIZE, 1);
+	uint32 slotCount = pg_nextpower2_32(FSST_SAMPLE_SIZE * 4);
+	FsstCandidate *candidates = palloc(slotCount * sizeof(FsstCandidate));
+
+	table->symbolCount = 0;
+	memset(table->bucketStart, 0, sizeof(table->bucketStart));
+
+	for (int trainingRound = 0; trainingRound < FSST_TRAINING_ROUNDS; trainingRound++)
+	{
+		uint32 sampleSize = 0;
+
+		memset(candidates, 0, slotCount * sizeof(FsstCandidate));
+
+		for (uint32 valueIndex = 0;
+			 valueIndex < valueCount && sampleSize < FSST_SAMPLE_SIZE;
+			 valueIndex += sampleStride)
+		{
+			const char *value = valueBuffer->data + valueOffsets[valueIndex];
+			uint32 valueLength = Min(valueOffsets[valueIndex + 1] -
+									 valueOffsets[valueIndex],
+									 FSST_SAMPLE_SIZE - sampleSize);
+			uint32 position = 0;
+			uint32 previousPosition = 0;
+			uint32 previousLength = 0;
+
+			while (position < valueLength)
+			{
+				int code = FsstFindSymbol(table, value + position,
+										  valueLength - position);
+				uint32 length = (code >= 0) ? table->lengths[code] : 1;
+
+				FsstCountCandidate(candidates, slotCount, value + position, length);
+
+				if (previousLength > 0 &&
+					previousLength + length <= FSST_MAX_SYMBOL_LENGTH)
+				{
+					FsstCountCandidate(candidates, slotCount, value + previousPosition,
+									   previousLength + length);
+				}
+
+				previousPosition = position;
+				previousLength = length;
+				position += length;
+			}
+
+			sampleSize += valueLength;
+		}
+
+		/* compact the counted candidates to the front of the array */
+		uint32 candidateCount = 0;
+		for (uint32 slot = 0; slot < slotCount; slot++)
+		{
+			if (candidates[slot].count > 0)
+			{
+				candidates[candidateCount++] = candidates[slot];
+			}
+		}
+
+		FsstBuildTable(candidates, candidateCount, table);
+	}
+
+	pfree(candidates);
+}
+
+
+/*
+ * FsstCountCandidate increments the count of the given byte sequence in the
+ * candidate hash table.
+ */
+static void
+FsstCountCandidate(FsstCandidate *candidates, uint32 slotCount, const char *bytes,
+				   uint32 length)
+{
+	uint32 slot = hash_bytes((const unsigned char *) bytes, length) & (slotCount - 1);
+
+	while (candidates[slot].count > 0)
+	{
+		if (candidates[slot].length == length &&
+			memcmp(candidates[slot].symbol.bytes, bytes, length) == 0)
+		{
+			candidates[slot].count++;
+			return;
+		}
+
+		slot = (slot + 1) & (slotCount - 1);
+	}
+
+	memset(&candidates[slot].symbol, 0, sizeof(FsstSymbol));
+	memcpy(candidates[slot].symbol.bytes, bytes, length);
+	candidates[slot].length = length;
+	candidates[slot].count = 1;
+}
+
+
+/*
+ * FsstCandidateGainCompare orders candidates by the number of bytes they
+ * cover, then deterministically by length and bytes.
+ */
+static int
+FsstCandidateGainCompare(const void *left, const void *right)
+{
+	const FsstCandidate *leftCandidate = (const FsstCandidate *) left;
+	const FsstCandidate *rightCandidate = (const FsstCandidate *) right;
+	uint64 leftGain = (uint64) leftCandidate->count * leftCandidate->length;
+	uint64 rightGain = (uint64) rightCandidate->count * rightCandidate->length;
+
+	if (leftGain != rightGain)
+	{
+		return (leftGain > rightGain) ? -1 : 1;
+	}
+
+	if (leftCandidate->length != rightCandidate->length)
+	{
+		return (leftCandidate->length > rightCandidate->length) ? -1 : 1;
+	}
+
+	return memcmp(leftCandidate->symbol.bytes, rightCandidate->symbol.bytes,
+				  FSST_MAX_SYMBOL_LENGTH);
+}
+
+
+/*
+ * FsstCandidateOrderCompare orders symbols by first byte and then by
+ * decreasing length, which is the lookup order of FsstSymbolTable.
+ */
+static int
+FsstCandidateOrderCompare(const void *left, const void *right)
+{
+	const FsstCandidate *leftCandidate = (const FsstCandidate *) left;
+	const FsstCandidate *rightCandidate = (const FsstCandidate *) right;
+	uint8 leftFirst = (uint8) leftCandidate->symbol.bytes[0];
+	uint8 rightFirst = (uint8) rightCandidate->symbol.bytes[0];
+
+	if (leftFirst != rightFirst)
+	{
+		return (leftFirst < rightFirst) ? -1 : 1;
+	}
+
+	if (leftCandidate->length != rightCandidate->length)
+	{
+		return (leftCandidate->length > rightCandidate->length) ? -1 : 1;
+	}
+
+	return memcmp(leftCandidate->symbol.bytes, rightCandidate->symbol.bytes,
+				  FSST_MAX_SYMBOL_LENGTH);
+}
+
+
+/*
+ * FsstBuildTable fills the symbol table with the candidates that cover the
+ * most bytes. Single bytes only save space over an escape, so they are
+ * weighed like any other symbol of length one.
+ */
+static void
+FsstBuildTable(FsstCandidate *candidates, uint32 candidateCount,
+			   FsstSymbolTable *table)
+{
+	qsort(candidates, candidateCount, sizeof(FsstCandidate), FsstCandidateGainCompare);
+
+	uint32 symbolCount = Min(candidateCount, FSST_MAX_SYMBOLS);
+	qsort(candidates, symbolCount, sizeof(FsstCandidate), FsstCandidateOrderCompare);
+
+	memset(table->bucketStart, 0, sizeof(table->bucketStart));
+
+	for (uint32 symbolIndex = 0; symbolIndex < symbolCount; symbolIndex++)
+	{
+		table->symbols[symbolIndex] = candidates[symbolIndex].symbol;
+		table->lengths[symbolIndex] = candidates[symbolIndex].length;
+		table->bucketStart[(uint8) candidates[symbolIndex].symbol.bytes[0] + 1]++;
+	}
+
+	for (uint32 bucket = 1; bucket <= PG_UINT8_MAX + 1; bucket++)
+	{
+		table->bucketStart[bucket] += table->bucketStart[bucket - 1];
+	}
+
+	table->symbolCount = symbolCount;
+}
+
+
+/*
+ * FsstFindSymbol returns the code of the longest symbol that data starts
+ * with, or -1 if there is none.
+ */
+static inline int
+FsstFindSymbol(FsstSymbolTable *table, const char *data, uint32 remaining)
+{
+	uint8 firstByte = (uint8) data[0];
+
+	for (uint32 code = table->bucketStart[firstByte];
+		 code < table->bucketStart[firstByte + 1]; code++)
+	{
+		if (table->lengths[code] <= remaining &&
+			memcmp(table->symbols[code].bytes, data, table->lengths[code]) == 0)
+		{
+			return code;
+		}
+	}
+
+	return -1;
+}
+
+
+/*
+ * FsstDecode decodes an FSST encoded value stream back into the plain stream
+ * and points valueArray into it. The returned buffer holds the plain stream.
+ */
+static StringInfo
+FsstDecode(StringInfo encodedBuffer, bool *existsArray, uint32 rowCount,
+		   Form_pg_attribute attributeForm, Datum *valueArray)
+{
+	if (encodedBuffer->len < FSST_HEADER_SIZE)
+	{
+		ereport(ERROR, (errmsg("insufficient data for reading FSST header")));
+	}
+
+	FsstEncodingHeader *header = (FsstEncodingHeader *) encodedBuffer->data;
+	StringInfo decodedBuffer = makeStringInfo();
+	enlargeStringInfo(decodedBuffer, header->decodedLength);
+
+	for (uint32 valueIndex = 0; valueIndex < header->valueCount; valueIndex++)
+	{
+		uint32 valueLength = FsstDecodeValue(encodedBuffer, valueIndex, NULL);
+
+		if ((uint64) decodedBuffer->len + valueLength > header->decodedLength)
+		{
+			ereport(ERROR, (errmsg("FSST decoded data exceeds expected length: %u",
+								   header->decodedLength)));
+		}
+
+		FsstDecodeValue(encodedBuffer, valueIndex,
+						decodedBuffer->data + decodedBuffer->len);
+		decodedBuffer->len += valueLength;
+	}
+
+	uint32 currentOffset = 0;
+	uint32 valueIndex = 0;
+
+	for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+	{
+		if (!existsArray[rowIndex])
+		{
+			continue;
+		}
+
+		if (valueIndex >= header->valueCount)
+		{
+			ereport(ERROR, (errmsg("insufficient values in FSST encoded chunk")));
+		}
+
+		valueArray[rowIndex] = fetch_att(decodedBuffer->data + currentOffset,
+										 attributeForm->attbyval,
+										 attributeForm->attlen);
+		currentOffset = NextValueOffset(decodedBuffer, currentOffset, attributeForm);
+		valueIndex++;
+	}
+
+	return decodedBuffer;
+}
+
+
+/*
+ * FsstDecodeValue decodes the valueIndex'th value of an FSST encoded stream
+ * into output, and returns its decoded length. If output is NULL, only the
+ * length is computed.
+ */
+static uint32
+FsstDecodeValue(StringInfo encodedBuffer, uint32 valueIndex, char *output)
+{
+	FsstEncodingHeader *header = (FsstEncodingHeader *) encodedBuffer->data;
+	uint32 symbolsSize = MAXALIGN(header->symbolCount * sizeof(FsstSymbol));
+	uint32 tableSize = symbolsSize + MAXALIGN(header->symbolCount * sizeof(uint8));
+	uint32 offsetsSize = MAXALIGN((header->valueCount + 1) * sizeof(uint32));
+	uint64 codesOffset = (uint64) FSST_HEADER_SIZE + tableSize + offsetsSize;
+
+	if (header->symbolCount > FSST_MAX_SYMBOLS || valueIndex >= header->valueCount ||
+		codesOffset + header->codesLength > encodedBuffer->len)
+	{
+		ereport(ERROR, (errmsg("insufficient data left in FSST buffer: %d",
+							   encodedBuffer->len)));
+	}
+
+	FsstSymbol *symbols = (FsstSymbol *) (encodedBuffer->data + FSST_HEADER_SIZE);
+	uint8 *lengths = (uint8 *) (encodedBuffer->data + FSST_HEADER_SIZE + symbolsSize);
+	uint32 *codeOffsets = (uint32 *) (encodedBuffer->data + FSST_HEADER_SIZE +
+									  tableSize);
+	uint8 *codes = (uint8 *) (encodedBuffer->data + codesOffset);
+	uint32 codeStart = codeOffsets[valueIndex];
+	uint32 codeEnd = codeOffsets[valueIndex + 1];
+	uint32 length = 0;
+
+	if (codeStart > codeEnd || codeEnd > header->codesLength)
+	{
+		ereport(ERROR, (errmsg("invalid FSST code offsets: %u, %u",
+							   codeStart, codeEnd)));
+	}
+
+	for (uint32 codeIndex = codeStart; codeIndex < codeEnd; codeIndex++)
+	{
+		uint8 code = codes[codeIndex];
+
+		if (code == FSST_ESCAPE)
+		{
+			if (++codeIndex >= codeEnd)
+			{
+				ereport(ERROR, (errmsg("unexpected end of FSST escape sequence")));
+			}
+
+			if (output != NULL)
+			{
+				output[length] = codes[codeIndex];
+			}
+			length++;
+		}
+		else
+		{
+			if (code >= header->symbolCount)
+			{
+				ereport(ERROR, (errmsg("invalid FSST symbol code: %u", code)));
+			}
+
+			if (output != NULL)
+			{
+				memcpy(output + length, symbols[code].bytes, lengths[code]);
+			}
+			length += lengths[code];
+		}
+	}
+
+	return length;
+}
+
+
+/*
+ * ReadFloatXorBits reads the next bitWidth bits of a float XOR stream holding
+ * bitCount bits, and advances bitPosition past them.
+ */
+static inline uint64
+ReadFloatXorBits(uint64 *words, uint64 *bitPosition, uint64 bitCount, uint32 bitWidth)
+{
+	if (*bitPosition + bitWidth > bitCount)
+	{
+		ereport(ERROR, (errmsg("unexpected end of float XOR encoded chunk")));
+	}
+
+	uint64 value = ReadPackedBits(words, *bitPosition, bitWidth);
+	*bitPosition += bitWidth;
+
+	return value;
+}
+
+
+/*
+ * BitWidth returns the number of bits needed to store any value between 0 and
+ * range.
+ */
+static inline uint32
+BitWidth(uint64 range)
+{
+	return (range == 0) ? 0 : pg_leftmost_one_pos64(range) + 1;
+}
+
+
+/*
+ * WritePackedBits stores the low bitWidth bits of value at the given bit
+ * position of a zeroed array of uint64 words, least significant bit first.
+ */
+static inline void
+WritePackedBits(uint64 *words, uint64 bitPosition, uint32 bitWidth, uint64 value)
+{
+	uint64 wordIndex = bitPosition / 64;
+	uint32 shift = bitPosition % 64;
+
+	if (bitWidth == 0)
+	{
+		return;
+	}
+
+	if (bitWidth < 64)
+	{
+		value &= (UINT64CONST(1) << bitWidth) - 1;
+	}
+
+	words[wordIndex] |= value << shift;
+	if (shift + bitWidth > 64)
+	{
+		words[wordIndex + 1] |= value >> (64 - shift);
+	}
+}
+
+
+/*
+ * ReadPackedBits returns the bitWidth bits stored at the given bit position by
+ * WritePackedBits.
+ */
+static inline uint64
+ReadPackedBits(uint64 *words, uint64 bitPosition, uint32 bitWidth)
+{
+	uint64 wordIndex = bitPosition / 64;
+	uint32 shift = bitPosition % 64;
+
+	if (bitWidth == 0)
+	{
+		return 0;
+	}
+
+	uint64 value = words[wordIndex] >> shift;
+	if (shift + bitWidth > 64)
+	{
+		value |= words[wordIndex + 1] << (64 - shift);
+	}
+
+	if (bitWidth < 64)
+	{
+		value &= (UINT64CONST(1) << bitWidth) - 1;
+	}
+
+	return value;
+}
+
+
+/*
+ * NextValueOffset returns the offset right after the serialized value that
+ * starts at currentOffset of a plain value stream, including its alignment
+ * padding.
+ */
+static inline uint32
+NextValueOffset(StringInfo valueBuffer, uint32 currentOffset,
+				Form_pg_attribute attributeForm)
+{
+	char *valuePointer = valueBuffer->data + currentOffset;
+	uint32 nextOffset = att_addlength_pointer(currentOffset, attributeForm->attlen,
+											  valuePointer);
+	nextOffset = att_align_nominal(nextOffset, attributeForm->attalign);
+
+	if (nextOffset > valueBuffer->len)
+	{
+		ereport(ERROR, (errmsg("insufficient data left in datum buffer: %d, %d",
+							   nextOffset, valueBuffer->len)));
+	}
+
+	return nextOffset;
+}
@@ -114,8 +114,14 @@ static Oid ColumnarStripePKeyIndexRelationId(void);
 static Oid ColumnarStripeFirstRowNumberIndexRelationId(void);
 static Oid ColumnarOptionsRelationId(void);
 static Oid ColumnarOptionsIndexRegclass(void);
+static Oid ColumnarColumnOptionsRelationId(void);
+static Oid ColumnarColumnOptionsIndexRegclass(void);
+static Oid ColumnarZstdDictionaryRelationId(void);
+static Oid ColumnarZstdDictionaryIndexRelationId(void);
 static Oid ColumnarChunkRelationId(void);
 static Oid ColumnarChunkGroupRelationId(void);
+static Oid ColumnarStripeZoneMapRelationId(void);
+static Oid ColumnarStripeZoneMapIndexRelationId(void);
 static Oid ColumnarRowMaskRelationId(void);
 static Oid ColumnarRowMaskSeqId(void);
 static Oid ColumnarChunkIndexRelationId(void);
@@ -142,6 +148,7 @@ static void FinishModifyRelation(ModifyState *state);
 static bytea * DatumToBytea(Datum value, Form_pg_attribute attrForm);
 static Datum ByteaToDatum(bytea *bytes, Form_pg_attribute attrForm);
 static bool WriteColumnarOptions(Oid regclass, ColumnarOptions *options, bool overwrite);
+static void DeleteColumnarColumnOptions(Oid regclass);
 static StripeMetadata * StripeMetadataLookupRowNumber(Relation relation, uint64 rowNumber,
 													  Snapshot snapshot,
 													  RowNumberLookupMode lookupMode);
@@ -176,6 +183,15 @@ typedef struct FormData_columnar_options
 typedef FormData_columnar_options *Form_columnar_options;
 
 
+/* constants for columnar.column_options */
+#define Natts_columnar_column_options 5
+#define Anum_columnar_column_options_regclass 1
+#define Anum_columnar_column_options_attr_num 2
+#define Anum_columnar_column_options_compression_level 3
+#define Anum_columnar_column_options_compression 4
+#define Anum_columnar_column_options_bloom_filter 5
+
+
 /* constants for columnar.stripe */
 #define Natts_columnar_stripe 9
 #define Anum_columnar_stripe_storageid 1
@@ -197,7 +213,7 @@ typedef FormData_columnar_options *Form_columnar_options;
 #define Anum_columnar_chunkgroup_deleted_rows 5
 
 /* constants for columnar.chunk */
-#define Natts_columnar_chunk 14
+#define Natts_columnar_chunk 16
 #define Anum_columnar_chunk_storageid 1
 #define Anum_columnar_chunk_stripe 2
 #define Anum_columnar_chunk_attr 3
@@ -212,6 +228,25 @@ typedef FormData_columnar_options *Form_columnar_options;
 #define Anum_columnar_chunk_value_compression_level 12
 #define Anum_columnar_chunk_value_decompressed_size 13
 #define Anum_columnar_chunk_value_count 14
+#define Anum_columnar_chunk_value_encoding_type 15
+#define Anum_columnar_chunk_bloom_filter 16
+
+/* constants for columnar.stripe_zone_map */
+#define Natts_columnar_stripe_zone_map 6
+#define Anum_columnar_stripe_zone_map_storage_id 1
+#define Anum_columnar_stripe_zone_map_stripe_num 2
+#define Anum_columnar_stripe_zone_map_attr_num 3
+#define Anum_columnar_stripe_zone_map_minimum_value 4
+#define Anum_columnar_stripe_zone_map_maximum_value 5
+#define Anum_columnar_stripe_zone_map_null_count 6
+
+/* constants for columnar.zstd_dictionary */
+#define Natts_columnar_zstd_dictionary 5
+#define Anum_columnar_zstd_dictionary_storage_id 1
+#define Anum_columnar_zstd_dictionary_attr_num 2
+#define Anum_columnar_zstd_dictionary_version 3
+#define Anum_columnar_zstd_dictionary_dictionary_id 4
+#define Anum_columnar_zstd_dictionary_dictionary 5
 
 /* constants for columnar.row_mask */
 #define Natts_columnar_row_mask 8
@@ -403,6 +438,8 @@ DeleteColumnarTableOptions(Oid regclass, bool missingOk)
 	index_close(index, AccessShareLock);
 	relation_close(columnarOptions, RowExclusiveLock);
 
+	DeleteColumnarColumnOptions(regclass);
+
 	return result;
 }
 
@@ -462,10 +499,214 @@ ReadColumnarOptions(Oid regclass, ColumnarOptions *options)
 	index_close(index, AccessShareLock);
 	relation_close(columnarOptions, AccessShareLock);
 
+	options->columnOptionsList = ReadColumnarColumnOptions(regclass);
+
 	return true;
 }
 
 
+/*
+ * ReadColumnarColumnOptions returns the list of per-column compression overrides
+ * and bloom filter settings (ColumnarColumnOptions) stored in
+ * columnar.column_options for the given regclass, ordered by attribute number.
+ */
+List *
+ReadColumnarColumnOptions(Oid regclass)
+{
+	List *columnOptionsList = NIL;
+
+	Relation columnOptions = try_relation_open(ColumnarColumnOptionsRelationId(),
+											   AccessShareLock);
+	if (columnOptions == NULL)
+	{
+		/* extension has been dropped, or catalog is not upgraded yet */
+		return NIL;
+	}
+
+	ScanKeyData scanKey[1];
+	ScanKeyInit(&scanKey[0], Anum_columnar_column_options_regclass,
+				BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(regclass));
+
+	Relation index = index_open(ColumnarColumnOptionsIndexRegclass(), AccessShareLock);
+	SysScanDesc scanDescriptor = systable_beginscan_ordered(columnOptions, index, NULL,
+															1, scanKey);
+	TupleDesc tupleDescriptor = RelationGetDescr(columnOptions);
+
+	HeapTuple heapTuple = NULL;
+	while (HeapTupleIsValid(heapTuple = systable_getnext_ordered(scanDescriptor,
+																 ForwardScanDirection)))
+	{
+		Datum datumArray[Natts_columnar_column_options];
+		bool isNullArray[Natts_columnar_column_options];
+
+		heap_deform_tuple(heapTuple, tupleDescriptor, datumArray, isNullArray);
+
+		ColumnarColumnOptions *columnOption = palloc0(sizeof(ColumnarColumnOptions));
+		columnOption->attrNum =
+			DatumGetInt32(datumArray[Anum_columnar_column_options_attr_num - 1]);
+
+		columnOption->compressionType = COMPRESSION_TYPE_INVALID;
+		if (!isNullArray[Anum_columnar_column_options_compression - 1])
+		{
+			Name compressionName =
+				DatumGetName(datumArray[Anum_columnar_column_options_compression - 1]);
+			columnOption->compressionType =
+				ParseCompressionType(NameStr(*compressionName));
+		}
+
+		columnOption->compressionLevel = COLUMN_COMPRESSION_LEVEL_INHERIT;
+		if (!isNullArray[Anum_columnar_column_options_compression_level - 1])
+		{
+			columnOption->compressionLevel = DatumGetInt32(
+				datumArray[Anum_columnar_column_options_compression_level - 1]);
+		}
+
+		columnOption->bloomFilter =
+			DatumGetBool(datumArray[Anum_columnar_column_options_bloom_filter - 1]);
+
+		columnOptionsList = lappend(columnOptionsList, columnOption);
+	}
+
+	systable_endscan_ordered(scanDescriptor);
+	index_close(index, AccessShareLock);
+	relation_close(columnOptions, AccessShareLock);
+
+	return columnOptionsList;
+}
+
+
+/*
+ * SetColumnarColumnOptions writes the compression overrides and the bloom filter
+ * setting of a single column to columnar.column_options. When neither the
+ * compression type nor the level is overridden anymore and the column has no
+ * bloom filter the record is removed, so the column follows the table wide
+ * settings again.
+ */
+void
+SetColumnarColumnOptions(Oid regclass, ColumnarColumnOptions *columnOptions)
+{
+	Assert(!IsBinaryUpgrade);
+
+	bool inherit = columnOptions->compressionType == COMPRESSION_TYPE_INVALID &&
+				   columnOptions->compressionLevel == COLUMN_COMPRESSION_LEVEL_INHERIT &&
+				   !columnOptions->bloomFilter;
+
+	bool nulls[Natts_columnar_column_options] = { 0 };
+	Datum values[Natts_columnar_column_options] = {
+		ObjectIdGetDatum(regclass),
+		Int32GetDatum(columnOptions->attrNum),
+		Int32GetDatum(columnOptions->compressionLevel),
+		0, /* to be filled below */
+		BoolGetDatum(columnOptions->bloomFilter)
+	};
+
+	NameData compressionName = { 0 };
+	if (columnOptions->compressionType != COMPRESSION_TYPE_INVALID)
+	{
+		namestrcpy(&compressionName, CompressionTypeStr(columnOptions->compressionType));
+		values[Anum_columnar_column_options_compression - 1] =
+			NameGetDatum(&compressionName);
+	}
+	else
+	{
+		nulls[Anum_columnar_column_options_compression - 1] = true;
+	}
+
+	if (columnOptions->compressionLevel == COLUMN_COMPRESSION_LEVEL_INHERIT)
+	{
+		nulls[Anum_columnar_column_options_compression_level - 1] = true;
+	}
+
+	Relation columnOptionsRel = relation_open(ColumnarColumnOptionsRelationId(),
+											  RowExclusiveLock);
+	TupleDesc tupleDescriptor = RelationGetDescr(columnOptionsRel);
+
+	/* find existing item to perform update if exist */
+	ScanKeyData scanKey[2];
+	ScanKeyInit(&scanKey[0], Anum_columnar_column_options_regclass,
+				BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(regclass));
+	ScanKeyInit(&scanKey[1], Anum_columnar_column_options_attr_num,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(columnOptions->attrNum));
+
+	Relation index = index_open(ColumnarColumnOptionsIndexRegclass(), AccessShareLock);
+	SysScanDesc scanDescriptor = systable_beginscan_ordered(columnOptionsRel, index,
+															NULL, 2, scanKey);
+
+	HeapTuple heapTuple = systable_getnext_ordered(scanDescriptor, ForwardScanDirection);
+	if (HeapTupleIsValid(heapTuple))
+	{
+		if (inherit)
+		{
+			CatalogTupleDelete(columnOptionsRel, &heapTuple->t_self);
+		}
+		else
+		{
+			bool update[Natts_columnar_column_options] = { 0 };
+			update[Anum_columnar_column_options_compression_level - 1] = true;
+			update[Anum_columnar_column_options_compression - 1] = true;
+			update[Anum_columnar_column_options_bloom_filter - 1] = true;
+
+			HeapTuple tuple = heap_modify_tuple(heapTuple, tupleDescriptor,
+												values, nulls, update);
+			CatalogTupleUpdate(columnOptionsRel, &tuple->t_self, tuple);
+		}
+	}
+	else if (!inherit)
+	{
+		HeapTuple newTuple = heap_form_tuple(tupleDescriptor, values, nulls);
+		CatalogTupleInsert(columnOptionsRel, newTuple);
+	}
+
+	CommandCounterIncrement();
+
+	systable_endscan_ordered(scanDescriptor);
+	index_close(index, AccessShareLock);
+	relation_close(columnOptionsRel, RowExclusiveLock);
+}
+
+
+/*
+ * DeleteColumnarColumnOptions removes all per-column options of a regclass.
+ */
+static void
+DeleteColumnarColumnOptions(Oid regclass)
+{
+	Relation columnOptions = try_relation_open(ColumnarColumnOptionsRelationId(),
+											   RowExclusiveLock);
+	if (columnOptions == NULL)
+	{
+		/* extension has been dropped */
+		return;
+	}
+
+	ScanKeyData scanKey[1];
+	ScanKeyInit(&scanKey[0], Anum_columnar_column_options_regclass,
+				BTEqualStrategyNumber, F_OIDEQ, ObjectIdGetDatum(regclass));
+
+	Relation index = index_open(ColumnarColumnOptionsIndexRegclass(), AccessShareLock);
+	SysScanDesc scanDescriptor = systable_beginscan_ordered(columnOptions, index, NULL,
+															1, scanKey);
+
+	bool deleted = false;
+	HeapTuple heapTuple = NULL;
+	while (HeapTupleIsValid(heapTuple = systable_getnext_ordered(scanDescriptor,
+																 ForwardScanDirection)))
+	{
+		CatalogTupleDelete(columnOptions, &heapTuple->t_self);
+		deleted = true;
+	}
+
+	if (deleted)
+	{
+		CommandCounterIncrement();
+	}
+
+	systable_endscan_ordered(scanDescriptor);
+	index_close(index, AccessShareLock);
+	relation_close(columnOptions, RowExclusiveLock);
+}
+
+
 /*
  * SaveStripeSkipList saves chunkList for a given stripe as rows
  * of columnar.chunk.
@@ -504,7 +745,9 @@ SaveStripeSkipList(RelFileLocator relfilelocator, uint64 stripe, StripeSkipList
 				Int32GetDatum(chunk->valueCompressionType),
 				Int32GetDatum(chunk->valueCompressionLevel),
 				Int64GetDatum(chunk->decompressedValueSize),
-				Int64GetDatum(chunk->rowCount)
+				Int64GetDatum(chunk->rowCount),
+				Int32GetDatum(chunk->valueEncodingType),
+				0  /* to be filled below */
 			};
 
 			bool nulls[Natts_columnar_chunk] = { false };
@@ -524,6 +767,16 @@ SaveStripeSkipList(RelFileLocator relfilelocator, uint64 stripe, StripeSkipList
 				nulls[Anum_columnar_chunk_maximum_value - 1] = true;
 			}
 
+			if (chunk->bloomFilter != NULL)
+			{
+				values[Anum_columnar_chunk_bloom_filter - 1] =
+					PointerGetDatum(chunk->bloomFilter);
+			}
+			else
+			{
+				nulls[Anum_columnar_chunk_bloom_filter - 1] = true;
+			}
+
 			InsertTupleAndEnforceConstraints(modifyState, values, nulls);
 		}
 	}
@@ -570,6 +823,57 @@ SaveChunkGroups(RelFileLocator relfilelocator, uint64 stripe,
 }
 
 
+/*
+ * SaveStripeZoneMap saves the per column zone maps of a stripe as rows of
+ * columnar.stripe_zone_map.
+ */
+void
+SaveStripeZoneMap(RelFileLocator relfilelocator, uint64 stripe,
+				  ColumnZoneMap *columnZoneMapArray, TupleDesc tupleDescriptor)
+{
+	uint64 storageId = LookupStorageId(relfilelocator);
+	Relation stripeZoneMap = table_open(ColumnarStripeZoneMapRelationId(),
+										RowExclusiveLock);
+	ModifyState *modifyState = StartModifyRelation(stripeZoneMap);
+
+	for (int columnIndex = 0; columnIndex < tupleDescriptor->natts; columnIndex++)
+	{
+		ColumnZoneMap *columnZoneMap = &columnZoneMapArray[columnIndex];
+
+		Datum values[Natts_columnar_stripe_zone_map] = {
+			UInt64GetDatum(storageId),
+			Int64GetDatum(stripe),
+			Int32GetDatum(columnIndex + 1),
+			0, /* to be filled below */
+			0, /* to be filled below */
+			Int64GetDatum(columnZoneMap->nullCount)
+		};
+
+		bool nulls[Natts_columnar_stripe_zone_map] = { false };
+
+		if (columnZoneMap->hasMinMax)
+		{
+			values[Anum_columnar_stripe_zone_map_minimum_value - 1] =
+				PointerGetDatum(DatumToBytea(columnZoneMap->minimumValue,
+											 &tupleDescriptor->attrs[columnIndex]));
+			values[Anum_columnar_stripe_zone_map_maximum_value - 1] =
+				PointerGetDatum(DatumToBytea(columnZoneMap->maximumValue,
+											 &tupleDescriptor->attrs[columnIndex]));
+		}
+		else
+		{
+			nulls[Anum_columnar_stripe_zone_map_minimum_value - 1] = true;
+			nulls[Anum_columnar_stripe_zone_map_maximum_value - 1] = true;
+		}
+
+		InsertTupleAndEnforceConstraints(modifyState, values, nulls);
+	}
+
+	FinishModifyRelation(modifyState);
+	table_close(stripeZoneMap, RowExclusiveLock);
+}
+
+
 /*
  * SaveEmptyRowMask saves the metadata for inserted rows in columnar.mask_row
  */
@@ -758,6 +1062,8 @@ ReadStripeSkipList(RelFileLocator relfilelocator, uint64 stripe, TupleDesc tuple
 			DatumGetInt32(datumArray[Anum_columnar_chunk_value_compression_level - 1]);
 		chunk->decompressedValueSize =
 			DatumGetInt64(datumArray[Anum_columnar_chunk_value_decompressed_size - 1]);
+		chunk->valueEncodingType =
+			DatumGetInt32(datumArray[Anum_columnar_chunk_value_encoding_type - 1]);
 
 		if (isNullArray[Anum_columnar_chunk_minimum_value - 1] ||
 			isNullArray[Anum_columnar_chunk_maximum_value - 1])
@@ -778,6 +1084,12 @@ ReadStripeSkipList(RelFileLocator relfilelocator, uint64 stripe, TupleDesc tuple
 
 			chunk->hasMinMax = true;
 		}
+
+		if (!isNullArray[Anum_columnar_chunk_bloom_filter - 1])
+		{
+			chunk->bloomFilter =
+				DatumGetByteaPCopy(datumArray[Anum_columnar_chunk_bloom_filter - 1]);
+		}
 	}
 
 	systable_endscan_ordered(scanDescriptor);
@@ -801,6 +1113,109 @@ ReadStripeSkipList(RelFileLocator relfilelocator, uint64 stripe, TupleDesc tuple
 }
 
 
+/*
+ * ReadStripeZoneMaps reads the zone maps of all stripes of the given storage into
+ * a hash table of StripeZoneMap entries keyed by stripe id. Only the zone maps
+ * of the columns with a zoneMapIndexArray entry other than -1 are read, into
+ * that slot of the entries' zoneMapCount long columnZoneMapArray. Columns a
+ * stripe has no zone map for are left with exists set to false. Stripes
+ * written before zone maps were maintained have no entry.
+ */
+HTAB *
+ReadStripeZoneMaps(RelFileLocator relfilelocator, TupleDesc tupleDescriptor,
+				   int *zoneMapIndexArray, int zoneMapCount, Snapshot snapshot)
+{
+	uint32 columnCount = tupleDescriptor->natts;
+
+	HASHCTL info;
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(uint64);
+	info.entrysize = sizeof(StripeZoneMap);
+	info.hcxt = CurrentMemoryContext;
+
+	HTAB *stripeZoneMaps = hash_create("columnar stripe zone maps", 64, &info,
+									   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	Relation stripeZoneMap = try_relation_open(ColumnarStripeZoneMapRelationId(),
+											   AccessShareLock);
+	if (stripeZoneMap == NULL)
+	{
+		/* extension has been dropped, or catalog is not upgraded yet */
+		return stripeZoneMaps;
+	}
+
+	uint64 storageId = LookupStorageId(relfilelocator);
+
+	ScanKeyData scanKey[1];
+	ScanKeyInit(&scanKey[0], Anum_columnar_stripe_zone_map_storage_id,
+				BTEqualStrategyNumber, F_INT8EQ, UInt64GetDatum(storageId));
+
+	Relation index = index_open(ColumnarStripeZoneMapIndexRelationId(),
+								AccessShareLock);
+	SysScanDesc scanDescriptor = systable_beginscan_ordered(stripeZoneMap, index,
+															snapshot, 1, scanKey);
+
+	HeapTuple heapTuple = NULL;
+	while (HeapTupleIsValid(heapTuple = systable_getnext_ordered(scanDescriptor,
+																 ForwardScanDirection)))
+	{
+		Datum datumArray[Natts_columnar_stripe_zone_map];
+		bool isNullArray[Natts_columnar_stripe_zone_map];
+
+		heap_deform_tuple(heapTuple, RelationGetDescr(stripeZoneMap), datumArray,
+						  isNullArray);
+
+		uint64 stripeId =
+			DatumGetInt64(datumArray[Anum_columnar_stripe_zone_map_stripe_num - 1]);
+		int32 attr =
+			DatumGetInt32(datumArray[Anum_columnar_stripe_zone_map_attr_num - 1]);
+
+		/* columns might have been added to the table after the stripe was written */
+		if (attr <= 0 || attr > columnCount || zoneMapIndexArray[attr - 1] < 0)
+		{
+			continue;
+		}
+
+		bool found = false;
+		StripeZoneMap *stripeEntry = hash_search(stripeZoneMaps, &stripeId,
+												 HASH_ENTER, &found);
+		if (!found)
+		{
+			stripeEntry->columnZoneMapArray =
+				palloc0(zoneMapCount * sizeof(ColumnZoneMap));
+		}
+
+		int columnIndex = attr - 1;
+		ColumnZoneMap *columnZoneMap =
+			&stripeEntry->columnZoneMapArray[zoneMapIndexArray[columnIndex]];
+		columnZoneMap->exists = true;
+		columnZoneMap->nullCount =
+			DatumGetInt64(datumArray[Anum_columnar_stripe_zone_map_null_count - 1]);
+
+		if (!isNullArray[Anum_columnar_stripe_zone_map_minimum_value - 1] &&
+			!isNullArray[Anum_columnar_stripe_zone_map_maximum_value - 1])
+		{
+			bytea *minValue = DatumGetByteaP(
+				datumArray[Anum_columnar_stripe_zone_map_minimum_value - 1]);
+			bytea *maxValue = DatumGetByteaP(
+				datumArray[Anum_columnar_stripe_zone_map_maximum_value - 1]);
+
+			columnZoneMap->minimumValue =
+				ByteaToDatum(minValue, &tupleDescriptor->attrs[columnIndex]);
+			columnZoneMap->maximumValue =
+				ByteaToDatum(maxValue, &tupleDescriptor->attrs[columnIndex]);
+			columnZoneMap->hasMinMax = true;
+		}
+	}
+
+	systable_endscan_ordered(scanDescriptor);
+	index_close(index, AccessShareLock);
+	table_close(stripeZoneMap, AccessShareLock);
+
+	return stripeZoneMaps;
+}
+
+
 /*
  * ReadChunkRowMask fetches chunk row mask for columnar relation.
  */
@@ -1901,6 +2316,8 @@ DeleteMetadataRows(RelFileLocator relfilelocator)
 
 	uint64 storageId = LookupStorageId(relfilelocator);
 
+	ColumnarInvalidateCompressedCache(storageId);
+
 	DeleteStorageFromColumnarMetadataTable(ColumnarStripeRelationId(),
 										   Anum_columnar_stripe_storageid,
 										   ColumnarStripePKeyIndexRelationId(),
@@ -1913,10 +2330,128 @@ DeleteMetadataRows(RelFileLocator relfilelocator)
 										   Anum_columnar_chunk_storageid,
 										   ColumnarChunkIndexRelationId(),
 										   storageId);
+	DeleteStorageFromColumnarMetadataTable(ColumnarStripeZoneMapRelationId(),
+										   Anum_columnar_stripe_zone_map_storage_id,
+										   ColumnarStripeZoneMapIndexRelationId(),
+										   storageId);
 	DeleteStorageFromColumnarMetadataTable(ColumnarRowMaskRelationId(),
 										   Anum_columnar_row_mask_storage_id,
 										   ColumnarRowMaskIndexRelationId(),
 										   storageId);
+	DeleteStorageFromColumnarMetadataTable(ColumnarZstdDictionaryRelationId(),
+										   Anum_columnar_zstd_dictionary_storage_id,
+										   ColumnarZstdDictionaryIndexRelationId(),
+										   storageId);
+}
+
+
+/*
+ * ReadZstdDictionaries returns the zstd dictionaries (ZstdDictionary) trained for
+ * the columns of the given storage, ordered by attribute number and, for each
+ * column, from the oldest to the newest dictionary.
+ */
+List *
+ReadZstdDictionaries(uint64 storageId)
+{
+	List *dictionaryList = NIL;
+
+	Relation zstdDictionary = try_relation_open(ColumnarZstdDictionaryRelationId(),
+												AccessShareLock);
+	if (zstdDictionary == NULL)
+	{
+		/* extension has been dropped, or catalog is not upgraded yet */
+		return NIL;
+	}
+
+	ScanKeyData scanKey[1];
+	ScanKeyInit(&scanKey[0], Anum_columnar_zstd_dictionary_storage_id,
+				BTEqualStrategyNumber, F_INT8EQ, UInt64GetDatum(storageId));
+
+	Relation index = index_open(ColumnarZstdDictionaryIndexRelationId(),
+								AccessShareLock);
+	SysScanDesc scanDescriptor = systable_beginscan_ordered(zstdDictionary, index, NULL,
+															1, scanKey);
+
+	HeapTuple heapTuple = NULL;
+	while (HeapTupleIsValid(heapTuple = systable_getnext_ordered(scanDescriptor,
+																 ForwardScanDirection)))
+	{
+		Datum datumArray[Natts_columnar_zstd_dictionary];
+		bool isNullArray[Natts_columnar_zstd_dictionary];
+
+		heap_deform_tuple(heapTuple, RelationGetDescr(zstdDictionary), datumArray,
+						  isNullArray);
+
+		int32 attrNum =
+			DatumGetInt32(datumArray[Anum_columnar_zstd_dictionary_attr_num - 1]);
+		bytea *dictionaryData = DatumGetByteaPCopy(
+			datumArray[Anum_columnar_zstd_dictionary_dictionary - 1]);
+
+		dictionaryList = lappend(dictionaryList,
+								 CreateZstdDictionary(attrNum, dictionaryData));
+	}
+
+	systable_endscan_ordered(scanDescriptor);
+	index_close(index, AccessShareLock);
+	table_close(zstdDictionary, AccessShareLock);
+
+	return dictionaryList;
+}
+
+
+/*
+ * SaveZstdDictionary stores a newly trained zstd dictionary for a column of the
+ * given storage. It becomes the newest dictionary of the column, older ones are
+ * kept as long as the storage exists since chunks may still refer to them.
+ */
+void
+SaveZstdDictionary(uint64 storageId, ZstdDictionary *dictionary)
+{
+	int32 version = 1;
+
+	Relation zstdDictionary = table_open(ColumnarZstdDictionaryRelationId(),
+										 RowExclusiveLock);
+
+	/* find the newest version of the column's dictionary */
+	ScanKeyData scanKey[2];
+	ScanKeyInit(&scanKey[0], Anum_columnar_zstd_dictionary_storage_id,
+				BTEqualStrategyNumber, F_INT8EQ, UInt64GetDatum(storageId));
+	ScanKeyInit(&scanKey[1], Anum_columnar_zstd_dictionary_attr_num,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(dictionary->attrNum));
+
+	Relation index = index_open(ColumnarZstdDictionaryIndexRelationId(),
+								AccessShareLock);
+	SysScanDesc scanDescriptor = systable_beginscan_ordered(zstdDictionary, index, NULL,
+															2, scanKey);
+
+	HeapTuple heapTuple = systable_getnext_ordered(scanDescriptor,
+												   BackwardScanDirection);
+	if (HeapTupleIsValid(heapTuple))
+	{
+		bool isNull = false;
+		Datum versionDatum = heap_getattr(heapTuple,
+										  Anum_columnar_zstd_dictionary_version,
+										  RelationGetDescr(zstdDictionary), &isNull);
+		version = DatumGetInt32(versionDatum) + 1;
+	}
+
+	systable_endscan_ordered(scanDescriptor);
+	index_close(index, AccessShareLock);
+
+	Datum values[Natts_columnar_zstd_dictionary] = {
+		UInt64GetDatum(storageId),
+		Int32GetDatum(dictionary->attrNum),
+		Int32GetDatum(version),
+		Int64GetDatum(dictionary->dictionaryId),
+		PointerGetDatum(dictionary->dictionaryData)
+	};
+	bool nulls[Natts_columnar_zstd_dictionary] = { false };
+
+	ModifyState *modifyState = StartModifyRelation(zstdDictionary);
+	InsertTupleAndEnforceConstraints(modifyState, values, nulls);
+	FinishModifyRelation(modifyState);
+
+	table_close(zstdDictionary, RowExclusiveLock);
 }
 
 
@@ -1938,6 +2473,8 @@ DeleteMetadataRowsForStripeId(RelFileLocator relfilelocator, uint64 stripeId)
 
 	uint64 storageId = LookupStorageId(relfilelocator);
 
+	ColumnarInvalidateCompressedCacheStripe(storageId, stripeId);
+
 	DeleteStripeFromColumnarMetadataTable(
 		ColumnarStripeRelationId(),
 		Anum_columnar_stripe_storageid,
@@ -1956,6 +2493,12 @@ DeleteMetadataRowsForStripeId(RelFileLocator relfilelocator, uint64 stripeId)
 		Anum_columnar_chunk_stripe,
 		ColumnarChunkIndexRelationId(),
 		storageId, stripeId);
+	DeleteStripeFromColumnarMetadataTable(
+		ColumnarStripeZoneMapRelationId(),
+		Anum_columnar_stripe_zone_map_storage_id,
+		Anum_columnar_stripe_zone_map_stripe_num,
+		ColumnarStripeZoneMapIndexRelationId(),
+		storageId, stripeId);
 	DeleteStripeFromColumnarMetadataTable(
 		ColumnarRowMaskRelationId(),
 		Anum_columnar_row_mask_storage_id,
@@ -2317,6 +2860,48 @@ ColumnarOptionsIndexRegclass(void)
 }
 
 
+/*
+ * ColumnarColumnOptionsRelationId returns relation id of columnar.column_options.
+ */
+static Oid
+ColumnarColumnOptionsRelationId(void)
+{
+	return get_relname_relid("column_options", ColumnarNamespaceId());
+}
+
+
+/*
+ * ColumnarColumnOptionsIndexRegclass returns relation id of
+ * columnar.column_options_pkey.
+ */
+static Oid
+ColumnarColumnOptionsIndexRegclass(void)
+{
+	return get_relname_relid("column_options_pkey", ColumnarNamespaceId());
+}
+
+
+/*
+ * ColumnarZstdDictionaryRelationId returns relation id of columnar.zstd_dictionary.
+ */
+static Oid
+ColumnarZstdDictionaryRelationId(void)
+{
+	return get_relname_relid("zstd_dictionary", ColumnarNamespaceId());
+}
+
+
+/*
+ * ColumnarZstdDictionaryIndexRelationId returns relation id of
+ * columnar.zstd_dictionary_pkey.
+ */
+static Oid
+ColumnarZstdDictionaryIndexRelationId(void)
+{
+	return get_relname_relid("zstd_dictionary_pkey", ColumnarNamespaceId());
+}
+
+
 /*
  * ColumnarChunkRelationId returns relation id of columnar.chunk.
  * TODO: should we cache this similar to citus?
@@ -2339,6 +2924,27 @@ ColumnarChunkGroupRelationId(void)
 }
 
 
+/*
+ * ColumnarStripeZoneMapRelationId returns relation id of columnar.stripe_zone_map.
+ */
+static Oid
+ColumnarStripeZoneMapRelationId(void)
+{
+	return get_relname_relid("stripe_zone_map", ColumnarNamespaceId());
+}
+
+
+/*
+ * ColumnarStripeZoneMapIndexRelationId returns relation id of
+ * columnar.stripe_zone_map_pkey.
+ */
+static Oid
+ColumnarStripeZoneMapIndexRelationId(void)
+{
+	return get_relname_relid("stripe_zone_map_pkey", ColumnarNamespaceId());
+}
+
+
 /*
  * ColumnarRowMaskRelationId returns relation id of columnar.row_mask.
  */
@@ -219,9 +219,21 @@ PlanTreeMutator(Plan *node, void *context)
 			if (!columnar_enable_vectorization)
 				return node;
 
-			if (aggNode->plan.lefttree->type == T_CustomScan)
+			Plan *inputPlan = aggNode->plan.lefttree;
+
+			/*
+			 * Sorted grouping also reads the rows of a Sort over the scan, and
+			 * packs them into vectors itself.
+			 */
+			if (aggNode->aggstrategy == AGG_SORTED && IsA(inputPlan, Sort))
+				inputPlan = inputPlan->lefttree;
+
+			if (inputPlan->type == T_CustomScan)
 			{
-				if (aggNode->aggstrategy == AGG_PLAIN)
+				/* grouping is vectorized for a single grouping set */
+				if (aggNode->aggstrategy == AGG_PLAIN ||
+					(aggNode->aggstrategy == AGG_HASHED && aggNode->chain == NIL) ||
+					(aggNode->aggstrategy == AGG_SORTED && aggNode->groupingSets == NIL))
 				{
 					vectorizedAggNode = columnar_create_aggregator_node();
 
@@ -229,6 +241,8 @@ PlanTreeMutator(Plan *node, void *context)
 
 					newAgg->plan.targetlist = 
 						(List *) expression_tree_mutator((Node *) newAgg->plan.targetlist, ExpressionMutator, NULL);
+					newAgg->plan.qual =
+						(List *) expression_tree_mutator((Node *) newAgg->plan.qual, ExpressionMutator, NULL);
 
 
 					vectorizedAggNode->custom_plans = 
@@ -246,8 +260,9 @@ PlanTreeMutator(Plan *node, void *context)
 					vectorizedAggNodePlan->plan_width = aggNode->plan.plan_width;
 
 
+					/* a Sort below the aggregate needs rows from the scan */
 					PlanTreeMutatorContext *planTreeContext = (PlanTreeMutatorContext *) context;
-					planTreeContext->vectorizedAggregation = true;
+					planTreeContext->vectorizedAggregation = inputPlan == aggNode->plan.lefttree;
 
 					PlanTreeMutator(node->lefttree, context);
 					PlanTreeMutator(node->righttree, context);
@@ -0,0 +1,730 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_prewarm.c
+ *
+ * Loading of chunks into the shared column cache ahead of the queries that
+ * read them. columnar.prewarm loads the chunks of chosen columns and stripes
+ * of a table. With columnar.enable_cache_warm_set, a background worker also
+ * records the chunks in the cache to a file, every
+ * columnar.cache_warm_set_interval and at shutdown, and loads them back after
+ * a restart, so that the cache doesn't start out cold.
+ *
+ * The file records chunks by database and storage id. At startup the warm set
+ * worker starts a loader worker for each database in the file, which maps the
+ * storage ids back to the columnar tables of its database and loads their
+ * chunks.
+ *
+ * Copyright (c) Hydra, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <unistd.h>
+
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/relation.h"
+#include "access/table.h"
+#include "access/tableam.h"
+#include "access/xact.h"
+#include "catalog/objectaddress.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_type.h"
+#include "commands/dbcommands.h"
+#include "commands/defrem.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "tcop/tcopprot.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/snapmgr.h"
+
+#include "pg_version_compat.h"
+
+#include "columnar/columnar.h"
+#include "columnar/columnar_metadata.h"
+#include "columnar/columnar_storage.h"
+#include "columnar/columnar_tableam.h"
+#include "columnar/utils/listutils.h"
+
+#define COLUMNAR_WARM_SET_FILE "columnar_cache_warm_set"
+#define COLUMNAR_WARM_SET_TEMP_FILE COLUMNAR_WARM_SET_FILE ".tmp"
+
+typedef struct StorageIdRelation
+{
+	uint64 storageId;
+	Oid relationId;
+} StorageIdRelation;
+
+PGDLLEXPORT void ColumnarWarmSetWorkerMain(Datum main_arg);
+PGDLLEXPORT void ColumnarWarmSetLoadWorkerMain(Datum main_arg);
+
+static List * PrewarmColumnList(Relation rel, ArrayType *columnArray);
+static int ColumnarCachedChunkCompare(const void *left, const void *right);
+static void ColumnarWarmSetDump(void);
+static ColumnarCachedChunk * ColumnarWarmSetRead(int *chunkCount);
+static void ColumnarWarmSetLoad(void);
+static void ColumnarWarmSetLoadDatabase(Oid databaseId);
+static HTAB * ColumnarRelationsByStorageId(void);
+static uint64 ColumnarWarmSetLoadStripe(Relation rel, List *stripeList,
+										ColumnarCachedChunk *chunkArray,
+										int chunkCount);
+
+
+/*
+ * columnar_prewarm is a UDF exposed in postgres to load the chunks of a
+ * columnar table into the shared column cache, in the spirit of pg_prewarm.
+ * Returns the number of chunks loaded, not counting those already cached.
+ *
+ * sql syntax:
+ *   columnar.prewarm(
+ *        table_name regclass,
+ *        columns text[] DEFAULT NULL,
+ *        since_stripe bigint DEFAULT 0)
+ *
+ * All columns are loaded when columns is NULL, and only stripes whose id is
+ * at least since_stripe are loaded.
+ */
+PG_FUNCTION_INFO_V1(columnar_prewarm);
+Datum
+columnar_prewarm(PG_FUNCTION_ARGS)
+{
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR, (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+						errmsg("table name cannot be NULL")));
+	}
+
+	Oid relationId = PG_GETARG_OID(0);
+	int64 sinceStripe = PG_ARGISNULL(2) ? 0 : PG_GETARG_INT64(2);
+	uint64 firstStripeId = (uint64) Max(sinceStripe, 0);
+
+	if (!ColumnarSharedCacheEnabled())
+	{
+		ereport(ERROR, (errmsg("the column cache is not in shared memory"),
+						errhint("Set columnar.shared_column_cache_size and load "
+								"columnar with shared_preload_libraries.")));
+	}
+
+	Relation rel = table_open(relationId, AccessShareLock);
+	if (!IsColumnarTableAmTable(relationId))
+	{
+		ereport(ERROR, (errmsg("table %s is not a columnar table",
+							   quote_identifier(RelationGetRelationName(rel)))));
+	}
+
+	AclResult aclResult = pg_class_aclcheck(relationId, GetUserId(), ACL_SELECT);
+	if (aclResult != ACLCHECK_OK)
+	{
+		aclcheck_error(aclResult, get_relkind_objtype(rel->rd_rel->relkind),
+					   get_rel_name(relationId));
+	}
+
+	List *columnList = PrewarmColumnList(rel, PG_ARGISNULL(1) ? NULL :
+										 PG_GETARG_ARRAYTYPE_P(1));
+	Snapshot snapshot = GetTransactionSnapshot();
+	uint64 chunkCount = 0;
+
+	StripeMetadata *stripeMetadata =
+		columnList == NIL ? NULL :
+		FindNextStripeByRowNumber(rel, COLUMNAR_INVALID_ROW_NUMBER, snapshot);
+
+	while (stripeMetadata != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (StripeWriteState(stripeMetadata) == STRIPE_WRITE_FLUSHED &&
+			stripeMetadata->id >= firstStripeId)
+		{
+			chunkCount += ColumnarPrewarmStripe(rel, stripeMetadata, columnList, NULL,
+												snapshot);
+		}
+
+		stripeMetadata = FindNextStripeByRowNumber(rel, stripeMetadata->firstRowNumber,
+												   snapshot);
+	}
+
+	table_close(rel, AccessShareLock);
+
+	PG_RETURN_INT64(chunkCount);
+}
+
+
+/*
+ * PrewarmColumnList returns the attribute numbers of the columns with the
+ * given names, or of all columns if columnArray is NULL.
+ */
+static List *
+PrewarmColumnList(Relation rel, ArrayType *columnArray)
+{
+	TupleDesc tupleDescriptor = RelationGetDescr(rel);
+	List *columnList = NIL;
+
+	if (columnArray == NULL)
+	{
+		for (int columnIndex = 0; columnIndex < tupleDescriptor->natts; columnIndex++)
+		{
+			if (!TupleDescAttr(tupleDescriptor, columnIndex)->attisdropped)
+			{
+				columnList = lappend_int(columnList,
+										 AttrOffsetGetAttrNumber(columnIndex));
+			}
+		}
+
+		return columnList;
+	}
+
+	Datum *columnNameArray = NULL;
+	bool *columnNullArray = NULL;
+	int columnNameCount = 0;
+
+	deconstruct_array(columnArray, TEXTOID, -1, false, TYPALIGN_INT,
+					  &columnNameArray, &columnNullArray, &columnNameCount);
+
+	for (int columnNameIndex = 0; columnNameIndex < columnNameCount; columnNameIndex++)
+	{
+		if (columnNullArray[columnNameIndex])
+		{
+			ereport(ERROR, (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+							errmsg("column name cannot be NULL")));
+		}
+
+		char *columnName = TextDatumGetCString(columnNameArray[columnNameIndex]);
+		AttrNumber attrNum = get_attnum(RelationGetRelid(rel), columnName);
+
+		if (attrNum <= 0)
+		{
+			ereport(ERROR, (errcode(ERRCODE_UNDEFINED_COLUMN),
+							errmsg("column \"%s\" of relation \"%s\" does not exist",
+								   columnName, RelationGetRelationName(rel))));
+		}
+
+		columnList = list_append_unique_int(columnList, attrNum);
+	}
+
+	return columnList;
+}
+
+
+/*
+ * ColumnarWarmSetInit registers the warm set worker. It must be called from
+ * _PG_init, and does nothing unless columnar is being loaded with
+ * shared_preload_libraries, the shared column cache is configured and
+ * columnar.enable_cache_warm_set is on.
+ */
+void
+ColumnarWarmSetInit(void)
+{
+	if (!process_shared_preload_libraries_in_progress ||
+		columnar_shared_column_cache_size == 0 ||
+		!columnar_enable_cache_warm_set)
+	{
+		return;
+	}
+
+	BackgroundWorker worker;
+	memset(&worker, 0, sizeof(worker));
+
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_ConsistentState;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	strlcpy(worker.bgw_library_name, "columnar", BGW_MAXLEN);
+	strlcpy(worker.bgw_function_name, "ColumnarWarmSetWorkerMain", BGW_MAXLEN);
+	strlcpy(worker.bgw_name, "columnar cache warm set", BGW_MAXLEN);
+	strlcpy(worker.bgw_type, "columnar cache warm set", BGW_MAXLEN);
+
+	RegisterBackgroundWorker(&worker);
+}
+
+
+/*
+ * ColumnarWarmSetWorkerMain is the main function of the warm set worker. It
+ * loads the warm set recorded before the last shutdown, and then records the
+ * chunks in the cache every columnar.cache_warm_set_interval, and once more
+ * when it is asked to shut down.
+ */
+void
+ColumnarWarmSetWorkerMain(Datum main_arg)
+{
+	pqsignal(SIGTERM, SignalHandlerForShutdownRequest);
+	pqsignal(SIGHUP, SignalHandlerForConfigReload);
+	BackgroundWorkerUnblockSignals();
+
+	ColumnarWarmSetLoad();
+
+	while (!ShutdownRequestPending)
+	{
+		long timeout = (long) columnar_cache_warm_set_interval * 1000L;
+		int waitEvents = WL_LATCH_SET | WL_EXIT_ON_PM_DEATH;
+
+		if (timeout > 0)
+		{
+			waitEvents |= WL_TIMEOUT;
+		}
+
+		int rc = WaitLatch(MyLatch, waitEvents, timeout, PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (ConfigReloadPending)
+		{
+			ConfigReloadPending = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		if (rc & WL_TIMEOUT)
+		{
+			ColumnarWarmSetDump();
+		}
+	}
+
+	ColumnarWarmSetDump();
+
+	proc_exit(0);
+}
+
+
+/*
+ * ColumnarCachedChunkCompare orders chunks by database, storage id, stripe,
+ * chunk group and column.
+ */
+static int
+ColumnarCachedChunkCompare(const void *left, const void *right)
+{
+	const ColumnarCachedChunk *leftChunk = left;
+	const ColumnarCachedChunk *rightChunk = right;
+
+	if (leftChunk->databaseId != rightChunk->databaseId)
+	{
+		return leftChunk->databaseId < rightChunk->databaseId ? -1 : 1;
+	}
+
+	if (leftChunk->storageId != rightChunk->storageId)
+	{
+		return leftChunk->storageId < rightChunk->storageId ? -1 : 1;
+	}
+
+	if (leftChunk->stripeId != rightChunk->stripeId)
+	{
+		return leftChunk->stripeId < rightChunk->stripeId ? -1 : 1;
+	}
+
+	if (leftChunk->chunkId != rightChunk->chunkId)
+	{
+		return leftChunk->chunkId < rightChunk->chunkId ? -1 : 1;
+	}
+
+	if (leftChunk->columnId != rightChunk->columnId)
+	{
+		return leftChunk->columnId < rightChunk->columnId ? -1 : 1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * ColumnarWarmSetDump writes the chunks in the shared column cache to the warm
+ * set file. The file is written under a temporary name and renamed, so that a
+ * crash never leaves a partial warm set behind. Failures are only logged, as
+ * the worker has to keep going.
+ */
+static void
+ColumnarWarmSetDump(void)
+{
+	int chunkCount = 0;
+	ColumnarCachedChunk *chunkArray = ColumnarSharedCacheChunks(&chunkCount);
+
+	qsort(chunkArray, chunkCount, sizeof(ColumnarCachedChunk),
+		  ColumnarCachedChunkCompare);
+
+	FILE *file = AllocateFile(COLUMNAR_WARM_SET_TEMP_FILE, "w");
+	if (file == NULL)
+	{
+		ereport(LOG, (errcode_for_file_access(),
+					  errmsg("could not open file \"%s\": %m",
+							 COLUMNAR_WARM_SET_TEMP_FILE)));
+		pfree(chunkArray);
+		return;
+	}
+
+	fprintf(file, "<<%d>>\n", chunkCount);
+
+	for (int chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	{
+		ColumnarCachedChunk *chunk = &chunkArray[chunkIndex];
+
+		fprintf(file, "%u," UINT64_FORMAT "," UINT64_FORMAT "," UINT64_FORMAT ",%u\n",
+				chunk->databaseId, chunk->storageId, chunk->stripeId, chunk->chunkId,
+				chunk->columnId);
+	}
+
+	pfree(chunkArray);
+
+	if (ferror(file) || FreeFile(file) != 0)
+	{
+		ereport(LOG, (errcode_for_file_access(),
+					  errmsg("could not write file \"%s\": %m",
+							 COLUMNAR_WARM_SET_TEMP_FILE)));
+		unlink(COLUMNAR_WARM_SET_TEMP_FILE);
+		return;
+	}
+
+	(void) durable_rename(COLUMNAR_WARM_SET_TEMP_FILE, COLUMNAR_WARM_SET_FILE, LOG);
+
+	ereport(DEBUG1, (errmsg("recorded %d chunks of the columnar cache", chunkCount)));
+}
+
+
+/*
+ * ColumnarWarmSetRead reads the chunks of the warm set file in a palloc'd
+ * array, and sets chunkCount to their number. It returns NULL if there is no
+ * warm set file, or if it is not valid.
+ */
+static ColumnarCachedChunk *
+ColumnarWarmSetRead(int *chunkCount)
+{
+	*chunkCount = 0;
+
+	FILE *file = AllocateFile(COLUMNAR_WARM_SET_FILE, "r");
+	if (file == NULL)
+	{
+		if (errno != ENOENT)
+		{
+			ereport(LOG, (errcode_for_file_access(),
+						  errmsg("could not read file \"%s\": %m",
+								 COLUMNAR_WARM_SET_FILE)));
+		}
+
+		return NULL;
+	}
+
+	int count = 0;
+	if (fscanf(file, "<<%d>>\n", &count) != 1 || count < 0)
+	{
+		ereport(LOG, (errmsg("invalid columnar cache warm set file \"%s\"",
+							 COLUMNAR_WARM_SET_FILE)));
+		FreeFile(file);
+		return NULL;
+	}
+
+	ColumnarCachedChunk *chunkArray = palloc0(Max(count, 1) *
+											  sizeof(ColumnarCachedChunk));
+
+	for (int chunkIndex = 0; chunkIndex < count; chunkIndex++)
+	{
+		ColumnarCachedChunk *chunk = &chunkArray[chunkIndex];
+
+		if (fscanf(file, "%u," UINT64_FORMAT "," UINT64_FORMAT "," UINT64_FORMAT
+				   ",%u\n", &chunk->databaseId, &chunk->storageId, &chunk->stripeId,
+				   &chunk->chunkId, &chunk->columnId) != 5)
+		{
+			ereport(LOG, (errmsg("invalid columnar cache warm set file \"%s\"",
+								 COLUMNAR_WARM_SET_FILE)));
+			FreeFile(file);
+			pfree(chunkArray);
+			return NULL;
+		}
+	}
+
+	FreeFile(file);
+
+	*chunkCount = count;
+
+	return chunkArray;
+}
+
+
+/*
+ * ColumnarWarmSetLoad loads the warm set file into the cache, one database
+ * after the other.
+ */
+static void
+ColumnarWarmSetLoad(void)
+{
+	int chunkCount = 0;
+	ColumnarCachedChunk *chunkArray = ColumnarWarmSetRead(&chunkCount);
+
+	/* the file is written in database order */
+	for (int chunkIndex = 0; chunkIndex < chunkCount && !ShutdownRequestPending;
+		 chunkIndex++)
+	{
+		if (chunkIndex == 0 ||
+			chunkArray[chunkIndex].databaseId != chunkArray[chunkIndex - 1].databaseId)
+		{
+			ColumnarWarmSetLoadDatabase(chunkArray[chunkIndex].databaseId);
+		}
+	}
+
+	if (chunkArray != NULL)
+	{
+		pfree(chunkArray);
+	}
+}
+
+
+/*
+ * ColumnarWarmSetLoadDatabase starts a loader worker for the chunks of the
+ * given database, and waits for it to finish. Workers connect to a single
+ * database, so each database gets a worker of its own.
+ */
+static void
+ColumnarWarmSetLoadDatabase(Oid databaseId)
+{
+	BackgroundWorker worker;
+	memset(&worker, 0, sizeof(worker));
+
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS | BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_ConsistentState;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	strlcpy(worker.bgw_library_name, "columnar", BGW_MAXLEN);
+	strlcpy(worker.bgw_function_name, "ColumnarWarmSetLoadWorkerMain", BGW_MAXLEN);
+	strlcpy(worker.bgw_name, "columnar cache warm set loader", BGW_MAXLEN);
+	strlcpy(worker.bgw_type, "columnar cache warm set loader", BGW_MAXLEN);
+	worker.bgw_main_arg = ObjectIdGetDatum(databaseId);
+	worker.bgw_notify_pid = MyProcPid;
+
+	BackgroundWorkerHandle *handle = NULL;
+	if (!RegisterDynamicBackgroundWorker(&worker, &handle))
+	{
+		ereport(LOG, (errmsg("could not register a worker to load the columnar "
+							 "cache warm set of database %u", databaseId),
+					  errhint("Consider increasing max_worker_processes.")));
+		return;
+	}
+
+	if (WaitForBackgroundWorkerShutdown(handle) == BGWH_POSTMASTER_DIED)
+	{
+		proc_exit(1);
+	}
+}
+
+
+/*
+ * ColumnarWarmSetLoadWorkerMain is the main function of the loader workers.
+ * It loads the chunks of the warm set file that belong to its database.
+ */
+void
+ColumnarWarmSetLoadWorkerMain(Datum main_arg)
+{
+	Oid databaseId = DatumGetObjectId(main_arg);
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	BackgroundWorkerInitializeConnectionByOid(databaseId, InvalidOid, 0);
+
+	int chunkCount = 0;
+	ColumnarCachedChunk *chunkArray = ColumnarWarmSetRead(&chunkCount);
+
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	HTAB *relationsByStorageId = ColumnarRelationsByStorageId();
+	uint64 loadedCount = 0;
+	int chunkIndex = 0;
+
+	while (chunkIndex < chunkCount)
+	{
+		ColumnarCachedChunk *chunk = &chunkArray[chunkIndex];
+
+		/* the chunks of a table, in stripe order */
+		int storageChunkCount = 1;
+		while (chunkIndex + storageChunkCount < chunkCount &&
+			   chunk[storageChunkCount].databaseId == chunk->databaseId &&
+			   chunk[storageChunkCount].storageId == chunk->storageId)
+		{
+			storageChunkCount++;
+		}
+
+		StorageIdRelation *storageIdRelation = NULL;
+		if (chunk->databaseId == MyDatabaseId)
+		{
+			storageIdRelation = hash_search(relationsByStorageId, &chunk->storageId,
+											HASH_FIND, NULL);
+		}
+
+		Relation rel = NULL;
+		if (storageIdRelation != NULL)
+		{
+			rel = try_relation_open(storageIdRelation->relationId, AccessShareLock);
+		}
+
+		if (rel != NULL)
+		{
+			List *stripeList =
+				StripesForRelfilenode(RelationPhysicalIdentifier_compat(rel),
+									  ForwardScanDirection);
+			int stripeChunkIndex = 0;
+
+			while (stripeChunkIndex < storageChunkCount)
+			{
+				int stripeChunkCount = 1;
+				while (stripeChunkIndex + stripeChunkCount < storageChunkCount &&
+					   chunk[stripeChunkIndex + stripeChunkCount].stripeId ==
+					   chunk[stripeChunkIndex].stripeId)
+				{
+					stripeChunkCount++;
+				}
+
+				CHECK_FOR_INTERRUPTS();
+
+				loadedCount += ColumnarWarmSetLoadStripe(rel, stripeList,
+														 &chunk[stripeChunkIndex],
+														 stripeChunkCount);
+
+				stripeChunkIndex += stripeChunkCount;
+			}
+
+			relation_close(rel, AccessShareLock);
+		}
+
+		chunkIndex += storageChunkCount;
+	}
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+
+	ereport(LOG, (errmsg("loaded " UINT64_FORMAT " chunks of the columnar cache "
+						 "warm set of database \"%s\"", loadedCount,
+						 get_database_name(MyDatabaseId))));
+
+	proc_exit(0);
+}
+
+
+/*
+ * ColumnarRelationsByStorageId returns a hash table of the columnar tables of
+ * the current database, keyed by storage id.
+ */
+static HTAB *
+ColumnarRelationsByStorageId(void)
+{
+	HASHCTL info;
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(uint64);
+	info.entrysize = sizeof(StorageIdRelation);
+	info.hcxt = CurrentMemoryContext;
+
+	HTAB *relationsByStorageId = hash_create("columnar relations by storage id", 64,
+											 &info,
+											 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	Oid columnarAmOid = get_table_am_oid("columnar", true);
+	List *relationIdList = NIL;
+
+	Relation classRel = table_open(RelationRelationId, AccessShareLock);
+	TableScanDesc scan = table_beginscan_catalog(classRel, 0, NULL);
+	HeapTuple tuple = NULL;
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		Form_pg_class classForm = (Form_pg_class) GETSTRUCT(tuple);
+
+		if (classForm->relam == columnarAmOid &&
+			(classForm->relkind == RELKIND_RELATION ||
+			 classForm->relkind == RELKIND_MATVIEW))
+		{
+			relationIdList = lappend_oid(relationIdList, classForm->oid);
+		}
+	}
+
+	table_endscan(scan);
+	table_close(classRel, AccessShareLock);
+
+	Oid relationId = InvalidOid;
+	foreach_oid(relationId, relationIdList)
+	{
+		Relation rel = try_relation_open(relationId, AccessShareLock);
+		if (rel == NULL)
+		{
+			continue;
+		}
+
+		uint64 storageId = ColumnarStorageGetStorageId(rel, false);
+		StorageIdRelation *storageIdRelation =
+			hash_search(relationsByStorageId, &storageId, HASH_ENTER, NULL);
+		storageIdRelation->relationId = relationId;
+
+		relation_close(rel, AccessShareLock);
+	}
+
+	return relationsByStorageId;
+}
+
+
+/*
+ * ColumnarWarmSetLoadStripe loads the given warm set chunks of a stripe, and
+ * returns the number of chunks loaded. The chunks of all recorded columns are
+ * loaded in all recorded chunk groups of the stripe.
+ */
+static uint64
+ColumnarWarmSetLoadStripe(Relation rel, List *stripeList,
+						  ColumnarCachedChunk *chunkArray, int chunkCount)
+{
+	TupleDesc tupleDescriptor = RelationGetDescr(rel);
+	StripeMetadata *stripeMetadata = NULL;
+	StripeMetadata *candidateMetadata = NULL;
+
+	foreach_ptr(candidateMetadata, stripeList)
+	{
+		if (candidateMetadata->id == chunkArray[0].stripeId)
+		{
+			stripeMetadata = candidateMetadata;
+			break;
+		}
+	}
+
+	if (stripeMetadata == NULL ||
+		StripeWriteState(stripeMetadata) != STRIPE_WRITE_FLUSHED)
+	{
+		return 0;
+	}
+
+	bool *chunkGroupMask = palloc0(stripeMetadata->chunkCount * sizeof(bool));
+	List *columnList = NIL;
+
+	for (int chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	{
+		ColumnarCachedChunk *chunk = &chunkArray[chunkIndex];
+
+		if (chunk->chunkId < stripeMetadata->chunkCount)
+		{
+			chunkGroupMask[chunk->chunkId] = true;
+		}
+
+		if (chunk->columnId < (uint32) tupleDescriptor->natts &&
+			!TupleDescAttr(tupleDescriptor, chunk->columnId)->attisdropped)
+		{
+			columnList = list_append_unique_int(columnList,
+												AttrOffsetGetAttrNumber(chunk->columnId));
+		}
+	}
+
+	uint64 loadedCount = 0;
+
+	if (columnList != NIL)
+	{
+		loadedCount = ColumnarPrewarmStripe(rel, stripeMetadata, columnList,
+											chunkGroupMask, GetActiveSnapshot());
+	}
+
+	pfree(chunkGroupMask);
+	list_free(columnList);
+
+	return loadedCount;
+}
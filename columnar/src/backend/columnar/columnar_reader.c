@@ -19,9 +19,11 @@
 
 #include "safe_lib.h"
 
+#include "access/hash.h"
 #include "access/nbtree.h"
 #include "access/xact.h"
 #include "catalog/pg_am.h"
+#include "catalog/pg_type.h"
 #include "commands/defrem.h"
 #include "storage/smgr.h"
 #include "columnar/utils/listutils.h"
@@ -34,10 +36,13 @@
 #include "utils/guc.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
+#include "utils/array.h"
 #include "utils/palloc.h"
 #include "utils/rel.h"
+#include "utils/spccache.h"
 
 #include "columnar/columnar.h"
+#include "columnar/columnar_bloom_filter.h"
 #include "columnar/columnar_storage.h"
 #include "columnar/columnar_tableam.h"
 #include "columnar/columnar_version_compat.h"
@@ -57,8 +62,26 @@ typedef struct ChunkGroupReadState
 	bool rowMaskCached; /* If rowMask metadata is cached and borrowed */
 	uint32 chunkStripeRowOffset; 
 	uint32 chunkGroupDeletedRows;
+
+	/*
+	 * Row of the chunk group each position of the last vector was read from,
+	 * only kept when some columns are materialized late.
+	 */
+	uint32 *vectorRowIndexArray;
 } ChunkGroupReadState;
 
+/*
+ * ZstdDictionaryCache holds the zstd dictionaries of a relation by column, so
+ * that a scan reads them from the catalog once rather than for every stripe.
+ */
+typedef struct ZstdDictionaryCache
+{
+	MemoryContext context;          /* context the dictionaries live in */
+	bool loaded;
+	int columnCount;
+	List **columnDictionaries;      /* ZstdDictionary lists, by column index */
+} ZstdDictionaryCache;
+
 typedef struct StripeReadState
 {
 	int columnCount;
@@ -72,8 +95,110 @@ typedef struct StripeReadState
 	StripeBuffers *stripeBuffers;   /* allocated in stripeReadContext */
 	List *projectedColumnList;      /* borrowed reference */
 	ChunkGroupReadState *chunkGroupReadState; /* owned */
+
+	/*
+	 * Chunks are only read from storage when their chunk group is read, so
+	 * at most one chunk group's serialized data is in memory at a time.
+	 * selectedChunkSkipList has the chunks of the selected chunk groups, and
+	 * their offsets are relative to stripeFileOffset. Columns at or after
+	 * stripeColumnCount were added after the stripe was written.
+	 */
+	StripeSkipList *selectedChunkSkipList;  /* allocated in stripeReadContext */
+	uint64 stripeFileOffset;
+	uint32 stripeColumnCount;
+	uint32 stripeChunkGroupRowCount;
+
+	/* storage id of the relation, read on first use, 0 until then */
+	uint64 storageId;
+
+	/*
+	 * Sequential reads prefetch the chunks of up to prefetchDistance chunk
+	 * groups past the one being read. prefetchChunkGroupIndex is the first
+	 * chunk group that wasn't prefetched yet.
+	 */
+	int prefetchDistance;
+	int prefetchChunkGroupIndex;
+
+	/* zstd dictionaries of the relation, borrowed from the scan */
+	ZstdDictionaryCache *zstdDictionaryCache;
 } StripeReadState;
 
+/*
+ * BloomFilterProbe holds the hashes of the constants an equality or IN qual
+ * compares a column with. A chunk whose bloom filter contains none of them has
+ * no rows matching the qual.
+ */
+typedef struct BloomFilterProbe
+{
+	uint32 columnIndex;
+	int hashCount;
+	uint32 *hashArray;
+} BloomFilterProbe;
+
+/*
+ * ColumnIntervalComparison tells how the bounds of a ColumnInterval are compared
+ * with min/max values. Integer and date/time columns that are compared with
+ * values of their own type are compared inline, other columns with the btree
+ * comparison function of the operator family.
+ */
+typedef enum ColumnIntervalComparison
+{
+	COLUMN_INTERVAL_COMPARE_INT16,
+	COLUMN_INTERVAL_COMPARE_INT32,
+	COLUMN_INTERVAL_COMPARE_INT64,
+	COLUMN_INTERVAL_COMPARE_FUNCTION
+} ColumnIntervalComparison;
+
+/*
+ * ColumnInterval is the range of values of a column that the compiled quals on
+ * it accept, and the IN lists the values must appear in. All quals comparing
+ * the column with values of the same type and collation are merged into a
+ * single interval.
+ */
+typedef struct ColumnInterval
+{
+	uint32 columnIndex;
+	Oid valueType;
+	Oid collation;
+
+	ColumnIntervalComparison comparison;
+	FmgrInfo comparisonFunction;        /* column value vs. bound value */
+	FmgrInfo valueComparisonFunction;   /* bound value vs. bound value */
+
+	bool hasLowerBound;
+	bool lowerBoundInclusive;
+	Datum lowerBound;
+
+	bool hasUpperBound;
+	bool upperBoundInclusive;
+	Datum upperBound;
+
+	/* sorted values of "column = ANY(array)" quals (ColumnIntervalInList) */
+	List *inListList;
+} ColumnInterval;
+
+typedef struct ColumnIntervalInList
+{
+	int valueCount;
+	Datum *valueArray;
+} ColumnIntervalInList;
+
+/*
+ * ChunkRefutationProgram is what the pushed down quals are compiled to once per
+ * scan. Chunks and stripes are refuted by comparing their min/max values with
+ * the column intervals directly, and only the quals that can't be expressed as
+ * intervals go through predicate_refuted_by().
+ */
+typedef struct ChunkRefutationProgram
+{
+	List *intervalList;
+	List *fallbackClauseList;
+	List *fallbackClauseVars;
+
+	/* probes of the quals that bloom filters can refute chunks on */
+	List *bloomFilterProbeList;
+} ChunkRefutationProgram;
+
 struct ColumnarReadState
 {
 	TupleDesc tupleDescriptor;
@@ -88,12 +213,37 @@ struct ColumnarReadState
 	 */
 	List *projectedColumnList;
 
+	/*
+	 * When vectors are read with late materialization, filterColumnList holds
+	 * the projected columns the vectorized quals read, and lateColumnList the
+	 * rest. Vectors only get the filter columns, and the late columns are
+	 * filled by ColumnarReadMaterializeVector for the rows that pass the quals.
+	 */
+	List *filterColumnList;
+	List *lateColumnList;
+
 	List *whereClauseList;
 	List *whereClauseVars;
 
+	/* whereClauseList compiled for refuting chunks, allocated in scanContext */
+	ChunkRefutationProgram *chunkRefutationProgram;
+
 	MemoryContext stripeReadContext;
 	int64 chunkGroupsFiltered;
 
+	/*
+	 * Zone maps of the stripes for the columns in whereClauseVars, read on the
+	 * first stripe that is checked against them. zoneMapIndexArray maps the
+	 * columns to their slot in the entries, -1 for the other columns.
+	 * Allocated in scanContext.
+	 */
+	HTAB *stripeZoneMaps;
+	int *zoneMapIndexArray;
+	bool stripeZoneMapsLoaded;
+
+	/* zstd dictionaries of the relation, allocated in scanContext */
+	ZstdDictionaryCache *zstdDictionaryCache;
+
 	/*
 	 * Memory context guaranteed to be not freed during scan so we can
 	 * safely use for any memory allocations regarding ColumnarReadState
@@ -126,10 +276,20 @@ static bool StripeReadInProgress(ColumnarReadState *readState);
 static bool HasUnreadStripe(ColumnarReadState *readState);
 static StripeReadState * BeginStripeRead(StripeMetadata *stripeMetadata, Relation rel,
 										 TupleDesc tupleDesc, List *projectedColumnList,
-										 List *whereClauseList, List *whereClauseVars,
+										 ChunkRefutationProgram *refutationProgram,
+										 ZstdDictionaryCache *zstdDictionaryCache,
 										 MemoryContext stripeReadContext,
 										 Snapshot snapshot);
+static ZstdDictionaryCache * CreateZstdDictionaryCache(MemoryContext context,
+													   int columnCount);
 static void AdvanceStripeRead(ColumnarReadState *readState);
+static StripeMetadata * FindNextStripeToRead(ColumnarReadState *readState,
+											 StripeMetadata *lastStripeMetadata);
+static bool StripeRefutedByZoneMap(ColumnarReadState *readState,
+								   StripeMetadata *stripeMetadata);
+static ColumnZoneMap * StripeColumnZoneMap(ColumnarReadState *readState,
+										   StripeZoneMap *stripeZoneMap,
+										   int columnIndex);
 static bool SnapshotMightSeeUnflushedStripes(Snapshot snapshot);
 static bool ReadStripeNextRow(StripeReadState *stripeReadState, Datum *columnValues,
 							  bool *columnNulls,
@@ -139,27 +299,57 @@ static ChunkGroupReadState * BeginChunkGroupRead(StripeBuffers *stripeBuffers, i
 												 chunkIndex,
 												 TupleDesc tupleDesc,
 												 List *projectedColumnList,
-												 MemoryContext cxt, StripeReadState *state, uint64 stripeId);
+												 MemoryContext cxt, StripeReadState *state, uint64 stripeId,
+												 bool lazyDecode);
 static void EndChunkGroupRead(ChunkGroupReadState *chunkGroupReadState);
 static bool ReadChunkGroupNextRow(ChunkGroupReadState *chunkGroupReadState,
 								  Datum *columnValues,
 								  bool *columnNulls,
 								  int32 *deletedColumnsNumber);
+static ColumnChunkBuffers ** LoadChunkGroupBuffers(StripeReadState *stripeReadState,
+												   uint64 chunkIndex, uint64 stripeId,
+												   bool *columnMask);
+static void FreeChunkBuffers(ColumnChunkBuffers *chunkBuffers);
+static uint64 StripeReadStorageId(StripeReadState *state);
+static uint64 StripeReadChunkGroupId(StripeReadState *state, uint64 chunkIndex);
+static void PrefetchChunkGroups(StripeReadState *stripeReadState, List *columnList);
 static StripeBuffers * LoadFilteredStripeBuffers(Relation relation,
 												 StripeMetadata *stripeMetadata,
 												 TupleDesc tupleDescriptor,
 												 List *projectedColumnList,
-												 List *whereClauseList,
-												 List *whereClauseVars,
+												 ChunkRefutationProgram *refutationProgram,
 												 int64 *chunkGroupsFiltered,
-												 Snapshot snapshot);
+												 Snapshot snapshot,
+												 StripeSkipList **selectedChunkSkipList);
 static ColumnBuffers * LoadColumnBuffers(Relation relation,
 										 ColumnChunkSkipNode *chunkSkipNodeArray,
 										 uint32 chunkCount, uint64 stripeOffset,
 										 Form_pg_attribute attributeForm);
 static bool * SelectedChunkMask(StripeSkipList *stripeSkipList,
-								List *whereClauseList, List *whereClauseVars,
+								ChunkRefutationProgram *refutationProgram,
 								int64 *chunkGroupsFiltered);
+static ChunkRefutationProgram * CompileChunkRefutationProgram(List *whereClauseList,
+															  int natts);
+static void CompileChunkRefutationClauses(ChunkRefutationProgram *program,
+										  Node *clause);
+static bool CompileColumnIntervalClause(ChunkRefutationProgram *program, Node *clause);
+static ColumnInterval * FindOrAddColumnInterval(ChunkRefutationProgram *program,
+												Var *column, Oid opfamily,
+												Oid columnType, Oid valueType,
+												Oid collation);
+static void ColumnIntervalAddLowerBound(ColumnInterval *interval, Datum value,
+										bool inclusive);
+static void ColumnIntervalAddUpperBound(ColumnInterval *interval, Datum value,
+										bool inclusive);
+static void ColumnIntervalAddInList(ColumnInterval *interval, Const *arrayConst);
+static int ColumnIntervalValueCompare(const void *left, const void *right, void *arg);
+static inline int ColumnIntervalCompare(ColumnInterval *interval, FmgrInfo *function,
+										Datum left, Datum right);
+static bool ColumnIntervalRefutesRange(ColumnInterval *interval, Datum minimumValue,
+									   Datum maximumValue);
+static List * BuildBloomFilterProbes(List *probeList, Node *clause);
+static bool BloomFilterRefutesChunk(StripeSkipList *stripeSkipList, uint32 chunkIndex,
+									List *probeList);
 static Node * BuildBaseConstraint(Var *variable);
 static List * GetClauseVars(List *clauses, int natts);
 static OpExpr * MakeOpExpression(Var *variable, int16 strategyNumber);
@@ -176,9 +366,20 @@ static void DeserializeDatumArray(StringInfo datumBuffer, bool *existsArray,
 								  uint32 datumCount, bool datumTypeByValue,
 								  int datumTypeLength, char datumTypeAlign,
 								  Datum *datumArray);
+static StringInfo DecompressValueBuffer(ColumnChunkBuffers *chunkBuffers,
+										int columnIndex, StripeReadState *state);
+static void DeserializeChunkColumnData(ChunkData *chunkData,
+									   ColumnChunkBuffers *chunkBuffers,
+									   uint64 chunkIndex, uint32 columnIndex,
+									   uint32 rowCount, TupleDesc tupleDescriptor,
+									   StripeReadState *state, uint64 stripeId,
+									   bool lazyDecode);
 static ChunkData * DeserializeChunkData(StripeBuffers *stripeBuffers, uint64 chunkIndex,
 										uint32 rowCount, TupleDesc tupleDescriptor,
-										List *projectedColumnList, StripeReadState *state, uint64 stripeId);
+										List *projectedColumnList, StripeReadState *state, uint64 stripeId,
+										bool lazyDecode);
+static inline Datum ChunkDataValue(ChunkData *chunkData, uint32 columnIndex,
+								   uint32 rowIndex);
 static Datum ColumnDefaultValue(TupleConstr *tupleConstraints,
 								Form_pg_attribute attributeForm);
 
@@ -188,7 +389,9 @@ static bool ReadStripeNextVector(StripeReadState *stripeReadState, Datum *column
 								 uint64 stripeId,
 								 Snapshot snapshot,
 								 uint64 *rowNumber,
-								 uint64 stripeFirstRowNumber);
+								 uint64 stripeFirstRowNumber,
+								 List *vectorColumnList,
+								 bool lateMaterialization);
 static bool ReadChunkGroupNextVector(ChunkGroupReadState *chunkGroupReadState, Datum *columnValues,
 									 bool *columnNulls, TupleDesc tupleDesc, 
 									 int32 *columnValueOffset, int *chunkReadRows,
@@ -221,9 +424,20 @@ ColumnarBeginRead(Relation relation, TupleDesc tupleDescriptor,
 	readState->whereClauseList = whereClauseList;
 	readState->whereClauseVars = GetClauseVars(whereClauseList, tupleDescriptor->natts);
 	readState->chunkGroupsFiltered = 0;
+
+	MemoryContext oldContext = MemoryContextSwitchTo(scanContext);
+	readState->chunkRefutationProgram =
+		CompileChunkRefutationProgram(whereClauseList, tupleDescriptor->natts);
+	MemoryContextSwitchTo(oldContext);
+
 	readState->tupleDescriptor = tupleDescriptor;
 	readState->stripeReadContext = stripeReadContext;
 	readState->stripeReadState = NULL;
+	readState->stripeZoneMaps = NULL;
+	readState->zoneMapIndexArray = NULL;
+	readState->stripeZoneMapsLoaded = false;
+	readState->zstdDictionaryCache =
+		CreateZstdDictionaryCache(scanContext, tupleDescriptor->natts);
 	readState->scanContext = scanContext;
 
 	/*
@@ -347,8 +561,8 @@ ColumnarReadNextRow(ColumnarReadState *readState, Datum *columnValues, bool *col
 														 readState->relation,
 														 readState->tupleDescriptor,
 														 readState->projectedColumnList,
-														 readState->whereClauseList,
-														 readState->whereClauseVars,
+														 readState->chunkRefutationProgram,
+														 readState->zstdDictionaryCache,
 														 readState->stripeReadContext,
 														 readState->snapshot);
 		}
@@ -435,15 +649,14 @@ ColumnarReadRowByRowNumber(ColumnarReadState *readState,
 		ColumnarResetRead(readState);
 
 		TupleDesc relationTupleDesc = RelationGetDescr(columnarRelation);
-		List *whereClauseList = NIL;
-		List *whereClauseVars = NIL;
+		ChunkRefutationProgram *refutationProgram = NULL;
 		MemoryContext stripeReadContext = readState->stripeReadContext;
 		readState->stripeReadState = BeginStripeRead(stripeMetadata,
 													 columnarRelation,
 													 relationTupleDesc,
 													 readState->projectedColumnList,
-													 whereClauseList,
-													 whereClauseVars,
+													 refutationProgram,
+													 readState->zstdDictionaryCache,
 													 stripeReadContext,
 													 snapshot);
 
@@ -489,15 +702,14 @@ ColumnarSetStripeReadState(ColumnarReadState *readState,
 		ColumnarResetRead(readState);
 
 		TupleDesc relationTupleDesc = RelationGetDescr(columnarRelation);
-		List *whereClauseList = NIL;
-		List *whereClauseVars = NIL;
+		ChunkRefutationProgram *refutationProgram = NULL;
 		MemoryContext stripeReadContext = readState->stripeReadContext;
 		readState->stripeReadState = BeginStripeRead(stripeMetadata,
 													 columnarRelation,
 													 relationTupleDesc,
 													 readState->projectedColumnList,
-													 whereClauseList,
-													 whereClauseVars,
+													 refutationProgram,
+													 readState->zstdDictionaryCache,
 													 stripeReadContext,
 													 snapshot);
 
@@ -578,7 +790,8 @@ ReadStripeRowByRowNumber(ColumnarReadState *readState,
 			stripeReadState->projectedColumnList,
 			stripeReadState->stripeReadContext,
 			stripeReadState,
-			readState->currentStripeMetadata->id
+			readState->currentStripeMetadata->id,
+			true
 			);
 
 		uint64 chunkFirstRowNumber = 
@@ -702,12 +915,17 @@ ColumnarRescan(ColumnarReadState *readState, List *scanQual)
 
 	ColumnarResetRead(readState);
 
-	/* set currentStripeMetadata for the first stripe to read */
-	AdvanceStripeRead(readState);
-
 	readState->chunkGroupsFiltered = 0;
 
+	/* AdvanceStripeRead checks the zone map of the first stripe against these */
 	readState->whereClauseList = copyObject(scanQual);
+	readState->chunkRefutationProgram =
+		CompileChunkRefutationProgram(readState->whereClauseList,
+									  readState->tupleDescriptor->natts);
+
+	/* set currentStripeMetadata for the first stripe to read */
+	AdvanceStripeRead(readState);
+
 	MemoryContextSwitchTo(oldContext);
 }
 
@@ -762,7 +980,8 @@ ColumnarResetRead(ColumnarReadState *readState)
  */
 static StripeReadState *
 BeginStripeRead(StripeMetadata *stripeMetadata, Relation rel, TupleDesc tupleDesc,
-				List *projectedColumnList, List *whereClauseList, List *whereClauseVars,
+				List *projectedColumnList, ChunkRefutationProgram *refutationProgram,
+				ZstdDictionaryCache *zstdDictionaryCache,
 				MemoryContext stripeReadContext, Snapshot snapshot)
 {
 	MemoryContext oldContext = MemoryContextSwitchTo(stripeReadContext);
@@ -775,16 +994,29 @@ BeginStripeRead(StripeMetadata *stripeMetadata, Relation rel, TupleDesc tupleDes
 	stripeReadState->chunkGroupReadState = NULL;
 	stripeReadState->projectedColumnList = projectedColumnList;
 	stripeReadState->stripeReadContext = stripeReadContext;
+	stripeReadState->stripeFileOffset = stripeMetadata->fileOffset;
+	stripeReadState->stripeColumnCount = stripeMetadata->columnCount;
+	stripeReadState->stripeChunkGroupRowCount = stripeMetadata->chunkGroupRowCount;
+	stripeReadState->prefetchDistance =
+		get_tablespace_io_concurrency(rel->rd_rel->reltablespace);
+	stripeReadState->prefetchChunkGroupIndex = 0;
+
+	/* reads outside of a scan keep the dictionaries for the stripe only */
+	stripeReadState->zstdDictionaryCache = zstdDictionaryCache != NULL ?
+										   zstdDictionaryCache :
+										   CreateZstdDictionaryCache(stripeReadContext,
+																	 tupleDesc->natts);
 
 	stripeReadState->stripeBuffers = LoadFilteredStripeBuffers(rel,
 															   stripeMetadata,
 															   tupleDesc,
 															   projectedColumnList,
-															   whereClauseList,
-															   whereClauseVars,
+															   refutationProgram,
 															   &stripeReadState->
 															   chunkGroupsFiltered,
-															   snapshot);
+															   snapshot,
+															   &stripeReadState->
+															   selectedChunkSkipList);
 
 	stripeReadState->rowCount = stripeReadState->stripeBuffers->rowCount;
 
@@ -797,62 +1029,38 @@ BeginStripeRead(StripeMetadata *stripeMetadata, Relation rel, TupleDesc tupleDes
 
 /*
  * AdvanceStripeRead updates chunkGroupsFiltered and sets
- * currentStripeMetadata for next stripe read.
+ * currentStripeMetadata for next stripe read. Stripes whose zone maps refute
+ * the where clauses are skipped without reading their chunk metadata, and
+ * their chunk groups are counted as filtered.
  */
 static void
 AdvanceStripeRead(ColumnarReadState *readState)
 {
 	MemoryContext oldContext = MemoryContextSwitchTo(readState->scanContext);
 
-	if (readState->parallelColumnarScan == 0)
+	/* if not read any stripes yet, start from the first one .. */
+	StripeMetadata *lastStripeMetadata = NULL;
+	if (StripeReadInProgress(readState))
 	{
-		/* if not read any stripes yet, start from the first one .. */
-		uint64 lastReadRowNumber = COLUMNAR_INVALID_ROW_NUMBER;
-		if (StripeReadInProgress(readState))
-		{
-			/* .. otherwise, continue with the next stripe */
-			lastReadRowNumber = StripeGetHighestRowNumber(readState->currentStripeMetadata);
-
-			readState->chunkGroupsFiltered +=
-				readState->stripeReadState->chunkGroupsFiltered;
-		}
+		/* .. otherwise, continue with the next stripe */
+		lastStripeMetadata = readState->currentStripeMetadata;
 
-		readState->currentStripeMetadata = FindNextStripeByRowNumber(readState->relation,
-																	lastReadRowNumber,
-																	readState->snapshot);
+		readState->chunkGroupsFiltered +=
+			readState->stripeReadState->chunkGroupsFiltered;
 	}
-	else
-	{
-		if (StripeReadInProgress(readState))
-		{
-			readState->chunkGroupsFiltered +=
-				readState->stripeReadState->chunkGroupsFiltered;
-		}
 
-		SpinLockAcquire(&readState->parallelColumnarScan->mutex);
+	readState->currentStripeMetadata = FindNextStripeToRead(readState,
+															lastStripeMetadata);
 
-		/* Fetch atomic next stripe id to be read by this scan. */
-		uint64 nextStripeId = 
-			pg_atomic_fetch_add_u64(&readState->parallelColumnarScan->nextStripeId, 1);
-
-		uint64 nextHigherStripeId = nextStripeId;
-
-		readState->currentStripeMetadata = FindNextStripeForParallelWorker(readState->relation,
-																		   readState->snapshot,
-																		   nextStripeId,
-																		   &nextHigherStripeId);
-
-		/* 
-		 * There exists higher stripe id than this one so adjust and 
-		 * add +1 for next workers.
-		 */
-		if (nextHigherStripeId != nextStripeId)
-		{
-			pg_atomic_write_u64(&readState->parallelColumnarScan->nextStripeId,
-								nextHigherStripeId + 1);
-		}
+	while (readState->currentStripeMetadata &&
+		   StripeRefutedByZoneMap(readState, readState->currentStripeMetadata))
+	{
+		StripeMetadata *skippedStripeMetadata = readState->currentStripeMetadata;
 
-		SpinLockRelease(&readState->parallelColumnarScan->mutex);
+		readState->chunkGroupsFiltered += skippedStripeMetadata->chunkCount;
+		readState->currentStripeMetadata = FindNextStripeToRead(readState,
+																skippedStripeMetadata);
+		pfree(skippedStripeMetadata);
 	}
 
 	if (readState->currentStripeMetadata &&
@@ -885,6 +1093,189 @@ AdvanceStripeRead(ColumnarReadState *readState)
 }
 
 
+/*
+ * FindNextStripeToRead returns the metadata of the stripe to read after
+ * lastStripeMetadata, or of the first one if it is NULL. Parallel workers
+ * instead take the next stripe id that no worker has claimed yet.
+ */
+static StripeMetadata *
+FindNextStripeToRead(ColumnarReadState *readState, StripeMetadata *lastStripeMetadata)
+{
+	if (readState->parallelColumnarScan == 0)
+	{
+		uint64 lastReadRowNumber = COLUMNAR_INVALID_ROW_NUMBER;
+		if (lastStripeMetadata != NULL)
+		{
+			lastReadRowNumber = StripeGetHighestRowNumber(lastStripeMetadata);
+		}
+
+		return FindNextStripeByRowNumber(readState->relation, lastReadRowNumber,
+										 readState->snapshot);
+	}
+
+	SpinLockAcquire(&readState->parallelColumnarScan->mutex);
+
+	/* Fetch atomic next stripe id to be read by this scan. */
+	uint64 nextStripeId =
+		pg_atomic_fetch_add_u64(&readState->parallelColumnarScan->nextStripeId, 1);
+
+	uint64 nextHigherStripeId = nextStripeId;
+
+	StripeMetadata *stripeMetadata =
+		FindNextStripeForParallelWorker(readState->relation,
+										readState->snapshot,
+										nextStripeId,
+										&nextHigherStripeId);
+
+	/*
+	 * There exists higher stripe id than this one so adjust and
+	 * add +1 for next workers.
+	 */
+	if (nextHigherStripeId != nextStripeId)
+	{
+		pg_atomic_write_u64(&readState->parallelColumnarScan->nextStripeId,
+							nextHigherStripeId + 1);
+	}
+
+	SpinLockRelease(&readState->parallelColumnarScan->mutex);
+
+	return stripeMetadata;
+}
+
+
+/*
+ * StripeRefutedByZoneMap returns true if the zone maps of the given stripe
+ * prove that none of its rows match the where clauses. Like in
+ * SelectedChunkMask, the min/max values of the columns are checked against
+ * the compiled column intervals, and turned into range constraints for the
+ * quals that fall back to predicate_refuted_by(). Columns that only hold NULLs
+ * in the stripe refute all the strict operator quals that are pushed down.
+ */
+static bool
+StripeRefutedByZoneMap(ColumnarReadState *readState, StripeMetadata *stripeMetadata)
+{
+	ChunkRefutationProgram *refutationProgram = readState->chunkRefutationProgram;
+	if (refutationProgram == NULL || readState->whereClauseVars == NIL)
+	{
+		return false;
+	}
+
+	if (!readState->stripeZoneMapsLoaded)
+	{
+		TupleDesc tupleDescriptor = readState->tupleDescriptor;
+		int *zoneMapIndexArray = palloc(tupleDescriptor->natts * sizeof(int));
+		int zoneMapCount = 0;
+
+		for (int columnIndex = 0; columnIndex < tupleDescriptor->natts; columnIndex++)
+		{
+			zoneMapIndexArray[columnIndex] = -1;
+		}
+
+		ListCell *columnCell = NULL;
+		foreach(columnCell, readState->whereClauseVars)
+		{
+			Var *column = lfirst(columnCell);
+			if (zoneMapIndexArray[column->varattno - 1] < 0)
+			{
+				zoneMapIndexArray[column->varattno - 1] = zoneMapCount++;
+			}
+		}
+
+		readState->stripeZoneMaps =
+			ReadStripeZoneMaps(RelationPhysicalIdentifier_compat(readState->relation),
+							   tupleDescriptor, zoneMapIndexArray, zoneMapCount,
+							   readState->snapshot);
+		readState->zoneMapIndexArray = zoneMapIndexArray;
+		readState->stripeZoneMapsLoaded = true;
+	}
+
+	StripeZoneMap *stripeZoneMap = hash_search(readState->stripeZoneMaps,
+											   &stripeMetadata->id, HASH_FIND, NULL);
+	if (stripeZoneMap == NULL)
+	{
+		return false;
+	}
+
+	ListCell *intervalCell = NULL;
+	foreach(intervalCell, refutationProgram->intervalList)
+	{
+		ColumnInterval *interval = lfirst(intervalCell);
+		ColumnZoneMap *columnZoneMap = StripeColumnZoneMap(readState, stripeZoneMap,
+														   interval->columnIndex);
+		if (columnZoneMap == NULL || !columnZoneMap->exists)
+		{
+			continue;
+		}
+
+		if (columnZoneMap->hasMinMax)
+		{
+			if (ColumnIntervalRefutesRange(interval, columnZoneMap->minimumValue,
+										   columnZoneMap->maximumValue))
+			{
+				return true;
+			}
+		}
+		else if (columnZoneMap->nullCount == stripeMetadata->rowCount)
+		{
+			return true;
+		}
+	}
+
+	List *constraintList = NIL;
+	ListCell *columnCell = NULL;
+	foreach(columnCell, refutationProgram->fallbackClauseVars)
+	{
+		Var *column = lfirst(columnCell);
+		ColumnZoneMap *columnZoneMap = StripeColumnZoneMap(readState, stripeZoneMap,
+														   column->varattno - 1);
+		if (columnZoneMap == NULL || !columnZoneMap->exists)
+		{
+			continue;
+		}
+
+		if (columnZoneMap->hasMinMax)
+		{
+			Node *baseConstraint = BuildBaseConstraint(column);
+			UpdateConstraint(baseConstraint, columnZoneMap->minimumValue,
+							 columnZoneMap->maximumValue);
+			constraintList = lappend(constraintList, baseConstraint);
+		}
+		else if (columnZoneMap->nullCount == stripeMetadata->rowCount)
+		{
+			/* strict quals on a column that is NULL in all rows match nothing */
+			NullTest *nullTest = makeNode(NullTest);
+			nullTest->arg = (Expr *) column;
+			nullTest->nulltesttype = IS_NULL;
+			nullTest->argisrow = false;
+			nullTest->location = -1;
+			constraintList = lappend(constraintList, nullTest);
+		}
+	}
+
+	return constraintList != NIL &&
+		   predicate_refuted_by(constraintList, refutationProgram->fallbackClauseList,
+								false);
+}
+
+
+/*
+ * StripeColumnZoneMap returns the zone map of the given column in a stripe
+ * read by StripeRefutedByZoneMap, or NULL if the column's zone maps weren't read.
+ */
+static ColumnZoneMap *
+StripeColumnZoneMap(ColumnarReadState *readState, StripeZoneMap *stripeZoneMap,
+					int columnIndex)
+{
+	int zoneMapIndex = readState->zoneMapIndexArray[columnIndex];
+	if (zoneMapIndex < 0)
+	{
+		return NULL;
+	}
+
+	return &stripeZoneMap->columnZoneMapArray[zoneMapIndex];
+}
+
+
 /*
  * SnapshotMightSeeUnflushedStripes returns true if given snapshot is
  * expected to see un-flushed stripes either because of other backends'
@@ -937,6 +1328,9 @@ ReadStripeNextRow(StripeReadState *stripeReadState, Datum *columnValues,
 	{
 		if (stripeReadState->chunkGroupReadState == NULL)
 		{
+			PrefetchChunkGroups(stripeReadState,
+								stripeReadState->projectedColumnList);
+
 			stripeReadState->chunkGroupReadState = BeginChunkGroupRead(
 				stripeReadState->stripeBuffers,
 				stripeReadState->
@@ -948,7 +1342,8 @@ ReadStripeNextRow(StripeReadState *stripeReadState, Datum *columnValues,
 				stripeReadState->
 				stripeReadContext,
 				stripeReadState,
-				stripeId
+				stripeId,
+				false
 				);
 			
 			if (columnar_enable_dml &&
@@ -1011,11 +1406,14 @@ ReadStripeNextRow(StripeReadState *stripeReadState, Datum *columnValues,
 
 
 /*
- * BeginChunkGroupRead allocates state for reading a chunk.
+ * BeginChunkGroupRead allocates state for reading a chunk. If lazyDecode is
+ * set, values of encodings that support random access are only decoded for
+ * the rows that are read, which suits reads of single rows by row number.
  */
 static ChunkGroupReadState *
 BeginChunkGroupRead(StripeBuffers *stripeBuffers, int chunkIndex, TupleDesc tupleDesc,
-					List *projectedColumnList, MemoryContext cxt, StripeReadState *state, uint64 stripeId)
+					List *projectedColumnList, MemoryContext cxt, StripeReadState *state, uint64 stripeId,
+					bool lazyDecode)
 {
 	uint32 chunkGroupRowCount =
 		stripeBuffers->selectedChunkGroupRowCounts[chunkIndex];
@@ -1037,7 +1435,8 @@ BeginChunkGroupRead(StripeBuffers *stripeBuffers, int chunkIndex, TupleDesc tupl
 	chunkGroupReadState->chunkGroupData = DeserializeChunkData(stripeBuffers, chunkIndex,
 															   chunkGroupRowCount,
 															   tupleDesc,
-															   projectedColumnList, state, stripeId);
+															   projectedColumnList, state, stripeId,
+															   lazyDecode);
 	MemoryContextSwitchTo(oldContext);
 
 	return chunkGroupReadState;
@@ -1055,6 +1454,8 @@ EndChunkGroupRead(ChunkGroupReadState *chunkGroupReadState)
 	if (chunkGroupReadState->rowMask != NULL && !chunkGroupReadState->rowMaskCached)
 		pfree(chunkGroupReadState->rowMask);
 	chunkGroupReadState->rowMask = NULL;
+	if (chunkGroupReadState->vectorRowIndexArray != NULL)
+		pfree(chunkGroupReadState->vectorRowIndexArray);
 	pfree(chunkGroupReadState);
 }
 
@@ -1094,7 +1495,7 @@ ReadChunkGroupNextRow(ChunkGroupReadState *chunkGroupReadState, Datum *columnVal
 		int attno;
 		foreach_int(attno, chunkGroupReadState->projectedColumnList)
 		{
-			const ChunkData *chunkGroupData = chunkGroupReadState->chunkGroupData;
+			ChunkData *chunkGroupData = chunkGroupReadState->chunkGroupData;
 			const int rowIndex = chunkGroupReadState->currentRow;
 
 			/* attno is 1-indexed; existsArray is 0-indexed */
@@ -1102,7 +1503,8 @@ ReadChunkGroupNextRow(ChunkGroupReadState *chunkGroupReadState, Datum *columnVal
 
 			if (chunkGroupData->existsArray[columnIndex][rowIndex])
 			{
-				columnValues[columnIndex] = chunkGroupData->valueArray[columnIndex][rowIndex];
+				columnValues[columnIndex] = ChunkDataValue(chunkGroupData, columnIndex,
+														   rowIndex);
 				columnNulls[columnIndex] = false;
 			}
 		}
@@ -1141,6 +1543,10 @@ CreateEmptyChunkData(uint32 columnCount, bool *columnMask, uint32 chunkGroupRowC
 	chunkData->existsArray = palloc0(columnCount * sizeof(bool *));
 	chunkData->valueArray = palloc0(columnCount * sizeof(Datum *));
 	chunkData->valueBufferArray = palloc0(columnCount * sizeof(StringInfo));
+	chunkData->runStartArray = palloc0(columnCount * sizeof(bool *));
+	chunkData->lazyEncodingArray = palloc0(columnCount * sizeof(EncodingType));
+	chunkData->lazyValueIndexArray = palloc0(columnCount * sizeof(uint32 *));
+	chunkData->lazyDecodeContext = NULL;
 	chunkData->columnCount = columnCount;
 	chunkData->rowCount = chunkGroupRowCount;
 
@@ -1188,10 +1594,28 @@ FreeChunkData(ChunkData *chunkData)
 		{
 			pfree(chunkData->valueArray[columnIndex]);
 		}
+
+		if (chunkData->runStartArray[columnIndex] != NULL)
+		{
+			pfree(chunkData->runStartArray[columnIndex]);
+		}
+
+		if (chunkData->lazyValueIndexArray[columnIndex] != NULL)
+		{
+			pfree(chunkData->lazyValueIndexArray[columnIndex]);
+		}
+	}
+
+	if (chunkData->lazyDecodeContext != NULL)
+	{
+		MemoryContextDelete(chunkData->lazyDecodeContext);
 	}
 
 	pfree(chunkData->existsArray);
 	pfree(chunkData->valueArray);
+	pfree(chunkData->runStartArray);
+	pfree(chunkData->lazyEncodingArray);
+	pfree(chunkData->lazyValueIndexArray);
 	pfree(chunkData);
 }
 
@@ -1267,17 +1691,19 @@ ColumnarTableRowCount(Relation relation)
 
 
 /*
- * LoadFilteredStripeBuffers reads serialized stripe data from the given file.
- * The function skips over chunks whose rows are refuted by restriction qualifiers,
- * and only loads columns that are projected in the query.
+ * LoadFilteredStripeBuffers prepares the given stripe for reading. The function
+ * skips over chunks whose rows are refuted by restriction qualifiers, and sets
+ * selectedChunkSkipList to the chunks of the projected columns in the chunk
+ * groups that remain. The chunks themselves are read by LoadChunkGroupBuffers once
+ * their chunk group is read.
  */
 static StripeBuffers *
 LoadFilteredStripeBuffers(Relation relation, StripeMetadata *stripeMetadata,
 						  TupleDesc tupleDescriptor, List *projectedColumnList,
-						  List *whereClauseList, List *whereClauseVars,
-						  int64 *chunkGroupsFiltered, Snapshot snapshot)
+						  ChunkRefutationProgram *refutationProgram,
+						  int64 *chunkGroupsFiltered, Snapshot snapshot,
+						  StripeSkipList **selectedChunkSkipList)
 {
-	uint32 columnIndex = 0;
 	uint32 columnCount = tupleDescriptor->natts;
 
 	bool *projectedColumnMask = ProjectedColumnMask(columnCount, projectedColumnList);
@@ -1295,44 +1721,22 @@ LoadFilteredStripeBuffers(Relation relation, StripeMetadata *stripeMetadata,
 														stripeMetadata->chunkCount,
 														snapshot);
 #endif
-	bool *selectedChunkMask = SelectedChunkMask(stripeSkipList, whereClauseList,
-												whereClauseVars, chunkGroupsFiltered);
-
-	StripeSkipList *selectedChunkSkipList =
-		SelectedChunkSkipList(stripeSkipList, projectedColumnMask,
-							  selectedChunkMask);
-
-	/* load column data for projected columns */
-	ColumnBuffers **columnBuffersArray = palloc0(columnCount * sizeof(ColumnBuffers *));
-
-	for (columnIndex = 0; columnIndex < stripeMetadata->columnCount; columnIndex++)
-	{
-		if (projectedColumnMask[columnIndex])
-		{
-			ColumnChunkSkipNode *chunkSkipNode =
-				selectedChunkSkipList->chunkSkipNodeArray[columnIndex];
-			Form_pg_attribute attributeForm = TupleDescAttr(tupleDescriptor, columnIndex);
-			uint32 chunkCount = selectedChunkSkipList->chunkCount;
+	bool *selectedChunkMask = SelectedChunkMask(stripeSkipList, refutationProgram,
+												chunkGroupsFiltered);
 
-			ColumnBuffers *columnBuffers = LoadColumnBuffers(relation, chunkSkipNode,
-															 chunkCount,
-															 stripeMetadata->fileOffset,
-															 attributeForm);
-
-			columnBuffersArray[columnIndex] = columnBuffers;
-		}
-	}
+	*selectedChunkSkipList = SelectedChunkSkipList(stripeSkipList, projectedColumnMask,
+												   selectedChunkMask);
 
 	StripeBuffers *stripeBuffers = palloc0(sizeof(StripeBuffers));
 	stripeBuffers->columnCount = columnCount;
-	stripeBuffers->rowCount = StripeSkipListRowCount(selectedChunkSkipList);
-	stripeBuffers->columnBuffersArray = columnBuffersArray;
+	stripeBuffers->rowCount = StripeSkipListRowCount(*selectedChunkSkipList);
+	stripeBuffers->columnBuffersArray = NULL;
 	stripeBuffers->selectedChunkGroupRowCounts =
-		selectedChunkSkipList->chunkGroupRowCounts;
+		(*selectedChunkSkipList)->chunkGroupRowCounts;
 	stripeBuffers->selectedChunkGroupRowOffset =
-		selectedChunkSkipList->chunkGroupRowOffset;
+		(*selectedChunkSkipList)->chunkGroupRowOffset;
 	stripeBuffers->selectedChunkGroupDeletedRows =
-		selectedChunkSkipList->chunkGroupDeletedRows;
+		(*selectedChunkSkipList)->chunkGroupDeletedRows;
 	
 
 	return stripeBuffers;
@@ -1340,129 +1744,1091 @@ LoadFilteredStripeBuffers(Relation relation, StripeMetadata *stripeMetadata,
 
 
 /*
- * LoadColumnBuffers reads serialized column data from the given file. These
- * column data are laid out as sequential chunks in the file; and chunk positions
- * and lengths are retrieved from the column chunk skip node array.
+ * LoadChunkGroupBuffers reads the serialized exists and value streams of the
+ * chunks of the given columns in the given chunk group, and returns them in an
+ * array indexed by column. Entries of columns that aren't in columnMask, or
+ * that were added after the stripe was written, are NULL.
+ *
+ * All streams are read with a single ColumnarStorageReadRanges call. Columns
+ * are stored one after the other with their exists streams before their value
+ * streams, so going through the columns in order yields ranges sorted by
+ * offset, and pages shared by the streams of neighbouring columns are only
+ * read once. Streams found in the compressed tier of the column cache are
+ * copied from there instead, and those read are added to it.
  */
-static ColumnBuffers *
-LoadColumnBuffers(Relation relation, ColumnChunkSkipNode *chunkSkipNodeArray,
-				  uint32 chunkCount, uint64 stripeOffset,
-				  Form_pg_attribute attributeForm)
+static ColumnChunkBuffers **
+LoadChunkGroupBuffers(StripeReadState *stripeReadState, uint64 chunkIndex,
+					  uint64 stripeId, bool *columnMask)
 {
-	uint32 chunkIndex = 0;
-	ColumnChunkBuffers **chunkBuffersArray =
-		palloc0(chunkCount * sizeof(ColumnChunkBuffers *));
-
-	for (chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	StripeSkipList *selectedChunkSkipList = stripeReadState->selectedChunkSkipList;
+	uint32 columnCount = stripeReadState->columnCount;
+	uint32 stripeColumnCount = Min(columnCount, stripeReadState->stripeColumnCount);
+	bool useCompressedCache = ColumnarCompressedCacheEnabled();
+	uint64 storageId = 0;
+	uint64 chunkGroupId = 0;
+
+	if (useCompressedCache)
 	{
-		chunkBuffersArray[chunkIndex] = palloc0(sizeof(ColumnChunkBuffers));
+		storageId = StripeReadStorageId(stripeReadState);
+		chunkGroupId = StripeReadChunkGroupId(stripeReadState, chunkIndex);
 	}
 
-	/*
-	 * We first read the "exists" chunks. We don't read "values" array here,
-	 * because "exists" chunks are stored sequentially on disk, and we want to
-	 * minimize disk seeks.
-	 */
-	for (chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	ColumnChunkBuffers **chunkBuffersArray =
+		palloc0(columnCount * sizeof(ColumnChunkBuffers *));
+	bool *readColumnMask = palloc0(columnCount * sizeof(bool));
+	ColumnarStorageRange *rangeArray =
+		palloc(2 * stripeColumnCount * sizeof(ColumnarStorageRange));
+	int rangeCount = 0;
+
+	for (uint32 columnIndex = 0; columnIndex < stripeColumnCount; columnIndex++)
 	{
-		ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
-		uint64 existsOffset = stripeOffset + chunkSkipNode->existsChunkOffset;
-		StringInfo rawExistsBuffer = makeStringInfo();
+		if (!columnMask[columnIndex])
+		{
+			continue;
+		}
+
+		ColumnChunkSkipNode *chunkSkipNode =
+			&selectedChunkSkipList->chunkSkipNodeArray[columnIndex][chunkIndex];
+		ColumnChunkBuffers *chunkBuffers = palloc0(sizeof(ColumnChunkBuffers));
 
+		StringInfo rawExistsBuffer = makeStringInfo();
 		enlargeStringInfo(rawExistsBuffer, chunkSkipNode->existsLength);
 		rawExistsBuffer->len = chunkSkipNode->existsLength;
-		ColumnarStorageRead(relation, existsOffset, rawExistsBuffer->data,
-							chunkSkipNode->existsLength);
-
-		chunkBuffersArray[chunkIndex]->existsBuffer = rawExistsBuffer;
-	}
 
-	/* then read "values" chunks, which are also stored sequentially on disk */
-	for (chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
-	{
-		ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
-		CompressionType compressionType = chunkSkipNode->valueCompressionType;
-		uint64 valueOffset = stripeOffset + chunkSkipNode->valueChunkOffset;
 		StringInfo rawValueBuffer = makeStringInfo();
-
 		enlargeStringInfo(rawValueBuffer, chunkSkipNode->valueLength);
 		rawValueBuffer->len = chunkSkipNode->valueLength;
-		ColumnarStorageRead(relation, valueOffset, rawValueBuffer->data,
-							chunkSkipNode->valueLength);
 
-		chunkBuffersArray[chunkIndex]->valueBuffer = rawValueBuffer;
-		chunkBuffersArray[chunkIndex]->valueCompressionType = compressionType;
-		chunkBuffersArray[chunkIndex]->decompressedValueSize =
-			chunkSkipNode->decompressedValueSize;
+		chunkBuffers->existsBuffer = rawExistsBuffer;
+		chunkBuffers->valueBuffer = rawValueBuffer;
+		chunkBuffers->valueCompressionType = chunkSkipNode->valueCompressionType;
+		chunkBuffers->valueEncodingType = chunkSkipNode->valueEncodingType;
+		chunkBuffers->decompressedValueSize = chunkSkipNode->decompressedValueSize;
+
+		chunkBuffersArray[columnIndex] = chunkBuffers;
+
+		if (useCompressedCache &&
+			ColumnarRetrieveCompressedCache(storageId, stripeId, chunkGroupId,
+											columnIndex, rawExistsBuffer,
+											rawValueBuffer))
+		{
+			continue;
+		}
+
+		rangeArray[rangeCount].logicalOffset =
+			stripeReadState->stripeFileOffset + chunkSkipNode->existsChunkOffset;
+		rangeArray[rangeCount].amount = chunkSkipNode->existsLength;
+		rangeArray[rangeCount].data = rawExistsBuffer->data;
+		rangeCount++;
+
+		rangeArray[rangeCount].logicalOffset =
+			stripeReadState->stripeFileOffset + chunkSkipNode->valueChunkOffset;
+		rangeArray[rangeCount].amount = chunkSkipNode->valueLength;
+		rangeArray[rangeCount].data = rawValueBuffer->data;
+		rangeCount++;
+
+		readColumnMask[columnIndex] = true;
 	}
 
-	ColumnBuffers *columnBuffers = palloc0(sizeof(ColumnBuffers));
-	columnBuffers->chunkBuffersArray = chunkBuffersArray;
+	ColumnarStorageReadRanges(stripeReadState->relation, rangeArray, rangeCount);
+	pfree(rangeArray);
 
-	return columnBuffers;
+	for (uint32 columnIndex = 0; useCompressedCache && columnIndex < stripeColumnCount;
+		 columnIndex++)
+	{
+		if (readColumnMask[columnIndex])
+		{
+			ColumnarAddCompressedCacheEntry(storageId, stripeId, chunkGroupId,
+											columnIndex,
+											chunkBuffersArray[columnIndex]->existsBuffer,
+											chunkBuffersArray[columnIndex]->valueBuffer);
+		}
+	}
+
+	pfree(readColumnMask);
+
+	return chunkBuffersArray;
 }
 
 
 /*
- * SelectedChunkMask walks over each column's chunks and checks if a chunk can
- * be filtered without reading its data. The filtering happens when all rows in
- * the chunk can be refuted by the given qualifier conditions.
+ * FreeChunkBuffers frees the serialized streams of a chunk once it has been
+ * deserialized. The value stream is left alone when it is NULL, which is how
+ * callers mark a value stream that deserialized data still points into.
  */
-static bool *
-SelectedChunkMask(StripeSkipList *stripeSkipList, List *whereClauseList,
-				  List *whereClauseVars, int64 *chunkGroupsFiltered)
+static void
+FreeChunkBuffers(ColumnChunkBuffers *chunkBuffers)
 {
-	ListCell *columnCell = NULL;
-	uint32 chunkIndex = 0;
-
-	bool *selectedChunkMask = palloc0(stripeSkipList->chunkCount * sizeof(bool));
-	memset(selectedChunkMask, true, stripeSkipList->chunkCount * sizeof(bool));
+	pfree(chunkBuffers->existsBuffer->data);
+	pfree(chunkBuffers->existsBuffer);
 
-	foreach(columnCell, whereClauseVars)
+	if (chunkBuffers->valueBuffer != NULL)
 	{
-		Var *column = lfirst(columnCell);
-		uint32 columnIndex = column->varattno - 1;
+		pfree(chunkBuffers->valueBuffer->data);
+		pfree(chunkBuffers->valueBuffer);
+	}
 
-		/* if this column's data type doesn't have a comparator, skip it */
+	pfree(chunkBuffers);
+}
+
+
+/*
+ * PrefetchChunkGroups issues prefetch requests for the chunks of the given
+ * columns in the chunk group about to be read and in the prefetchDistance
+ * chunk groups after it. Chunk groups are only prefetched once, so as a stripe
+ * is read sequentially each chunk group read prefetches the one entering the
+ * window. Chunks of late materialized columns, which may never be read, are
+ * left out by passing only the columns read up front.
+ */
+static void
+PrefetchChunkGroups(StripeReadState *stripeReadState, List *columnList)
+{
+	StripeSkipList *selectedChunkSkipList = stripeReadState->selectedChunkSkipList;
+
+	if (stripeReadState->prefetchDistance <= 0)
+	{
+		return;
+	}
+
+	int firstChunkGroupIndex = Max(stripeReadState->prefetchChunkGroupIndex,
+								   stripeReadState->chunkGroupIndex);
+	int lastChunkGroupIndex = Min(stripeReadState->chunkGroupIndex +
+								  stripeReadState->prefetchDistance,
+								  (int) selectedChunkSkipList->chunkCount - 1);
+
+	for (int chunkGroupIndex = firstChunkGroupIndex;
+		 chunkGroupIndex <= lastChunkGroupIndex;
+		 chunkGroupIndex++)
+	{
+		int attno;
+
+		foreach_int(attno, columnList)
+		{
+			/* attno is 1-indexed; chunkSkipNodeArray is 0-indexed */
+			uint32 columnIndex = attno - 1;
+
+			if (columnIndex >= stripeReadState->stripeColumnCount)
+			{
+				continue;
+			}
+
+			ColumnChunkSkipNode *chunkSkipNode =
+				&selectedChunkSkipList->chunkSkipNodeArray[columnIndex][chunkGroupIndex];
+
+			ColumnarStoragePrefetch(stripeReadState->relation,
+									stripeReadState->stripeFileOffset +
+									chunkSkipNode->existsChunkOffset,
+									chunkSkipNode->existsLength);
+			ColumnarStoragePrefetch(stripeReadState->relation,
+									stripeReadState->stripeFileOffset +
+									chunkSkipNode->valueChunkOffset,
+									chunkSkipNode->valueLength);
+		}
+	}
+
+	stripeReadState->prefetchChunkGroupIndex =
+		Max(stripeReadState->prefetchChunkGroupIndex, lastChunkGroupIndex + 1);
+}
+
+
+/*
+ * StripeReadStorageId returns the storage id of the relation being read.
+ */
+static uint64
+StripeReadStorageId(StripeReadState *state)
+{
+	if (state->storageId == 0)
+	{
+		state->storageId = ColumnarStorageGetStorageId(state->relation, false);
+	}
+
+	return state->storageId;
+}
+
+
+/*
+ * StripeReadChunkGroupId returns the index of the given selected chunk group
+ * among all chunk groups of the stripe, which identifies its chunks in the
+ * column cache whatever chunk groups a scan's quals filter out. All chunk
+ * groups but the last one of a stripe are full.
+ */
+static uint64
+StripeReadChunkGroupId(StripeReadState *state, uint64 chunkIndex)
+{
+	return state->selectedChunkSkipList->chunkGroupRowOffset[chunkIndex] /
+		   state->stripeChunkGroupRowCount;
+}
+
+
+/*
+ * LoadColumnBuffers reads serialized column data from the given file. These
+ * column data are laid out as sequential chunks in the file; and chunk positions
+ * and lengths are retrieved from the column chunk skip node array.
+ */
+static ColumnBuffers *
+LoadColumnBuffers(Relation relation, ColumnChunkSkipNode *chunkSkipNodeArray,
+				  uint32 chunkCount, uint64 stripeOffset,
+				  Form_pg_attribute attributeForm)
+{
+	uint32 chunkIndex = 0;
+	ColumnChunkBuffers **chunkBuffersArray =
+		palloc0(chunkCount * sizeof(ColumnChunkBuffers *));
+
+	for (chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	{
+		chunkBuffersArray[chunkIndex] = palloc0(sizeof(ColumnChunkBuffers));
+	}
+
+	/*
+	 * The "exists" chunks are stored sequentially on disk, followed by the
+	 * "values" chunks, so reading all of them in that order with a single
+	 * ColumnarStorageReadRanges call visits every page only once.
+	 */
+	ColumnarStorageRange *rangeArray =
+		palloc(2 * chunkCount * sizeof(ColumnarStorageRange));
+
+	for (chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	{
+		ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
+		StringInfo rawExistsBuffer = makeStringInfo();
+
+		enlargeStringInfo(rawExistsBuffer, chunkSkipNode->existsLength);
+		rawExistsBuffer->len = chunkSkipNode->existsLength;
+
+		rangeArray[chunkIndex].logicalOffset =
+			stripeOffset + chunkSkipNode->existsChunkOffset;
+		rangeArray[chunkIndex].amount = chunkSkipNode->existsLength;
+		rangeArray[chunkIndex].data = rawExistsBuffer->data;
+
+		chunkBuffersArray[chunkIndex]->existsBuffer = rawExistsBuffer;
+	}
+
+	for (chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	{
+		ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
+		CompressionType compressionType = chunkSkipNode->valueCompressionType;
+		StringInfo rawValueBuffer = makeStringInfo();
+
+		enlargeStringInfo(rawValueBuffer, chunkSkipNode->valueLength);
+		rawValueBuffer->len = chunkSkipNode->valueLength;
+
+		rangeArray[chunkCount + chunkIndex].logicalOffset =
+			stripeOffset + chunkSkipNode->valueChunkOffset;
+		rangeArray[chunkCount + chunkIndex].amount = chunkSkipNode->valueLength;
+		rangeArray[chunkCount + chunkIndex].data = rawValueBuffer->data;
+
+		chunkBuffersArray[chunkIndex]->valueBuffer = rawValueBuffer;
+		chunkBuffersArray[chunkIndex]->valueCompressionType = compressionType;
+		chunkBuffersArray[chunkIndex]->valueEncodingType =
+			chunkSkipNode->valueEncodingType;
+		chunkBuffersArray[chunkIndex]->decompressedValueSize =
+			chunkSkipNode->decompressedValueSize;
+	}
+
+	ColumnarStorageReadRanges(relation, rangeArray, 2 * chunkCount);
+	pfree(rangeArray);
+
+	ColumnBuffers *columnBuffers = palloc0(sizeof(ColumnBuffers));
+	columnBuffers->chunkBuffersArray = chunkBuffersArray;
+
+	return columnBuffers;
+}
+
+
+/*
+ * SelectedChunkMask walks over each column's chunks and checks if a chunk can
+ * be filtered without reading its data. The filtering happens when all rows in
+ * the chunk can be refuted by the given qualifier conditions.
+ */
+static bool *
+SelectedChunkMask(StripeSkipList *stripeSkipList,
+				  ChunkRefutationProgram *refutationProgram, int64 *chunkGroupsFiltered)
+{
+	ListCell *columnCell = NULL;
+	uint32 chunkIndex = 0;
+
+	bool *selectedChunkMask = palloc0(stripeSkipList->chunkCount * sizeof(bool));
+	memset(selectedChunkMask, true, stripeSkipList->chunkCount * sizeof(bool));
+
+	if (refutationProgram == NULL)
+	{
+		return selectedChunkMask;
+	}
+
+	/* the quals compiled into intervals are checked by comparing min/max directly */
+	ListCell *intervalCell = NULL;
+	foreach(intervalCell, refutationProgram->intervalList)
+	{
+		ColumnInterval *interval = lfirst(intervalCell);
+		ColumnChunkSkipNode *chunkSkipNodeArray =
+			stripeSkipList->chunkSkipNodeArray[interval->columnIndex];
+
+		for (chunkIndex = 0; chunkIndex < stripeSkipList->chunkCount; chunkIndex++)
+		{
+			ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
+
+			if (selectedChunkMask[chunkIndex] && chunkSkipNode->hasMinMax &&
+				ColumnIntervalRefutesRange(interval, chunkSkipNode->minimumValue,
+										   chunkSkipNode->maximumValue))
+			{
+				selectedChunkMask[chunkIndex] = false;
+				*chunkGroupsFiltered += 1;
+			}
+		}
+	}
+
+	/* the other quals are refuted by constraints built from min/max */
+	foreach(columnCell, refutationProgram->fallbackClauseVars)
+	{
+		Var *column = lfirst(columnCell);
+		uint32 columnIndex = column->varattno - 1;
+
+		/* if this column's data type doesn't have a comparator, skip it */
 		FmgrInfo *comparisonFunction = GetFunctionInfoOrNull(column->vartype,
 															 BTREE_AM_OID,
 															 BTORDER_PROC);
 		if (comparisonFunction == NULL)
 		{
-			continue;
+			continue;
+		}
+
+		Node *baseConstraint = BuildBaseConstraint(column);
+		for (chunkIndex = 0; chunkIndex < stripeSkipList->chunkCount; chunkIndex++)
+		{
+			ColumnChunkSkipNode *chunkSkipNodeArray =
+				stripeSkipList->chunkSkipNodeArray[columnIndex];
+			ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
+
+			/*
+			 * A column chunk with comparable data type can miss min/max values
+			 * if all values in the chunk are NULL.
+			 */
+			if (!selectedChunkMask[chunkIndex] || !chunkSkipNode->hasMinMax)
+			{
+				continue;
+			}
+
+			UpdateConstraint(baseConstraint, chunkSkipNode->minimumValue,
+							 chunkSkipNode->maximumValue);
+
+			List *constraintList = list_make1(baseConstraint);
+			bool predicateRefuted =
+				predicate_refuted_by(constraintList,
+									 refutationProgram->fallbackClauseList, false);
+			if (predicateRefuted)
+			{
+				selectedChunkMask[chunkIndex] = false;
+				*chunkGroupsFiltered += 1;
+			}
+		}
+	}
+
+	/* chunks that pass min/max can still be skipped by their bloom filters */
+	List *probeList = refutationProgram->bloomFilterProbeList;
+	if (probeList != NIL)
+	{
+		for (chunkIndex = 0; chunkIndex < stripeSkipList->chunkCount; chunkIndex++)
+		{
+			if (selectedChunkMask[chunkIndex] &&
+				BloomFilterRefutesChunk(stripeSkipList, chunkIndex, probeList))
+			{
+				selectedChunkMask[chunkIndex] = false;
+				*chunkGroupsFiltered += 1;
+			}
+		}
+	}
+
+	return selectedChunkMask;
+}
+
+
+/*
+ * CompileChunkRefutationProgram compiles the given (implicitly ANDed) pushed
+ * down quals into a ChunkRefutationProgram, or returns NULL if there are none.
+ */
+static ChunkRefutationProgram *
+CompileChunkRefutationProgram(List *whereClauseList, int natts)
+{
+	if (whereClauseList == NIL)
+	{
+		return NULL;
+	}
+
+	ChunkRefutationProgram *program = palloc0(sizeof(ChunkRefutationProgram));
+
+	CompileChunkRefutationClauses(program, (Node *) whereClauseList);
+
+	program->fallbackClauseVars = GetClauseVars(program->fallbackClauseList, natts);
+	program->bloomFilterProbeList = BuildBloomFilterProbes(NIL,
+														   (Node *) whereClauseList);
+
+	return program;
+}
+
+
+/*
+ * CompileChunkRefutationClauses adds the given clause, or each of its items if
+ * it is a list or an AND clause, to the intervals of the program. Clauses that
+ * can't be expressed as an interval are kept for predicate_refuted_by(), which
+ * refutes a conjunction if it refutes any of its items, so splitting the AND
+ * doesn't lose anything.
+ */
+static void
+CompileChunkRefutationClauses(ChunkRefutationProgram *program, Node *clause)
+{
+	if (clause == NULL)
+	{
+		return;
+	}
+
+	if (IsA(clause, List) || is_andclause(clause))
+	{
+		List *argList = IsA(clause, List) ? (List *) clause : ((BoolExpr *) clause)->args;
+
+		ListCell *argCell = NULL;
+		foreach(argCell, argList)
+		{
+			CompileChunkRefutationClauses(program, (Node *) lfirst(argCell));
+		}
+
+		return;
+	}
+
+	if (!CompileColumnIntervalClause(program, clause))
+	{
+		program->fallbackClauseList = lappend(program->fallbackClauseList, clause);
+	}
+}
+
+
+/*
+ * CompileColumnIntervalClause adds a "Var <op> Const" or "Var = ANY(Const)"
+ * clause to the interval of its column and returns true, where <op> is one of
+ * the comparison operators of the default btree operator family of the column
+ * type. Returns false for other clauses.
+ */
+static bool
+CompileColumnIntervalClause(ChunkRefutationProgram *program, Node *clause)
+{
+	Oid opno = InvalidOid;
+	Oid inputCollation = InvalidOid;
+	List *argList = NIL;
+	bool isArrayOp = false;
+
+	if (IsA(clause, OpExpr) && list_length(((OpExpr *) clause)->args) == 2)
+	{
+		opno = ((OpExpr *) clause)->opno;
+		inputCollation = ((OpExpr *) clause)->inputcollid;
+		argList = ((OpExpr *) clause)->args;
+	}
+	else if (IsA(clause, ScalarArrayOpExpr) && ((ScalarArrayOpExpr *) clause)->useOr)
+	{
+		opno = ((ScalarArrayOpExpr *) clause)->opno;
+		inputCollation = ((ScalarArrayOpExpr *) clause)->inputcollid;
+		argList = ((ScalarArrayOpExpr *) clause)->args;
+		isArrayOp = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	Node *leftArg = linitial(argList);
+	Node *rightArg = lsecond(argList);
+	bool columnOnLeft = false;
+
+	if (IsA(leftArg, Var) && IsA(rightArg, Const))
+	{
+		columnOnLeft = true;
+	}
+	else if (!isArrayOp && IsA(leftArg, Const) && IsA(rightArg, Var))
+	{
+		columnOnLeft = false;
+	}
+	else
+	{
+		return false;
+	}
+
+	Var *column = (Var *) (columnOnLeft ? leftArg : rightArg);
+	Const *constant = (Const *) (columnOnLeft ? rightArg : leftArg);
+
+	/* min/max are only meaningful under the collation they were computed with */
+	if (column->varattno <= 0 || constant->constisnull ||
+		inputCollation != column->varcollid)
+	{
+		return false;
+	}
+
+	Oid opclass = GetDefaultOpClass(column->vartype, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+	{
+		return false;
+	}
+
+	Oid opfamily = get_opclass_family(opclass);
+	if (!op_in_opfamily(opno, opfamily))
+	{
+		return false;
+	}
+
+	int strategy = 0;
+	Oid leftType = InvalidOid;
+	Oid rightType = InvalidOid;
+	get_op_opfamily_properties(opno, opfamily, false, &strategy, &leftType, &rightType);
+
+	Oid columnType = columnOnLeft ? leftType : rightType;
+	Oid valueType = columnOnLeft ? rightType : leftType;
+	if (!columnOnLeft)
+	{
+		strategy = BTCommuteStrategyNumber(strategy);
+	}
+
+	if (isArrayOp && strategy != BTEqualStrategyNumber)
+	{
+		return false;
+	}
+
+	ColumnInterval *interval = FindOrAddColumnInterval(program, column, opfamily,
+													   columnType, valueType,
+													   inputCollation);
+	if (interval == NULL)
+	{
+		return false;
+	}
+
+	Datum value = constant->constvalue;
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+		{
+			ColumnIntervalAddUpperBound(interval, value, false);
+			break;
+		}
+
+		case BTLessEqualStrategyNumber:
+		{
+			ColumnIntervalAddUpperBound(interval, value, true);
+			break;
+		}
+
+		case BTEqualStrategyNumber:
+		{
+			if (isArrayOp)
+			{
+				ColumnIntervalAddInList(interval, constant);
+			}
+			else
+			{
+				ColumnIntervalAddLowerBound(interval, value, true);
+				ColumnIntervalAddUpperBound(interval, value, true);
+			}
+			break;
+		}
+
+		case BTGreaterEqualStrategyNumber:
+		{
+			ColumnIntervalAddLowerBound(interval, value, true);
+			break;
+		}
+
+		case BTGreaterStrategyNumber:
+		{
+			ColumnIntervalAddLowerBound(interval, value, false);
+			break;
+		}
+
+		default:
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * FindOrAddColumnInterval returns the interval of the program for comparing the
+ * given column with values of valueType under the given collation, and adds it
+ * if there is none yet. Returns NULL if the operator family lacks the
+ * comparison functions for the types.
+ */
+static ColumnInterval *
+FindOrAddColumnInterval(ChunkRefutationProgram *program, Var *column, Oid opfamily,
+						Oid columnType, Oid valueType, Oid collation)
+{
+	uint32 columnIndex = column->varattno - 1;
+
+	ListCell *intervalCell = NULL;
+	foreach(intervalCell, program->intervalList)
+	{
+		ColumnInterval *interval = lfirst(intervalCell);
+		if (interval->columnIndex == columnIndex && interval->valueType == valueType &&
+			interval->collation == collation)
+		{
+			return interval;
+		}
+	}
+
+	Oid comparisonProc = get_opfamily_proc(opfamily, columnType, valueType,
+										   BTORDER_PROC);
+	Oid valueComparisonProc = get_opfamily_proc(opfamily, valueType, valueType,
+												BTORDER_PROC);
+	if (!OidIsValid(comparisonProc) || !OidIsValid(valueComparisonProc))
+	{
+		return NULL;
+	}
+
+	ColumnInterval *interval = palloc0(sizeof(ColumnInterval));
+	interval->columnIndex = columnIndex;
+	interval->valueType = valueType;
+	interval->collation = collation;
+	fmgr_info(comparisonProc, &interval->comparisonFunction);
+	fmgr_info(valueComparisonProc, &interval->valueComparisonFunction);
+
+	interval->comparison = COLUMN_INTERVAL_COMPARE_FUNCTION;
+	if (columnType == valueType && column->vartype == columnType)
+	{
+		switch (columnType)
+		{
+			case INT2OID:
+			{
+				interval->comparison = COLUMN_INTERVAL_COMPARE_INT16;
+				break;
+			}
+
+			case INT4OID:
+			case DATEOID:
+			{
+				interval->comparison = COLUMN_INTERVAL_COMPARE_INT32;
+				break;
+			}
+
+			case INT8OID:
+			case TIMEOID:
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+			{
+				interval->comparison = COLUMN_INTERVAL_COMPARE_INT64;
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	}
+
+	program->intervalList = lappend(program->intervalList, interval);
+
+	return interval;
+}
+
+
+/*
+ * ColumnIntervalAddLowerBound narrows the interval to the values above the given
+ * one, or equal to it if inclusive.
+ */
+static void
+ColumnIntervalAddLowerBound(ColumnInterval *interval, Datum value, bool inclusive)
+{
+	if (interval->hasLowerBound)
+	{
+		int comparison = ColumnIntervalCompare(interval,
+											   &interval->valueComparisonFunction,
+											   value, interval->lowerBound);
+		if (comparison < 0 || (comparison == 0 && inclusive))
+		{
+			return;
+		}
+	}
+
+	interval->hasLowerBound = true;
+	interval->lowerBound = value;
+	interval->lowerBoundInclusive = inclusive;
+}
+
+
+/*
+ * ColumnIntervalAddUpperBound narrows the interval to the values below the given
+ * one, or equal to it if inclusive.
+ */
+static void
+ColumnIntervalAddUpperBound(ColumnInterval *interval, Datum value, bool inclusive)
+{
+	if (interval->hasUpperBound)
+	{
+		int comparison = ColumnIntervalCompare(interval,
+											   &interval->valueComparisonFunction,
+											   value, interval->upperBound);
+		if (comparison > 0 || (comparison == 0 && inclusive))
+		{
+			return;
+		}
+	}
+
+	interval->hasUpperBound = true;
+	interval->upperBound = value;
+	interval->upperBoundInclusive = inclusive;
+}
+
+
+/*
+ * ColumnIntervalAddInList adds the elements of the array of a "Var = ANY(Const)"
+ * qual to the interval as a sorted IN list. NULL elements are left out since
+ * they don't match any value.
+ */
+static void
+ColumnIntervalAddInList(ColumnInterval *interval, Const *arrayConst)
+{
+	ArrayType *array = DatumGetArrayTypeP(arrayConst->constvalue);
+	int16 elementLength = 0;
+	bool elementByValue = false;
+	char elementAlign = 0;
+	Datum *elementArray = NULL;
+	bool *elementNullArray = NULL;
+	int elementCount = 0;
+
+	get_typlenbyvalalign(ARR_ELEMTYPE(array), &elementLength, &elementByValue,
+						 &elementAlign);
+	deconstruct_array(array, ARR_ELEMTYPE(array), elementLength, elementByValue,
+					  elementAlign, &elementArray, &elementNullArray, &elementCount);
+
+	ColumnIntervalInList *inList = palloc0(sizeof(ColumnIntervalInList));
+	inList->valueArray = palloc0(Max(elementCount, 1) * sizeof(Datum));
+
+	for (int elementIndex = 0; elementIndex < elementCount; elementIndex++)
+	{
+		if (!elementNullArray[elementIndex])
+		{
+			inList->valueArray[inList->valueCount++] = elementArray[elementIndex];
 		}
+	}
 
-		Node *baseConstraint = BuildBaseConstraint(column);
-		for (chunkIndex = 0; chunkIndex < stripeSkipList->chunkCount; chunkIndex++)
+	qsort_arg(inList->valueArray, inList->valueCount, sizeof(Datum),
+			  ColumnIntervalValueCompare, interval);
+
+	interval->inListList = lappend(interval->inListList, inList);
+}
+
+
+/*
+ * ColumnIntervalValueCompare is the qsort_arg() comparator of IN list values.
+ */
+static int
+ColumnIntervalValueCompare(const void *left, const void *right, void *arg)
+{
+	ColumnInterval *interval = (ColumnInterval *) arg;
+
+	return ColumnIntervalCompare(interval, &interval->valueComparisonFunction,
+								 *(const Datum *) left, *(const Datum *) right);
+}
+
+
+/*
+ * ColumnIntervalCompare compares two values with the given comparison function
+ * of the interval, or inline if the interval's types allow it.
+ */
+static inline int
+ColumnIntervalCompare(ColumnInterval *interval, FmgrInfo *function, Datum left,
+					  Datum right)
+{
+	switch (interval->comparison)
+	{
+		case COLUMN_INTERVAL_COMPARE_INT16:
 		{
-			ColumnChunkSkipNode *chunkSkipNodeArray =
-				stripeSkipList->chunkSkipNodeArray[columnIndex];
-			ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
+			int16 leftValue = DatumGetInt16(left);
+			int16 rightValue = DatumGetInt16(right);
+			return (leftValue > rightValue) - (leftValue < rightValue);
+		}
 
-			/*
-			 * A column chunk with comparable data type can miss min/max values
-			 * if all values in the chunk are NULL.
-			 */
-			if (!chunkSkipNode->hasMinMax)
+		case COLUMN_INTERVAL_COMPARE_INT32:
+		{
+			int32 leftValue = DatumGetInt32(left);
+			int32 rightValue = DatumGetInt32(right);
+			return (leftValue > rightValue) - (leftValue < rightValue);
+		}
+
+		case COLUMN_INTERVAL_COMPARE_INT64:
+		{
+			int64 leftValue = DatumGetInt64(left);
+			int64 rightValue = DatumGetInt64(right);
+			return (leftValue > rightValue) - (leftValue < rightValue);
+		}
+
+		default:
+		{
+			return DatumGetInt32(FunctionCall2Coll(function, interval->collation,
+												   left, right));
+		}
+	}
+}
+
+
+/*
+ * ColumnIntervalRefutesRange returns true if no value between the given
+ * minimum and maximum values is in the interval.
+ */
+static bool
+ColumnIntervalRefutesRange(ColumnInterval *interval, Datum minimumValue,
+						   Datum maximumValue)
+{
+	FmgrInfo *comparisonFunction = &interval->comparisonFunction;
+
+	if (interval->hasLowerBound)
+	{
+		int comparison = ColumnIntervalCompare(interval, comparisonFunction,
+											   maximumValue, interval->lowerBound);
+		if (comparison < 0 || (comparison == 0 && !interval->lowerBoundInclusive))
+		{
+			return true;
+		}
+	}
+
+	if (interval->hasUpperBound)
+	{
+		int comparison = ColumnIntervalCompare(interval, comparisonFunction,
+											   minimumValue, interval->upperBound);
+		if (comparison > 0 || (comparison == 0 && !interval->upperBoundInclusive))
+		{
+			return true;
+		}
+	}
+
+	ListCell *inListCell = NULL;
+	foreach(inListCell, interval->inListList)
+	{
+		ColumnIntervalInList *inList = lfirst(inListCell);
+
+		/* binary search for the first value that is not below the minimum */
+		int low = 0;
+		int high = inList->valueCount;
+		while (low < high)
+		{
+			int middle = low + (high - low) / 2;
+			int comparison = ColumnIntervalCompare(interval, comparisonFunction,
+												   minimumValue,
+												   inList->valueArray[middle]);
+			if (comparison > 0)
 			{
-				continue;
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
 			}
+		}
 
-			UpdateConstraint(baseConstraint, chunkSkipNode->minimumValue,
-							 chunkSkipNode->maximumValue);
+		if (low == inList->valueCount ||
+			ColumnIntervalCompare(interval, comparisonFunction, maximumValue,
+								  inList->valueArray[low]) < 0)
+		{
+			return true;
+		}
+	}
 
-			List *constraintList = list_make1(baseConstraint);
-			bool predicateRefuted =
-				predicate_refuted_by(constraintList, whereClauseList, false);
-			if (predicateRefuted && selectedChunkMask[chunkIndex])
+	return false;
+}
+
+
+/*
+ * BuildBloomFilterProbes appends a BloomFilterProbe to probeList for every
+ * "Var = Const" and "Var = ANY(Const)" qual in the given (implicitly ANDed)
+ * clauses whose operator is the equality operator of the hash operator family
+ * the column's bloom filters are built with. The constants are hashed with the
+ * family's hash function for their type, so that cross-type comparisons, e.g.
+ * of an int8 column with an int4 constant, can use the filters as well.
+ */
+static List *
+BuildBloomFilterProbes(List *probeList, Node *clause)
+{
+	if (clause == NULL)
+	{
+		return probeList;
+	}
+
+	if (IsA(clause, List) || is_andclause(clause))
+	{
+		List *argList = IsA(clause, List) ? (List *) clause :
+						((BoolExpr *) clause)->args;
+
+		ListCell *argCell = NULL;
+		foreach(argCell, argList)
+		{
+			probeList = BuildBloomFilterProbes(probeList, lfirst(argCell));
+		}
+
+		return probeList;
+	}
+
+	Oid operatorId = InvalidOid;
+	Oid inputCollation = InvalidOid;
+	Node *leftArg = NULL;
+	Node *rightArg = NULL;
+	bool isArray = false;
+
+	if (IsA(clause, OpExpr) && list_length(((OpExpr *) clause)->args) == 2)
+	{
+		OpExpr *opExpr = (OpExpr *) clause;
+		operatorId = opExpr->opno;
+		inputCollation = opExpr->inputcollid;
+		leftArg = linitial(opExpr->args);
+		rightArg = lsecond(opExpr->args);
+	}
+	else if (IsA(clause, ScalarArrayOpExpr) && ((ScalarArrayOpExpr *) clause)->useOr)
+	{
+		ScalarArrayOpExpr *arrayOpExpr = (ScalarArrayOpExpr *) clause;
+		operatorId = arrayOpExpr->opno;
+		inputCollation = arrayOpExpr->inputcollid;
+		leftArg = linitial(arrayOpExpr->args);
+		rightArg = lsecond(arrayOpExpr->args);
+		isArray = true;
+	}
+	else
+	{
+		return probeList;
+	}
+
+	if (IsA(leftArg, RelabelType))
+	{
+		leftArg = (Node *) ((RelabelType *) leftArg)->arg;
+	}
+
+	if (IsA(rightArg, RelabelType))
+	{
+		rightArg = (Node *) ((RelabelType *) rightArg)->arg;
+	}
+
+	/* the constant side of an ANY qual is always the array on the right */
+	bool constantOnLeft = !isArray && IsA(leftArg, Const) && IsA(rightArg, Var);
+	Var *column = (Var *) (constantOnLeft ? rightArg : leftArg);
+	Const *constant = (Const *) (constantOnLeft ? leftArg : rightArg);
+
+	if (!IsA(column, Var) || !IsA(constant, Const) || column->varattno <= 0 ||
+		constant->constisnull)
+	{
+		return probeList;
+	}
+
+	/* bloom filters hash values with the column's collation */
+	if (inputCollation != column->varcollid)
+	{
+		return probeList;
+	}
+
+	Oid operatorClassId = GetDefaultOpClass(column->vartype, HASH_AM_OID);
+	if (!OidIsValid(operatorClassId))
+	{
+		return probeList;
+	}
+
+	Oid operatorFamilyId = get_opclass_family(operatorClassId);
+	if (get_op_opfamily_strategy(operatorId, operatorFamilyId) != HTEqualStrategyNumber)
+	{
+		return probeList;
+	}
+
+	Oid leftType = InvalidOid;
+	Oid rightType = InvalidOid;
+	op_input_types(operatorId, &leftType, &rightType);
+
+	Oid constantType = constantOnLeft ? leftType : rightType;
+	Oid hashProcedureId = get_opfamily_proc(operatorFamilyId, constantType,
+											constantType, HASHSTANDARD_PROC);
+	if (!OidIsValid(hashProcedureId))
+	{
+		return probeList;
+	}
+
+	FmgrInfo hashFunction;
+	fmgr_info(hashProcedureId, &hashFunction);
+
+	BloomFilterProbe *probe = palloc0(sizeof(BloomFilterProbe));
+	probe->columnIndex = AttrNumberGetAttrOffset(column->varattno);
+
+	if (!isArray)
+	{
+		probe->hashArray = palloc(sizeof(uint32));
+		probe->hashArray[probe->hashCount++] =
+			DatumGetUInt32(FunctionCall1Coll(&hashFunction, inputCollation,
+											 constant->constvalue));
+	}
+	else
+	{
+		ArrayType *array = DatumGetArrayTypeP(constant->constvalue);
+		Oid elementType = ARR_ELEMTYPE(array);
+		int16 elementLength = 0;
+		bool elementByValue = false;
+		char elementAlign = 0;
+		Datum *elementArray = NULL;
+		bool *elementNullArray = NULL;
+		int elementCount = 0;
+
+		get_typlenbyvalalign(elementType, &elementLength, &elementByValue,
+							 &elementAlign);
+		deconstruct_array(array, elementType, elementLength, elementByValue,
+						  elementAlign, &elementArray, &elementNullArray,
+						  &elementCount);
+
+		/* NULL elements never compare equal, so they don't need a probe */
+		probe->hashArray = palloc(Max(elementCount, 1) * sizeof(uint32));
+		for (int elementIndex = 0; elementIndex < elementCount; elementIndex++)
+		{
+			if (!elementNullArray[elementIndex])
 			{
-				selectedChunkMask[chunkIndex] = false;
-				*chunkGroupsFiltered += 1;
+				probe->hashArray[probe->hashCount++] =
+					DatumGetUInt32(FunctionCall1Coll(&hashFunction, inputCollation,
+													 elementArray[elementIndex]));
 			}
 		}
 	}
 
-	return selectedChunkMask;
+	return lappend(probeList, probe);
+}
+
+
+/*
+ * BloomFilterRefutesChunk returns true if the bloom filter of a column of the
+ * given chunk shows that none of the constants of one of the probes is in it.
+ * Columns without bloom filters never refute a chunk.
+ */
+static bool
+BloomFilterRefutesChunk(StripeSkipList *stripeSkipList, uint32 chunkIndex,
+						List *probeList)
+{
+	ListCell *probeCell = NULL;
+	foreach(probeCell, probeList)
+	{
+		BloomFilterProbe *probe = lfirst(probeCell);
+		if (probe->columnIndex >= stripeSkipList->columnCount)
+		{
+			continue;
+		}
+
+		ColumnChunkSkipNode *chunkSkipNode =
+			&stripeSkipList->chunkSkipNodeArray[probe->columnIndex][chunkIndex];
+		if (chunkSkipNode->bloomFilter == NULL)
+		{
+			continue;
+		}
+
+		bool mightContain = false;
+		for (int hashIndex = 0; hashIndex < probe->hashCount && !mightContain;
+			 hashIndex++)
+		{
+			mightContain = BloomFilterMightContainHash(chunkSkipNode->bloomFilter,
+													   probe->hashArray[hashIndex]);
+		}
+
+		if (!mightContain)
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 
@@ -1840,46 +3206,280 @@ DeserializeBoolArray(StringInfo boolArrayBuffer, bool *boolArray,
 
 
 /*
- * DeserializeDatumArray reads an array of datums from the given buffer and stores
- * them in provided datumArray. If a value is marked as false in the exists array,
- * the function assumes that the datum isn't in the buffer, and simply skips it.
+ * DeserializeDatumArray reads an array of datums from the given buffer and stores
+ * them in provided datumArray. If a value is marked as false in the exists array,
+ * the function assumes that the datum isn't in the buffer, and simply skips it.
+ */
+static void
+DeserializeDatumArray(StringInfo datumBuffer, bool *existsArray, uint32 datumCount,
+					  bool datumTypeByValue, int datumTypeLength,
+					  char datumTypeAlign, Datum *datumArray)
+{
+	uint32 datumIndex = 0;
+	uint32 currentDatumDataOffset = 0;
+
+	for (datumIndex = 0; datumIndex < datumCount; datumIndex++)
+	{
+		if (!existsArray[datumIndex])
+		{
+			continue;
+		}
+
+		char *currentDatumDataPointer = datumBuffer->data + currentDatumDataOffset;
+
+		datumArray[datumIndex] = fetch_att(currentDatumDataPointer, datumTypeByValue,
+										   datumTypeLength);
+		currentDatumDataOffset = att_addlength_datum(currentDatumDataOffset,
+													 datumTypeLength,
+													 datumArray[datumIndex]);
+		currentDatumDataOffset = att_align_nominal(currentDatumDataOffset,
+												   datumTypeAlign);
+
+		if (currentDatumDataOffset > datumBuffer->len)
+		{
+			ereport(ERROR, (errmsg("insufficient data left in datum buffer: %d, %d", currentDatumDataOffset, datumBuffer->len)));
+		}
+	}
+}
+
+
+/*
+ * ReadColumnValueStreams returns the decompressed value streams of the chunks of
+ * the given column, in stripe order, until their total size reaches
+ * maxSampleSize. It is used to train zstd dictionaries on data that is already
+ * stored.
+ */
+List *
+ReadColumnValueStreams(Relation relation, AttrNumber attrNum, uint64 maxSampleSize,
+					   Snapshot snapshot)
+{
+	TupleDesc tupleDescriptor = RelationGetDescr(relation);
+	int columnIndex = AttrNumberGetAttrOffset(attrNum);
+	Form_pg_attribute attributeForm = TupleDescAttr(tupleDescriptor, columnIndex);
+	List *sampleList = NIL;
+	uint64 sampleSize = 0;
+
+	/* only used to look up zstd dictionaries while decompressing */
+	StripeReadState *stripeReadState = palloc0(sizeof(StripeReadState));
+	stripeReadState->relation = relation;
+	stripeReadState->stripeReadContext = CurrentMemoryContext;
+	stripeReadState->zstdDictionaryCache =
+		CreateZstdDictionaryCache(CurrentMemoryContext, tupleDescriptor->natts);
+
+	StripeMetadata *stripeMetadata =
+		FindNextStripeByRowNumber(relation, COLUMNAR_INVALID_ROW_NUMBER, snapshot);
+
+	while (stripeMetadata != NULL && sampleSize < maxSampleSize)
+	{
+		if (StripeWriteState(stripeMetadata) == STRIPE_WRITE_FLUSHED &&
+			columnIndex < (int) stripeMetadata->columnCount)
+		{
+			StripeSkipList *stripeSkipList =
+				ReadStripeSkipList(RelationPhysicalIdentifier_compat(relation),
+								   stripeMetadata->id, tupleDescriptor,
+								   stripeMetadata->chunkCount, snapshot);
+			ColumnBuffers *columnBuffers =
+				LoadColumnBuffers(relation,
+								  stripeSkipList->chunkSkipNodeArray[columnIndex],
+								  stripeSkipList->chunkCount,
+								  stripeMetadata->fileOffset, attributeForm);
+
+			for (uint32 chunkIndex = 0;
+				 chunkIndex < stripeSkipList->chunkCount && sampleSize < maxSampleSize;
+				 chunkIndex++)
+			{
+				ColumnChunkBuffers *chunkBuffers =
+					columnBuffers->chunkBuffersArray[chunkIndex];
+				StringInfo valueBuffer =
+					DecompressValueBuffer(chunkBuffers, columnIndex, stripeReadState);
+
+				sampleList = lappend(sampleList, valueBuffer);
+				sampleSize += valueBuffer->len;
+			}
+		}
+
+		stripeMetadata = FindNextStripeByRowNumber(relation,
+												   stripeMetadata->firstRowNumber,
+												   snapshot);
+	}
+
+	return sampleList;
+}
+
+
+/*
+ * ColumnarPrewarmStripe decompresses the chunks of the given columns in the
+ * given stripe into the shared column cache, and returns the number of chunks
+ * it stored there, leaving out those that were already cached. chunkGroupMask,
+ * if not NULL, has the chunk groups of the stripe to load. Uncompressed chunks
+ * are read as is, so caching them gains nothing, and they are skipped like they
+ * are by scans.
+ */
+uint64
+ColumnarPrewarmStripe(Relation relation, StripeMetadata *stripeMetadata,
+					  List *columnList, bool *chunkGroupMask, Snapshot snapshot)
+{
+	TupleDesc tupleDescriptor = RelationGetDescr(relation);
+	uint64 chunkCount = 0;
+
+	MemoryContext stripeReadContext = AllocSetContextCreate(CurrentMemoryContext,
+															"Columnar Prewarm Context",
+															ALLOCSET_DEFAULT_SIZES);
+
+	StripeReadState *stripeReadState = BeginStripeRead(stripeMetadata, relation,
+													   tupleDescriptor, columnList,
+													   NULL, NULL, stripeReadContext,
+													   snapshot);
+
+	MemoryContext oldContext = MemoryContextSwitchTo(stripeReadContext);
+
+	bool *columnMask = ProjectedColumnMask(tupleDescriptor->natts, columnList);
+	uint64 storageId = StripeReadStorageId(stripeReadState);
+
+	for (uint32 chunkIndex = 0;
+		 chunkIndex < stripeReadState->selectedChunkSkipList->chunkCount;
+		 chunkIndex++)
+	{
+		uint64 chunkGroupId = StripeReadChunkGroupId(stripeReadState, chunkIndex);
+
+		if (chunkGroupMask != NULL && !chunkGroupMask[chunkGroupId])
+		{
+			continue;
+		}
+
+		ColumnChunkBuffers **chunkBuffersArray =
+			LoadChunkGroupBuffers(stripeReadState, chunkIndex, stripeMetadata->id,
+								  columnMask);
+
+		for (int columnIndex = 0; columnIndex < tupleDescriptor->natts; columnIndex++)
+		{
+			ColumnChunkBuffers *chunkBuffers = chunkBuffersArray[columnIndex];
+
+			if (chunkBuffers == NULL)
+			{
+				continue;
+			}
+
+			if (chunkBuffers->valueCompressionType != COMPRESSION_NONE)
+			{
+				StringInfo valueBuffer = DecompressValueBuffer(chunkBuffers, columnIndex,
+															   stripeReadState);
+
+				int evictedCount = 0;
+
+				if (ColumnarSharedCacheAdd(storageId, stripeMetadata->id, chunkGroupId,
+										   columnIndex, valueBuffer, &evictedCount))
+				{
+					chunkCount++;
+				}
+
+				pfree(valueBuffer->data);
+				pfree(valueBuffer);
+			}
+
+			FreeChunkBuffers(chunkBuffers);
+		}
+
+		pfree(chunkBuffersArray);
+	}
+
+	MemoryContextSwitchTo(oldContext);
+	MemoryContextDelete(stripeReadContext);
+
+	return chunkCount;
+}
+
+
+/*
+ * DecompressValueBuffer decompresses the value stream of a chunk. zstd chunks
+ * that were compressed with a trained dictionary name it in their frame header,
+ * in which case the dictionaries of the relation are read on first use.
  */
-static void
-DeserializeDatumArray(StringInfo datumBuffer, bool *existsArray, uint32 datumCount,
-					  bool datumTypeByValue, int datumTypeLength,
-					  char datumTypeAlign, Datum *datumArray)
+static StringInfo
+DecompressValueBuffer(ColumnChunkBuffers *chunkBuffers, int columnIndex,
+					  StripeReadState *state)
 {
-	uint32 datumIndex = 0;
-	uint32 currentDatumDataOffset = 0;
+	uint32 dictionaryId = 0;
 
-	for (datumIndex = 0; datumIndex < datumCount; datumIndex++)
+	if (chunkBuffers->valueCompressionType == COMPRESSION_ZSTD)
 	{
-		if (!existsArray[datumIndex])
+		dictionaryId = ZstdFrameDictionaryId(chunkBuffers->valueBuffer);
+	}
+
+	if (dictionaryId == 0)
+	{
+		return DecompressBuffer(chunkBuffers->valueBuffer,
+								chunkBuffers->valueCompressionType,
+								chunkBuffers->decompressedValueSize);
+	}
+
+	ZstdDictionaryCache *dictionaryCache = state->zstdDictionaryCache;
+	if (!dictionaryCache->loaded)
+	{
+		MemoryContext oldContext = MemoryContextSwitchTo(dictionaryCache->context);
+
+		ListCell *loadCell = NULL;
+		foreach(loadCell, ReadZstdDictionaries(StripeReadStorageId(state)))
 		{
-			continue;
+			ZstdDictionary *dictionary = lfirst(loadCell);
+			int dictionaryColumnIndex = AttrNumberGetAttrOffset(dictionary->attrNum);
+
+			if (dictionaryColumnIndex < dictionaryCache->columnCount)
+			{
+				dictionaryCache->columnDictionaries[dictionaryColumnIndex] =
+					lappend(dictionaryCache->columnDictionaries[dictionaryColumnIndex],
+							dictionary);
+			}
 		}
+		dictionaryCache->loaded = true;
 
-		char *currentDatumDataPointer = datumBuffer->data + currentDatumDataOffset;
+		MemoryContextSwitchTo(oldContext);
+	}
 
-		datumArray[datumIndex] = fetch_att(currentDatumDataPointer, datumTypeByValue,
-										   datumTypeLength);
-		currentDatumDataOffset = att_addlength_datum(currentDatumDataOffset,
-													 datumTypeLength,
-													 datumArray[datumIndex]);
-		currentDatumDataOffset = att_align_nominal(currentDatumDataOffset,
-												   datumTypeAlign);
+	ListCell *dictionaryCell = NULL;
+	foreach(dictionaryCell, dictionaryCache->columnDictionaries[columnIndex])
+	{
+		ZstdDictionary *dictionary = lfirst(dictionaryCell);
 
-		if (currentDatumDataOffset > datumBuffer->len)
+		if (dictionary->dictionaryId == dictionaryId)
 		{
-			ereport(ERROR, (errmsg("insufficient data left in datum buffer: %d, %d", currentDatumDataOffset, datumBuffer->len)));
+			return DecompressBufferWithZstdDictionary(chunkBuffers->valueBuffer,
+													  chunkBuffers->decompressedValueSize,
+													  dictionary);
 		}
 	}
+
+	ereport(ERROR, (errmsg("zstd dictionary %u of column %d of \"%s\" not found",
+						   dictionaryId, AttrOffsetGetAttrNumber(columnIndex),
+						   RelationGetRelationName(state->relation))));
+}
+
+
+/*
+ * CreateZstdDictionaryCache creates an empty zstd dictionary cache in the
+ * given memory context. Dictionaries are read when the first chunk that needs
+ * one is decompressed.
+ */
+static ZstdDictionaryCache *
+CreateZstdDictionaryCache(MemoryContext context, int columnCount)
+{
+	ZstdDictionaryCache *dictionaryCache =
+		MemoryContextAllocZero(context, sizeof(ZstdDictionaryCache));
+
+	dictionaryCache->context = context;
+	dictionaryCache->loaded = false;
+	dictionaryCache->columnCount = columnCount;
+	dictionaryCache->columnDictionaries =
+		MemoryContextAllocZero(context, Max(columnCount, 1) * sizeof(List *));
+
+	return dictionaryCache;
 }
 
 
 /*
- * DeserializeChunkGroupData deserializes requested data chunk for all columns and
- * stores in chunkDataArray. It uncompresses serialized data if necessary. The
+ * DeserializeChunkGroupData deserializes requested data chunk for the given columns and
+ * stores in chunkDataArray. It uncompresses and decodes serialized data if
+ * necessary. The
  * function also deallocates data buffers used for previous chunk, and compressed
  * data buffers for the current chunk which will not be needed again. If a column
  * data is not present serialized buffer, then default value (or null) is used
@@ -1888,7 +3488,8 @@ DeserializeDatumArray(StringInfo datumBuffer, bool *existsArray, uint32 datumCou
 static ChunkData *
 DeserializeChunkData(StripeBuffers *stripeBuffers, uint64 chunkIndex,
 					 uint32 rowCount, TupleDesc tupleDescriptor,
-					 List *projectedColumnList, StripeReadState *state, uint64 stripeId)
+					 List *projectedColumnList, StripeReadState *state, uint64 stripeId,
+					 bool lazyDecode)
 {
 	int columnIndex = 0;
 	bool *columnMask = ProjectedColumnMask(tupleDescriptor->natts, projectedColumnList);
@@ -1897,95 +3498,228 @@ DeserializeChunkData(StripeBuffers *stripeBuffers, uint64 chunkIndex,
 	ChunkData *chunkData = CreateEmptyChunkData(tupleDescriptor->natts, columnMask,
 												rowCount);
 
+	ColumnChunkBuffers **chunkBuffersArray = LoadChunkGroupBuffers(state, chunkIndex,
+																   stripeId, columnMask);
+
 	for (columnIndex = 0; columnIndex < stripeBuffers->columnCount; columnIndex++)
 	{
-		Form_pg_attribute attributeForm = TupleDescAttr(tupleDescriptor, columnIndex);
-		ColumnBuffers *columnBuffers = stripeBuffers->columnBuffersArray[columnIndex];
-		bool columnAdded = false;
-
-		if (columnBuffers == NULL && columnMask[columnIndex])
+		/* columns that are materialized late are deserialized when needed */
+		if (!columnMask[columnIndex])
 		{
-			columnAdded = true;
+			continue;
 		}
 
+		DeserializeChunkColumnData(chunkData, chunkBuffersArray[columnIndex],
+								   chunkIndex, columnIndex, rowCount,
+								   tupleDescriptor, state, stripeId, lazyDecode);
+	}
+
+	pfree(chunkBuffersArray);
+
+	return chunkData;
+}
+
+
+/*
+ * DeserializeChunkColumnData deserializes the given serialized chunk of a single
+ * column into chunkData, whose exists and value arrays for the column must
+ * already be allocated, and frees chunkBuffers. A NULL chunkBuffers stands for
+ * a column that was added after the stripe was written.
+ */
+static void
+DeserializeChunkColumnData(ChunkData *chunkData, ColumnChunkBuffers *chunkBuffers,
+						   uint64 chunkIndex, uint32 columnIndex, uint32 rowCount,
+						   TupleDesc tupleDescriptor, StripeReadState *state,
+						   uint64 stripeId, bool lazyDecode)
+{
+	Form_pg_attribute attributeForm = TupleDescAttr(tupleDescriptor, columnIndex);
+
+	if (chunkBuffers != NULL)
+	{
+		bool shouldCache = columnar_enable_page_cache == true && chunkBuffers->valueCompressionType != COMPRESSION_NONE;
+		uint64 storageId = 0;
+		uint64 chunkGroupId = 0;
 
-		if (columnBuffers != NULL)
+		if (shouldCache)
 		{
-			ColumnChunkBuffers *chunkBuffers =
-				columnBuffers->chunkBuffersArray[chunkIndex];
-			bool shouldCache = columnar_enable_page_cache == true && chunkBuffers->valueCompressionType != COMPRESSION_NONE;
+			storageId = StripeReadStorageId(state);
+			chunkGroupId = StripeReadChunkGroupId(state, chunkIndex);
 
-			if (shouldCache)
+			ColumnarMarkChunkGroupInUse(storageId, stripeId, chunkGroupId);
+		}
+
+		/* decompress and deserialize current chunk's data */
+		StringInfo valueBuffer = NULL;
+		
+		if (shouldCache)
+		{
+			valueBuffer = ColumnarRetrieveCache(storageId, stripeId, chunkGroupId, columnIndex);
+		}
+
+		if (valueBuffer == NULL)
+		{
+			/* the shared cache keeps a copy, the per-backend one takes the buffer */
+			bool cacheOwnsBuffer = shouldCache && !ColumnarSharedCacheEnabled();
+			MemoryContext oldMemoryContext;
+			if (cacheOwnsBuffer)
 			{
-				ColumnarMarkChunkGroupInUse(state->relation->rd_id, stripeId, chunkIndex);
+				oldMemoryContext = MemoryContextSwitchTo(ColumnarCacheMemoryContext());
 			}
 
-			/* decompress and deserialize current chunk's data */
-			StringInfo valueBuffer = NULL;
-			
+			valueBuffer = DecompressValueBuffer(chunkBuffers, columnIndex, state);
+
 			if (shouldCache)
 			{
-				valueBuffer = ColumnarRetrieveCache(state->relation->rd_id, stripeId, chunkIndex, columnIndex);
+				ColumnarAddCacheEntry(storageId, stripeId, chunkGroupId, columnIndex, valueBuffer);
 			}
 
-			if (valueBuffer == NULL)
+			if (cacheOwnsBuffer)
 			{
-				MemoryContext oldMemoryContext;
-				if (shouldCache)
-				{
-					oldMemoryContext = MemoryContextSwitchTo(ColumnarCacheMemoryContext());
-				}
-
-				valueBuffer = DecompressBuffer(chunkBuffers->valueBuffer,
-								 chunkBuffers->valueCompressionType,
-								 chunkBuffers->decompressedValueSize);
-
-				if (shouldCache)
-				{
-					ColumnarAddCacheEntry(state->relation->rd_id, stripeId, chunkIndex, columnIndex, valueBuffer);
-					MemoryContextSwitchTo(oldMemoryContext);
-				}
+				MemoryContextSwitchTo(oldMemoryContext);
 			}
+		}
+
+		/* an uncompressed value stream is used as is, and must outlive chunkBuffers */
+		if (valueBuffer == chunkBuffers->valueBuffer)
+		{
+			chunkBuffers->valueBuffer = NULL;
+		}
 
+		if (chunkBuffers->existsBuffer->len == 0)
+		{
+			/* the exists stream is elided when no row or every row has a value */
+			memset(chunkData->existsArray[columnIndex], valueBuffer->len > 0,
+				   rowCount * sizeof(bool));
+		}
+		else
+		{
 			DeserializeBoolArray(chunkBuffers->existsBuffer,
 								 chunkData->existsArray[columnIndex],
 								 rowCount);
+		}
+
+		if (chunkBuffers->valueEncodingType == ENCODING_NONE)
+		{
 			DeserializeDatumArray(valueBuffer, chunkData->existsArray[columnIndex],
 								  rowCount, attributeForm->attbyval,
 								  attributeForm->attlen, attributeForm->attalign,
 								  chunkData->valueArray[columnIndex]);
+		}
+		else if (lazyDecode &&
+				 EncodingSupportsRandomAccess(chunkBuffers->valueEncodingType))
+		{
+			/* values are decoded by ChunkDataValue when their row is read */
+			uint32 *valueIndexArray = palloc(rowCount * sizeof(uint32));
+			uint32 valueIndex = 0;
+
+			for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+			{
+				valueIndexArray[rowIndex] = valueIndex;
+				if (chunkData->existsArray[columnIndex][rowIndex])
+				{
+					valueIndex++;
+				}
+			}
+
+			chunkData->lazyEncodingArray[columnIndex] =
+				chunkBuffers->valueEncodingType;
+			chunkData->lazyValueIndexArray[columnIndex] = valueIndexArray;
 
-			/* store current chunk's data buffer to be freed at next chunk read */
-			chunkData->valueBufferArray[columnIndex] = valueBuffer;
+			if (chunkData->lazyDecodeContext == NULL)
+			{
+				chunkData->lazyDecodeContext =
+					AllocSetContextCreate(CurrentMemoryContext,
+										  "Columnar Lazy Decode Context",
+										  ALLOCSET_SMALL_SIZES);
+			}
 		}
-		else if (columnAdded)
+		else
 		{
-			/*
-			 * This is a column that was added after creation of this stripe.
-			 * So we use either the default value or NULL.
-			 */
-			if (attributeForm->atthasdef)
+			/* remember run boundaries so vectors can be built run by run */
+			if (chunkBuffers->valueEncodingType == ENCODING_RLE ||
+				chunkBuffers->valueEncodingType == ENCODING_CONSTANT)
 			{
-				int rowIndex = 0;
+				chunkData->runStartArray[columnIndex] =
+					palloc(rowCount * sizeof(bool));
+			}
 
-				Datum defaultValue = ColumnDefaultValue(tupleDescriptor->constr,
-														attributeForm);
+			StringInfo decodedBuffer =
+				DecodeChunkValues(valueBuffer, chunkBuffers->valueEncodingType,
+								  chunkData->existsArray[columnIndex], rowCount,
+								  attributeForm, chunkData->valueArray[columnIndex],
+								  chunkData->runStartArray[columnIndex]);
 
-				for (rowIndex = 0; rowIndex < rowCount; rowIndex++)
+			/*
+			 * Some encodings decode into a buffer of their own, in which case
+			 * the encoded buffer is no longer needed unless it is cached.
+			 */
+			if (decodedBuffer != valueBuffer)
+			{
+				if (!MemoryContextContains(ColumnarCacheMemoryContext(), valueBuffer))
 				{
-					chunkData->existsArray[columnIndex][rowIndex] = true;
-					chunkData->valueArray[columnIndex][rowIndex] = defaultValue;
+					pfree(valueBuffer->data);
+					pfree(valueBuffer);
 				}
+
+				valueBuffer = decodedBuffer;
 			}
-			else
+		}
+
+		/* store current chunk's data buffer to be freed at next chunk read */
+		chunkData->valueBufferArray[columnIndex] = valueBuffer;
+
+		FreeChunkBuffers(chunkBuffers);
+	}
+	else
+	{
+		/*
+		 * This is a column that was added after creation of this stripe.
+		 * So we use either the default value or NULL.
+		 */
+		if (attributeForm->atthasdef)
+		{
+			int rowIndex = 0;
+
+			Datum defaultValue = ColumnDefaultValue(tupleDescriptor->constr,
+													attributeForm);
+
+			for (rowIndex = 0; rowIndex < rowCount; rowIndex++)
 			{
-				memset(chunkData->existsArray[columnIndex], false,
-					   rowCount * sizeof(bool));
+				chunkData->existsArray[columnIndex][rowIndex] = true;
+				chunkData->valueArray[columnIndex][rowIndex] = defaultValue;
 			}
 		}
+		else
+		{
+			memset(chunkData->existsArray[columnIndex], false,
+				   rowCount * sizeof(bool));
+		}
 	}
+}
 
-	return chunkData;
+
+/*
+ * ChunkDataValue returns the value of the given existing row of chunkData,
+ * decoding it first if its column is decoded lazily.
+ */
+static inline Datum
+ChunkDataValue(ChunkData *chunkData, uint32 columnIndex, uint32 rowIndex)
+{
+	EncodingType lazyEncodingType = chunkData->lazyEncodingArray[columnIndex];
+
+	if (lazyEncodingType != ENCODING_NONE &&
+		chunkData->valueArray[columnIndex][rowIndex] == (Datum) 0)
+	{
+		MemoryContext oldContext = MemoryContextSwitchTo(chunkData->lazyDecodeContext);
+
+		chunkData->valueArray[columnIndex][rowIndex] =
+			DecodeChunkValue(chunkData->valueBufferArray[columnIndex], lazyEncodingType,
+							 chunkData->lazyValueIndexArray[columnIndex][rowIndex]);
+
+		MemoryContextSwitchTo(oldContext);
+	}
+
+	return chunkData->valueArray[columnIndex][rowIndex];
 }
 
 
@@ -2031,6 +3765,9 @@ ColumnDefaultValue(TupleConstr *tupleConstraints, Form_pg_attribute attributeFor
 
 #include "columnar/vectorization/columnar_vector_types.h"
 
+static void UpdateVectorColumnRuns(VectorColumn *vectorColumn, bool *runStartArray,
+								   int rowIndex, bool startNewRun);
+
 bool
 ColumnarReadNextVector(ColumnarReadState *readState,  Datum *columnValues,
 					   bool *columnNulls, uint64 *rowNumber, int *newVectorSize)
@@ -2048,18 +3785,25 @@ ColumnarReadNextVector(ColumnarReadState *readState,  Datum *columnValues,
 														 readState->relation,
 														 readState->tupleDescriptor,
 														 readState->projectedColumnList,
-														 readState->whereClauseList,
-														 readState->whereClauseVars,
+														 readState->chunkRefutationProgram,
+														 readState->zstdDictionaryCache,
 														 readState->stripeReadContext,
 														 readState->snapshot);
 		}
 
+		bool lateMaterialization = readState->lateColumnList != NIL;
+		List *vectorColumnList = lateMaterialization ?
+								 readState->filterColumnList :
+								 readState->projectedColumnList;
+
 		if (!ReadStripeNextVector(readState->stripeReadState, columnValues, columnNulls, 
 								  newVectorSize,
 								  readState->currentStripeMetadata->id,
 								  readState->snapshot,
 								  rowNumber,
-								  readState->currentStripeMetadata->firstRowNumber))
+								  readState->currentStripeMetadata->firstRowNumber,
+								  vectorColumnList,
+								  lateMaterialization))
 		{
 			AdvanceStripeRead(readState);
 			
@@ -2077,13 +3821,164 @@ ColumnarReadNextVector(ColumnarReadState *readState,  Datum *columnValues,
 }
 
 
+/*
+ * ColumnarReadSetFilterColumns enables late materialization for vector reads.
+ * filterColumnList is an integer list of the attribute numbers the vectorized
+ * quals read. Vectors only get those columns, and the other projected columns
+ * are left for ColumnarReadMaterializeVector.
+ */
+void
+ColumnarReadSetFilterColumns(ColumnarReadState *readState, List *filterColumnList)
+{
+	MemoryContext oldContext = MemoryContextSwitchTo(readState->scanContext);
+
+	List *projectedFilterColumnList = NIL;
+	List *lateColumnList = NIL;
+
+	int attno;
+	foreach_int(attno, readState->projectedColumnList)
+	{
+		if (list_member_int(filterColumnList, attno))
+		{
+			projectedFilterColumnList = lappend_int(projectedFilterColumnList, attno);
+		}
+		else
+		{
+			lateColumnList = lappend_int(lateColumnList, attno);
+		}
+	}
+
+	readState->filterColumnList = projectedFilterColumnList;
+	readState->lateColumnList = lateColumnList;
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+
+/*
+ * ColumnarReadMaterializeVector fills the late materialized columns of the
+ * vector last returned by ColumnarReadNextVector for the rows that are kept.
+ * The columns are only deserialized if any row of the vector is kept, and
+ * values of encodings that support random access are only decoded for the
+ * kept rows.
+ */
+void
+ColumnarReadMaterializeVector(ColumnarReadState *readState, Datum *columnValues,
+							  bool *keep, int vectorSize)
+{
+	if (readState->lateColumnList == NIL || !StripeReadInProgress(readState) ||
+		readState->stripeReadState->chunkGroupReadState == NULL)
+	{
+		return;
+	}
+
+	int vectorIndex = 0;
+	while (vectorIndex < vectorSize && !keep[vectorIndex])
+	{
+		vectorIndex++;
+	}
+
+	if (vectorIndex == vectorSize)
+	{
+		return;
+	}
+
+	StripeReadState *stripeReadState = readState->stripeReadState;
+	ChunkGroupReadState *chunkGroupReadState = stripeReadState->chunkGroupReadState;
+	ChunkData *chunkGroupData = chunkGroupReadState->chunkGroupData;
+	uint32 rowCount = chunkGroupReadState->rowCount;
+
+	MemoryContext oldContext = MemoryContextSwitchTo(stripeReadState->stripeReadContext);
+
+	/*
+	 * Vectors of a chunk group larger than a vector share its late columns,
+	 * which are all read together for the first vector with kept rows.
+	 */
+	ColumnChunkBuffers **chunkBuffersArray = NULL;
+	int attno;
+
+	if (chunkGroupData->existsArray[linitial_int(readState->lateColumnList) - 1] == NULL)
+	{
+		bool *lateColumnMask = ProjectedColumnMask(stripeReadState->columnCount,
+												   readState->lateColumnList);
+
+		chunkBuffersArray = LoadChunkGroupBuffers(stripeReadState,
+												  stripeReadState->chunkGroupIndex,
+												  readState->currentStripeMetadata->id,
+												  lateColumnMask);
+		pfree(lateColumnMask);
+	}
+
+	foreach_int(attno, readState->lateColumnList)
+	{
+		/* attno is 1-indexed; existsArray is 0-indexed */
+		const uint32 columnIndex = attno - 1;
+
+		if (chunkBuffersArray != NULL)
+		{
+			chunkGroupData->existsArray[columnIndex] = palloc0(rowCount * sizeof(bool));
+			chunkGroupData->valueArray[columnIndex] = palloc0(rowCount * sizeof(Datum));
+
+			DeserializeChunkColumnData(chunkGroupData, chunkBuffersArray[columnIndex],
+									   stripeReadState->chunkGroupIndex, columnIndex,
+									   rowCount, stripeReadState->tupleDescriptor,
+									   stripeReadState,
+									   readState->currentStripeMetadata->id, true);
+		}
+
+		VectorColumn *vectorColumn = (VectorColumn *) columnValues[columnIndex];
+
+		for (vectorIndex = 0; vectorIndex < vectorSize; vectorIndex++)
+		{
+			uint32 rowIndex = chunkGroupReadState->vectorRowIndexArray[vectorIndex];
+
+			if (!keep[vectorIndex] || !chunkGroupData->existsArray[columnIndex][rowIndex])
+			{
+				continue;
+			}
+
+			int8 *writeColumnRowPosition =
+				(int8 *) vectorColumn->value + vectorColumn->columnTypeLen * vectorIndex;
+
+			Datum value = ChunkDataValue(chunkGroupData, columnIndex, rowIndex);
+
+			if (vectorColumn->columnTypeLen <= sizeof(Datum))
+			{
+				store_att_byval(writeColumnRowPosition, value,
+								vectorColumn->columnTypeLen);
+			}
+			else
+			{
+				memcpy(writeColumnRowPosition, (int8 *) value,
+					   vectorColumn->columnTypeLen);
+			}
+
+			vectorColumn->isnull[vectorIndex] = false;
+		}
+
+		/* only the kept rows are filled, so the column has no runs */
+		vectorColumn->dimension = vectorSize;
+		vectorColumn->hasRuns = false;
+	}
+
+	if (chunkBuffersArray != NULL)
+	{
+		pfree(chunkBuffersArray);
+	}
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+
 static bool
 ReadStripeNextVector(StripeReadState *stripeReadState, Datum *columnValues,
 					 bool *columnNulls, int *newVectorSize,
 					 uint64 stripeId,
 					 Snapshot snapshot,
 					 uint64 *rowNumber,
-					 uint64 stripeFirstRowNumber)
+					 uint64 stripeFirstRowNumber,
+					 List *vectorColumnList,
+					 bool lateMaterialization)
 {
 	if (stripeReadState->currentRow >= stripeReadState->rowCount)
 	{
@@ -2100,18 +3995,27 @@ ReadStripeNextVector(StripeReadState *stripeReadState, Datum *columnValues,
 
 		if (stripeReadState->chunkGroupReadState == NULL)
 		{
+			PrefetchChunkGroups(stripeReadState, vectorColumnList);
+
 			stripeReadState->chunkGroupReadState = BeginChunkGroupRead(
 				stripeReadState->stripeBuffers,
 				stripeReadState->
 				chunkGroupIndex,
 				stripeReadState->
 				tupleDescriptor,
-				stripeReadState->
-				projectedColumnList,
+				vectorColumnList,
 				stripeReadState->
 				stripeReadContext,
 				stripeReadState,
-				stripeId);
+				stripeId,
+				false);
+
+			if (lateMaterialization)
+			{
+				stripeReadState->chunkGroupReadState->vectorRowIndexArray =
+					MemoryContextAlloc(stripeReadState->stripeReadContext,
+									   COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(uint32));
+			}
 
 			chunkFirstRowNumber = stripeFirstRowNumber +
 								  stripeReadState->chunkGroupReadState->chunkStripeRowOffset;
@@ -2201,6 +4105,12 @@ ReadChunkGroupNextVector(ChunkGroupReadState *chunkGroupReadState, Datum *column
 	int i;
 	int rowNumberIndex = 0;
 
+	/*
+	 * Rows of a new chunk group, or rows following a deleted row, never
+	 * continue a run of the vector.
+	 */
+	bool startNewRun = true;
+
 	for (i = 0; i < chunkGroupReadState->rowCount; i ++)
 	{
 		if (chunkGroupReadState->currentRow >= chunkGroupReadState->rowCount)
@@ -2217,6 +4127,7 @@ ReadChunkGroupNextVector(ChunkGroupReadState *chunkGroupReadState, Datum *column
 			if (checkLookupMask & checkColumnMask)
 			{
 				chunkGroupReadState->currentRow++;
+				startNewRun = true;
 				continue;
 			}
 		}
@@ -2224,7 +4135,7 @@ ReadChunkGroupNextVector(ChunkGroupReadState *chunkGroupReadState, Datum *column
 		int attno;
 		foreach_int(attno, chunkGroupReadState->projectedColumnList)
 		{
-			const ChunkData *chunkGroupData = chunkGroupReadState->chunkGroupData;
+			ChunkData *chunkGroupData = chunkGroupReadState->chunkGroupData;
 			const int rowIndex = chunkGroupReadState->currentRow;
 
 			/* attno is 1-indexed; existsArray is 0-indexed */
@@ -2242,26 +4153,37 @@ ReadChunkGroupNextVector(ChunkGroupReadState *chunkGroupReadState, Datum *column
 				 * For data types which have len less or equal sizeof(Datum) we can
 				 * use `store_att_byval` function.
 				 */
+				Datum value = ChunkDataValue(chunkGroupData, columnIndex, rowIndex);
+
 				if (vectorColumn->columnTypeLen <= sizeof(Datum))
 				{
-					store_att_byval(writeColumnRowPosition,
-									chunkGroupData->valueArray[columnIndex][rowIndex],
+					store_att_byval(writeColumnRowPosition, value,
 									vectorColumn->columnTypeLen);
 				}
 				else
 				{
-					memcpy(writeColumnRowPosition,
-						   (int8 *)(chunkGroupData->valueArray[columnIndex][rowIndex]),
+					memcpy(writeColumnRowPosition, (int8 *) value,
 						   vectorColumn->columnTypeLen);
 				}
 
 				vectorColumn->isnull[vectorColumn->dimension] = false;
 			}
 
+			UpdateVectorColumnRuns(vectorColumn,
+								   chunkGroupData->runStartArray[columnIndex],
+								   rowIndex, startNewRun);
+
 			vectorColumn->dimension++;
 			columnValueOffset[columnIndex] += vectorColumn->columnTypeLen;
 		}
 
+		if (chunkGroupReadState->vectorRowIndexArray != NULL)
+		{
+			chunkGroupReadState->vectorRowIndexArray[*chunkReadRows] =
+				chunkGroupReadState->currentRow;
+		}
+
+		startNewRun = false;
 		(*chunkReadRows)++;
 		chunkGroupReadState->currentRow++;
 		rowNumber[rowNumberIndex++] = stripeFirstRowNumber + chunkGroupReadState->currentRow - 1;
@@ -2269,3 +4191,47 @@ ReadChunkGroupNextVector(ChunkGroupReadState *chunkGroupReadState, Datum *column
 
 	return true;
 }
+
+
+/*
+ * UpdateVectorColumnRuns extends the run-length description of the given
+ * vector column with the row that is about to be appended to it. Runs are only
+ * kept while every appended row comes from a run-length encoded chunk.
+ */
+static void
+UpdateVectorColumnRuns(VectorColumn *vectorColumn, bool *runStartArray,
+					   int rowIndex, bool startNewRun)
+{
+	if (vectorColumn->dimension == 0)
+	{
+		vectorColumn->hasRuns = true;
+		vectorColumn->runCount = 0;
+	}
+
+	if (!vectorColumn->hasRuns)
+	{
+		return;
+	}
+
+	if (runStartArray == NULL)
+	{
+		vectorColumn->hasRuns = false;
+		return;
+	}
+
+	if (vectorColumn->runLength == NULL)
+	{
+		vectorColumn->runLength =
+			MemoryContextAlloc(GetMemoryChunkContext(vectorColumn),
+							   COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(uint32));
+	}
+
+	if (startNewRun || vectorColumn->runCount == 0 || runStartArray[rowIndex])
+	{
+		vectorColumn->runLength[vectorColumn->runCount++] = 1;
+	}
+	else
+	{
+		vectorColumn->runLength[vectorColumn->runCount - 1]++;
+	}
+}
@@ -0,0 +1,672 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_shared_cache.c
+ *
+ * Column cache in shared memory, used instead of the per-backend cache of
+ * columnar_cache.c when columnar.shared_column_cache_size is set and columnar
+ * is loaded with shared_preload_libraries. Decompressed chunks cached by one
+ * backend are then served to all others, and stay cached after scans end.
+ *
+ * Entries are keyed by (database, storage id, stripe id, chunk group, column).
+ * Storage ids are only unique within a database, but are never reused there,
+ * and stripes are never rewritten in place, so a cached chunk can't go stale,
+ * and there is no invalidation. Entries of dropped or rewritten tables just
+ * age out.
+ *
+ * The cache memory is divided into fixed size blocks. An entry's data is kept
+ * in a chain of blocks, so that entries of any size can be stored without
+ * fragmentation, and is copied out of the chain when retrieved. Lookups go
+ * through a partitioned shared hash table, and take only the lock of their
+ * partition. Allocation and eviction take the allocator lock; entries are
+ * evicted with a clock sweep over their usage counts.
+ *
+ * Lock order is the allocator lock before partition locks.
+ *
+ * Copyright (c) Hydra, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/hsearch.h"
+
+#include "pg_version_compat.h"
+
+#include "columnar/columnar.h"
+
+#define COLUMNAR_SHARED_CACHE_TRANCHE "columnar shared cache"
+#define COLUMNAR_SHARED_CACHE_BLOCK_SIZE 8192
+#define COLUMNAR_SHARED_CACHE_PARTITIONS 16
+#define COLUMNAR_SHARED_CACHE_MAX_USAGE 5
+
+typedef struct ColumnarSharedCacheKey
+{
+	uint64 storageId;
+	uint64 stripeId;
+	uint64 chunkId;
+	uint32 columnId;
+	Oid databaseId;
+} ColumnarSharedCacheKey;
+
+typedef struct ColumnarSharedCacheHashEntry
+{
+	ColumnarSharedCacheKey key;
+	int32 entryIndex;
+} ColumnarSharedCacheHashEntry;
+
+typedef enum ColumnarSharedCacheEntryState
+{
+	SHARED_CACHE_ENTRY_FREE,
+
+	/* blocks are allocated, and being filled by the backend adding the entry */
+	SHARED_CACHE_ENTRY_RESERVED,
+
+	/* in the hash table, and can be retrieved and evicted */
+	SHARED_CACHE_ENTRY_VALID
+} ColumnarSharedCacheEntryState;
+
+typedef struct ColumnarSharedCacheEntry
+{
+	ColumnarSharedCacheKey key;
+	uint32 hashcode;
+	ColumnarSharedCacheEntryState state;
+	uint32 length;
+	int32 firstBlock;
+	int32 nextFreeEntry;
+	pg_atomic_uint32 usageCount;
+} ColumnarSharedCacheEntry;
+
+/*
+ * ColumnarSharedCacheControl is the shared state of the cache. Every entry
+ * takes at least one block, so there are as many entry slots as blocks. All
+ * fields except the entries' usage counts are protected by the allocator lock,
+ * or by the partition lock of the entry for VALID entries' contents.
+ */
+typedef struct ColumnarSharedCacheControl
+{
+	int32 blockCount;
+	int32 freeBlockHead;
+	int32 freeBlockCount;
+	int32 freeEntryHead;
+	int32 clockHand;
+	int32 usedEntryCount;
+	uint64 usedBytes;
+	ColumnarSharedCacheEntry entries[FLEXIBLE_ARRAY_MEMBER];
+} ColumnarSharedCacheControl;
+
+static ColumnarSharedCacheControl *sharedCache = NULL;
+static int32 *sharedCacheBlockNext = NULL;
+static char *sharedCacheBlocks = NULL;
+static HTAB *sharedCacheHash = NULL;
+static LWLockPadded *sharedCacheLocks = NULL;
+
+#if PG_VERSION_NUM >= PG_VERSION_15
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+#endif
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static int32 ColumnarSharedCacheBlockCount(void);
+static Size ColumnarSharedCacheControlSize(int32 blockCount);
+static void ColumnarSharedCacheShmemRequest(void);
+static void ColumnarSharedCacheShmemStartup(void);
+static void ColumnarSharedCacheInitKey(ColumnarSharedCacheKey *key, uint64 storageId,
+									   uint64 stripeId, uint64 chunkId,
+									   uint32 columnId);
+static LWLock * ColumnarSharedCacheAllocatorLock(void);
+static LWLock * ColumnarSharedCachePartitionLock(uint32 hashcode);
+static bool ColumnarSharedCacheEvictOne(void);
+static void ColumnarSharedCacheFreeEntry(int32 entryIndex);
+
+
+/*
+ * ColumnarSharedCacheInit requests the shared memory of the cache. It must be
+ * called from _PG_init, and does nothing unless columnar is being loaded with
+ * shared_preload_libraries and columnar.shared_column_cache_size is set.
+ */
+void
+ColumnarSharedCacheInit(void)
+{
+	if (!process_shared_preload_libraries_in_progress ||
+		columnar_shared_column_cache_size == 0)
+	{
+		return;
+	}
+
+#if PG_VERSION_NUM >= PG_VERSION_15
+	prev_shmem_request_hook = shmem_request_hook;
+	shmem_request_hook = ColumnarSharedCacheShmemRequest;
+#else
+	ColumnarSharedCacheShmemRequest();
+#endif
+
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = ColumnarSharedCacheShmemStartup;
+}
+
+
+/*
+ * ColumnarSharedCacheEnabled returns true if the column cache lives in shared
+ * memory.
+ */
+bool
+ColumnarSharedCacheEnabled(void)
+{
+	return sharedCache != NULL;
+}
+
+
+/*
+ * ColumnarSharedCacheBlockCount returns the number of blocks the configured
+ * cache size fits.
+ */
+static int32
+ColumnarSharedCacheBlockCount(void)
+{
+	return (int32) ((uint64) columnar_shared_column_cache_size * 1024 * 1024 /
+					COLUMNAR_SHARED_CACHE_BLOCK_SIZE);
+}
+
+
+/*
+ * ColumnarSharedCacheControlSize returns the size of the control struct,
+ * including its entries and the block chain links, for the given number of
+ * blocks.
+ */
+static Size
+ColumnarSharedCacheControlSize(int32 blockCount)
+{
+	Size size = offsetof(ColumnarSharedCacheControl, entries);
+	size = add_size(size, mul_size(blockCount, sizeof(ColumnarSharedCacheEntry)));
+	size = add_size(size, mul_size(blockCount, sizeof(int32)));
+
+	return MAXALIGN(size);
+}
+
+
+/*
+ * ColumnarSharedCacheShmemRequest requests the shared memory and the locks of
+ * the cache.
+ */
+static void
+ColumnarSharedCacheShmemRequest(void)
+{
+#if PG_VERSION_NUM >= PG_VERSION_15
+	if (prev_shmem_request_hook)
+	{
+		prev_shmem_request_hook();
+	}
+#endif
+
+	int32 blockCount = ColumnarSharedCacheBlockCount();
+	Size size = ColumnarSharedCacheControlSize(blockCount);
+	size = add_size(size, mul_size(blockCount, COLUMNAR_SHARED_CACHE_BLOCK_SIZE));
+	size = add_size(size, hash_estimate_size(blockCount,
+											 sizeof(ColumnarSharedCacheHashEntry)));
+
+	RequestAddinShmemSpace(size);
+	RequestNamedLWLockTranche(COLUMNAR_SHARED_CACHE_TRANCHE,
+							  COLUMNAR_SHARED_CACHE_PARTITIONS + 1);
+}
+
+
+/*
+ * ColumnarSharedCacheShmemStartup creates the shared state of the cache, or
+ * attaches to it.
+ */
+static void
+ColumnarSharedCacheShmemStartup(void)
+{
+	if (prev_shmem_startup_hook)
+	{
+		prev_shmem_startup_hook();
+	}
+
+	int32 blockCount = ColumnarSharedCacheBlockCount();
+	Size controlSize = ColumnarSharedCacheControlSize(blockCount);
+	bool found = false;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	ColumnarSharedCacheControl *control =
+		ShmemInitStruct("columnar shared cache", controlSize, &found);
+	char *blocks = ShmemInitStruct("columnar shared cache blocks",
+								   mul_size(blockCount,
+											COLUMNAR_SHARED_CACHE_BLOCK_SIZE),
+								   &found);
+
+	sharedCacheBlockNext =
+		(int32 *) ((char *) control + offsetof(ColumnarSharedCacheControl, entries) +
+				   blockCount * sizeof(ColumnarSharedCacheEntry));
+	sharedCacheBlocks = blocks;
+
+	if (!found)
+	{
+		control->blockCount = blockCount;
+		control->freeBlockHead = 0;
+		control->freeBlockCount = blockCount;
+		control->freeEntryHead = 0;
+		control->clockHand = 0;
+		control->usedEntryCount = 0;
+		control->usedBytes = 0;
+
+		for (int32 index = 0; index < blockCount; index++)
+		{
+			ColumnarSharedCacheEntry *entry = &control->entries[index];
+
+			memset(entry, 0, sizeof(ColumnarSharedCacheEntry));
+			entry->state = SHARED_CACHE_ENTRY_FREE;
+			entry->firstBlock = -1;
+			entry->nextFreeEntry = index + 1 < blockCount ? index + 1 : -1;
+			pg_atomic_init_u32(&entry->usageCount, 0);
+
+			sharedCacheBlockNext[index] = index + 1 < blockCount ? index + 1 : -1;
+		}
+	}
+
+	HASHCTL info;
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(ColumnarSharedCacheKey);
+	info.entrysize = sizeof(ColumnarSharedCacheHashEntry);
+	info.num_partitions = COLUMNAR_SHARED_CACHE_PARTITIONS;
+
+	sharedCacheHash = ShmemInitHash("columnar shared cache hash",
+									blockCount, blockCount, &info,
+									HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+	sharedCacheLocks = GetNamedLWLockTranche(COLUMNAR_SHARED_CACHE_TRANCHE);
+	sharedCache = control;
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+
+/*
+ * ColumnarSharedCacheInitKey fills in a hash key for a chunk of the current
+ * database.
+ */
+static void
+ColumnarSharedCacheInitKey(ColumnarSharedCacheKey *key, uint64 storageId,
+						   uint64 stripeId, uint64 chunkId, uint32 columnId)
+{
+	memset(key, 0, sizeof(ColumnarSharedCacheKey));
+	key->storageId = storageId;
+	key->stripeId = stripeId;
+	key->chunkId = chunkId;
+	key->columnId = columnId;
+	key->databaseId = MyDatabaseId;
+}
+
+
+static LWLock *
+ColumnarSharedCacheAllocatorLock(void)
+{
+	return &sharedCacheLocks[0].lock;
+}
+
+
+static LWLock *
+ColumnarSharedCachePartitionLock(uint32 hashcode)
+{
+	return &sharedCacheLocks[1 + hashcode % COLUMNAR_SHARED_CACHE_PARTITIONS].lock;
+}
+
+
+/*
+ * ColumnarSharedCacheRetrieve returns a copy of the cached data of the given
+ * chunk in the current memory context, or NULL if it isn't cached.
+ */
+StringInfo
+ColumnarSharedCacheRetrieve(uint64 storageId, uint64 stripeId, uint64 chunkId,
+							uint32 columnId)
+{
+	ColumnarSharedCacheKey key;
+	ColumnarSharedCacheInitKey(&key, storageId, stripeId, chunkId, columnId);
+
+	uint32 hashcode = get_hash_value(sharedCacheHash, &key);
+	LWLock *partitionLock = ColumnarSharedCachePartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_SHARED);
+
+	ColumnarSharedCacheHashEntry *hashEntry =
+		hash_search_with_hash_value(sharedCacheHash, &key, hashcode, HASH_FIND, NULL);
+
+	if (hashEntry == NULL)
+	{
+		LWLockRelease(partitionLock);
+		return NULL;
+	}
+
+	ColumnarSharedCacheEntry *entry = &sharedCache->entries[hashEntry->entryIndex];
+
+	StringInfo data = makeStringInfo();
+	enlargeStringInfo(data, entry->length);
+
+	uint32 copied = 0;
+	int32 blockIndex = entry->firstBlock;
+
+	while (copied < entry->length)
+	{
+		uint32 toCopy = Min(entry->length - copied, COLUMNAR_SHARED_CACHE_BLOCK_SIZE);
+
+		memcpy(data->data + copied,
+			   sharedCacheBlocks + (Size) blockIndex * COLUMNAR_SHARED_CACHE_BLOCK_SIZE,
+			   toCopy);
+
+		copied += toCopy;
+		blockIndex = sharedCacheBlockNext[blockIndex];
+	}
+
+	data->len = entry->length;
+	data->data[data->len] = '\0';
+
+	if (pg_atomic_read_u32(&entry->usageCount) < COLUMNAR_SHARED_CACHE_MAX_USAGE)
+	{
+		pg_atomic_fetch_add_u32(&entry->usageCount, 1);
+	}
+
+	LWLockRelease(partitionLock);
+
+	return data;
+}
+
+
+/*
+ * ColumnarSharedCacheAdd copies the given data of a chunk into the cache,
+ * evicting other entries if needed, and returns true if it stored the chunk.
+ * Chunks that are already cached, and ones larger than a quarter of the cache,
+ * are left alone. evictedCount is set to the number of entries evicted.
+ */
+bool
+ColumnarSharedCacheAdd(uint64 storageId, uint64 stripeId, uint64 chunkId,
+					   uint32 columnId, StringInfo data, int *evictedCount)
+{
+	ColumnarSharedCacheKey key;
+	ColumnarSharedCacheInitKey(&key, storageId, stripeId, chunkId, columnId);
+
+	uint32 hashcode = get_hash_value(sharedCacheHash, &key);
+	LWLock *partitionLock = ColumnarSharedCachePartitionLock(hashcode);
+	uint32 length = data->len;
+	int32 blocksNeeded = Max(1, (length + COLUMNAR_SHARED_CACHE_BLOCK_SIZE - 1) /
+							 COLUMNAR_SHARED_CACHE_BLOCK_SIZE);
+
+	*evictedCount = 0;
+
+	if (blocksNeeded > sharedCache->blockCount / 4)
+	{
+		return false;
+	}
+
+	LWLockAcquire(partitionLock, LW_SHARED);
+	bool cached = hash_search_with_hash_value(sharedCacheHash, &key, hashcode,
+											  HASH_FIND, NULL) != NULL;
+	LWLockRelease(partitionLock);
+
+	if (cached)
+	{
+		return false;
+	}
+
+	/* reserve an entry and its blocks */
+	LWLockAcquire(ColumnarSharedCacheAllocatorLock(), LW_EXCLUSIVE);
+
+	while (sharedCache->freeBlockCount < blocksNeeded || sharedCache->freeEntryHead < 0)
+	{
+		if (!ColumnarSharedCacheEvictOne())
+		{
+			/* everything else is being added right now */
+			LWLockRelease(ColumnarSharedCacheAllocatorLock());
+			return false;
+		}
+
+		(*evictedCount)++;
+	}
+
+	int32 entryIndex = sharedCache->freeEntryHead;
+	ColumnarSharedCacheEntry *entry = &sharedCache->entries[entryIndex];
+	sharedCache->freeEntryHead = entry->nextFreeEntry;
+
+	int32 firstBlock = sharedCache->freeBlockHead;
+	int32 lastBlock = firstBlock;
+	for (int32 blockNumber = 1; blockNumber < blocksNeeded; blockNumber++)
+	{
+		lastBlock = sharedCacheBlockNext[lastBlock];
+	}
+
+	sharedCache->freeBlockHead = sharedCacheBlockNext[lastBlock];
+	sharedCache->freeBlockCount -= blocksNeeded;
+	sharedCacheBlockNext[lastBlock] = -1;
+
+	entry->state = SHARED_CACHE_ENTRY_RESERVED;
+	entry->firstBlock = firstBlock;
+	entry->length = length;
+	sharedCache->usedEntryCount++;
+	sharedCache->usedBytes += length;
+
+	LWLockRelease(ColumnarSharedCacheAllocatorLock());
+
+	/* the reserved blocks are ours alone, so they are filled without locks */
+	uint32 copied = 0;
+	int32 blockIndex = firstBlock;
+
+	while (copied < length)
+	{
+		uint32 toCopy = Min(length - copied, COLUMNAR_SHARED_CACHE_BLOCK_SIZE);
+
+		memcpy(sharedCacheBlocks + (Size) blockIndex * COLUMNAR_SHARED_CACHE_BLOCK_SIZE,
+			   data->data + copied, toCopy);
+
+		copied += toCopy;
+		blockIndex = sharedCacheBlockNext[blockIndex];
+	}
+
+	entry->key = key;
+	entry->hashcode = hashcode;
+	pg_atomic_write_u32(&entry->usageCount, 1);
+
+	/* publish the entry */
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+
+	bool found = false;
+	ColumnarSharedCacheHashEntry *hashEntry =
+		hash_search_with_hash_value(sharedCacheHash, &key, hashcode,
+									HASH_ENTER_NULL, &found);
+
+	if (hashEntry != NULL && !found)
+	{
+		hashEntry->entryIndex = entryIndex;
+		entry->state = SHARED_CACHE_ENTRY_VALID;
+
+		LWLockRelease(partitionLock);
+		return true;
+	}
+
+	LWLockRelease(partitionLock);
+
+	/* another backend added the chunk in the meantime */
+	LWLockAcquire(ColumnarSharedCacheAllocatorLock(), LW_EXCLUSIVE);
+	ColumnarSharedCacheFreeEntry(entryIndex);
+	LWLockRelease(ColumnarSharedCacheAllocatorLock());
+
+	return false;
+}
+
+
+/*
+ * ColumnarSharedCacheEvictOne advances the clock hand until it finds a valid
+ * entry whose usage count has dropped to zero, decrementing the usage counts
+ * of the entries it passes, and evicts it. It returns false if no entry could
+ * be evicted, which happens if all of them are being added. The caller must
+ * hold the allocator lock.
+ */
+static bool
+ColumnarSharedCacheEvictOne(void)
+{
+	int32 entryCount = sharedCache->blockCount;
+	int64 maxSteps = (int64) entryCount * (COLUMNAR_SHARED_CACHE_MAX_USAGE + 1);
+
+	for (int64 step = 0; step < maxSteps; step++)
+	{
+		int32 entryIndex = sharedCache->clockHand;
+		ColumnarSharedCacheEntry *entry = &sharedCache->entries[entryIndex];
+
+		sharedCache->clockHand = (entryIndex + 1) % entryCount;
+
+		if (entry->state != SHARED_CACHE_ENTRY_VALID)
+		{
+			continue;
+		}
+
+		if (pg_atomic_read_u32(&entry->usageCount) > 0)
+		{
+			pg_atomic_fetch_sub_u32(&entry->usageCount, 1);
+			continue;
+		}
+
+		LWLock *partitionLock = ColumnarSharedCachePartitionLock(entry->hashcode);
+
+		LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+		hash_search_with_hash_value(sharedCacheHash, &entry->key, entry->hashcode,
+									HASH_REMOVE, NULL);
+		LWLockRelease(partitionLock);
+
+		ColumnarSharedCacheFreeEntry(entryIndex);
+
+		return true;
+	}
+
+	return false;
+}
+
+
+/*
+ * ColumnarSharedCacheFreeEntry returns an entry that is no longer in the hash
+ * table, and its blocks, to the free lists. The caller must hold the allocator
+ * lock.
+ */
+static void
+ColumnarSharedCacheFreeEntry(int32 entryIndex)
+{
+	ColumnarSharedCacheEntry *entry = &sharedCache->entries[entryIndex];
+	int32 blockCount = 1;
+	int32 lastBlock = entry->firstBlock;
+
+	while (sharedCacheBlockNext[lastBlock] >= 0)
+	{
+		lastBlock = sharedCacheBlockNext[lastBlock];
+		blockCount++;
+	}
+
+	sharedCacheBlockNext[lastBlock] = sharedCache->freeBlockHead;
+	sharedCache->freeBlockHead = entry->firstBlock;
+	sharedCache->freeBlockCount += blockCount;
+
+	sharedCache->usedEntryCount--;
+	sharedCache->usedBytes -= entry->length;
+
+	entry->state = SHARED_CACHE_ENTRY_FREE;
+	entry->firstBlock = -1;
+	entry->length = 0;
+	entry->nextFreeEntry = sharedCache->freeEntryHead;
+	sharedCache->freeEntryHead = entryIndex;
+}
+
+
+/*
+ * ColumnarSharedCacheRemove removes the given chunk of the current database
+ * from the cache, and returns false if it wasn't cached.
+ */
+bool
+ColumnarSharedCacheRemove(uint64 storageId, uint64 stripeId, uint64 chunkId,
+						  uint32 columnId)
+{
+	ColumnarSharedCacheKey key;
+	ColumnarSharedCacheInitKey(&key, storageId, stripeId, chunkId, columnId);
+
+	uint32 hashcode = get_hash_value(sharedCacheHash, &key);
+	LWLock *partitionLock = ColumnarSharedCachePartitionLock(hashcode);
+
+	LWLockAcquire(ColumnarSharedCacheAllocatorLock(), LW_EXCLUSIVE);
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+
+	ColumnarSharedCacheHashEntry *hashEntry =
+		hash_search_with_hash_value(sharedCacheHash, &key, hashcode, HASH_FIND, NULL);
+	int32 entryIndex = hashEntry != NULL ? hashEntry->entryIndex : -1;
+
+	if (hashEntry != NULL)
+	{
+		hash_search_with_hash_value(sharedCacheHash, &key, hashcode, HASH_REMOVE,
+									NULL);
+	}
+
+	LWLockRelease(partitionLock);
+
+	if (entryIndex >= 0)
+	{
+		ColumnarSharedCacheFreeEntry(entryIndex);
+	}
+
+	LWLockRelease(ColumnarSharedCacheAllocatorLock());
+
+	return entryIndex >= 0;
+}
+
+
+/*
+ * ColumnarSharedCacheUsage returns the number of cached entries and the total
+ * size of their data.
+ */
+void
+ColumnarSharedCacheUsage(uint64 *entries, uint64 *size)
+{
+	LWLockAcquire(ColumnarSharedCacheAllocatorLock(), LW_SHARED);
+	*entries = sharedCache->usedEntryCount;
+	*size = sharedCache->usedBytes;
+	LWLockRelease(ColumnarSharedCacheAllocatorLock());
+}
+
+
+/*
+ * ColumnarSharedCacheChunks returns the keys of the cached chunks of all
+ * databases in a palloc'd array, and sets chunkCount to their number.
+ */
+ColumnarCachedChunk *
+ColumnarSharedCacheChunks(int *chunkCount)
+{
+	/*
+	 * Entries can't be reserved or freed while the allocator lock is held, so
+	 * there are at most usedEntryCount valid ones.
+	 */
+	LWLockAcquire(ColumnarSharedCacheAllocatorLock(), LW_SHARED);
+
+	ColumnarCachedChunk *chunkArray =
+		palloc(Max(sharedCache->usedEntryCount, 1) * sizeof(ColumnarCachedChunk));
+	int count = 0;
+
+	for (int32 entryIndex = 0; entryIndex < sharedCache->blockCount; entryIndex++)
+	{
+		ColumnarSharedCacheEntry *entry = &sharedCache->entries[entryIndex];
+
+		if (entry->state != SHARED_CACHE_ENTRY_VALID)
+		{
+			continue;
+		}
+
+		chunkArray[count].databaseId = entry->key.databaseId;
+		chunkArray[count].storageId = entry->key.storageId;
+		chunkArray[count].stripeId = entry->key.stripeId;
+		chunkArray[count].chunkId = entry->key.chunkId;
+		chunkArray[count].columnId = entry->key.columnId;
+		count++;
+	}
+
+	LWLockRelease(ColumnarSharedCacheAllocatorLock());
+
+	*chunkCount = count;
+
+	return chunkArray;
+}
@@ -138,6 +138,8 @@ PhysicalToLogical(PhysicalAddr addr)
 static void ColumnarOverwriteMetapage(Relation relation,
 									  ColumnarMetapage columnarMetapage);
 static ColumnarMetapage ColumnarMetapageRead(Relation rel, bool force);
+static void CopyFromPage(Relation rel, Buffer buffer, uint32 offset, char *buf,
+						 uint32 len, bool force);
 static void ReadFromBlock(Relation rel, BlockNumber blockno, uint32 offset,
 						  char *buf, uint32 len, bool force);
 static void WriteToBlock(Relation rel, BlockNumber blockno, uint32 offset,
@@ -525,6 +527,94 @@ ColumnarStorageRead(Relation rel, uint64 logicalOffset, char *data, uint32 amoun
 }
 
 
+/*
+ * ColumnarStorageReadRanges - read each of the given ranges of logical offsets
+ * into its data buffer. Unlike separate ColumnarStorageRead calls, a page is
+ * kept pinned and locked for as long as consecutive ranges are read from it,
+ * so when the ranges are sorted by offset every page is visited only once, no
+ * matter how many of the ranges share it.
+ */
+void
+ColumnarStorageReadRanges(Relation rel, ColumnarStorageRange *ranges, int rangeCount)
+{
+	Buffer buffer = InvalidBuffer;
+
+	for (int rangeIndex = 0; rangeIndex < rangeCount; rangeIndex++)
+	{
+		ColumnarStorageRange *range = &ranges[rangeIndex];
+
+		/* if there's no work to do, succeed even with invalid offset */
+		if (range->amount == 0)
+		{
+			continue;
+		}
+
+		if (!ColumnarLogicalOffsetIsValid(range->logicalOffset))
+		{
+			elog(ERROR,
+				 "attempted columnar read on relation %d from invalid logical offset: "
+				 UINT64_FORMAT,
+				 rel->rd_id, range->logicalOffset);
+		}
+
+		uint64 read = 0;
+
+		while (read < range->amount)
+		{
+			PhysicalAddr addr = LogicalToPhysical(range->logicalOffset + read);
+
+			if (!BufferIsValid(buffer) || BufferGetBlockNumber(buffer) != addr.blockno)
+			{
+				if (BufferIsValid(buffer))
+				{
+					UnlockReleaseBuffer(buffer);
+				}
+
+				buffer = ReadBuffer(rel, addr.blockno);
+				LockBuffer(buffer, BUFFER_LOCK_SHARE);
+			}
+
+			uint32 to_read = Min(range->amount - read, BLCKSZ - addr.offset);
+			CopyFromPage(rel, buffer, addr.offset, range->data + read, to_read,
+						 false);
+
+			read += to_read;
+		}
+	}
+
+	if (BufferIsValid(buffer))
+	{
+		UnlockReleaseBuffer(buffer);
+	}
+}
+
+
+/*
+ * ColumnarStoragePrefetch - issue prefetch requests for the blocks that hold
+ * the given range of logical offsets, so that a later ColumnarStorageRead of
+ * the range doesn't have to wait for them. This is a no-op on builds without
+ * prefetch support.
+ */
+void
+ColumnarStoragePrefetch(Relation rel, uint64 logicalOffset, uint32 amount)
+{
+#ifdef USE_PREFETCH
+	if (amount == 0 || !ColumnarLogicalOffsetIsValid(logicalOffset))
+	{
+		return;
+	}
+
+	BlockNumber firstBlockno = LogicalToPhysical(logicalOffset).blockno;
+	BlockNumber lastBlockno = LogicalToPhysical(logicalOffset + amount - 1).blockno;
+
+	for (BlockNumber blockno = firstBlockno; blockno <= lastBlockno; blockno++)
+	{
+		PrefetchBuffer(rel, MAIN_FORKNUM, blockno);
+	}
+#endif
+}
+
+
 /*
  * ColumnarStorageWrite - map the logical offset to a block and offset, then
  * write the buffer across multiple blocks if necessary.
@@ -722,6 +812,19 @@ ReadFromBlock(Relation rel, BlockNumber blockno, uint32 offset, char *buf,
 {
 	Buffer buffer = ReadBuffer(rel, blockno);
 	LockBuffer(buffer, BUFFER_LOCK_SHARE);
+	CopyFromPage(rel, buffer, offset, buf, len, force);
+	UnlockReleaseBuffer(buffer);
+}
+
+
+/*
+ * CopyFromPage - copy bytes at the given offset out of a pinned and locked
+ * buffer. If 'force' is true, don't check pd_lower.
+ */
+static void
+CopyFromPage(Relation rel, Buffer buffer, uint32 offset, char *buf, uint32 len,
+			 bool force)
+{
 	Page page = BufferGetPage(buffer);
 	PageHeader phdr = (PageHeader) page;
 
@@ -729,11 +832,10 @@ ReadFromBlock(Relation rel, BlockNumber blockno, uint32 offset, char *buf,
 	{
 		elog(ERROR,
 			 "attempt to read columnar data of length %d from offset %d of block %d of relation %d",
-			 len, offset, blockno, rel->rd_id);
+			 len, offset, BufferGetBlockNumber(buffer), rel->rd_id);
 	}
 
 	memcpy_s(buf, len, page + offset, len);
-	UnlockReleaseBuffer(buffer);
 }
 
 
@@ -28,6 +28,7 @@
 #include "catalog/pg_am.h"
 #include "catalog/pg_publication.h"
 #include "catalog/pg_trigger.h"
+#include "catalog/pg_type.h"
 #include "catalog/pg_extension.h"
 #include "catalog/storage.h"
 #include "catalog/storage_xlog.h"
@@ -51,6 +52,7 @@
 #include "storage/procarray.h"
 #include "storage/smgr.h"
 #include "tcop/utility.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
 #include "utils/memutils.h"
@@ -100,6 +102,12 @@ typedef struct ColumnarScanDescData
 
 	/* Vectorization */
 	bool returnVectorizedTuple;
+
+	/*
+	 * Attributes the vectorized quals read. If set, the other attributes in
+	 * attr_needed are materialized late.
+	 */
+	Bitmapset *attr_filter;
 } ColumnarScanDescData;
 
 
@@ -156,6 +164,12 @@ static void TruncateColumnar(Relation rel, int elevel);
 static bool TruncateAndCombineColumnarStripes(Relation rel, int elevel);
 static HeapTuple ColumnarSlotCopyHeapTuple(TupleTableSlot *slot);
 static void ColumnarCheckLogicalReplication(Relation rel);
+static List * ColumnNameArrayToAttrNumList(Relation rel, ArrayType *columnNameArray);
+static void UpdateColumnOptions(Oid relationId, List *attrNumList,
+								bool setCompressionType,
+								CompressionType compressionType,
+								bool setCompressionLevel, int compressionLevel,
+								bool setBloomFilter, bool bloomFilter);
 static Datum * detoast_values(TupleDesc tupleDesc, Datum *orig_values, bool *isnull);
 static uint64 tid_to_row_number(ItemPointerData tid);
 static void ErrorIfInvalidRowNumber(uint64 rowNumber);
@@ -209,7 +223,7 @@ columnar_beginscan(Relation relation, Snapshot snapshot,
 														 parallel_scan,
 														 flags, attr_needed, NULL,
 														 NULL,
-														 false);
+														 false, NULL);
 
 	bms_free(attr_needed);
 
@@ -223,7 +237,7 @@ columnar_beginscan_extended(Relation relation, Snapshot snapshot,
 							ParallelTableScanDesc parallel_scan,
 							uint32 flags, Bitmapset *attr_needed, List *scanQual,
 							ParallelColumnarScan parallelColumnarScan,
-							bool returnVectorizedTuple)
+							bool returnVectorizedTuple, Bitmapset *attr_filter)
 {
 	previousCacheEnabledState = columnar_enable_page_cache;
 #if PG_VERSION_NUM >= PG_VERSION_16
@@ -264,6 +278,7 @@ columnar_beginscan_extended(Relation relation, Snapshot snapshot,
 
 	/* Vectorized result */
 	scan->returnVectorizedTuple = returnVectorizedTuple;
+	scan->attr_filter = bms_copy(attr_filter);
 
 	if (PendingWritesInUpperTransactions(relfilelocator, GetCurrentSubTransactionId()))
 	{
@@ -372,6 +387,17 @@ columnar_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableSlo
 									 scan->scanContext, scan->cs_base.rs_snapshot,
 									 randomAccess,
 									 scan->parallelColumnarScan);
+
+		if (scan->returnVectorizedTuple && scan->attr_filter != NULL)
+		{
+			MemoryContext oldContext = MemoryContextSwitchTo(scan->scanContext);
+
+			List *filterColumnList = NeededColumnsList(slot->tts_tupleDescriptor,
+													   scan->attr_filter);
+			ColumnarReadSetFilterColumns(scan->cs_readState, filterColumnList);
+
+			MemoryContextSwitchTo(oldContext);
+		}
 	}
 
 	ExecClearTuple(slot);
@@ -2717,6 +2743,26 @@ columnar_tableam_init()
 }
 
 
+/*
+ * ColumnarScanMaterializeVector fills the late materialized columns of the
+ * vector slot last returned by the given scan for the rows it keeps.
+ */
+void
+ColumnarScanMaterializeVector(ColumnarScanDesc columnarScanDesc,
+							  TupleTableSlot *slot)
+{
+	VectorTupleTableSlot *vectorSlot = (VectorTupleTableSlot *) slot;
+
+	/* readState is initialized lazily */
+	if (columnarScanDesc->cs_readState != NULL)
+	{
+		ColumnarReadMaterializeVector(columnarScanDesc->cs_readState,
+									  vectorSlot->tts.tts_values, vectorSlot->keep,
+									  vectorSlot->dimension);
+	}
+}
+
+
 /*
  * Get the number of chunks filtered out during the given scan.
  */
@@ -3123,11 +3169,14 @@ ColumnarCheckLogicalReplication(Relation rel)
  * table. Calling this function on a non-columnar table gives an error.
  *
  * sql syntax:
- *   pg_catalog.alter_columnar_table_set(
+ *   columnar.alter_columnar_table_set(
  *        table_name regclass,
  *        chunk_group_row_limit int DEFAULT NULL,
  *        stripe_row_limit int DEFAULT NULL,
- *        compression name DEFAULT null)
+ *        compression name DEFAULT null,
+ *        compression_level int DEFAULT NULL,
+ *        column_names name[] DEFAULT NULL,
+ *        bloom_filter bool DEFAULT NULL)
  *
  * All arguments except the table name are optional. The UDF is supposed to be called
  * like:
@@ -3137,6 +3186,15 @@ ColumnarCheckLogicalReplication(Relation rel)
  * same. Multiple settings can be changed at the same time by providing multiple
  * arguments. Calling the argument with the NULL value will be interperted as not having
  * provided the argument.
+ *
+ * When column_names is given, compression and compression_level are only changed for
+ * the listed columns, overriding the table wide settings for them:
+ *   SELECT alter_columnar_table_set('table', compression => 'none',
+ *                                   column_names => '{hash}');
+ *
+ * bloom_filter can only be given together with column_names. It makes the writer
+ * store a bloom filter with every chunk of the listed columns, which lets scans
+ * skip chunks on equality and IN quals. Stripes written before are not changed.
  */
 PG_FUNCTION_INFO_V1(alter_columnar_table_set);
 Datum
@@ -3166,6 +3224,25 @@ alter_columnar_table_set(PG_FUNCTION_ARGS)
 		ereport(ERROR, (errmsg("unable to read current options for table")));
 	}
 
+	/* column_names => not null */
+	bool perColumn = !PG_ARGISNULL(5);
+	List *attrNumList = NIL;
+	if (perColumn)
+	{
+		if (!PG_ARGISNULL(1) || !PG_ARGISNULL(2))
+		{
+			ereport(ERROR, (errmsg("chunk_group_row_limit and stripe_row_limit "
+								   "cannot be set for individual columns")));
+		}
+
+		attrNumList = ColumnNameArrayToAttrNumList(rel, PG_GETARG_ARRAYTYPE_P(5));
+	}
+	else if (!PG_ARGISNULL(6))
+	{
+		ereport(ERROR, (errmsg("bloom_filter can only be set for individual columns"),
+						errhint("Specify the columns with column_names.")));
+	}
+
 	/* chunk_group_row_limit => not null */
 	if (!PG_ARGISNULL(1))
 	{
@@ -3232,12 +3309,33 @@ alter_columnar_table_set(PG_FUNCTION_ARGS)
 								options.compressionLevel)));
 	}
 
+	/* bloom_filter => not null */
+	if (!PG_ARGISNULL(6))
+	{
+		ereport(DEBUG1, (errmsg("updating bloom filter to %s",
+								PG_GETARG_BOOL(6) ? "true" : "false")));
+	}
+
+	if (perColumn)
+	{
+		UpdateColumnOptions(relationId, attrNumList,
+							!PG_ARGISNULL(3), options.compressionType,
+							!PG_ARGISNULL(4), options.compressionLevel,
+							!PG_ARGISNULL(6), !PG_ARGISNULL(6) && PG_GETARG_BOOL(6));
+
+		/* table wide options stay untouched, pick up the new overrides */
+		ReadColumnarOptions(relationId, &options);
+	}
+
 	if (ColumnarTableSetOptions_hook != NULL)
 	{
 		ColumnarTableSetOptions_hook(relationId, options);
 	}
 
-	SetColumnarOptions(relationId, &options);
+	if (!perColumn)
+	{
+		SetColumnarOptions(relationId, &options);
+	}
 
 	table_close(rel, NoLock);
 
@@ -3250,18 +3348,23 @@ alter_columnar_table_set(PG_FUNCTION_ARGS)
  * columnar table. Calling this function on a non-columnar table gives an error.
  *
  * sql syntax:
- *   pg_catalog.alter_columnar_table_re
- *   teset(
+ *   columnar.alter_columnar_table_reset(
  *        table_name regclass,
  *        chunk_group_row_limit bool DEFAULT FALSE,
  *        stripe_row_limit bool DEFAULT FALSE,
- *        compression bool DEFAULT FALSE)
+ *        compression bool DEFAULT FALSE,
+ *        compression_level bool DEFAULT FALSE,
+ *        column_names name[] DEFAULT NULL,
+ *        bloom_filter bool DEFAULT FALSE)
  *
  * All arguments except the table name are optional. The UDF is supposed to be called
  * like:
  *   SELECT alter_columnar_table_set('table', compression => true);
  *
- * All options set to true will be reset to the default system value.
+ * All options set to true will be reset to the default system value. When
+ * column_names is given, the compression overrides of the listed columns are removed
+ * instead, so they follow the table wide settings again. bloom_filter, which turns
+ * the bloom filters of the listed columns off, requires column_names.
  */
 PG_FUNCTION_INFO_V1(alter_columnar_table_reset);
 Datum
@@ -3292,6 +3395,45 @@ alter_columnar_table_reset(PG_FUNCTION_ARGS)
 		ereport(ERROR, (errmsg("unable to read current options for table")));
 	}
 
+	bool resetBloomFilter = !PG_ARGISNULL(6) && PG_GETARG_BOOL(6);
+
+	/* column_names => not null */
+	if (!PG_ARGISNULL(5))
+	{
+		if ((!PG_ARGISNULL(1) && PG_GETARG_BOOL(1)) ||
+			(!PG_ARGISNULL(2) && PG_GETARG_BOOL(2)))
+		{
+			ereport(ERROR, (errmsg("chunk_group_row_limit and stripe_row_limit "
+								   "cannot be reset for individual columns")));
+		}
+
+		List *attrNumList = ColumnNameArrayToAttrNumList(rel,
+														 PG_GETARG_ARRAYTYPE_P(5));
+
+		UpdateColumnOptions(relationId, attrNumList,
+							!PG_ARGISNULL(3) && PG_GETARG_BOOL(3),
+							COMPRESSION_TYPE_INVALID,
+							!PG_ARGISNULL(4) && PG_GETARG_BOOL(4),
+							COLUMN_COMPRESSION_LEVEL_INHERIT,
+							resetBloomFilter, false);
+
+		ReadColumnarOptions(relationId, &options);
+
+		if (ColumnarTableSetOptions_hook != NULL)
+		{
+			ColumnarTableSetOptions_hook(relationId, options);
+		}
+
+		table_close(rel, NoLock);
+
+		PG_RETURN_VOID();
+	}
+	else if (resetBloomFilter)
+	{
+		ereport(ERROR, (errmsg("bloom_filter can only be reset for individual columns"),
+						errhint("Specify the columns with column_names.")));
+	}
+
 	/* chunk_group_row_limit => true */
 	if (!PG_ARGISNULL(1) && PG_GETARG_BOOL(1))
 	{
@@ -3338,6 +3480,208 @@ alter_columnar_table_reset(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * train_zstd_dictionaries is a UDF exposed in postgres to train a zstd dictionary for
+ * each zstd compressed column of a columnar table, on the chunks already stored in
+ * the table. Chunks written afterwards are compressed with the new dictionaries,
+ * which mostly pays off for small chunks. Returns the number of dictionaries
+ * trained.
+ *
+ * sql syntax:
+ *   columnar.train_zstd_dictionaries(
+ *        table_name regclass,
+ *        dictionary_size int DEFAULT NULL)
+ *
+ * dictionary_size is in kilobytes, ZSTD_DICTIONARY_SIZE_DEFAULT when NULL.
+ */
+PG_FUNCTION_INFO_V1(train_zstd_dictionaries);
+Datum
+train_zstd_dictionaries(PG_FUNCTION_ARGS)
+{
+	Oid relationId = PG_GETARG_OID(0);
+	int dictionarySize = PG_ARGISNULL(1) ? ZSTD_DICTIONARY_SIZE_DEFAULT :
+						 PG_GETARG_INT32(1);
+
+	Relation rel = table_open(relationId, ShareUpdateExclusiveLock);
+	if (!IsColumnarTableAmTable(relationId))
+	{
+		ereport(ERROR, (errmsg("table %s is not a columnar table",
+							   quote_identifier(RelationGetRelationName(rel)))));
+	}
+#if PG_VERSION_NUM >= PG_VERSION_16
+	if (!object_ownercheck(RelationRelationId, relationId, GetUserId()))
+#else
+	if (!pg_class_ownercheck(relationId, GetUserId()))
+#endif
+	{
+		aclcheck_error(ACLCHECK_NOT_OWNER, OBJECT_TABLE,
+					   get_rel_name(relationId));
+	}
+
+	if (ParseCompressionType("zstd") == COMPRESSION_TYPE_INVALID)
+	{
+		ereport(ERROR, (errmsg("zstd support is not compiled in")));
+	}
+
+	if (dictionarySize < 1 || dictionarySize > ZSTD_DICTIONARY_SIZE_MAX)
+	{
+		ereport(ERROR, (errmsg("dictionary size out of range"),
+						errhint("dictionary size must be between 1 and %d",
+								ZSTD_DICTIONARY_SIZE_MAX)));
+	}
+
+	ColumnarOptions options = { 0 };
+	if (!ReadColumnarOptions(relationId, &options))
+	{
+		ereport(ERROR, (errmsg("unable to read current options for table")));
+	}
+
+	TupleDesc tupleDescriptor = RelationGetDescr(rel);
+	uint64 storageId = ColumnarStorageGetStorageId(rel, false);
+	uint64 maxSampleSize =
+		(uint64) dictionarySize * 1024 * ZSTD_DICTIONARY_SAMPLE_RATIO;
+	int trainedCount = 0;
+
+	for (int columnIndex = 0; columnIndex < tupleDescriptor->natts; columnIndex++)
+	{
+		AttrNumber attrNum = AttrOffsetGetAttrNumber(columnIndex);
+		CompressionType compressionType = options.compressionType;
+
+		if (TupleDescAttr(tupleDescriptor, columnIndex)->attisdropped)
+		{
+			continue;
+		}
+
+		ListCell *columnOptionsCell = NULL;
+		foreach(columnOptionsCell, options.columnOptionsList)
+		{
+			ColumnarColumnOptions *columnOptions = lfirst(columnOptionsCell);
+			if (columnOptions->attrNum == attrNum &&
+				columnOptions->compressionType != COMPRESSION_TYPE_INVALID)
+			{
+				compressionType = columnOptions->compressionType;
+			}
+		}
+
+		if (compressionType != COMPRESSION_ZSTD)
+		{
+			continue;
+		}
+
+		List *sampleList = ReadColumnValueStreams(rel, attrNum, maxSampleSize,
+												  GetTransactionSnapshot());
+		bytea *dictionaryData = TrainZstdDictionary(sampleList, dictionarySize * 1024);
+		if (dictionaryData == NULL)
+		{
+			ereport(DEBUG1, (errmsg("not enough data to train a zstd dictionary "
+									"for column %d", attrNum)));
+			continue;
+		}
+
+		SaveZstdDictionary(storageId, CreateZstdDictionary(attrNum, dictionaryData));
+		trainedCount++;
+	}
+
+	table_close(rel, NoLock);
+
+	PG_RETURN_INT32(trainedCount);
+}
+
+
+/*
+ * ColumnNameArrayToAttrNumList resolves the column names passed to
+ * alter_columnar_table_set/reset to a list of attribute numbers of rel.
+ */
+static List *
+ColumnNameArrayToAttrNumList(Relation rel, ArrayType *columnNameArray)
+{
+	Datum *columnNameDatumArray = NULL;
+	bool *columnNameNullArray = NULL;
+	int columnNameCount = 0;
+	List *attrNumList = NIL;
+
+	deconstruct_array(columnNameArray, NAMEOID, NAMEDATALEN, false, TYPALIGN_CHAR,
+					  &columnNameDatumArray, &columnNameNullArray, &columnNameCount);
+
+	for (int columnNameIndex = 0; columnNameIndex < columnNameCount; columnNameIndex++)
+	{
+		if (columnNameNullArray[columnNameIndex])
+		{
+			ereport(ERROR, (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+							errmsg("column name cannot be NULL")));
+		}
+
+		char *columnName = NameStr(*DatumGetName(columnNameDatumArray[columnNameIndex]));
+		AttrNumber attrNum = get_attnum(RelationGetRelid(rel), columnName);
+		if (attrNum <= 0)
+		{
+			ereport(ERROR, (errcode(ERRCODE_UNDEFINED_COLUMN),
+							errmsg("column \"%s\" of relation \"%s\" does not exist",
+								   columnName, RelationGetRelationName(rel))));
+		}
+
+		attrNumList = list_append_unique_int(attrNumList, attrNum);
+	}
+
+	return attrNumList;
+}
+
+
+/*
+ * UpdateColumnOptions changes the compression overrides and the bloom filter
+ * setting of the given columns, keeping the settings that are not asked to be
+ * changed.
+ */
+static void
+UpdateColumnOptions(Oid relationId, List *attrNumList,
+					bool setCompressionType, CompressionType compressionType,
+					bool setCompressionLevel, int compressionLevel,
+					bool setBloomFilter, bool bloomFilter)
+{
+	List *columnOptionsList = ReadColumnarColumnOptions(relationId);
+
+	ListCell *attrNumCell = NULL;
+	foreach(attrNumCell, attrNumList)
+	{
+		AttrNumber attrNum = (AttrNumber) lfirst_int(attrNumCell);
+		ColumnarColumnOptions columnOptions = {
+			.attrNum = attrNum,
+			.compressionType = COMPRESSION_TYPE_INVALID,
+			.compressionLevel = COLUMN_COMPRESSION_LEVEL_INHERIT,
+			.bloomFilter = false
+		};
+
+		ListCell *columnOptionsCell = NULL;
+		foreach(columnOptionsCell, columnOptionsList)
+		{
+			ColumnarColumnOptions *existingOptions = lfirst(columnOptionsCell);
+			if (existingOptions->attrNum == attrNum)
+			{
+				columnOptions = *existingOptions;
+				break;
+			}
+		}
+
+		if (setCompressionType)
+		{
+			columnOptions.compressionType = compressionType;
+		}
+
+		if (setCompressionLevel)
+		{
+			columnOptions.compressionLevel = compressionLevel;
+		}
+
+		if (setBloomFilter)
+		{
+			columnOptions.bloomFilter = bloomFilter;
+		}
+
+		SetColumnarColumnOptions(relationId, &columnOptions);
+	}
+}
+
+
 /*
  * upgrade_columnar_storage - upgrade columnar storage to the current
  * version.
@@ -19,6 +19,7 @@
 
 #include "safe_lib.h"
 
+#include "access/hash.h"
 #include "access/heapam.h"
 #include "access/nbtree.h"
 #include "catalog/pg_am.h"
@@ -38,9 +39,13 @@
 
 
 #include "columnar/columnar.h"
+#include "columnar/columnar_bloom_filter.h"
 #include "columnar/columnar_storage.h"
 #include "columnar/columnar_version_compat.h"
 
+/* expected cost of decoding a value of an encoded chunk, see ChooseAutoCompression */
+#define ENCODING_DECODE_NS_PER_VALUE 1.0
+
 struct ColumnarWriteState
 {
 	TupleDesc tupleDescriptor;
@@ -55,6 +60,28 @@ struct ColumnarWriteState
 	ColumnarOptions options;
 	ChunkData *chunkData;
 
+	/* compression type and level of each column, after per-column overrides */
+	CompressionType *columnCompressionTypeArray;
+	int *columnCompressionLevelArray;
+
+	/*
+	 * hash function of each column with bloom_filter enabled (NULL for the
+	 * other columns), and the hashes of the values of the current chunk.
+	 */
+	FmgrInfo **bloomFilterHashFunctionArray;
+	uint32 **bloomFilterHashArray;
+
+	/*
+	 * newest zstd dictionary of each column, and whether a column waits for the
+	 * stripe being written to train one; loaded when the first stripe is
+	 * created and allocated in dictionaryContext.
+	 */
+	MemoryContext dictionaryContext;
+	uint64 storageId;
+	bool zstdDictionariesLoaded;
+	ZstdDictionary **zstdDictionaryArray;
+	bool *trainZstdDictionaryArray;
+
 	List *chunkGroupRowCounts;
 
 	/*
@@ -64,6 +91,13 @@ struct ColumnarWriteState
 	 * deallocated when memory context is reset.
 	 */
 	StringInfo compressionBuffer;
+
+	/*
+	 * encodingBuffer is used as temporary storage for the encoded value
+	 * stream of a chunk, before it is compressed. Same lifetime as
+	 * compressionBuffer.
+	 */
+	StringInfo encodingBuffer;
 };
 
 static StripeBuffers * CreateEmptyStripeBuffers(uint32 stripeMaxRowCount,
@@ -73,12 +107,21 @@ static StripeSkipList * CreateEmptyStripeSkipList(uint32 stripeMaxRowCount,
 												  uint32 chunkRowCount,
 												  uint32 columnCount);
 static void FlushStripe(ColumnarWriteState *writeState);
+static ColumnZoneMap * BuildStripeZoneMap(ColumnarWriteState *writeState);
 static StringInfo SerializeBoolArray(bool *boolArray, uint32 boolArrayLength);
 static void SerializeSingleDatum(StringInfo datumBuffer, Datum datum,
 								 bool datumTypeByValue, int datumTypeLength,
 								 char datumTypeAlign);
 static void SerializeChunkData(ColumnarWriteState *writeState, uint32 chunkIndex,
 							   uint32 rowCount);
+static void LoadZstdDictionaries(ColumnarWriteState *writeState, uint64 storageId);
+static void TrainZstdDictionaries(ColumnarWriteState *writeState);
+static StringInfo ChooseAutoCompression(ColumnarWriteState *writeState,
+									   StringInfo plainBuffer,
+									   ColumnChunkBuffers *chunkBuffers,
+									   uint32 valueCount,
+									   CompressionType *compressionType,
+									   int *compressionLevel);
 static void UpdateChunkSkipNodeMinMax(ColumnChunkSkipNode *chunkSkipNode,
 									  Datum columnValue, bool columnTypeByValue,
 									  int columnTypeLength, Oid columnCollation,
@@ -131,9 +174,62 @@ ColumnarBeginWrite(RelFileLocator relfilelocator,
 	ChunkData *chunkData = CreateEmptyChunkData(columnCount, columnMaskArray,
 												options.chunkRowCount);
 
+	/* resolve the compression settings of each column */
+	CompressionType *columnCompressionTypeArray =
+		palloc(columnCount * sizeof(CompressionType));
+	int *columnCompressionLevelArray = palloc(columnCount * sizeof(int));
+	FmgrInfo **bloomFilterHashFunctionArray = palloc0(columnCount * sizeof(FmgrInfo *));
+	uint32 **bloomFilterHashArray = palloc0(columnCount * sizeof(uint32 *));
+	for (uint32 columnIndex = 0; columnIndex < columnCount; columnIndex++)
+	{
+		columnCompressionTypeArray[columnIndex] = options.compressionType;
+		columnCompressionLevelArray[columnIndex] = options.compressionLevel;
+	}
+
+	ListCell *columnOptionsCell = NULL;
+	foreach(columnOptionsCell, options.columnOptionsList)
+	{
+		ColumnarColumnOptions *columnOptions = lfirst(columnOptionsCell);
+		int columnIndex = AttrNumberGetAttrOffset(columnOptions->attrNum);
+
+		if (columnIndex < 0 || (uint32) columnIndex >= columnCount)
+		{
+			continue;
+		}
+
+		if (columnOptions->compressionType != COMPRESSION_TYPE_INVALID)
+		{
+			columnCompressionTypeArray[columnIndex] = columnOptions->compressionType;
+		}
+
+		if (columnOptions->compressionLevel != COLUMN_COMPRESSION_LEVEL_INHERIT)
+		{
+			columnCompressionLevelArray[columnIndex] = columnOptions->compressionLevel;
+		}
+
+		/* types without a hash function can't have a bloom filter */
+		Form_pg_attribute attributeForm = TupleDescAttr(tupleDescriptor, columnIndex);
+		if (columnOptions->bloomFilter && !attributeForm->attisdropped)
+		{
+			FmgrInfo *hashFunction = GetFunctionInfoOrNull(attributeForm->atttypid,
+														   HASH_AM_OID,
+														   HASHSTANDARD_PROC);
+			if (hashFunction != NULL)
+			{
+				bloomFilterHashFunctionArray[columnIndex] = hashFunction;
+				bloomFilterHashArray[columnIndex] =
+					palloc(options.chunkRowCount * sizeof(uint32));
+			}
+		}
+	}
+
 	ColumnarWriteState *writeState = palloc0(sizeof(ColumnarWriteState));
 	writeState->relfilelocator = relfilelocator;
 	writeState->options = options;
+	writeState->columnCompressionTypeArray = columnCompressionTypeArray;
+	writeState->columnCompressionLevelArray = columnCompressionLevelArray;
+	writeState->bloomFilterHashFunctionArray = bloomFilterHashFunctionArray;
+	writeState->bloomFilterHashArray = bloomFilterHashArray;
 	writeState->tupleDescriptor = CreateTupleDescCopy(tupleDescriptor);
 	writeState->comparisonFunctionArray = comparisonFunctionArray;
 	writeState->stripeBuffers = NULL;
@@ -142,6 +238,11 @@ ColumnarBeginWrite(RelFileLocator relfilelocator,
 	writeState->stripeWriteContext = stripeWriteContext;
 	writeState->chunkData = chunkData;
 	writeState->compressionBuffer = NULL;
+	writeState->encodingBuffer = NULL;
+	writeState->dictionaryContext = AllocSetContextCreate(CurrentMemoryContext,
+														  "Columnar zstd dictionary context",
+														  ALLOCSET_SMALL_SIZES);
+	writeState->zstdDictionariesLoaded = false;
 	writeState->perTupleContext = AllocSetContextCreate(CurrentMemoryContext,
 														"Columnar per tuple context",
 														ALLOCSET_DEFAULT_SIZES);
@@ -232,6 +333,7 @@ ColumnarWriteRow(ColumnarWriteState *writeState, Datum *columnValues, bool *colu
 		writeState->stripeBuffers = stripeBuffers;
 		writeState->stripeSkipList = stripeSkipList;
 		writeState->compressionBuffer = makeStringInfo();
+		writeState->encodingBuffer = makeStringInfo();
 
 #if PG_VERSION_NUM >= PG_VERSION_16
 		Oid relationId = RelidByRelfilenumber(writeState->relfilelocator.spcOid,
@@ -244,6 +346,13 @@ ColumnarWriteRow(ColumnarWriteState *writeState, Datum *columnValues, bool *colu
 		writeState->emptyStripeReservation =
 			ReserveEmptyStripe(relation, columnCount, chunkRowCount,
 							   options->stripeRowCount);
+
+		if (!writeState->zstdDictionariesLoaded)
+		{
+			LoadZstdDictionaries(writeState,
+								 ColumnarStorageGetStorageId(relation, false));
+		}
+
 		relation_close(relation, NoLock);
 
 		/*
@@ -268,6 +377,7 @@ ColumnarWriteRow(ColumnarWriteState *writeState, Datum *columnValues, bool *colu
 		if (columnNulls[columnIndex])
 		{
 			chunkData->existsArray[columnIndex][chunkRowIndex] = false;
+			chunkSkipNode->nullCount++;
 		}
 		else
 		{
@@ -298,6 +408,15 @@ ColumnarWriteRow(ColumnarWriteState *writeState, Datum *columnValues, bool *colu
 			UpdateChunkSkipNodeMinMax(chunkSkipNode, columnValues[columnIndex],
 									  columnTypeByValue, columnTypeLength,
 									  columnCollation, comparisonFunction);
+
+			FmgrInfo *hashFunction = writeState->bloomFilterHashFunctionArray[columnIndex];
+			if (hashFunction != NULL)
+			{
+				Datum hashDatum = FunctionCall1Coll(hashFunction, columnCollation,
+													columnValues[columnIndex]);
+				writeState->bloomFilterHashArray[columnIndex][chunkRowIndex] =
+					DatumGetUInt32(hashDatum);
+			}
 		}
 
 		chunkSkipNode->rowCount++;
@@ -335,7 +454,20 @@ ColumnarEndWrite(ColumnarWriteState *writeState)
 	ColumnarFlushPendingWrites(writeState);
 
 	MemoryContextDelete(writeState->stripeWriteContext);
+	MemoryContextDelete(writeState->dictionaryContext);
 	pfree(writeState->comparisonFunctionArray);
+	pfree(writeState->columnCompressionTypeArray);
+	pfree(writeState->columnCompressionLevelArray);
+	for (int columnIndex = 0; columnIndex < writeState->tupleDescriptor->natts;
+		 columnIndex++)
+	{
+		if (writeState->bloomFilterHashArray[columnIndex] != NULL)
+		{
+			pfree(writeState->bloomFilterHashArray[columnIndex]);
+		}
+	}
+	pfree(writeState->bloomFilterHashFunctionArray);
+	pfree(writeState->bloomFilterHashArray);
 	FreeChunkData(writeState->chunkData);
 	pfree(writeState);
 }
@@ -397,6 +529,7 @@ CreateEmptyStripeBuffers(uint32 stripeMaxRowCount, uint32 chunkRowCount,
 			chunkBuffersArray[chunkIndex]->existsBuffer = NULL;
 			chunkBuffersArray[chunkIndex]->valueBuffer = NULL;
 			chunkBuffersArray[chunkIndex]->valueCompressionType = COMPRESSION_NONE;
+			chunkBuffersArray[chunkIndex]->valueEncodingType = ENCODING_NONE;
 		}
 
 		columnBuffersArray[columnIndex] = palloc0(sizeof(ColumnBuffers));
@@ -485,6 +618,8 @@ FlushStripe(ColumnarWriteState *writeState)
 		SerializeChunkData(writeState, lastChunkIndex, lastChunkRowCount);
 	}
 
+	TrainZstdDictionaries(writeState);
+
 	/* update buffer sizes in stripe skip list */
 	for (columnIndex = 0; columnIndex < columnCount; columnIndex++)
 	{
@@ -514,7 +649,8 @@ FlushStripe(ColumnarWriteState *writeState)
 			chunkSkipNode->valueChunkOffset = stripeSize;
 			chunkSkipNode->valueLength = valueBufferSize;
 			chunkSkipNode->valueCompressionType = valueCompressionType;
-			chunkSkipNode->valueCompressionLevel = writeState->options.compressionLevel;
+			chunkSkipNode->valueCompressionLevel = chunkBuffers->valueCompressionLevel;
+			chunkSkipNode->valueEncodingType = chunkBuffers->valueEncodingType;
 			chunkSkipNode->decompressedValueSize = chunkBuffers->decompressedValueSize;
 
 			stripeSize += valueBufferSize;
@@ -571,6 +707,9 @@ FlushStripe(ColumnarWriteState *writeState)
 	SaveStripeSkipList(writeState->relfilelocator,
 					   stripeMetadata->id,
 					   stripeSkipList, tupleDescriptor);
+	SaveStripeZoneMap(writeState->relfilelocator,
+					  stripeMetadata->id,
+					  BuildStripeZoneMap(writeState), tupleDescriptor);
 	SaveEmptyRowMask(LookupStorageId(writeState->relfilelocator),
 					 stripeMetadata->id,
 					 stripeMetadata->firstRowNumber,
@@ -582,6 +721,73 @@ FlushStripe(ColumnarWriteState *writeState)
 }
 
 
+/*
+ * BuildStripeZoneMap aggregates the chunk skip nodes of the stripe being flushed
+ * into a zone map per column: the smallest chunk minimum, the largest chunk
+ * maximum and the total number of NULLs.
+ */
+static ColumnZoneMap *
+BuildStripeZoneMap(ColumnarWriteState *writeState)
+{
+	StripeSkipList *stripeSkipList = writeState->stripeSkipList;
+	TupleDesc tupleDescriptor = writeState->tupleDescriptor;
+	uint32 columnCount = tupleDescriptor->natts;
+
+	ColumnZoneMap *columnZoneMapArray = palloc0(columnCount * sizeof(ColumnZoneMap));
+
+	for (uint32 columnIndex = 0; columnIndex < columnCount; columnIndex++)
+	{
+		ColumnChunkSkipNode *chunkSkipNodeArray =
+			stripeSkipList->chunkSkipNodeArray[columnIndex];
+		FmgrInfo *comparisonFunction = writeState->comparisonFunctionArray[columnIndex];
+		Oid columnCollation = TupleDescAttr(tupleDescriptor, columnIndex)->attcollation;
+		ColumnZoneMap *columnZoneMap = &columnZoneMapArray[columnIndex];
+
+		columnZoneMap->exists = true;
+
+		for (uint32 chunkIndex = 0; chunkIndex < stripeSkipList->chunkCount; chunkIndex++)
+		{
+			ColumnChunkSkipNode *chunkSkipNode = &chunkSkipNodeArray[chunkIndex];
+
+			columnZoneMap->nullCount += chunkSkipNode->nullCount;
+
+			if (!chunkSkipNode->hasMinMax)
+			{
+				continue;
+			}
+
+			if (!columnZoneMap->hasMinMax)
+			{
+				columnZoneMap->hasMinMax = true;
+				columnZoneMap->minimumValue = chunkSkipNode->minimumValue;
+				columnZoneMap->maximumValue = chunkSkipNode->maximumValue;
+				continue;
+			}
+
+			Datum minimumComparisonDatum =
+				FunctionCall2Coll(comparisonFunction, columnCollation,
+								  chunkSkipNode->minimumValue,
+								  columnZoneMap->minimumValue);
+			if (DatumGetInt32(minimumComparisonDatum) < 0)
+			{
+				columnZoneMap->minimumValue = chunkSkipNode->minimumValue;
+			}
+
+			Datum maximumComparisonDatum =
+				FunctionCall2Coll(comparisonFunction, columnCollation,
+								  chunkSkipNode->maximumValue,
+								  columnZoneMap->maximumValue);
+			if (DatumGetInt32(maximumComparisonDatum) > 0)
+			{
+				columnZoneMap->maximumValue = chunkSkipNode->maximumValue;
+			}
+		}
+	}
+
+	return columnZoneMapArray;
+}
+
+
 /*
  * SerializeBoolArray serializes the given boolean array and returns the result
  * as a StringInfo. This function packs every 8 boolean values into one byte.
@@ -649,8 +855,9 @@ SerializeSingleDatum(StringInfo datumBuffer, Datum datum, bool datumTypeByValue,
 
 
 /*
- * SerializeChunkData serializes and compresses chunk data at given chunk index with given
- * compression type for every column.
+ * SerializeChunkData serializes, encodes and compresses chunk data at given chunk
+ * index, using the compression type and level resolved for every column. It also
+ * builds the bloom filters of the columns that have one.
  */
 static void
 SerializeChunkData(ColumnarWriteState *writeState, uint32 chunkIndex, uint32 rowCount)
@@ -658,10 +865,9 @@ SerializeChunkData(ColumnarWriteState *writeState, uint32 chunkIndex, uint32 row
 	uint32 columnIndex = 0;
 	StripeBuffers *stripeBuffers = writeState->stripeBuffers;
 	ChunkData *chunkData = writeState->chunkData;
-	CompressionType requestedCompressionType = writeState->options.compressionType;
-	int compressionLevel = writeState->options.compressionLevel;
 	const uint32 columnCount = stripeBuffers->columnCount;
 	StringInfo compressionBuffer = writeState->compressionBuffer;
+	StringInfo encodingBuffer = writeState->encodingBuffer;
 
 	writeState->chunkGroupRowCounts =
 		lappend_int(writeState->chunkGroupRowCounts, rowCount);
@@ -677,30 +883,125 @@ SerializeChunkData(ColumnarWriteState *writeState, uint32 chunkIndex, uint32 row
 	}
 
 	/*
-	 * check and compress value buffers, if a value buffer is not compressable
-	 * then keep it as uncompressed, store compression information.
+	 * encode, check and compress value buffers, if a value buffer is not
+	 * compressable then keep it as uncompressed, store compression information.
 	 */
 	for (columnIndex = 0; columnIndex < columnCount; columnIndex++)
 	{
 		ColumnBuffers *columnBuffers = stripeBuffers->columnBuffersArray[columnIndex];
 		ColumnChunkBuffers *chunkBuffers = columnBuffers->chunkBuffersArray[chunkIndex];
+		Form_pg_attribute attributeForm =
+			TupleDescAttr(writeState->tupleDescriptor, columnIndex);
+		CompressionType requestedCompressionType =
+			writeState->columnCompressionTypeArray[columnIndex];
+		int compressionLevel = writeState->columnCompressionLevelArray[columnIndex];
 		CompressionType actualCompressionType = COMPRESSION_NONE;
+		uint32 valueCount = 0;
 
 		StringInfo serializedValueBuffer = chunkData->valueBufferArray[columnIndex];
 
 		Assert(requestedCompressionType >= 0 &&
 			   requestedCompressionType < COMPRESSION_COUNT);
 
-		chunkBuffers->decompressedValueSize =
-			chunkData->valueBufferArray[columnIndex]->len;
+		for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+		{
+			if (chunkData->existsArray[columnIndex][rowIndex])
+			{
+				valueCount++;
+			}
+		}
+
+		/* the bloom filter is sized for and built from the non-NULL values */
+		uint32 *bloomFilterHashArray = writeState->bloomFilterHashArray[columnIndex];
+		if (bloomFilterHashArray != NULL)
+		{
+			ColumnChunkSkipNode *chunkSkipNode =
+				&writeState->stripeSkipList->chunkSkipNodeArray[columnIndex][chunkIndex];
+
+			chunkSkipNode->bloomFilter = CreateBloomFilter(valueCount);
+			for (uint32 rowIndex = 0; rowIndex < rowCount; rowIndex++)
+			{
+				if (chunkData->existsArray[columnIndex][rowIndex])
+				{
+					BloomFilterAddHash(chunkSkipNode->bloomFilter,
+									   bloomFilterHashArray[rowIndex]);
+				}
+			}
+		}
+
+		/*
+		 * if a lightweight encoding makes the value buffer smaller, compress the
+		 * encoded buffer instead of the plain one.
+		 */
+		chunkBuffers->valueEncodingType = EncodeChunkValues(serializedValueBuffer,
+															valueCount, attributeForm,
+															encodingBuffer);
+		if (chunkBuffers->valueEncodingType != ENCODING_NONE)
+		{
+			serializedValueBuffer = encodingBuffer;
+		}
+
+		/*
+		 * Chunks without NULLs or without values don't need an exists stream,
+		 * the reader tells them apart by whether there are values. Constant and
+		 * empty value streams aren't worth compressing.
+		 */
+		if (columnar_enable_encoding && (valueCount == 0 || valueCount == rowCount))
+		{
+			resetStringInfo(chunkBuffers->existsBuffer);
+		}
+
+		if (chunkBuffers->valueEncodingType == ENCODING_CONSTANT ||
+			(columnar_enable_encoding && valueCount == 0))
+		{
+			requestedCompressionType = COMPRESSION_NONE;
+		}
+
+		bool autoCompression = requestedCompressionType == COMPRESSION_AUTO;
+		if (autoCompression)
+		{
+			serializedValueBuffer =
+				ChooseAutoCompression(writeState,
+									  chunkData->valueBufferArray[columnIndex],
+									  chunkBuffers, valueCount,
+									  &requestedCompressionType, &compressionLevel);
+		}
+
+		chunkBuffers->decompressedValueSize = serializedValueBuffer->len;
 
 		/*
 		 * if serializedValueBuffer is be compressed, update serializedValueBuffer
-		 * with compressed data and store compression type.
+		 * with compressed data and store compression type. Columns waiting for a
+		 * zstd dictionary are compressed by TrainZstdDictionaries instead.
 		 */
-		bool compressed = CompressBuffer(serializedValueBuffer, compressionBuffer,
-										 requestedCompressionType,
-										 compressionLevel);
+		ZstdDictionary *zstdDictionary = writeState->zstdDictionaryArray[columnIndex];
+		bool compressed = false;
+		if (requestedCompressionType == COMPRESSION_ZSTD &&
+			writeState->trainZstdDictionaryArray[columnIndex])
+		{
+			/* kept uncompressed until the dictionary is trained */
+			compressed = false;
+		}
+		else if (requestedCompressionType == COMPRESSION_ZSTD && zstdDictionary != NULL)
+		{
+			compressed = CompressBufferWithZstdDictionary(serializedValueBuffer,
+														  compressionBuffer,
+														  compressionLevel,
+														  zstdDictionary);
+		}
+		else
+		{
+			compressed = CompressBuffer(serializedValueBuffer, compressionBuffer,
+										requestedCompressionType,
+										compressionLevel);
+		}
+
+		/* the estimate of auto compression was off, keep the chunk uncompressed */
+		if (compressed && autoCompression &&
+			compressionBuffer->len >= serializedValueBuffer->len)
+		{
+			compressed = false;
+		}
 
 		if (compressed)
 		{
@@ -710,6 +1011,7 @@ SerializeChunkData(ColumnarWriteState *writeState, uint32 chunkIndex, uint32 row
 
 		/* store (compressed) value buffer */
 		chunkBuffers->valueCompressionType = actualCompressionType;
+		chunkBuffers->valueCompressionLevel = compressionLevel;
 		chunkBuffers->valueBuffer = CopyStringInfo(serializedValueBuffer);
 
 		/* valueBuffer needs to be reset for next chunk's data */
@@ -718,6 +1020,203 @@ SerializeChunkData(ColumnarWriteState *writeState, uint32 chunkIndex, uint32 row
 }
 
 
+/*
+ * LoadZstdDictionaries reads the newest zstd dictionary of each column, and marks
+ * the zstd compressed columns without one for training when
+ * columnar.zstd_dictionary_size is set.
+ */
+static void
+LoadZstdDictionaries(ColumnarWriteState *writeState, uint64 storageId)
+{
+	uint32 columnCount = writeState->tupleDescriptor->natts;
+	bool zstdCompressed = false;
+
+	MemoryContext oldContext = MemoryContextSwitchTo(writeState->dictionaryContext);
+
+	writeState->storageId = storageId;
+	writeState->zstdDictionaryArray = palloc0(columnCount * sizeof(ZstdDictionary *));
+	writeState->trainZstdDictionaryArray = palloc0(columnCount * sizeof(bool));
+
+	for (uint32 columnIndex = 0; columnIndex < columnCount; columnIndex++)
+	{
+		if (writeState->columnCompressionTypeArray[columnIndex] == COMPRESSION_ZSTD ||
+			writeState->columnCompressionTypeArray[columnIndex] == COMPRESSION_AUTO)
+		{
+			zstdCompressed = true;
+		}
+	}
+
+	/* dictionaries are listed from oldest to newest for each column */
+	List *dictionaryList = zstdCompressed ? ReadZstdDictionaries(storageId) : NIL;
+
+	ListCell *dictionaryCell = NULL;
+	foreach(dictionaryCell, dictionaryList)
+	{
+		ZstdDictionary *dictionary = lfirst(dictionaryCell);
+		int columnIndex = AttrNumberGetAttrOffset(dictionary->attrNum);
+
+		if (columnIndex >= 0 && (uint32) columnIndex < columnCount)
+		{
+			writeState->zstdDictionaryArray[columnIndex] = dictionary;
+		}
+	}
+
+	for (uint32 columnIndex = 0; columnIndex < columnCount; columnIndex++)
+	{
+		Form_pg_attribute attributeForm =
+			TupleDescAttr(writeState->tupleDescriptor, columnIndex);
+
+		writeState->trainZstdDictionaryArray[columnIndex] =
+			columnar_zstd_dictionary_size > 0 && !attributeForm->attisdropped &&
+			writeState->columnCompressionTypeArray[columnIndex] == COMPRESSION_ZSTD &&
+			writeState->zstdDictionaryArray[columnIndex] == NULL;
+	}
+
+	writeState->zstdDictionariesLoaded = true;
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+
+/*
+ * TrainZstdDictionaries trains a zstd dictionary for each column waiting for one,
+ * on the value streams of the chunks of the stripe being flushed, which
+ * SerializeChunkData left uncompressed. The chunks are then compressed with the
+ * new dictionary, or without one when training failed, and later stripes use the
+ * dictionary as well.
+ */
+static void
+TrainZstdDictionaries(ColumnarWriteState *writeState)
+{
+	StripeBuffers *stripeBuffers = writeState->stripeBuffers;
+	uint32 chunkCount = writeState->stripeSkipList->chunkCount;
+	uint32 columnCount = writeState->tupleDescriptor->natts;
+	StringInfo compressionBuffer = writeState->compressionBuffer;
+
+	for (uint32 columnIndex = 0; columnIndex < columnCount; columnIndex++)
+	{
+		if (!writeState->trainZstdDictionaryArray[columnIndex])
+		{
+			continue;
+		}
+
+		ColumnBuffers *columnBuffers = stripeBuffers->columnBuffersArray[columnIndex];
+		List *sampleList = NIL;
+
+		for (uint32 chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+		{
+			ColumnChunkBuffers *chunkBuffers =
+				columnBuffers->chunkBuffersArray[chunkIndex];
+			if (chunkBuffers->valueEncodingType != ENCODING_CONSTANT)
+			{
+				sampleList = lappend(sampleList, chunkBuffers->valueBuffer);
+			}
+		}
+
+		bytea *dictionaryData =
+			TrainZstdDictionary(sampleList, columnar_zstd_dictionary_size * 1024);
+
+		ZstdDictionary *dictionary = NULL;
+		if (dictionaryData != NULL)
+		{
+			MemoryContext oldContext =
+				MemoryContextSwitchTo(writeState->dictionaryContext);
+
+			bytea *dictionaryCopy = palloc(VARSIZE(dictionaryData));
+			memcpy(dictionaryCopy, dictionaryData, VARSIZE(dictionaryData));
+			dictionary = CreateZstdDictionary(AttrOffsetGetAttrNumber(columnIndex),
+											  dictionaryCopy);
+
+			MemoryContextSwitchTo(oldContext);
+
+			SaveZstdDictionary(writeState->storageId, dictionary);
+			writeState->zstdDictionaryArray[columnIndex] = dictionary;
+		}
+
+		writeState->trainZstdDictionaryArray[columnIndex] = false;
+
+		for (uint32 chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+		{
+			ColumnChunkBuffers *chunkBuffers =
+				columnBuffers->chunkBuffersArray[chunkIndex];
+			int compressionLevel = writeState->columnCompressionLevelArray[columnIndex];
+
+			if (chunkBuffers->valueEncodingType == ENCODING_CONSTANT ||
+				chunkBuffers->valueBuffer->len == 0)
+			{
+				continue;
+			}
+
+			bool compressed =
+				dictionary != NULL ?
+				CompressBufferWithZstdDictionary(chunkBuffers->valueBuffer,
+												 compressionBuffer, compressionLevel,
+												 dictionary) :
+				CompressBuffer(chunkBuffers->valueBuffer, compressionBuffer,
+							   COMPRESSION_ZSTD, compressionLevel);
+
+			if (compressed)
+			{
+				chunkBuffers->valueBuffer = CopyStringInfo(compressionBuffer);
+				chunkBuffers->valueCompressionType = COMPRESSION_ZSTD;
+			}
+		}
+	}
+}
+
+
+/*
+ * ChooseAutoCompression picks the codec of a chunk whose compression is auto, see
+ * ChooseCompression for the cost model. When the chunk is encoded, the plain value
+ * stream is costed as well and the encoding is dropped if storing the plain stream
+ * is cheaper; decoding is charged ENCODING_DECODE_NS_PER_VALUE for every value.
+ *
+ * Returns the buffer to compress and sets the codec and level to compress it with.
+ * compressionLevel holds the highest level to try on input.
+ */
+static StringInfo
+ChooseAutoCompression(ColumnarWriteState *writeState, StringInfo plainBuffer,
+					  ColumnChunkBuffers *chunkBuffers, uint32 valueCount,
+					  CompressionType *compressionType, int *compressionLevel)
+{
+	double decodeCostWeight = columnar_auto_compression_decode_weight;
+	int maxCompressionLevel = *compressionLevel;
+	int plainCompressionLevel = 0;
+	double plainCost = 0;
+
+	CompressionType plainCompressionType =
+		ChooseCompression(plainBuffer, writeState->compressionBuffer,
+						  maxCompressionLevel, decodeCostWeight,
+						  &plainCompressionLevel, &plainCost);
+
+	if (chunkBuffers->valueEncodingType != ENCODING_NONE)
+	{
+		int encodedCompressionLevel = 0;
+		double encodedCost = 0;
+
+		CompressionType encodedCompressionType =
+			ChooseCompression(writeState->encodingBuffer, writeState->compressionBuffer,
+							  maxCompressionLevel, decodeCostWeight,
+							  &encodedCompressionLevel, &encodedCost);
+
+		encodedCost += decodeCostWeight * ENCODING_DECODE_NS_PER_VALUE * valueCount;
+
+		if (encodedCost < plainCost)
+		{
+			*compressionType = encodedCompressionType;
+			*compressionLevel = encodedCompressionLevel;
+			return writeState->encodingBuffer;
+		}
+
+		chunkBuffers->valueEncodingType = ENCODING_NONE;
+	}
+
+	*compressionType = plainCompressionType;
+	*compressionLevel = plainCompressionLevel;
+	return plainBuffer;
+}
+
+
 /*
  * UpdateChunkSkipNodeMinMax takes the given column value, and checks if this
  * value falls outside the range of minimum/maximum values of the given column
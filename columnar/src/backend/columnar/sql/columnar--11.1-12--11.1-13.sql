@@ -0,0 +1,120 @@
+-- columnar--11.1-12--11.1-13.sql
+
+-- encoding applied to the value stream of a chunk before compression
+ALTER TABLE columnar.chunk ADD COLUMN value_encoding_type INT NOT NULL DEFAULT 0;
+
+-- bloom filter of the values of a chunk, for columns with bloom_filter enabled
+ALTER TABLE columnar.chunk ADD COLUMN bloom_filter bytea;
+
+-- per-column compression settings, overriding the ones in columnar.options
+CREATE TABLE columnar.column_options (
+    regclass regclass NOT NULL,
+    attr_num int NOT NULL,
+    compression_level int,
+    compression name,
+    bloom_filter bool NOT NULL DEFAULT false,
+    PRIMARY KEY (regclass, attr_num)
+) WITH (user_catalog_table = true);
+
+COMMENT ON TABLE columnar.column_options IS 'columnar column specific compression and bloom filter options, maintained by alter_columnar_table_set';
+
+GRANT SELECT ON columnar.column_options TO PUBLIC;
+
+-- zstd dictionaries trained on the chunks of a column, chunks compressed with
+-- a dictionary carry its dictionary_id in their zstd frame header
+CREATE TABLE columnar.zstd_dictionary (
+    storage_id bigint NOT NULL,
+    attr_num int NOT NULL,
+    version int NOT NULL,
+    dictionary_id bigint NOT NULL,
+    dictionary bytea NOT NULL,
+    PRIMARY KEY (storage_id, attr_num, version)
+) WITH (user_catalog_table = true);
+
+COMMENT ON TABLE columnar.zstd_dictionary IS 'columnar zstd dictionaries, trained by the writer or by train_zstd_dictionaries';
+
+-- dictionaries are built from table data
+REVOKE SELECT ON columnar.zstd_dictionary FROM PUBLIC;
+
+-- min/max values and null counts of each column over a whole stripe, so that
+-- scans can skip stripes without reading their columnar.chunk rows
+CREATE TABLE columnar.stripe_zone_map (
+    storage_id bigint NOT NULL,
+    stripe_num bigint NOT NULL,
+    attr_num int NOT NULL,
+    minimum_value bytea,
+    maximum_value bytea,
+    null_count bigint NOT NULL,
+    PRIMARY KEY (storage_id, stripe_num, attr_num)
+) WITH (user_catalog_table = true);
+
+COMMENT ON TABLE columnar.stripe_zone_map IS 'Columnar per stripe and column min/max values and null counts';
+
+-- min/max values are table data, like the ones in columnar.chunk
+REVOKE SELECT ON columnar.stripe_zone_map FROM PUBLIC;
+
+#include "udfs/alter_columnar_table_set/11.1-13.sql"
+#include "udfs/alter_columnar_table_reset/11.1-13.sql"
+#include "udfs/train_zstd_dictionaries/11.1-13.sql"
+#include "udfs/prewarm/11.1-13.sql"
+
+-- float4 / float8 vectorized aggregates, with the same transition states as
+-- the built-in ones so that partial results combine with their functions
+
+CREATE FUNCTION vfloat4pl(float4, float4) RETURNS float4 AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vsum(float4) (SFUNC = vfloat4pl, STYPE = float4);
+
+CREATE FUNCTION vfloat8pl(float8, float8) RETURNS float8 AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vsum(float8) (SFUNC = vfloat8pl, STYPE = float8);
+
+CREATE FUNCTION vfloat4larger(float4, float4) RETURNS float4 AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vmax(float4) (SFUNC = vfloat4larger, STYPE = float4);
+
+CREATE FUNCTION vfloat4smaller(float4, float4) RETURNS float4 AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vmin(float4) (SFUNC = vfloat4smaller, STYPE = float4);
+
+CREATE FUNCTION vfloat8larger(float8, float8) RETURNS float8 AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vmax(float8) (SFUNC = vfloat8larger, STYPE = float8);
+
+CREATE FUNCTION vfloat8smaller(float8, float8) RETURNS float8 AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vmin(float8) (SFUNC = vfloat8smaller, STYPE = float8);
+
+CREATE FUNCTION vfloat4accum(float8[], float4) RETURNS float8[] AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vavg(float4) (SFUNC = vfloat4accum, STYPE = float8[], FINALFUNC = float8_avg, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vvar_pop(float4) (SFUNC = vfloat4accum, STYPE = float8[], FINALFUNC = float8_var_pop, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vvar_samp(float4) (SFUNC = vfloat4accum, STYPE = float8[], FINALFUNC = float8_var_samp, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vvariance(float4) (SFUNC = vfloat4accum, STYPE = float8[], FINALFUNC = float8_var_samp, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vstddev_pop(float4) (SFUNC = vfloat4accum, STYPE = float8[], FINALFUNC = float8_stddev_pop, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vstddev_samp(float4) (SFUNC = vfloat4accum, STYPE = float8[], FINALFUNC = float8_stddev_samp, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vstddev(float4) (SFUNC = vfloat4accum, STYPE = float8[], FINALFUNC = float8_stddev_samp, INITCOND = '{0,0,0}');
+
+CREATE FUNCTION vfloat8accum(float8[], float8) RETURNS float8[] AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vavg(float8) (SFUNC = vfloat8accum, STYPE = float8[], FINALFUNC = float8_avg, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vvar_pop(float8) (SFUNC = vfloat8accum, STYPE = float8[], FINALFUNC = float8_var_pop, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vvar_samp(float8) (SFUNC = vfloat8accum, STYPE = float8[], FINALFUNC = float8_var_samp, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vvariance(float8) (SFUNC = vfloat8accum, STYPE = float8[], FINALFUNC = float8_var_samp, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vstddev_pop(float8) (SFUNC = vfloat8accum, STYPE = float8[], FINALFUNC = float8_stddev_pop, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vstddev_samp(float8) (SFUNC = vfloat8accum, STYPE = float8[], FINALFUNC = float8_stddev_samp, INITCOND = '{0,0,0}');
+CREATE AGGREGATE vstddev(float8) (SFUNC = vfloat8accum, STYPE = float8[], FINALFUNC = float8_stddev_samp, INITCOND = '{0,0,0}');
+
+-- numeric vectorized aggregates, sum and avg serialize to the state of the
+-- built-in ones so that partial results combine with their functions
+
+CREATE FUNCTION vnumericacc(internal, numeric) RETURNS internal AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+
+CREATE FUNCTION vnumeric_avg_serialize(internal) RETURNS bytea AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE STRICT;
+CREATE FUNCTION vnumeric_avg_deserialize(bytea, internal) RETURNS internal AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION vnumericsum(internal) RETURNS numeric AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vsum(numeric) (SFUNC = vnumericacc, STYPE = internal, FINALFUNC = vnumericsum,
+                                SERIALFUNC = vnumeric_avg_serialize, DESERIALFUNC = vnumeric_avg_deserialize);
+
+CREATE FUNCTION vnumericavg(internal) RETURNS numeric AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vavg(numeric) (SFUNC = vnumericacc, STYPE = internal, FINALFUNC = vnumericavg,
+                                SERIALFUNC = vnumeric_avg_serialize, DESERIALFUNC = vnumeric_avg_deserialize);
+
+CREATE FUNCTION vnumericlarger(numeric, numeric) RETURNS numeric AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vmax(numeric) (SFUNC = vnumericlarger, STYPE = numeric);
+
+CREATE FUNCTION vnumericsmaller(numeric, numeric) RETURNS numeric AS 'MODULE_PATHNAME' LANGUAGE C IMMUTABLE;
+CREATE AGGREGATE vmin(numeric) (SFUNC = vnumericsmaller, STYPE = numeric);
@@ -0,0 +1,24 @@
+DROP FUNCTION IF EXISTS columnar.alter_columnar_table_reset(regclass, bool, bool, bool, bool);
+
+CREATE OR REPLACE FUNCTION columnar.alter_columnar_table_reset(
+    table_name regclass,
+    chunk_group_row_limit bool DEFAULT false,
+    stripe_row_limit bool DEFAULT false,
+    compression bool DEFAULT false,
+    compression_level bool DEFAULT false,
+    column_names name[] DEFAULT NULL,
+    bloom_filter bool DEFAULT false)
+    RETURNS void
+    LANGUAGE C
+AS 'MODULE_PATHNAME', 'alter_columnar_table_reset';
+
+COMMENT ON FUNCTION columnar.alter_columnar_table_reset(
+    table_name regclass,
+    chunk_group_row_limit bool,
+    stripe_row_limit bool,
+    compression bool,
+    compression_level bool,
+    column_names name[],
+    bloom_filter bool)
+IS 'reset on or more options on a columnar table to the system defaults; '
+   'when column_names is given the per-column compression and bloom_filter settings are removed';
@@ -3,7 +3,9 @@ CREATE OR REPLACE FUNCTION columnar.alter_columnar_table_reset(
     chunk_group_row_limit bool DEFAULT false,
     stripe_row_limit bool DEFAULT false,
     compression bool DEFAULT false,
-    compression_level bool DEFAULT false)
+    compression_level bool DEFAULT false,
+    column_names name[] DEFAULT NULL,
+    bloom_filter bool DEFAULT false)
     RETURNS void
     LANGUAGE C
 AS 'MODULE_PATHNAME', 'alter_columnar_table_reset';
@@ -13,5 +15,8 @@ COMMENT ON FUNCTION columnar.alter_columnar_table_reset(
     chunk_group_row_limit bool,
     stripe_row_limit bool,
     compression bool,
-    compression_level bool)
-IS 'reset on or more options on a columnar table to the system defaults';
+    compression_level bool,
+    column_names name[],
+    bloom_filter bool)
+IS 'reset on or more options on a columnar table to the system defaults; '
+   'when column_names is given the per-column compression and bloom_filter settings are removed';
@@ -3,7 +3,9 @@ CREATE OR REPLACE FUNCTION columnar.alter_columnar_table_set(
     chunk_group_row_limit int DEFAULT NULL,
     stripe_row_limit int DEFAULT NULL,
     compression name DEFAULT null,
-    compression_level int DEFAULT NULL)
+    compression_level int DEFAULT NULL,
+    column_names name[] DEFAULT NULL,
+    bloom_filter bool DEFAULT NULL)
     RETURNS void
     LANGUAGE C
 AS 'MODULE_PATHNAME', 'alter_columnar_table_set';
@@ -13,5 +15,9 @@ COMMENT ON FUNCTION columnar.alter_columnar_table_set(
     chunk_group_row_limit int,
     stripe_row_limit int,
     compression name,
-    compression_level int)
-IS 'set one or more options on a columnar table, when set to NULL no change is made';
+    compression_level int,
+    column_names name[],
+    bloom_filter bool)
+IS 'set one or more options on a columnar table, when set to NULL no change is made; '
+   'compression and compression_level apply only to column_names when given, '
+   'bloom_filter requires column_names';
@@ -0,0 +1,13 @@
+CREATE OR REPLACE FUNCTION columnar.prewarm(
+    table_name regclass,
+    columns text[] DEFAULT NULL,
+    since_stripe bigint DEFAULT 0)
+    RETURNS bigint
+    LANGUAGE C
+AS 'MODULE_PATHNAME', 'columnar_prewarm';
+
+COMMENT ON FUNCTION columnar.prewarm(
+    table_name regclass,
+    columns text[],
+    since_stripe bigint)
+IS 'load the chunks of the given columns, all columns if NULL, in the stripes from since_stripe on of a columnar table into the shared column cache';
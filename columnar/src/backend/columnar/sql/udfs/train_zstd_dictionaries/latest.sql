@@ -0,0 +1,11 @@
+CREATE OR REPLACE FUNCTION columnar.train_zstd_dictionaries(
+    table_name regclass,
+    dictionary_size int DEFAULT NULL)
+    RETURNS int
+    LANGUAGE C
+AS 'MODULE_PATHNAME', 'train_zstd_dictionaries';
+
+COMMENT ON FUNCTION columnar.train_zstd_dictionaries(
+    table_name regclass,
+    dictionary_size int)
+IS 'train zstd dictionaries, of dictionary_size kB (64 kB by default), for the zstd compressed columns of a columnar table on its stored chunks';
@@ -164,6 +164,7 @@ CleanupVectorSlot(VectorTupleTableSlot *vectorSlot)
 		VectorColumn *column = (VectorColumn *) vectorSlot->tts.tts_values[i];
 		memset(column->isnull, true, COLUMNAR_VECTOR_COLUMN_SIZE);
 		column->dimension = 0;
+		column->hasRuns = false;
 	}
 	
 	memset(vectorSlot->keep, true, COLUMNAR_VECTOR_COLUMN_SIZE);
@@ -276,6 +276,7 @@
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "port/pg_bitutils.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
@@ -291,6 +292,8 @@
 #include "columnar/vectorization/columnar_vector_execution.h"
 #include "columnar/vectorization/nodes/columnar_aggregator_node.h"
 
+#include "columnar/utils/listutils.h"
+
 /*
  * Control how many partitions are created when spilling HashAgg to
  * disk.
@@ -415,6 +418,68 @@ typedef struct FindColsContext
 	Bitmapset  *unaggregated;	/* other column references */
 } FindColsContext;
 
+/*
+ * Slot of the open-addressing table that maps the grouping keys of the rows
+ * of a vector batch to batch-local groups.
+ */
+typedef struct VectorHashSlot
+{
+	uint32		hash;			/* hash of the grouping key */
+	int32		group;			/* local group, -1 if the slot is free */
+} VectorHashSlot;
+
+/*
+ * Hashed aggregation of vector batches.
+ *
+ * The grouping keys of a batch are hashed one key column at a time, and rows
+ * with equal keys are collected into local groups through a small
+ * open-addressing table. Each local group is looked up in the aggregate hash
+ * table only once, and the vectorized transition functions then run once per
+ * group, on a vector holding the rows of that group. Rows of groups that
+ * don't fit in the hash table are spilled like in row mode, and read back in
+ * batches.
+ */
+typedef struct VectorHashBatch
+{
+	uint32	   *hashes;			/* hash of the grouping key of each row */
+	int32	   *rowGroups;		/* local group of each row */
+	int32	   *groupRows;		/* rows, ordered by local group */
+	int32	   *groupFirstRow;	/* first row of each local group */
+	int32	   *groupRowCount;	/* row count of each local group */
+	bool	   *groupSpilled;	/* whether the rows of a local group spill */
+	AggStatePerGroup *groupStates;	/* transition states of each local group */
+	int32		groupCount;		/* number of local groups */
+	VectorHashSlot *slots;		/* local groups by grouping key */
+	List	   *columnList;		/* needed input columns, 0-based */
+	TupleTableSlot *groupSlot;	/* vector of the rows of one group */
+	TupleTableSlot *rowSlot;	/* single row of a batch, to spill it */
+	TupleTableSlot *refillSlot; /* vector of spilled rows read back */
+	MemoryContext refillContext;	/* by-reference values of refillSlot */
+} VectorHashBatch;
+
+/*
+ * Sorted aggregation of vector batches.
+ *
+ * Group boundaries within a batch are found by comparing the grouping keys of
+ * adjacent rows, one key column at a time. The rows between two boundaries
+ * form a run of one group, and the vectorized transition functions run once
+ * per run. When the sorted input comes from a Sort rather than from a
+ * columnar scan, its rows are packed into vector batches first.
+ */
+typedef struct VectorSortedBatch
+{
+	TupleTableSlot *batch;		/* current batch of the input */
+	int32		nextRow;		/* first row of the batch not aggregated yet */
+	bool	   *groupStart;		/* whether a row starts a new group */
+	FmgrInfo   *eqfunctions;	/* equality functions of the grouping keys */
+	bool	   *binaryEqual;	/* whether a key is equal iff binary equal */
+	List	   *columnList;		/* needed input columns, 0-based */
+	TupleTableSlot *runSlot;	/* vector of the rows of one run */
+	TupleTableSlot *rowSlot;	/* single row of a batch */
+	TupleTableSlot *packSlot;	/* vector of packed input rows, if any */
+	MemoryContext packContext;	/* by-reference values of packSlot */
+} VectorSortedBatch;
+
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
 static TupleTableSlot *fetch_input_tuple(AggState *aggstate);
@@ -467,10 +532,33 @@ static void initialize_hash_entry(AggState *aggstate,
 								  TupleHashTable hashtable,
 								  TupleHashEntry entry);
 static void lookup_hash_entries(AggState *aggstate);
+static VectorHashBatch *create_vector_hash_batch(AggState *aggstate);
+static void hash_vector_keys(AggStatePerHash perhash,
+							 VectorTupleTableSlot *batch, uint32 *hashes);
+static bool vector_keys_equal(AggStatePerHash perhash,
+							  VectorTupleTableSlot *batch,
+							  int32 leftRow, int32 rightRow);
+static void lookup_hash_entries_vector(VectorAggState *vectoraggstate,
+									   VectorTupleTableSlot *batch,
+									   HashAggSpill *spill, int used_bits,
+									   double input_groups);
+static void advance_hash_aggregates_vector(VectorAggState *vectoraggstate,
+										   VectorTupleTableSlot *batch);
+static void store_vector_row(VectorTupleTableSlot *vectorSlot, int32 row,
+							 TupleTableSlot *slot, List *columnList,
+							 MemoryContext valueContext);
+static VectorSortedBatch *create_vector_sorted_batch(AggState *aggstate);
+static VectorTupleTableSlot *fetch_input_batch(VectorAggState *vectoraggstate);
+static void mark_group_starts(VectorAggState *vectoraggstate,
+							  VectorTupleTableSlot *batch, bool groupContinues);
+static void advance_sorted_run(VectorAggState *vectoraggstate,
+							   VectorTupleTableSlot *batch,
+							   int32 startRow, int32 endRow);
 static TupleTableSlot *agg_retrieve_direct(VectorAggState *vectoraggstate);
-static void agg_fill_hash_table(AggState *aggstate);
-static bool agg_refill_hash_table(AggState *aggstate);
-static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_sorted(VectorAggState *vectoraggstate);
+static void agg_fill_hash_table(VectorAggState *vectoraggstate);
+static bool agg_refill_hash_table(VectorAggState *vectoraggstate);
+static TupleTableSlot *agg_retrieve_hash_table(VectorAggState *vectoraggstate);
 static TupleTableSlot *agg_retrieve_hash_table_in_memory(AggState *aggstate);
 static void hash_agg_check_limits(AggState *aggstate);
 static void hash_agg_enter_spill_mode(AggState *aggstate);
@@ -2272,6 +2360,679 @@ lookup_hash_entries(AggState *aggstate)
 	}
 }
 
+/*
+ * Allocate the state for hashing vector batches. The per-row and per-group
+ * arrays are sized for the largest batch.
+ */
+static VectorHashBatch *
+create_vector_hash_batch(AggState *aggstate)
+{
+	TupleDesc	scanDesc = aggstate->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	VectorHashBatch *hashBatch = palloc0(sizeof(VectorHashBatch));
+	int			colno = -1;
+
+	hashBatch->hashes = palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(uint32));
+	hashBatch->rowGroups = palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(int32));
+	hashBatch->groupRows = palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(int32));
+	hashBatch->groupFirstRow = palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(int32));
+	hashBatch->groupRowCount = palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(int32));
+	hashBatch->groupSpilled = palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(bool));
+	hashBatch->groupStates =
+		palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(AggStatePerGroup));
+	hashBatch->slots =
+		palloc(pg_nextpower2_32(2 * COLUMNAR_VECTOR_COLUMN_SIZE) *
+			   sizeof(VectorHashSlot));
+
+	while ((colno = bms_next_member(aggstate->colnos_needed, colno)) >= 0)
+	{
+		if (colno > 0 && colno <= scanDesc->natts)
+			hashBatch->columnList = lappend_int(hashBatch->columnList, colno - 1);
+	}
+
+	hashBatch->groupSlot = CreateVectorTupleTableSlot(scanDesc);
+	hashBatch->refillSlot = CreateVectorTupleTableSlot(scanDesc);
+	hashBatch->rowSlot = MakeSingleTupleTableSlot(scanDesc, &TTSOpsVirtual);
+	hashBatch->refillContext =
+		AllocSetContextCreate(CurrentMemoryContext,
+							  "VectorAgg refill values",
+							  ALLOCSET_DEFAULT_SIZES);
+
+	return hashBatch;
+}
+
+/*
+ * Return the value of the given row of a vector column.
+ */
+static inline Datum
+vector_column_value(VectorColumn *column, int32 row)
+{
+	int8	   *rawValue = (int8 *) column->value + column->columnTypeLen * row;
+
+	return fetch_att(rawValue, column->columnIsVal, column->columnTypeLen);
+}
+
+/*
+ * Store the needed columns of a row slot as the given row of a vector slot.
+ * Varlena values are kept in vectors by pointer, so they are copied into
+ * valueContext, which must live as long as the vector is used.
+ */
+static void
+store_vector_row(VectorTupleTableSlot *vectorSlot, int32 row,
+				 TupleTableSlot *slot, List *columnList,
+				 MemoryContext valueContext)
+{
+	TupleDesc	tupleDesc = slot->tts_tupleDescriptor;
+	int			attno;
+
+	slot_getallattrs(slot);
+
+	foreach_int(attno, columnList)
+	{
+		VectorColumn *column = (VectorColumn *) vectorSlot->tts.tts_values[attno];
+		Form_pg_attribute attr = TupleDescAttr(tupleDesc, attno);
+		int8	   *rawValue = (int8 *) column->value + column->columnTypeLen * row;
+		Datum		value = slot->tts_values[attno];
+
+		column->isnull[row] = slot->tts_isnull[attno];
+		column->dimension = row + 1;
+
+		if (slot->tts_isnull[attno])
+			continue;
+
+		if (attr->attlen == -1)
+		{
+			MemoryContext oldContext = MemoryContextSwitchTo(valueContext);
+
+			value = datumCopy(value, false, -1);
+			MemoryContextSwitchTo(oldContext);
+		}
+
+		if (column->columnTypeLen <= sizeof(Datum))
+			store_att_byval(rawValue, value, column->columnTypeLen);
+		else
+			memcpy(rawValue, DatumGetPointer(value), column->columnTypeLen);
+	}
+}
+
+/*
+ * Hash the grouping keys of all rows of a vector batch, one key column at a
+ * time. Keys are combined like TupleHashTableHash() does, and int4 and int8
+ * keys are hashed inline rather than through their hash functions.
+ */
+static void
+hash_vector_keys(AggStatePerHash perhash, VectorTupleTableSlot *batch,
+				 uint32 *hashes)
+{
+	uint32		rowCount = batch->dimension;
+	uint32		row;
+	int			i;
+
+	for (row = 0; row < rowCount; row++)
+		hashes[row] = perhash->hashtable->hash_iv;
+
+	for (i = 0; i < perhash->numCols; i++)
+	{
+		int			varNumber = perhash->hashGrpColIdxInput[i] - 1;
+		VectorColumn *column = (VectorColumn *) batch->tts.tts_values[varNumber];
+		FmgrInfo   *hashfunction = &perhash->hashfunctions[i];
+		Oid			collation = perhash->aggnode->grpCollations[i];
+
+		for (row = 0; row < rowCount; row++)
+			hashes[row] = (hashes[row] << 1) | (hashes[row] >> 31);
+
+		if (hashfunction->fn_addr == hashint4 &&
+			column->columnTypeLen == sizeof(int32))
+		{
+			int32	   *values = (int32 *) column->value;
+
+			for (row = 0; row < rowCount; row++)
+			{
+				if (!column->isnull[row])
+					hashes[row] ^= hash_bytes_uint32((uint32) values[row]);
+			}
+		}
+		else if (hashfunction->fn_addr == hashint8 &&
+				 column->columnTypeLen == sizeof(int64))
+		{
+			int64	   *values = (int64 *) column->value;
+
+			for (row = 0; row < rowCount; row++)
+			{
+				int64		value = values[row];
+				uint32		lohalf = (uint32) value;
+				uint32		hihalf = (uint32) (value >> 32);
+
+				/* same as hashint8() */
+				lohalf ^= (value >= 0) ? hihalf : ~hihalf;
+
+				if (!column->isnull[row])
+					hashes[row] ^= hash_bytes_uint32(lohalf);
+			}
+		}
+		else
+		{
+			for (row = 0; row < rowCount; row++)
+			{
+				if (!column->isnull[row])
+				{
+					Datum		value = vector_column_value(column, row);
+
+					hashes[row] ^=
+						DatumGetUInt32(FunctionCall1Coll(hashfunction, collation,
+														 value));
+				}
+			}
+		}
+	}
+
+	for (row = 0; row < rowCount; row++)
+		hashes[row] = murmurhash32(hashes[row]);
+}
+
+/*
+ * Check whether two rows of a vector batch have binary equal grouping keys.
+ * Keys that are equal but differ in their binary form land in different local
+ * groups, which still find the same hash table entry.
+ */
+static bool
+vector_keys_equal(AggStatePerHash perhash, VectorTupleTableSlot *batch,
+				  int32 leftRow, int32 rightRow)
+{
+	TupleDesc	hashDesc = perhash->hashslot->tts_tupleDescriptor;
+	int			i;
+
+	for (i = 0; i < perhash->numCols; i++)
+	{
+		int			varNumber = perhash->hashGrpColIdxInput[i] - 1;
+		VectorColumn *column = (VectorColumn *) batch->tts.tts_values[varNumber];
+		Form_pg_attribute attr = TupleDescAttr(hashDesc, i);
+
+		if (column->isnull[leftRow] || column->isnull[rightRow])
+		{
+			if (column->isnull[leftRow] != column->isnull[rightRow])
+				return false;
+
+			continue;
+		}
+
+		if (!datumIsEqual(vector_column_value(column, leftRow),
+						  vector_column_value(column, rightRow),
+						  attr->attbyval, attr->attlen))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Find or create the hash table entries of the rows of a vector batch, whose
+ * hashes are in the batch state already, for the current grouping set.
+ *
+ * Rows are first collected into local groups, and each local group is looked
+ * up once. In spill mode, the rows of local groups that are not in the hash
+ * table are spilled to spill, or to the spill of the current grouping set if
+ * spill is NULL.
+ */
+static void
+lookup_hash_entries_vector(VectorAggState *vectoraggstate,
+						   VectorTupleTableSlot *batch, HashAggSpill *spill,
+						   int used_bits, double input_groups)
+{
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorHashBatch *hashBatch = vectoraggstate->hashBatch;
+	AggStatePerHash perhash = &aggstate->perhash[aggstate->current_set];
+	TupleHashTable hashtable = perhash->hashtable;
+	TupleTableSlot *hashslot = perhash->hashslot;
+	VectorHashSlot *slots = hashBatch->slots;
+	uint32		rowCount = batch->dimension;
+	uint32		slotMask = pg_nextpower2_32(Max(2 * rowCount, 16)) - 1;
+	int32		groupCount = 0;
+	uint32		row;
+
+	for (uint32 slotIndex = 0; slotIndex <= slotMask; slotIndex++)
+		slots[slotIndex].group = -1;
+
+	for (row = 0; row < rowCount; row++)
+	{
+		uint32		hash = hashBatch->hashes[row];
+		uint32		slotIndex = hash & slotMask;
+		int32		group = -1;
+
+		/* find the local group of the row, probing linearly */
+		while (slots[slotIndex].group >= 0)
+		{
+			if (slots[slotIndex].hash == hash &&
+				vector_keys_equal(perhash, batch,
+								  hashBatch->groupFirstRow[slots[slotIndex].group],
+								  row))
+			{
+				group = slots[slotIndex].group;
+				break;
+			}
+
+			slotIndex = (slotIndex + 1) & slotMask;
+		}
+
+		if (group < 0)
+		{
+			TupleHashEntry entry;
+			bool		isnew = false;
+			bool	   *p_isnew;
+			int			i;
+
+			group = groupCount++;
+			slots[slotIndex].hash = hash;
+			slots[slotIndex].group = group;
+			hashBatch->groupFirstRow[group] = row;
+			hashBatch->groupRowCount[group] = 0;
+
+			/* if hash table already spilled, don't create new entries */
+			p_isnew = aggstate->hash_spill_mode ? NULL : &isnew;
+
+			ExecClearTuple(hashslot);
+			for (i = 0; i < perhash->numhashGrpCols; i++)
+			{
+				int			varNumber = perhash->hashGrpColIdxInput[i] - 1;
+				VectorColumn *column =
+					(VectorColumn *) batch->tts.tts_values[varNumber];
+
+				hashslot->tts_isnull[i] = column->isnull[row];
+				hashslot->tts_values[i] = column->isnull[row] ? (Datum) 0 :
+					vector_column_value(column, row);
+			}
+			ExecStoreVirtualTuple(hashslot);
+
+			entry = LookupTupleHashEntryHash(hashtable, hashslot, p_isnew, hash);
+
+			if (entry != NULL)
+			{
+				if (isnew)
+					initialize_hash_entry(aggstate, hashtable, entry);
+				hashBatch->groupStates[group] = entry->additional;
+				hashBatch->groupSpilled[group] = false;
+			}
+			else
+			{
+				hashBatch->groupStates[group] = NULL;
+				hashBatch->groupSpilled[group] = true;
+			}
+		}
+
+		hashBatch->rowGroups[row] = group;
+		hashBatch->groupRowCount[group]++;
+
+		if (hashBatch->groupSpilled[group])
+		{
+			HashAggSpill *rowSpill = spill != NULL ? spill :
+				&aggstate->hash_spills[aggstate->current_set];
+			TupleTableSlot *rowSlot = hashBatch->rowSlot;
+
+			if (rowSpill->partitions == NULL)
+#if PG_VERSION_NUM < PG_VERSION_15
+				hashagg_spill_init(rowSpill, aggstate->hash_tapeinfo, used_bits,
+#else
+				hashagg_spill_init(rowSpill, aggstate->hash_tapeset, used_bits,
+#endif
+								   input_groups, aggstate->hashentrysize);
+
+			ExecClearTuple(rowSlot);
+			memset(rowSlot->tts_isnull, true,
+				   rowSlot->tts_tupleDescriptor->natts * sizeof(bool));
+			ExtractTupleFromVectorSlot(rowSlot, batch, row, hashBatch->columnList);
+
+			hashagg_spill_tuple(aggstate, rowSpill, rowSlot, hash);
+		}
+	}
+
+	hashBatch->groupCount = groupCount;
+}
+
+/*
+ * Advance the transition states of the local groups of a vector batch that
+ * are in the hash table. The rows of the batch are ordered by local group,
+ * and each group's rows are gathered into a vector of their own, so that the
+ * vectorized transition functions run once per group rather than per row.
+ */
+static void
+advance_hash_aggregates_vector(VectorAggState *vectoraggstate,
+							   VectorTupleTableSlot *batch)
+{
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorHashBatch *hashBatch = vectoraggstate->hashBatch;
+	VectorTupleTableSlot *groupSlot = (VectorTupleTableSlot *) hashBatch->groupSlot;
+	/* the first rows of the local groups are not needed anymore */
+	int32	   *groupRowOffset = hashBatch->groupFirstRow;
+	int32		groupCount = hashBatch->groupCount;
+	int32		rowOffset = 0;
+	int32		group;
+	uint32		row;
+
+	/* nothing to advance without transition states */
+	if (aggstate->numtrans == 0)
+		return;
+
+	/* counting sort of the rows by local group, skipping spilled groups */
+	for (group = 0; group < groupCount; group++)
+	{
+		groupRowOffset[group] = rowOffset;
+
+		if (!hashBatch->groupSpilled[group])
+			rowOffset += hashBatch->groupRowCount[group];
+	}
+
+	for (row = 0; row < batch->dimension; row++)
+	{
+		group = hashBatch->rowGroups[row];
+
+		if (!hashBatch->groupSpilled[group])
+			hashBatch->groupRows[groupRowOffset[group]++] = row;
+	}
+
+	rowOffset = 0;
+
+	for (group = 0; group < groupCount; group++)
+	{
+		int32		groupRowCount = hashBatch->groupRowCount[group];
+		int32	   *groupRows = &hashBatch->groupRows[rowOffset];
+		AggStatePerGroup pergroup = hashBatch->groupStates[group];
+		int			attno;
+		int			transno;
+
+		if (hashBatch->groupSpilled[group])
+			continue;
+
+		rowOffset += groupRowCount;
+
+		ExecClearTuple(&groupSlot->tts);
+
+		foreach_int(attno, hashBatch->columnList)
+		{
+			VectorColumn *source = (VectorColumn *) batch->tts.tts_values[attno];
+			VectorColumn *target = (VectorColumn *) groupSlot->tts.tts_values[attno];
+			int16		typeLen = source->columnTypeLen;
+
+			for (int32 i = 0; i < groupRowCount; i++)
+			{
+				int32		sourceRow = groupRows[i];
+
+				memcpy((int8 *) target->value + typeLen * i,
+					   (int8 *) source->value + typeLen * sourceRow,
+					   typeLen);
+				target->isnull[i] = source->isnull[sourceRow];
+			}
+
+			target->dimension = groupRowCount;
+			target->hasRuns = false;
+		}
+
+		groupSlot->dimension = groupRowCount;
+		ExecStoreVirtualTuple(&groupSlot->tts);
+
+		aggstate->hash_pergroup[aggstate->current_set] = pergroup;
+		aggstate->tmpcontext->ecxt_outertuple = &groupSlot->tts;
+
+		advance_aggregates(aggstate);
+
+		/* count(*) has no argument to count the rows of */
+		for (transno = 0; transno < aggstate->numtrans; transno++)
+		{
+			AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+
+			if (pertrans->aggref->aggstar)
+				pergroup[transno].transValue =
+					Int64GetDatum(DatumGetInt64(pergroup[transno].transValue) +
+								  groupRowCount);
+		}
+
+		ResetExprContext(aggstate->tmpcontext);
+	}
+}
+
+/*
+ * Allocate the state for aggregating sorted vector batches.
+ */
+static VectorSortedBatch *
+create_vector_sorted_batch(AggState *aggstate)
+{
+	Agg		   *aggnode = (Agg *) aggstate->ss.ps.plan;
+	TupleDesc	scanDesc = aggstate->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	VectorSortedBatch *sortedBatch = palloc0(sizeof(VectorSortedBatch));
+	int			colno = -1;
+	int			i;
+
+	sortedBatch->groupStart = palloc(COLUMNAR_VECTOR_COLUMN_SIZE * sizeof(bool));
+	sortedBatch->eqfunctions = palloc0(aggnode->numCols * sizeof(FmgrInfo));
+	sortedBatch->binaryEqual = palloc0(aggnode->numCols * sizeof(bool));
+
+	for (i = 0; i < aggnode->numCols; i++)
+	{
+		FmgrInfo   *eqfunction = &sortedBatch->eqfunctions[i];
+
+		fmgr_info(get_opcode(aggnode->grpOperators[i]), eqfunction);
+
+		/* integer keys are compared without calling their equality function */
+		sortedBatch->binaryEqual[i] = eqfunction->fn_addr == int2eq ||
+			eqfunction->fn_addr == int4eq ||
+			eqfunction->fn_addr == int8eq ||
+			eqfunction->fn_addr == date_eq;
+	}
+
+	while ((colno = bms_next_member(aggstate->colnos_needed, colno)) >= 0)
+	{
+		if (colno > 0 && colno <= scanDesc->natts)
+			sortedBatch->columnList = lappend_int(sortedBatch->columnList, colno - 1);
+	}
+
+	sortedBatch->runSlot = CreateVectorTupleTableSlot(scanDesc);
+	sortedBatch->rowSlot = MakeSingleTupleTableSlot(scanDesc, &TTSOpsVirtual);
+
+	/* rows of a Sort are packed into vectors */
+	if (!IsA(outerPlan(aggnode), CustomScan))
+	{
+		sortedBatch->packSlot = CreateVectorTupleTableSlot(scanDesc);
+		sortedBatch->packContext =
+			AllocSetContextCreate(CurrentMemoryContext,
+								  "VectorAgg packed values",
+								  ALLOCSET_DEFAULT_SIZES);
+	}
+
+	return sortedBatch;
+}
+
+/*
+ * Fetch the next vector batch of the input, or NULL once the input is
+ * exhausted. Rows of an input that doesn't produce vectors are packed into
+ * batches here.
+ */
+static VectorTupleTableSlot *
+fetch_input_batch(VectorAggState *vectoraggstate)
+{
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorSortedBatch *sortedBatch = vectoraggstate->sortedBatch;
+	VectorTupleTableSlot *packSlot = (VectorTupleTableSlot *) sortedBatch->packSlot;
+	TupleTableSlot *outerslot;
+	int32		rowCount = 0;
+
+	if (packSlot == NULL)
+	{
+		outerslot = fetch_input_tuple(aggstate);
+
+		return TupIsNull(outerslot) ? NULL : (VectorTupleTableSlot *) outerslot;
+	}
+
+	ExecClearTuple(&packSlot->tts);
+	CleanupVectorSlot(packSlot);
+	MemoryContextReset(sortedBatch->packContext);
+
+	while (rowCount < COLUMNAR_VECTOR_COLUMN_SIZE)
+	{
+		outerslot = fetch_input_tuple(aggstate);
+		if (TupIsNull(outerslot))
+			break;
+
+		store_vector_row(packSlot, rowCount, outerslot,
+						 sortedBatch->columnList, sortedBatch->packContext);
+		rowCount++;
+	}
+
+	if (rowCount == 0)
+		return NULL;
+
+	packSlot->dimension = rowCount;
+	ExecStoreVirtualTuple(&packSlot->tts);
+
+	return packSlot;
+}
+
+/*
+ * Mark the rows of a sorted vector batch that start a new group, by comparing
+ * the grouping keys of adjacent rows one key column at a time. The first row
+ * is compared to the first row of the current group if groupContinues is set,
+ * and starts a new group otherwise.
+ */
+static void
+mark_group_starts(VectorAggState *vectoraggstate, VectorTupleTableSlot *batch,
+				  bool groupContinues)
+{
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorSortedBatch *sortedBatch = vectoraggstate->sortedBatch;
+	Agg		   *aggnode = aggstate->phase->aggnode;
+	TupleTableSlot *firstSlot = aggstate->ss.ss_ScanTupleSlot;
+	bool	   *groupStart = sortedBatch->groupStart;
+	uint32		rowCount = batch->dimension;
+	uint32		row;
+	int			i;
+
+	memset(groupStart, false, rowCount * sizeof(bool));
+	groupStart[0] = !groupContinues;
+
+	if (groupContinues)
+		slot_getallattrs(firstSlot);
+
+	for (i = 0; i < aggnode->numCols; i++)
+	{
+		int			varNumber = aggnode->grpColIdx[i] - 1;
+		VectorColumn *column = (VectorColumn *) batch->tts.tts_values[varNumber];
+		FmgrInfo   *eqfunction = &sortedBatch->eqfunctions[i];
+		Oid			collation = aggnode->grpCollations[i];
+		bool	   *isnull = column->isnull;
+
+		if (groupContinues && !groupStart[0])
+		{
+			if (isnull[0] || firstSlot->tts_isnull[varNumber])
+				groupStart[0] = isnull[0] != firstSlot->tts_isnull[varNumber];
+			else
+				groupStart[0] =
+					!DatumGetBool(FunctionCall2Coll(eqfunction, collation,
+													firstSlot->tts_values[varNumber],
+													vector_column_value(column, 0)));
+		}
+
+		/* branch-free loops over the values, so that they vectorize */
+		if (sortedBatch->binaryEqual[i] && column->columnTypeLen == sizeof(int16))
+		{
+			int16	   *values = (int16 *) column->value;
+
+			for (row = 1; row < rowCount; row++)
+				groupStart[row] |= (isnull[row] != isnull[row - 1]) |
+					(!isnull[row] & (values[row] != values[row - 1]));
+		}
+		else if (sortedBatch->binaryEqual[i] && column->columnTypeLen == sizeof(int32))
+		{
+			int32	   *values = (int32 *) column->value;
+
+			for (row = 1; row < rowCount; row++)
+				groupStart[row] |= (isnull[row] != isnull[row - 1]) |
+					(!isnull[row] & (values[row] != values[row - 1]));
+		}
+		else if (sortedBatch->binaryEqual[i] && column->columnTypeLen == sizeof(int64))
+		{
+			int64	   *values = (int64 *) column->value;
+
+			for (row = 1; row < rowCount; row++)
+				groupStart[row] |= (isnull[row] != isnull[row - 1]) |
+					(!isnull[row] & (values[row] != values[row - 1]));
+		}
+		else
+		{
+			for (row = 1; row < rowCount; row++)
+			{
+				/* rows that start a group already need no comparison */
+				if (groupStart[row])
+					continue;
+
+				if (isnull[row] || isnull[row - 1])
+					groupStart[row] = isnull[row] != isnull[row - 1];
+				else
+					groupStart[row] =
+						!DatumGetBool(FunctionCall2Coll(eqfunction, collation,
+														vector_column_value(column, row - 1),
+														vector_column_value(column, row)));
+			}
+		}
+	}
+}
+
+/*
+ * Advance the transition states of the current group with the rows from
+ * startRow up to, but not including, endRow of a sorted vector batch. A run
+ * that covers the whole batch is aggregated in place, other runs are copied
+ * into a vector of their own.
+ */
+static void
+advance_sorted_run(VectorAggState *vectoraggstate, VectorTupleTableSlot *batch,
+				   int32 startRow, int32 endRow)
+{
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorSortedBatch *sortedBatch = vectoraggstate->sortedBatch;
+	VectorTupleTableSlot *runSlot = batch;
+	AggStatePerGroup pergroup = aggstate->pergroups[0];
+	int32		runRowCount = endRow - startRow;
+	int			transno;
+
+	if (runRowCount != batch->dimension)
+	{
+		int			attno;
+
+		runSlot = (VectorTupleTableSlot *) sortedBatch->runSlot;
+		ExecClearTuple(&runSlot->tts);
+
+		foreach_int(attno, sortedBatch->columnList)
+		{
+			VectorColumn *source = (VectorColumn *) batch->tts.tts_values[attno];
+			VectorColumn *target = (VectorColumn *) runSlot->tts.tts_values[attno];
+			int16		typeLen = source->columnTypeLen;
+
+			memcpy(target->value, (int8 *) source->value + typeLen * startRow,
+				   typeLen * runRowCount);
+			memcpy(target->isnull, source->isnull + startRow,
+				   runRowCount * sizeof(bool));
+			target->dimension = runRowCount;
+			target->hasRuns = false;
+		}
+
+		runSlot->dimension = runRowCount;
+		ExecStoreVirtualTuple(&runSlot->tts);
+	}
+
+	aggstate->tmpcontext->ecxt_outertuple = &runSlot->tts;
+
+	advance_aggregates(aggstate);
+
+	/* count(*) has no argument to count the rows of */
+	for (transno = 0; transno < aggstate->numtrans; transno++)
+	{
+		AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+
+		if (pertrans->aggref->aggstar)
+			pergroup[transno].transValue =
+				Int64GetDatum(DatumGetInt64(pergroup[transno].transValue) +
+							  runRowCount);
+	}
+
+	ResetExprContext(aggstate->tmpcontext);
+}
+
 /*
  * ExecAgg -
  *
@@ -2301,13 +3062,19 @@ ExecAgg(PlanState *pstate)
 		{
 			case AGG_HASHED:
 				if (!node->table_filled)
-					agg_fill_hash_table(node);
+					agg_fill_hash_table(vectoraggstate);
 				/* FALLTHROUGH */
 			case AGG_MIXED:
-				result = agg_retrieve_hash_table(node);
+				result = agg_retrieve_hash_table(vectoraggstate);
 				break;
-			case AGG_PLAIN:
 			case AGG_SORTED:
+				if (vectoraggstate->sortedBatch != NULL)
+				{
+					result = agg_retrieve_sorted(vectoraggstate);
+					break;
+				}
+				/* FALLTHROUGH */
+			case AGG_PLAIN:
 				result = agg_retrieve_direct(vectoraggstate);
 				break;
 		}
@@ -2432,7 +3199,7 @@ agg_retrieve_direct(VectorAggState *vectoraggstate)
 				ResetTupleHashIterator(aggstate->perhash[0].hashtable,
 									   &aggstate->perhash[0].hashiter);
 				select_current_set(aggstate, 0, true);
-				return agg_retrieve_hash_table(aggstate);
+				return agg_retrieve_hash_table(vectoraggstate);
 			}
 			else
 			{
@@ -2693,39 +3460,150 @@ agg_retrieve_direct(VectorAggState *vectoraggstate)
 	return NULL;
 }
 
+/*
+ * ExecAgg for sorted grouping of vector batches
+ *
+ * Each group is aggregated a run at a time, where a run is the part of the
+ * group within one batch. A group that ends a batch may continue in the next
+ * one, so the first row of the next batch is compared to the first row of
+ * the group.
+ */
+static TupleTableSlot *
+agg_retrieve_sorted(VectorAggState *vectoraggstate)
+{
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorSortedBatch *sortedBatch = vectoraggstate->sortedBatch;
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	TupleTableSlot *firstSlot = aggstate->ss.ss_ScanTupleSlot;
+	TupleTableSlot *result;
+
+	while (!aggstate->agg_done)
+	{
+		bool		groupStarted = false;
+
+		ReScanExprContext(econtext);
+		ReScanExprContext(aggstate->aggcontexts[0]);
+
+		initialize_aggregates(aggstate, aggstate->pergroups, 1);
+
+		for (;;)
+		{
+			VectorTupleTableSlot *batch = (VectorTupleTableSlot *) sortedBatch->batch;
+			int32		runEnd;
+
+			if (batch == NULL || sortedBatch->nextRow >= batch->dimension)
+			{
+				CHECK_FOR_INTERRUPTS();
+
+				batch = fetch_input_batch(vectoraggstate);
+				sortedBatch->batch = (TupleTableSlot *) batch;
+				sortedBatch->nextRow = 0;
+
+				if (batch == NULL)
+				{
+					aggstate->agg_done = true;
+					break;
+				}
+
+				if (batch->dimension == 0)
+					continue;
+
+				mark_group_starts(vectoraggstate, batch, groupStarted);
+			}
+
+			if (groupStarted && sortedBatch->groupStart[sortedBatch->nextRow])
+				break;
+
+			if (!groupStarted)
+			{
+				/* keep the first row of the group for comparisons and projection */
+				ExecClearTuple(sortedBatch->rowSlot);
+				memset(sortedBatch->rowSlot->tts_isnull, true,
+					   sortedBatch->rowSlot->tts_tupleDescriptor->natts * sizeof(bool));
+				ExtractTupleFromVectorSlot(sortedBatch->rowSlot, batch,
+										   sortedBatch->nextRow,
+										   sortedBatch->columnList);
+				ExecCopySlot(firstSlot, sortedBatch->rowSlot);
+				groupStarted = true;
+			}
+
+			runEnd = sortedBatch->nextRow + 1;
+			while (runEnd < batch->dimension && !sortedBatch->groupStart[runEnd])
+				runEnd++;
+
+			advance_sorted_run(vectoraggstate, batch, sortedBatch->nextRow, runEnd);
+			sortedBatch->nextRow = runEnd;
+		}
+
+		/* grouping produces no rows without input */
+		if (!groupStarted)
+			break;
+
+		econtext->ecxt_outertuple = firstSlot;
+		aggstate->projected_set = 0;
+
+		prepare_projection_slot(aggstate, firstSlot, 0);
+
+		select_current_set(aggstate, 0, false);
+
+		finalize_aggregates(aggstate, aggstate->peragg, aggstate->pergroups[0]);
+
+		/*
+		 * If there's no row to project right now, we must continue rather
+		 * than returning a null since there might be more groups.
+		 */
+		result = project_aggregates(aggstate);
+		if (result)
+			return result;
+	}
+
+	/* No more groups */
+	return NULL;
+}
+
 /*
  * ExecAgg for hashed case: read input and build hash table
+ *
+ * The input arrives in vector batches, which are hashed and aggregated a
+ * batch at a time.
  */
 static void
-agg_fill_hash_table(AggState *aggstate)
+agg_fill_hash_table(VectorAggState *vectoraggstate)
 {
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorHashBatch *hashBatch = vectoraggstate->hashBatch;
 	TupleTableSlot *outerslot;
-	ExprContext *tmpcontext = aggstate->tmpcontext;
 
 	/*
-	 * Process each outer-plan tuple, and then fetch the next one, until we
+	 * Process each outer-plan batch, and then fetch the next one, until we
 	 * exhaust the outer plan.
 	 */
 	for (;;)
 	{
+		VectorTupleTableSlot *batch;
+		AggStatePerHash perhash;
+
+		CHECK_FOR_INTERRUPTS();
+
 		outerslot = fetch_input_tuple(aggstate);
 		if (TupIsNull(outerslot))
 			break;
 
-		/* set up for lookup_hash_entries and advance_aggregates */
-		tmpcontext->ecxt_outertuple = outerslot;
+		batch = (VectorTupleTableSlot *) outerslot;
+		if (batch->dimension == 0)
+			continue;
+
+		select_current_set(aggstate, 0, true);
+		perhash = &aggstate->perhash[aggstate->current_set];
+
+		hash_vector_keys(perhash, batch, hashBatch->hashes);
 
 		/* Find or build hashtable entries */
-		lookup_hash_entries(aggstate);
+		lookup_hash_entries_vector(vectoraggstate, batch, NULL, 0,
+								   perhash->aggnode->numGroups);
 
 		/* Advance the aggregates (or combine functions) */
-		advance_aggregates(aggstate);
-
-		/*
-		 * Reset per-input-tuple context after each tuple, but note that the
-		 * hash lookups do this too
-		 */
-		ResetExprContext(aggstate->tmpcontext);
+		advance_hash_aggregates_vector(vectoraggstate, batch);
 	}
 
 	/* finalize spills, if any */
@@ -2751,17 +3629,14 @@ agg_fill_hash_table(AggState *aggstate)
  * otherwise return true.
  */
 static bool
-agg_refill_hash_table(AggState *aggstate)
+agg_refill_hash_table(VectorAggState *vectoraggstate)
 {
+	AggState   *aggstate = vectoraggstate->aggstate;
+	VectorHashBatch *hashBatch = vectoraggstate->hashBatch;
+	VectorTupleTableSlot *refillSlot = (VectorTupleTableSlot *) hashBatch->refillSlot;
 	HashAggBatch *batch;
-	AggStatePerHash perhash;
 	HashAggSpill spill;
-#if PG_VERSION_NUM < PG_VERSION_15
-	HashTapeInfo *tapeinfo = aggstate->hash_tapeinfo;
-#else
-	LogicalTapeSet *tapeset = aggstate->hash_tapeset;
-#endif
-	bool		spill_initialized = false;
+	bool		input_done = false;
 
 	if (aggstate->hash_batches == NIL)
 		return false;
@@ -2805,85 +3680,60 @@ agg_refill_hash_table(AggState *aggstate)
 
 	select_current_set(aggstate, batch->setno, true);
 
-	perhash = &aggstate->perhash[aggstate->current_set];
-
 	/*
-	 * Spilled tuples are always read back as MinimalTuples, which may be
-	 * different from the outer plan, so recompile the aggregate expressions.
-	 *
-	 * We still need the NULL check, because we are only processing one
-	 * grouping set at a time and the rest will be NULL.
+	 * Spilled tuples are read back into vectors, like the ones of the outer
+	 * plan, so the aggregate expressions only need the NULL check, because we
+	 * are only processing one grouping set at a time and the rest will be
+	 * NULL.
 	 */
-	hashagg_recompile_expressions(aggstate, true, true);
+	hashagg_recompile_expressions(aggstate, false, true);
 
-	for (;;)
+	/* the spill is only initialized once a tuple needs it */
+	memset(&spill, 0, sizeof(spill));
+
+	while (!input_done)
 	{
 		TupleTableSlot *spillslot = aggstate->hash_spill_rslot;
-		TupleTableSlot *hashslot = perhash->hashslot;
-		TupleHashEntry entry;
-		MinimalTuple tuple;
-		uint32		hash;
-		bool		isnew = false;
-		bool	   *p_isnew = aggstate->hash_spill_mode ? NULL : &isnew;
+		int32		rowCount = 0;
 
 		CHECK_FOR_INTERRUPTS();
 
-		tuple = hashagg_batch_read(batch, &hash);
-		if (tuple == NULL)
-			break;
-
-		ExecStoreMinimalTuple(tuple, spillslot, true);
-		aggstate->tmpcontext->ecxt_outertuple = spillslot;
+		ExecClearTuple(&refillSlot->tts);
+		CleanupVectorSlot(refillSlot);
+		MemoryContextReset(hashBatch->refillContext);
 
-		prepare_hash_slot(perhash,
-						  aggstate->tmpcontext->ecxt_outertuple,
-						  hashslot);
-#if PG_VERSION_NUM < PG_VERSION_15
-		entry = LookupTupleHashEntryHash(
-										 perhash->hashtable, hashslot, p_isnew, hash);
-#else
-		entry = LookupTupleHashEntryHash(perhash->hashtable, hashslot,
-										 p_isnew, hash);
-#endif
-
-		if (entry != NULL)
+		while (rowCount < COLUMNAR_VECTOR_COLUMN_SIZE)
 		{
-			if (isnew)
-				initialize_hash_entry(aggstate, perhash->hashtable, entry);
-			aggstate->hash_pergroup[batch->setno] = entry->additional;
-			advance_aggregates(aggstate);
-		}
-		else
-		{
-			if (!spill_initialized)
+			MinimalTuple tuple = hashagg_batch_read(batch,
+													&hashBatch->hashes[rowCount]);
+
+			if (tuple == NULL)
 			{
-				/*
-				 * Avoid initializing the spill until we actually need it so
-				 * that we don't assign tapes that will never be used.
-				 */
-				spill_initialized = true;
-#if PG_VERSION_NUM < PG_VERSION_15
-				hashagg_spill_init(&spill, tapeinfo, batch->used_bits,
-#else
-				hashagg_spill_init(&spill, tapeset, batch->used_bits,
-#endif
-								   batch->input_card, aggstate->hashentrysize);
+				input_done = true;
+				break;
 			}
-			/* no memory for a new group, spill */
-			hashagg_spill_tuple(aggstate, &spill, spillslot, hash);
 
-			aggstate->hash_pergroup[batch->setno] = NULL;
+			ExecStoreMinimalTuple(tuple, spillslot, true);
+			store_vector_row(refillSlot, rowCount, spillslot,
+							 hashBatch->columnList, hashBatch->refillContext);
+
+			rowCount++;
 		}
 
-		/*
-		 * Reset per-input-tuple context after each tuple, but note that the
-		 * hash lookups do this too
-		 */
-		ResetExprContext(aggstate->tmpcontext);
+		if (rowCount == 0)
+			break;
+
+		refillSlot->dimension = rowCount;
+		ExecStoreVirtualTuple(&refillSlot->tts);
+
+		lookup_hash_entries_vector(vectoraggstate, refillSlot, &spill,
+								   batch->used_bits, batch->input_card);
+
+		advance_hash_aggregates_vector(vectoraggstate, refillSlot);
 	}
 
 #if PG_VERSION_NUM < PG_VERSION_15
-	hashagg_tapeinfo_release(tapeinfo, batch->input_tapenum);
+	hashagg_tapeinfo_release(aggstate->hash_tapeinfo, batch->input_tapenum);
 #else
 	LogicalTapeClose(batch->input_tape);
 #endif
@@ -2892,7 +3742,7 @@ agg_refill_hash_table(AggState *aggstate)
 	aggstate->current_phase = 0;
 	aggstate->phase = &aggstate->phases[aggstate->current_phase];
 
-	if (spill_initialized)
+	if (spill.partitions != NULL)
 	{
 		hashagg_spill_finish(aggstate, &spill, batch->setno);
 		hash_agg_update_metrics(aggstate, true, spill.npartitions);
@@ -2920,8 +3770,9 @@ agg_refill_hash_table(AggState *aggstate)
  * spilled tuples are exhausted.
  */
 static TupleTableSlot *
-agg_retrieve_hash_table(AggState *aggstate)
+agg_retrieve_hash_table(VectorAggState *vectoraggstate)
 {
+	AggState   *aggstate = vectoraggstate->aggstate;
 	TupleTableSlot *result = NULL;
 
 	while (result == NULL)
@@ -2929,7 +3780,7 @@ agg_retrieve_hash_table(AggState *aggstate)
 		result = agg_retrieve_hash_table_in_memory(aggstate);
 		if (result == NULL)
 		{
-			if (!agg_refill_hash_table(aggstate))
+			if (!agg_refill_hash_table(vectoraggstate))
 			{
 				aggstate->agg_done = true;
 				break;
@@ -3652,6 +4503,16 @@ VExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->ss.ps.outerops =
 		ExecGetResultSlotOps(outerPlanState(&aggstate->ss),
 							 &aggstate->ss.ps.outeropsfixed);
+
+	/*
+	 * Rows of an input that isn't a columnar scan, like a Sort, are packed
+	 * into vectors before the aggregates see them.
+	 */
+	if (!IsA(outerPlan, CustomScan))
+	{
+		aggstate->ss.ps.outerops = &TTSOpsVirtual;
+		aggstate->ss.ps.outeropsfixed = true;
+	}
 	aggstate->ss.ps.outeropsset = true;
 
 	ExecCreateScanSlotFromOuterPlan(estate, &aggstate->ss,
@@ -5300,6 +6161,12 @@ BeginVectorAgg(CustomScanState *css, EState *estate, int eflags)
 
 	vas->aggstate = VExecInitAgg(aggNode, estate, eflags);
 
+	if (vas->aggstate->aggstrategy == AGG_HASHED)
+		vas->hashBatch = create_vector_hash_batch(vas->aggstate);
+	else if (vas->aggstate->aggstrategy == AGG_SORTED &&
+			 vas->aggstate->maxsets <= 1)
+		vas->sortedBatch = create_vector_sorted_batch(vas->aggstate);
+
 	// HYDRA: add leftree to custom agg
 	outerPlanState(vas) = outerPlanState(vas->aggstate);
 
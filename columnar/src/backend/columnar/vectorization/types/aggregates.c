@@ -2,9 +2,12 @@
 #include "postgres.h"
 
 #include "fmgr.h"
+#include "catalog/pg_type.h"
 #include "nodes/execnodes.h"
+#include "port/pg_bswap.h"
 #include "utils/date.h"
 #include "utils/array.h"
+#include "utils/float.h"
 #include "utils/numeric.h"
 #include "utils/fmgrprotos.h"
 
@@ -30,6 +33,22 @@ vanycount(PG_FUNCTION_ARGS)
 	VectorColumn *arg1 = (VectorColumn *) PG_GETARG_POINTER(1);
 	int i;
 
+	if (arg1->hasRuns)
+	{
+		int rowIndex = 0;
+
+		/* every row of a run shares the nullness of its first row */
+		for (i = 0; i < arg1->runCount; i++)
+		{
+			if (!arg1->isnull[rowIndex])
+				result += arg1->runLength[i];
+
+			rowIndex += arg1->runLength[i];
+		}
+
+		PG_RETURN_INT64(result);
+	}
+
 	for (i = 0; i <  arg1->dimension; i++) 
 	{
 		if (arg1->isnull[i])
@@ -53,6 +72,21 @@ vint2sum(PG_FUNCTION_ARGS)
 
 	int16 *vectorValue = (int16*) arg1->value;
 
+	if (arg1->hasRuns)
+	{
+		int rowIndex = 0;
+
+		for (i = 0; i < arg1->runCount; i++)
+		{
+			if (!arg1->isnull[rowIndex])
+				sumX += (int64) vectorValue[rowIndex] * arg1->runLength[i];
+
+			rowIndex += arg1->runLength[i];
+		}
+
+		PG_RETURN_INT64(sumX);
+	}
+
 	for (i = 0; i < arg1->dimension; i++)
 	{
 		if (!arg1->isnull[i])
@@ -85,6 +119,24 @@ vint2acc(PG_FUNCTION_ARGS)
 
 	int16 *vectorValue = (int16*) arg1->value;
 
+	if (arg1->hasRuns)
+	{
+		int rowIndex = 0;
+
+		for (i = 0; i < arg1->runCount; i++)
+		{
+			if (!arg1->isnull[rowIndex])
+			{
+				transdata->N += arg1->runLength[i];
+				transdata->sumX += (int64) vectorValue[rowIndex] * arg1->runLength[i];
+			}
+
+			rowIndex += arg1->runLength[i];
+		}
+
+		PG_RETURN_ARRAYTYPE_P(transarray);
+	}
+
 	for (i = 0; i < arg1->dimension; i++)
 	{
 		if (!arg1->isnull[i])
@@ -155,6 +207,21 @@ vint4sum(PG_FUNCTION_ARGS)
 
 	int32 *vectorValue = (int32*) arg1->value;
 
+	if (arg1->hasRuns)
+	{
+		int rowIndex = 0;
+
+		for (i = 0; i < arg1->runCount; i++)
+		{
+			if (!arg1->isnull[rowIndex])
+				sumX += (int64) vectorValue[rowIndex] * arg1->runLength[i];
+
+			rowIndex += arg1->runLength[i];
+		}
+
+		PG_RETURN_INT64(sumX);
+	}
+
 	for (i = 0; i < arg1->dimension; i++)
 	{
 		if (!arg1->isnull[i])
@@ -187,6 +254,24 @@ vint4acc(PG_FUNCTION_ARGS)
 
 	int32 *vectorValue = (int32*) arg1->value;
 
+	if (arg1->hasRuns)
+	{
+		int rowIndex = 0;
+
+		for (i = 0; i < arg1->runCount; i++)
+		{
+			if (!arg1->isnull[rowIndex])
+			{
+				transdata->N += arg1->runLength[i];
+				transdata->sumX += (int64) vectorValue[rowIndex] * arg1->runLength[i];
+			}
+
+			rowIndex += arg1->runLength[i];
+		}
+
+		PG_RETURN_ARRAYTYPE_P(transarray);
+	}
+
 	for (i = 0; i < arg1->dimension; i++)
 	{
 		if (!arg1->isnull[i])
@@ -311,12 +396,30 @@ vint8acc(PG_FUNCTION_ARGS)
 
 	int64 *vectorValue = (int64*) arg1->value;
 
-	for (i = 0; i < arg1->dimension; i++)
+	if (arg1->hasRuns)
 	{
-		if (!arg1->isnull[i])
+		int rowIndex = 0;
+
+		for (i = 0; i < arg1->runCount; i++)
+		{
+			if (!arg1->isnull[rowIndex])
+			{
+				state->N += arg1->runLength[i];
+				state->sumX += (int128) vectorValue[rowIndex] * arg1->runLength[i];
+			}
+
+			rowIndex += arg1->runLength[i];
+		}
+	}
+	else
+	{
+		for (i = 0; i < arg1->dimension; i++)
 		{
-			state->N++;
-			state->sumX += (int128) vectorValue[i];
+			if (!arg1->isnull[i])
+			{
+				state->N++;
+				state->sumX += (int128) vectorValue[i];
+			}
 		}
 	}
 
@@ -454,4 +557,952 @@ Datum vdatesmaller(PG_FUNCTION_ARGS)
 	minValue = Min(minValue, result);
 
 	PG_RETURN_INT32(minValue);
-}
\ No newline at end of file
+}
+/* float4 / float8 */
+
+/*
+ * Number of independent accumulators the float loops below are split in.
+ * Floating point additions are not associative, so the compiler only maps a
+ * reduction to SIMD instructions when it is spelled out over separate lanes.
+ */
+#define VECTOR_FLOAT_LANES 8
+
+/*
+ * Count, sum and sum of squared deviations from the mean of the non-null
+ * values of a float vector.
+ */
+typedef struct FloatVectorSummary
+{
+	float8 N;
+	float8 Sx;
+	float8 Sxx;
+} FloatVectorSummary;
+
+/*
+ * Build the summary of a float vector. The sum of squares is computed in a
+ * second pass around the vector mean, so it is only as expensive as the sum.
+ */
+#define _BUILD_FLOAT_VECTOR_SUMMARY(FNAME, TYPE)							\
+static void																	\
+FNAME(VectorColumn *column, FloatVectorSummary *summary, bool calcSumX2)	\
+{																			\
+	const TYPE *values = (const TYPE *) column->value;						\
+	const bool *isnull = column->isnull;									\
+	float8 laneN[VECTOR_FLOAT_LANES] = {0};									\
+	float8 laneSx[VECTOR_FLOAT_LANES] = {0};								\
+	float8 laneSxx[VECTOR_FLOAT_LANES] = {0};								\
+	int dimension = column->dimension;										\
+	int i, j;																\
+																			\
+	for (i = 0; i + VECTOR_FLOAT_LANES <= dimension; i += VECTOR_FLOAT_LANES)	\
+	{																		\
+		for (j = 0; j < VECTOR_FLOAT_LANES; j++)							\
+		{																	\
+			laneN[j] += isnull[i + j] ? 0.0 : 1.0;							\
+			laneSx[j] += isnull[i + j] ? 0.0 : (float8) values[i + j];		\
+		}																	\
+	}																		\
+																			\
+	for (; i < dimension; i++)												\
+	{																		\
+		laneN[0] += isnull[i] ? 0.0 : 1.0;									\
+		laneSx[0] += isnull[i] ? 0.0 : (float8) values[i];					\
+	}																		\
+																			\
+	summary->N = 0.0;														\
+	summary->Sx = 0.0;														\
+	summary->Sxx = 0.0;														\
+																			\
+	for (j = 0; j < VECTOR_FLOAT_LANES; j++)								\
+	{																		\
+		summary->N += laneN[j];												\
+		summary->Sx += laneSx[j];											\
+	}																		\
+																			\
+	if (!calcSumX2 || summary->N == 0.0 || !isfinite(summary->Sx))			\
+		return;																\
+																			\
+	float8 mean = summary->Sx / summary->N;									\
+																			\
+	for (i = 0; i + VECTOR_FLOAT_LANES <= dimension; i += VECTOR_FLOAT_LANES)	\
+	{																		\
+		for (j = 0; j < VECTOR_FLOAT_LANES; j++)							\
+		{																	\
+			float8 deviation =												\
+				isnull[i + j] ? 0.0 : (float8) values[i + j] - mean;		\
+			laneSxx[j] += deviation * deviation;							\
+		}																	\
+	}																		\
+																			\
+	for (; i < dimension; i++)												\
+	{																		\
+		float8 deviation = isnull[i] ? 0.0 : (float8) values[i] - mean;		\
+		laneSxx[0] += deviation * deviation;								\
+	}																		\
+																			\
+	for (j = 0; j < VECTOR_FLOAT_LANES; j++)								\
+		summary->Sxx += laneSxx[j];											\
+}
+
+/*
+ * Find the smallest and largest non-null values of a float vector, where NaN
+ * sorts above every other value like in float8_cmp_internal(). Returns false
+ * if the vector has no non-null values.
+ */
+#define _BUILD_FLOAT_VECTOR_EXTREMES(FNAME, TYPE)							\
+static bool																	\
+FNAME(VectorColumn *column, TYPE *minValue, TYPE *maxValue)					\
+{																			\
+	const TYPE *values = (const TYPE *) column->value;						\
+	const bool *isnull = column->isnull;									\
+	TYPE laneMin[VECTOR_FLOAT_LANES];										\
+	TYPE laneMax[VECTOR_FLOAT_LANES];										\
+	int laneCount[VECTOR_FLOAT_LANES] = {0};								\
+	int laneNaN[VECTOR_FLOAT_LANES] = {0};									\
+	int dimension = column->dimension;										\
+	int count = 0;															\
+	int nanCount = 0;														\
+	int i, j;																\
+																			\
+	for (j = 0; j < VECTOR_FLOAT_LANES; j++)								\
+	{																		\
+		laneMin[j] = get_float4_infinity();									\
+		laneMax[j] = -get_float4_infinity();								\
+	}																		\
+																			\
+	/* NaN never compares smaller or larger, so it is only counted */		\
+	for (i = 0; i + VECTOR_FLOAT_LANES <= dimension; i += VECTOR_FLOAT_LANES)	\
+	{																		\
+		for (j = 0; j < VECTOR_FLOAT_LANES; j++)							\
+		{																	\
+			TYPE value = values[i + j];										\
+			bool valid = !isnull[i + j];									\
+																			\
+			laneCount[j] += valid;											\
+			laneNaN[j] += valid & (value != value);							\
+			laneMin[j] = (valid & (value < laneMin[j])) ? value : laneMin[j];	\
+			laneMax[j] = (valid & (value > laneMax[j])) ? value : laneMax[j];	\
+		}																	\
+	}																		\
+																			\
+	for (; i < dimension; i++)												\
+	{																		\
+		TYPE value = values[i];												\
+		bool valid = !isnull[i];											\
+																			\
+		laneCount[0] += valid;												\
+		laneNaN[0] += valid & (value != value);								\
+		laneMin[0] = (valid & (value < laneMin[0])) ? value : laneMin[0];	\
+		laneMax[0] = (valid & (value > laneMax[0])) ? value : laneMax[0];	\
+	}																		\
+																			\
+	*minValue = laneMin[0];													\
+	*maxValue = laneMax[0];													\
+																			\
+	for (j = 0; j < VECTOR_FLOAT_LANES; j++)								\
+	{																		\
+		count += laneCount[j];												\
+		nanCount += laneNaN[j];												\
+		*minValue = Min(*minValue, laneMin[j]);								\
+		*maxValue = Max(*maxValue, laneMax[j]);								\
+	}																		\
+																			\
+	if (count == 0)															\
+		return false;														\
+																			\
+	if (nanCount > 0)														\
+		*maxValue = get_float4_nan();										\
+																			\
+	if (nanCount == count)													\
+		*minValue = get_float4_nan();										\
+																			\
+	return true;															\
+}
+
+_BUILD_FLOAT_VECTOR_SUMMARY(float4_vector_summary, float4)
+_BUILD_FLOAT_VECTOR_SUMMARY(float8_vector_summary, float8)
+_BUILD_FLOAT_VECTOR_EXTREMES(float4_vector_extremes, float4)
+_BUILD_FLOAT_VECTOR_EXTREMES(float8_vector_extremes, float8)
+
+/*
+ * Sum the non-null values of a float vector one value at a time, with the
+ * overflow check of float8pl(). Used when the summary of a vector is not
+ * finite, to tell infinite inputs apart from an overflow.
+ */
+static float8
+float_vector_sum_checked(VectorColumn *column, bool isFloat4)
+{
+	float8 sumX = 0.0;
+	int i;
+
+	for (i = 0; i < column->dimension; i++)
+	{
+		if (column->isnull[i])
+			continue;
+
+		sumX = float8_pl(sumX, isFloat4 ? (float8) ((float4 *) column->value)[i] :
+									      ((float8 *) column->value)[i]);
+	}
+
+	return sumX;
+}
+
+/*
+ * Check that the transition state of float8_accum() is a 3 element float8
+ * array and return its values.
+ */
+static float8 *
+check_float8_accum_array(ArrayType *transarray, const char *caller)
+{
+	if (ARR_NDIM(transarray) != 1 ||
+		ARR_DIMS(transarray)[0] != 3 ||
+		ARR_HASNULL(transarray) ||
+		ARR_ELEMTYPE(transarray) != FLOAT8OID)
+		elog(ERROR, "%s: expected 3-element float8 array", caller);
+
+	return (float8 *) ARR_DATA_PTR(transarray);
+}
+
+/*
+ * Accumulate one value into a float8_accum() transition state, exactly like
+ * float8_accum() does (Youngs-Cramer).
+ */
+static void
+float8_accum_value(float8 *transvalues, float8 newval)
+{
+	float8 N = transvalues[0];
+	float8 Sx = transvalues[1];
+	float8 Sxx = transvalues[2];
+	float8 tmp;
+
+	N += 1.0;
+	Sx += newval;
+
+	if (transvalues[0] > 0.0)
+	{
+		tmp = newval * N - Sx;
+		Sxx += tmp * tmp / (N * transvalues[0]);
+
+		/* only finite inputs leading to infinite results are an overflow */
+		if (isinf(Sx) || isinf(Sxx))
+		{
+			if (!isinf(transvalues[1]) && !isinf(newval))
+				float_overflow_error();
+
+			Sxx = get_float8_nan();
+		}
+	}
+	else
+	{
+		/* a first input that is Inf or NaN has no variance either */
+		if (isnan(newval) || isinf(newval))
+			Sxx = get_float8_nan();
+	}
+
+	transvalues[0] = N;
+	transvalues[1] = Sx;
+	transvalues[2] = Sxx;
+}
+
+/*
+ * Merge the summary of a float vector into a float8_accum() transition state,
+ * the way float8_combine() merges two transition states. Vectors with Inf or
+ * NaN values, or whose sums overflow, are accumulated a value at a time
+ * instead, so that they end up in the same state as with float8_accum().
+ */
+static void
+float8_accum_vector(float8 *transvalues, VectorColumn *column, bool isFloat4)
+{
+	FloatVectorSummary summary;
+	float8 N1 = transvalues[0];
+	float8 Sx1 = transvalues[1];
+	float8 Sxx1 = transvalues[2];
+	float8 tmp;
+	int i;
+
+	if (isFloat4)
+		float4_vector_summary(column, &summary, true);
+	else
+		float8_vector_summary(column, &summary, true);
+
+	if (summary.N == 0.0)
+		return;
+
+	if (!isfinite(summary.Sx) || !isfinite(summary.Sxx))
+	{
+		for (i = 0; i < column->dimension; i++)
+		{
+			if (column->isnull[i])
+				continue;
+
+			float8_accum_value(transvalues,
+							   isFloat4 ? (float8) ((float4 *) column->value)[i] :
+										  ((float8 *) column->value)[i]);
+		}
+
+		return;
+	}
+
+	if (N1 == 0.0)
+	{
+		transvalues[0] = summary.N;
+		transvalues[1] = summary.Sx;
+		transvalues[2] = summary.Sxx;
+		return;
+	}
+
+	tmp = Sx1 / N1 - summary.Sx / summary.N;
+
+	transvalues[0] = N1 + summary.N;
+	transvalues[1] = float8_pl(Sx1, summary.Sx);
+	transvalues[2] = Sxx1 + summary.Sxx + N1 * summary.N * tmp * tmp / transvalues[0];
+
+	if (unlikely(isinf(transvalues[2])) && !isinf(Sxx1))
+		float_overflow_error();
+}
+
+PG_FUNCTION_INFO_V1(vfloat4pl);
+Datum
+vfloat4pl(PG_FUNCTION_ARGS)
+{
+	VectorColumn *arg1 = (VectorColumn *) PG_GETARG_POINTER(1);
+	FloatVectorSummary summary;
+	float4 sumX;
+
+	float4_vector_summary(arg1, &summary, false);
+
+	/* the state stays NULL until the first non-null value, like float4pl */
+	if (summary.N == 0.0)
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_FLOAT4(PG_GETARG_FLOAT4(0));
+	}
+
+	if (!isfinite(summary.Sx))
+		summary.Sx = float_vector_sum_checked(arg1, true);
+
+	/*
+	 * The vector is summed in float8, and added to the state in float4. The
+	 * row aggregate rounds to float4 after every value instead, so the sums
+	 * can differ, with ours being the more accurate one.
+	 */
+	sumX = (float4) summary.Sx;
+	if (unlikely(isinf(sumX)) && !isinf(summary.Sx))
+		float_overflow_error();
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_FLOAT4(sumX);
+
+	PG_RETURN_FLOAT4(float4_pl(PG_GETARG_FLOAT4(0), sumX));
+}
+
+PG_FUNCTION_INFO_V1(vfloat8pl);
+Datum
+vfloat8pl(PG_FUNCTION_ARGS)
+{
+	VectorColumn *arg1 = (VectorColumn *) PG_GETARG_POINTER(1);
+	FloatVectorSummary summary;
+
+	float8_vector_summary(arg1, &summary, false);
+
+	/* the state stays NULL until the first non-null value, like float8pl */
+	if (summary.N == 0.0)
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_FLOAT8(PG_GETARG_FLOAT8(0));
+	}
+
+	if (!isfinite(summary.Sx))
+		summary.Sx = float_vector_sum_checked(arg1, false);
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_FLOAT8(summary.Sx);
+
+	PG_RETURN_FLOAT8(float8_pl(PG_GETARG_FLOAT8(0), summary.Sx));
+}
+
+PG_FUNCTION_INFO_V1(vfloat4accum);
+Datum
+vfloat4accum(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray;
+	VectorColumn *arg1 = (VectorColumn *) PG_GETARG_POINTER(1);
+
+	/*
+	 * If we're invoked as an aggregate, we can cheat and modify our first
+	 * parameter in-place to reduce palloc overhead. Otherwise we need to make
+	 * a copy of it before scribbling on it.
+	 */
+	if (AggCheckCallContext(fcinfo, NULL))
+		transarray = PG_GETARG_ARRAYTYPE_P(0);
+	else
+		transarray = PG_GETARG_ARRAYTYPE_P_COPY(0);
+
+	float8_accum_vector(check_float8_accum_array(transarray, "vfloat4accum"),
+						arg1, true);
+
+	PG_RETURN_ARRAYTYPE_P(transarray);
+}
+
+PG_FUNCTION_INFO_V1(vfloat8accum);
+Datum
+vfloat8accum(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray;
+	VectorColumn *arg1 = (VectorColumn *) PG_GETARG_POINTER(1);
+
+	/*
+	 * If we're invoked as an aggregate, we can cheat and modify our first
+	 * parameter in-place to reduce palloc overhead. Otherwise we need to make
+	 * a copy of it before scribbling on it.
+	 */
+	if (AggCheckCallContext(fcinfo, NULL))
+		transarray = PG_GETARG_ARRAYTYPE_P(0);
+	else
+		transarray = PG_GETARG_ARRAYTYPE_P_COPY(0);
+
+	float8_accum_vector(check_float8_accum_array(transarray, "vfloat8accum"),
+						arg1, false);
+
+	PG_RETURN_ARRAYTYPE_P(transarray);
+}
+
+PG_FUNCTION_INFO_V1(vfloat4larger);
+Datum vfloat4larger(PG_FUNCTION_ARGS)
+{
+	VectorColumn *arg2 = (VectorColumn*) PG_GETARG_POINTER(1);
+	float4 minValue;
+	float4 maxValue;
+
+	if (!float4_vector_extremes(arg2, &minValue, &maxValue))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_FLOAT4(PG_GETARG_FLOAT4(0));
+	}
+
+	if (!PG_ARGISNULL(0) && float4_gt(PG_GETARG_FLOAT4(0), maxValue))
+		maxValue = PG_GETARG_FLOAT4(0);
+
+	PG_RETURN_FLOAT4(maxValue);
+}
+
+PG_FUNCTION_INFO_V1(vfloat4smaller);
+Datum vfloat4smaller(PG_FUNCTION_ARGS)
+{
+	VectorColumn *arg2 = (VectorColumn*) PG_GETARG_POINTER(1);
+	float4 minValue;
+	float4 maxValue;
+
+	if (!float4_vector_extremes(arg2, &minValue, &maxValue))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_FLOAT4(PG_GETARG_FLOAT4(0));
+	}
+
+	if (!PG_ARGISNULL(0) && float4_lt(PG_GETARG_FLOAT4(0), minValue))
+		minValue = PG_GETARG_FLOAT4(0);
+
+	PG_RETURN_FLOAT4(minValue);
+}
+
+PG_FUNCTION_INFO_V1(vfloat8larger);
+Datum vfloat8larger(PG_FUNCTION_ARGS)
+{
+	VectorColumn *arg2 = (VectorColumn*) PG_GETARG_POINTER(1);
+	float8 minValue;
+	float8 maxValue;
+
+	if (!float8_vector_extremes(arg2, &minValue, &maxValue))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_FLOAT8(PG_GETARG_FLOAT8(0));
+	}
+
+	if (!PG_ARGISNULL(0) && float8_gt(PG_GETARG_FLOAT8(0), maxValue))
+		maxValue = PG_GETARG_FLOAT8(0);
+
+	PG_RETURN_FLOAT8(maxValue);
+}
+
+PG_FUNCTION_INFO_V1(vfloat8smaller);
+Datum vfloat8smaller(PG_FUNCTION_ARGS)
+{
+	VectorColumn *arg2 = (VectorColumn*) PG_GETARG_POINTER(1);
+	float8 minValue;
+	float8 maxValue;
+
+	if (!float8_vector_extremes(arg2, &minValue, &maxValue))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+
+		PG_RETURN_FLOAT8(PG_GETARG_FLOAT8(0));
+	}
+
+	if (!PG_ARGISNULL(0) && float8_lt(PG_GETARG_FLOAT8(0), minValue))
+		minValue = PG_GETARG_FLOAT8(0);
+
+	PG_RETURN_FLOAT8(minValue);
+}
+
+/* numeric */
+
+/*
+ * Transition state of the vectorized numeric sum and avg. Values that fit a
+ * 64 bit integer at the largest display scale seen so far are added up in
+ * sumX, counted in units of 10^-scale. NaN, infinities and values that are
+ * too large or have too many fractional digits are added to sumNumeric with
+ * the regular numeric functions instead.
+ */
+typedef struct NumericVectorAggState
+{
+	int64 N;				/* count of finite non-null values */
+	int scale;				/* display scale of sumX */
+	int128 sumX;			/* sum of the values that fit an int64 */
+	Numeric sumNumeric;		/* sum of the other values, or NULL */
+} NumericVectorAggState;
+
+/*
+ * Largest display scale summed up as integers. A value with more fractional
+ * digits is summed as numeric, rather than scaling the other values up until
+ * they no longer fit an int64.
+ */
+#define VECTOR_NUMERIC_MAX_SCALE 8
+
+/*
+ * sumX is moved over to sumNumeric once it gets this large, so that adding
+ * the sum of a vector (below 2^91) to it can't overflow.
+ */
+#define VECTOR_NUMERIC_SUM_LIMIT ((int128) 1 << 120)
+
+static inline int128
+int128_abs(int128 value)
+{
+	return value < 0 ? -value : value;
+}
+
+/*
+ * Add value to the numeric part of the sum, in the aggregate context.
+ */
+static void
+numeric_vector_add_numeric(NumericVectorAggState *state, Numeric value,
+						   MemoryContext aggContext)
+{
+	MemoryContext oldContext = MemoryContextSwitchTo(aggContext);
+	Numeric sumNumeric = state->sumNumeric;
+
+	if (sumNumeric == NULL)
+		state->sumNumeric = DatumGetNumericCopy(NumericGetDatum(value));
+	else
+	{
+		state->sumNumeric = numeric_add_opt_error(sumNumeric, value, NULL);
+		pfree(sumNumeric);
+	}
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * Move the integer part of the sum over to its numeric part.
+ */
+static void
+numeric_vector_flush_sum(NumericVectorAggState *state, MemoryContext aggContext)
+{
+	if (state->sumX == 0)
+		return;
+
+	numeric_vector_add_numeric(state,
+							   int128_to_numeric_scaled(state->sumX, state->scale),
+							   aggContext);
+	state->sumX = 0;
+}
+
+/*
+ * Sum of all values of the state, or NULL when there were none.
+ */
+static Numeric
+numeric_vector_sum(NumericVectorAggState *state)
+{
+	Numeric sumX;
+
+	if (state == NULL || (state->N == 0 && state->sumNumeric == NULL))
+		return NULL;
+
+	sumX = int128_to_numeric_scaled(state->sumX, state->scale);
+
+	if (state->sumNumeric != NULL)
+		sumX = numeric_add_opt_error(sumX, state->sumNumeric, NULL);
+
+	return sumX;
+}
+
+/*
+ * Call one of the built-in numeric aggregate support functions, which insist
+ * on running in an aggregate context, on behalf of a vectorized one.
+ */
+static Datum
+numeric_agg_support_call(PGFunction function, FunctionCallInfo fcinfo,
+						 int nargs, NullableDatum *args, bool *isnull)
+{
+	LOCAL_FCINFO(callInfo, 2);
+	Datum result;
+	int i;
+
+	Assert(nargs <= 2);
+
+	InitFunctionCallInfoData(*callInfo, NULL, nargs, InvalidOid,
+							 fcinfo->context, NULL);
+
+	for (i = 0; i < nargs; i++)
+		callInfo->args[i] = args[i];
+
+	result = (*function) (callInfo);
+	*isnull = callInfo->isnull;
+
+	return result;
+}
+
+PG_FUNCTION_INFO_V1(vnumericacc);
+Datum
+vnumericacc(PG_FUNCTION_ARGS)
+{
+	NumericVectorAggState *state;
+	VectorColumn *arg1 = (VectorColumn *) PG_GETARG_POINTER(1);
+	Datum *vectorValue = (Datum *) arg1->value;
+	int entryCount = arg1->hasRuns ? arg1->runCount : arg1->dimension;
+	Numeric sumNumeric = NULL;
+	int128 sumX = 0;
+	int64 N = 0;
+	int scale;
+	int i, rowIndex, rowCount;
+
+	MemoryContext aggContext;
+
+	if (!AggCheckCallContext(fcinfo, &aggContext))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (NumericVectorAggState *) PG_GETARG_POINTER(0);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+		state = MemoryContextAllocZero(aggContext, sizeof(NumericVectorAggState));
+
+	/*
+	 * Values are summed up at the largest display scale of the vector, every
+	 * row of a run has the value of its first row.
+	 */
+	scale = state->scale;
+
+	for (i = 0, rowIndex = 0; i < entryCount; i++, rowIndex += rowCount)
+	{
+		int dscale;
+
+		rowCount = arg1->hasRuns ? arg1->runLength[i] : 1;
+
+		if (!arg1->isnull[rowIndex] &&
+			numeric_vector_value_dscale(vectorValue[rowIndex], &dscale) &&
+			dscale <= VECTOR_NUMERIC_MAX_SCALE)
+			scale = Max(scale, dscale);
+	}
+
+	if (scale > state->scale)
+	{
+		/* make room for the scaled up sum */
+		if (int128_abs(state->sumX) >= ((int128) 1 << 64))
+			numeric_vector_flush_sum(state, aggContext);
+
+		for (; state->scale < scale; state->scale++)
+			state->sumX *= 10;
+	}
+
+	for (i = 0, rowIndex = 0; i < entryCount; i++, rowIndex += rowCount)
+	{
+		Numeric value;
+		int64 scaledValue;
+
+		rowCount = arg1->hasRuns ? arg1->runLength[i] : 1;
+
+		if (arg1->isnull[rowIndex])
+			continue;
+
+		if (numeric_vector_value_to_int64(vectorValue[rowIndex], scale, &scaledValue))
+		{
+			sumX += (int128) scaledValue * rowCount;
+			N += rowCount;
+			continue;
+		}
+
+		value = DatumGetNumeric(vectorValue[rowIndex]);
+
+		if (!numeric_is_nan(value) && !numeric_is_inf(value))
+			N += rowCount;
+
+		if (rowCount > 1)
+			value = numeric_mul_opt_error(value, int64_to_numeric(rowCount), NULL);
+
+		sumNumeric = sumNumeric == NULL ?
+			value : numeric_add_opt_error(sumNumeric, value, NULL);
+	}
+
+	if (int128_abs(state->sumX) >= VECTOR_NUMERIC_SUM_LIMIT)
+		numeric_vector_flush_sum(state, aggContext);
+
+	state->N += N;
+	state->sumX += sumX;
+
+	if (sumNumeric != NULL)
+		numeric_vector_add_numeric(state, sumNumeric, aggContext);
+
+	PG_RETURN_POINTER(state);
+}
+
+PG_FUNCTION_INFO_V1(vnumericsum);
+Datum
+vnumericsum(PG_FUNCTION_ARGS)
+{
+	NumericVectorAggState *state;
+	Numeric res;
+
+	state = PG_ARGISNULL(0) ? NULL : (NumericVectorAggState *) PG_GETARG_POINTER(0);
+
+	res = numeric_vector_sum(state);
+
+	/* If there were no non-null inputs, return NULL */
+	if (res == NULL)
+		PG_RETURN_NULL();
+
+	PG_RETURN_NUMERIC(res);
+}
+
+PG_FUNCTION_INFO_V1(vnumericavg);
+Datum
+vnumericavg(PG_FUNCTION_ARGS)
+{
+	NumericVectorAggState *state;
+	Numeric sumNumeric, nNumeric, res;
+
+	state = PG_ARGISNULL(0) ? NULL : (NumericVectorAggState *) PG_GETARG_POINTER(0);
+
+	sumNumeric = numeric_vector_sum(state);
+
+	/* If there were no non-null inputs, return NULL */
+	if (sumNumeric == NULL)
+		PG_RETURN_NULL();
+
+	/* NaN and infinite sums are the average as well */
+	if (numeric_is_nan(sumNumeric) || numeric_is_inf(sumNumeric))
+		PG_RETURN_NUMERIC(sumNumeric);
+
+	nNumeric = int64_to_numeric(state->N);
+	res = numeric_div_opt_error(sumNumeric, nNumeric, NULL);
+
+	PG_RETURN_NUMERIC(res);
+}
+
+/*
+ * Serialize the state in the format of numeric_avg_serialize(), so that the
+ * partial results of parallel workers combine with the built-in sum and avg.
+ * The state of numeric_avg_accum() is built from the sum as its only input,
+ * after which the count that leads the serialized state is replaced by the
+ * count of all the inputs.
+ */
+PG_FUNCTION_INFO_V1(vnumeric_avg_serialize);
+Datum
+vnumeric_avg_serialize(PG_FUNCTION_ARGS)
+{
+	NumericVectorAggState *state;
+	NullableDatum args[2];
+	Numeric sumX;
+	bytea *result;
+	int64 N;
+	bool isnull;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = (NumericVectorAggState *) PG_GETARG_POINTER(0);
+
+	sumX = numeric_vector_sum(state);
+
+	args[0].value = (Datum) 0;
+	args[0].isnull = true;
+	args[1].value = NumericGetDatum(sumX);
+	args[1].isnull = sumX == NULL;
+
+	args[0].value = numeric_agg_support_call(numeric_avg_accum, fcinfo, 2,
+											 args, &isnull);
+	args[0].isnull = false;
+
+	result = (bytea *) DatumGetPointer(
+		numeric_agg_support_call(numeric_avg_serialize, fcinfo, 1, args, &isnull));
+
+	N = pg_hton64(state->N);
+	memcpy(VARDATA(result), &N, sizeof(int64));
+
+	PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * Deserialize a state written by vnumeric_avg_serialize() or by
+ * numeric_avg_serialize(), keeping its sum as numeric.
+ */
+PG_FUNCTION_INFO_V1(vnumeric_avg_deserialize);
+Datum
+vnumeric_avg_deserialize(PG_FUNCTION_ARGS)
+{
+	NumericVectorAggState *result;
+	NullableDatum args[2];
+	bytea *sstate;
+	Datum sumX;
+	int64 N;
+	bool isnull;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	args[0].value = PointerGetDatum(sstate);
+	args[0].isnull = false;
+	args[1].value = (Datum) 0;
+	args[1].isnull = true;
+
+	args[0].value = numeric_agg_support_call(numeric_avg_deserialize, fcinfo, 2,
+											 args, &isnull);
+
+	sumX = numeric_agg_support_call(numeric_sum, fcinfo, 1, args, &isnull);
+
+	memcpy(&N, VARDATA_ANY(sstate), sizeof(int64));
+
+	result = palloc0(sizeof(NumericVectorAggState));
+	result->N = pg_ntoh64(N);
+
+	if (!isnull)
+		result->sumNumeric = DatumGetNumeric(sumX);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Find the row of the largest, or smallest, non-null value of a numeric
+ * vector by comparing the values as integers at the largest display scale of
+ * the vector. Of equal values the last one is taken, like numeric_larger()
+ * and numeric_smaller() do. Returns false when some value doesn't fit an
+ * int64 that way, extremeRow is -1 for a vector of nulls.
+ */
+static bool
+numeric_vector_extreme_row(VectorColumn *column, bool larger, int *extremeRow)
+{
+	Datum *vectorValue = (Datum *) column->value;
+	int64 extremeValue = 0;
+	int scale = 0;
+	int i;
+
+	*extremeRow = -1;
+
+	for (i = 0; i < column->dimension; i++)
+	{
+		int dscale;
+
+		if (column->isnull[i])
+			continue;
+
+		if (!numeric_vector_value_dscale(vectorValue[i], &dscale) ||
+			dscale > VECTOR_NUMERIC_MAX_SCALE)
+			return false;
+
+		scale = Max(scale, dscale);
+	}
+
+	for (i = 0; i < column->dimension; i++)
+	{
+		int64 value;
+
+		if (column->isnull[i])
+			continue;
+
+		if (!numeric_vector_value_to_int64(vectorValue[i], scale, &value))
+			return false;
+
+		if (*extremeRow < 0 ||
+			(larger ? value >= extremeValue : value <= extremeValue))
+		{
+			extremeValue = value;
+			*extremeRow = i;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Shared body of vnumericlarger() and vnumericsmaller(). The state is
+ * compared with the extreme value of the vector, or with every value when
+ * the vector has values that don't compare as integers.
+ */
+static Datum
+numeric_vector_extreme(FunctionCallInfo fcinfo, PGFunction compare, bool larger)
+{
+	VectorColumn *arg2 = (VectorColumn *) PG_GETARG_POINTER(1);
+	Datum *vectorValue = (Datum *) arg2->value;
+	bool resultIsNull = PG_ARGISNULL(0);
+	Datum result = resultIsNull ? (Datum) 0 : PG_GETARG_DATUM(0);
+	int extremeRow;
+	int i;
+
+	if (numeric_vector_extreme_row(arg2, larger, &extremeRow))
+	{
+		if (extremeRow < 0)
+		{
+			if (resultIsNull)
+				PG_RETURN_NULL();
+
+			PG_RETURN_DATUM(result);
+		}
+
+		/* vector values may have a short varlena header */
+		result = resultIsNull ?
+			NumericGetDatum(DatumGetNumeric(vectorValue[extremeRow])) :
+			DirectFunctionCall2(compare, result, vectorValue[extremeRow]);
+
+		PG_RETURN_DATUM(result);
+	}
+
+	for (i = 0; i < arg2->dimension; i++)
+	{
+		if (arg2->isnull[i])
+			continue;
+
+		result = resultIsNull ?
+			NumericGetDatum(DatumGetNumeric(vectorValue[i])) :
+			DirectFunctionCall2(compare, result, vectorValue[i]);
+		resultIsNull = false;
+	}
+
+	if (resultIsNull)
+		PG_RETURN_NULL();
+
+	PG_RETURN_DATUM(result);
+}
+
+PG_FUNCTION_INFO_V1(vnumericlarger);
+Datum vnumericlarger(PG_FUNCTION_ARGS)
+{
+	return numeric_vector_extreme(fcinfo, numeric_larger, true);
+}
+
+PG_FUNCTION_INFO_V1(vnumericsmaller);
+Datum vnumericsmaller(PG_FUNCTION_ARGS)
+{
+	return numeric_vector_extreme(fcinfo, numeric_smaller, false);
+}
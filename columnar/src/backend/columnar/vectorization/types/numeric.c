@@ -258,9 +258,14 @@ typedef struct NumericVar
 	(weight) <= NUMERIC_SHORT_WEIGHT_MAX && \
 	(weight) >= NUMERIC_SHORT_WEIGHT_MIN)
 
+/* most digits numeric_vector_unpack() copies out of a vector value */
+#define NUMERIC_VECTOR_MAX_DIGITS	16
+
 static void alloc_var(NumericVar *var, int ndigits);
 static void free_var(NumericVar *var);
 static Numeric make_numeric(const struct NumericVar *var);
+static bool numeric_vector_unpack(Datum value, NumericVar *var,
+								  NumericDigit *digits);
 
 /*
  * alloc_var() -
@@ -449,3 +454,175 @@ Numeric int128_to_numeric(int128 val)
 
 	return res;
 }
+
+/*
+ * Convert 128 bit integer, counted in units of 10^-scale, to numeric with
+ * display scale.
+ */
+Numeric int128_to_numeric_scaled(int128 val, int scale)
+{
+	Numeric		res;
+	NumericVar	result;
+	int			shift = (DEC_DIGITS - scale % DEC_DIGITS) % DEC_DIGITS;
+
+	init_var(&result);
+
+	int128_to_numericvar(val, &result);
+
+	/*
+	 * Move the decimal point to a NBASE digit boundary by multiplying the
+	 * digits with 10^shift, the carry goes to the spare digit in front.
+	 */
+	if (shift > 0 && result.ndigits > 0)
+	{
+		int			factor = shift == 1 ? 10 : shift == 2 ? 100 : 1000;
+		int			carry = 0;
+		int			i;
+
+		for (i = result.ndigits - 1; i >= 0; i--)
+		{
+			int			digit = result.digits[i] * factor + carry;
+
+			result.digits[i] = digit % NBASE;
+			carry = digit / NBASE;
+		}
+
+		if (carry > 0)
+		{
+			result.digits--;
+			result.digits[0] = carry;
+			result.ndigits++;
+			result.weight++;
+		}
+	}
+
+	result.weight -= (scale + shift) / DEC_DIGITS;
+	result.dscale = scale;
+
+	res = make_numeric(&result);
+
+	free_var(&result);
+
+	return res;
+}
+
+/*
+ * numeric_vector_unpack() -
+ *
+ *	Read sign, weight and dscale of a finite numeric value stored in a column
+ *	vector, and copy its digits to digits[] when that isn't NULL. Vector values
+ *	may have a short varlena header, which leaves the numeric header unaligned,
+ *	so it is read with memcpy() rather than by detoasting every value.
+ *
+ *	Returns false for NaN and infinities, for compressed or external values and
+ *	for values with more than NUMERIC_VECTOR_MAX_DIGITS digits.
+ */
+static bool
+numeric_vector_unpack(Datum value, NumericVar *var, NumericDigit *digits)
+{
+	struct varlena *num = (struct varlena *) DatumGetPointer(value);
+	char	   *data;
+	Size		headerSize;
+	uint16		header;
+
+	if (VARATT_IS_EXTERNAL(num) || VARATT_IS_COMPRESSED(num))
+		return false;
+
+	data = VARDATA_ANY(num);
+	memcpy(&header, data, sizeof(uint16));
+
+	if ((header & NUMERIC_SIGN_MASK) == NUMERIC_SPECIAL)
+		return false;
+
+	if ((header & NUMERIC_SIGN_MASK) == NUMERIC_SHORT)
+	{
+		var->sign = (header & NUMERIC_SHORT_SIGN_MASK) ?
+			NUMERIC_NEG : NUMERIC_POS;
+		var->dscale = (header & NUMERIC_SHORT_DSCALE_MASK) >>
+			NUMERIC_SHORT_DSCALE_SHIFT;
+		var->weight = ((header & NUMERIC_SHORT_WEIGHT_SIGN_MASK) ?
+					   ~NUMERIC_SHORT_WEIGHT_MASK : 0) |
+			(header & NUMERIC_SHORT_WEIGHT_MASK);
+		headerSize = sizeof(uint16);
+	}
+	else
+	{
+		int16		weight;
+
+		memcpy(&weight, data + sizeof(uint16), sizeof(int16));
+
+		var->sign = header & NUMERIC_SIGN_MASK;
+		var->dscale = header & NUMERIC_DSCALE_MASK;
+		var->weight = weight;
+		headerSize = sizeof(uint16) + sizeof(int16);
+	}
+
+	var->ndigits = (VARSIZE_ANY_EXHDR(num) - headerSize) / sizeof(NumericDigit);
+	if (var->ndigits > NUMERIC_VECTOR_MAX_DIGITS)
+		return false;
+
+	var->buf = NULL;
+	var->digits = digits;
+
+	if (digits != NULL)
+		memcpy(digits, data + headerSize, var->ndigits * sizeof(NumericDigit));
+
+	return true;
+}
+
+/*
+ * Display scale of a numeric value in a column vector. Returns false when
+ * the value has to go through the regular numeric functions instead.
+ */
+bool numeric_vector_value_dscale(Datum value, int *dscale)
+{
+	NumericVar	var;
+
+	if (!numeric_vector_unpack(value, &var, NULL))
+		return false;
+
+	*dscale = var.dscale;
+
+	return true;
+}
+
+/*
+ * Convert numeric value in a column vector to 64 bit integer counted in
+ * units of 10^-scale. Returns false when the value doesn't fit, has a larger
+ * display scale, or has to go through the regular numeric functions.
+ */
+bool numeric_vector_value_to_int64(Datum value, int scale, int64 *result)
+{
+	NumericVar	var;
+	NumericDigit digits[NUMERIC_VECTOR_MAX_DIGITS];
+	int64		scaled = 0;
+	int			exponent;
+	int			i;
+
+	if (!numeric_vector_unpack(value, &var, digits) || var.dscale > scale)
+		return false;
+
+	for (i = 0; i < var.ndigits; i++)
+	{
+		if (pg_mul_s64_overflow(scaled, NBASE, &scaled) ||
+			pg_add_s64_overflow(scaled, var.digits[i], &scaled))
+			return false;
+	}
+
+	/* decimal exponent of the last digit, in units of 10^-scale */
+	exponent = (var.weight - var.ndigits + 1) * DEC_DIGITS + scale;
+
+	for (; exponent > 0; exponent--)
+	{
+		if (pg_mul_s64_overflow(scaled, 10, &scaled))
+			return false;
+	}
+
+	/* digits below 10^-scale are zeroes, as dscale <= scale */
+	for (; exponent < 0; exponent++)
+		scaled /= 10;
+
+	*result = var.sign == NUMERIC_NEG ? -scaled : scaled;
+
+	return true;
+}
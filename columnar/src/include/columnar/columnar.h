@@ -31,10 +31,12 @@
 typedef struct RelFileNode RelFileLocator;
 #endif
 #include "storage/s_lock.h"
+#include "utils/hsearch.h"
 #include "utils/relcache.h"
 #include "utils/snapmgr.h"
 
 #include "columnar/columnar_compression.h"
+#include "columnar/columnar_encoding.h"
 #include "columnar/columnar_metadata.h"
 #include "columnar/columnar_write_state_row_mask.h"
 
@@ -55,6 +57,19 @@ typedef struct RelFileNode RelFileLocator;
 #define COMPRESSION_LEVEL_MIN 1
 #define COMPRESSION_LEVEL_MAX 19
 
+/* limits of trained zstd dictionaries, sizes are in kB */
+#define ZSTD_DICTIONARY_SIZE_MAX 1024
+#define ZSTD_DICTIONARY_SIZE_DEFAULT 64
+
+/* zstd advises to train a dictionary on about 100 times its size of samples */
+#define ZSTD_DICTIONARY_SAMPLE_RATIO 100
+
+/* upper limit of columnar.zstd_compression_workers */
+#define ZSTD_COMPRESSION_WORKERS_MAX 64
+
+/* upper limit of columnar.shared_column_cache_size, in MB */
+#define SHARED_COLUMN_CACHE_SIZE_MAX (1024 * 1024)
+
 /* Columnar file signature */
 #define COLUMNAR_VERSION_MAJOR 2
 #define COLUMNAR_VERSION_MINOR 0
@@ -79,9 +94,30 @@ typedef struct ColumnarOptions
 	uint32 chunkRowCount;
 	CompressionType compressionType;
 	int compressionLevel;
+
+	/* per-column overrides of the compression settings, see ColumnarColumnOptions */
+	List *columnOptionsList;
 } ColumnarOptions;
 
 
+/*
+ * ColumnarColumnOptions holds the compression settings of a single column that
+ * override the table wide ones. A compressionType of COMPRESSION_TYPE_INVALID or
+ * a compressionLevel of COLUMN_COMPRESSION_LEVEL_INHERIT means the table wide
+ * setting is used. When bloomFilter is set, a bloom filter of the values of
+ * every chunk written to the column is stored with its skip node.
+ */
+typedef struct ColumnarColumnOptions
+{
+	AttrNumber attrNum;
+	CompressionType compressionType;
+	int compressionLevel;
+	bool bloomFilter;
+} ColumnarColumnOptions;
+
+#define COLUMN_COMPRESSION_LEVEL_INHERIT 0
+
+
 /* ColumnChunkSkipNode contains statistics for a ColumnChunkData. */
 typedef struct ColumnChunkSkipNode
 {
@@ -91,6 +127,9 @@ typedef struct ColumnChunkSkipNode
 	Datum maximumValue;
 	uint64 rowCount;
 
+	/* number of NULLs among rowCount, only maintained by the writer */
+	uint64 nullCount;
+
 	/*
 	 * Offsets and sizes of value and exists streams in the column data.
 	 * These enable us to skip reading suppressed row chunks, and start reading
@@ -109,6 +148,10 @@ typedef struct ColumnChunkSkipNode
 
 	CompressionType valueCompressionType;
 	int valueCompressionLevel;
+	EncodingType valueEncodingType;
+
+	/* bloom filter of the chunk's values, NULL if the column has none */
+	bytea *bloomFilter;
 } ColumnChunkSkipNode;
 
 
@@ -128,6 +171,36 @@ typedef struct StripeSkipList
 } StripeSkipList;
 
 
+/*
+ * ColumnZoneMap contains the statistics of a column over a whole stripe. It is
+ * aggregated from the column's chunk skip nodes when the stripe is flushed, so
+ * that scans can skip the stripe without reading its chunk metadata.
+ */
+typedef struct ColumnZoneMap
+{
+	/* false if the stripe has no zone map for the column */
+	bool exists;
+
+	bool hasMinMax;
+	Datum minimumValue;
+	Datum maximumValue;
+	uint64 nullCount;
+} ColumnZoneMap;
+
+
+/*
+ * StripeZoneMap is the entry of a stripe in the hash table built by
+ * ReadStripeZoneMaps. columnZoneMapArray only holds the columns that were
+ * asked for, columnZoneMapArray[zoneMapIndexArray[column]] is the zone map of
+ * the specified column.
+ */
+typedef struct StripeZoneMap
+{
+	uint64 stripeId;
+	ColumnZoneMap *columnZoneMapArray;
+} StripeZoneMap;
+
+
 /*
  * ChunkData represents a chunk of data for multiple columns. valueArray stores
  * the values of data, and existsArray stores whether a value is present.
@@ -149,6 +222,24 @@ typedef struct ChunkData
 
 	/* valueBuffer keeps actual data for type-by-reference datums from valueArray. */
 	StringInfo *valueBufferArray;
+
+	/*
+	 * Indexed by [column][row], only set for run-length encoded columns.
+	 * runStartArray[column][row] is true when the row starts a run of
+	 * identical values (or NULLs).
+	 */
+	bool **runStartArray;
+
+	/*
+	 * lazyEncodingArray[column] is set for columns whose values are only
+	 * decoded when their row is read, in which case valueBufferArray[column]
+	 * holds the encoded values and lazyValueIndexArray[column][row] the
+	 * position of the row's value among the chunk's non-null values. Decoded
+	 * values are allocated in lazyDecodeContext.
+	 */
+	EncodingType *lazyEncodingArray;
+	uint32 **lazyValueIndexArray;
+	MemoryContext lazyDecodeContext;
 } ChunkData;
 
 
@@ -156,7 +247,8 @@ typedef struct ChunkData
  * ColumnChunkBuffers represents a chunk of serialized data in a column.
  * valueBuffer stores the serialized values of data, and existsBuffer stores
  * serialized value of presence information. valueCompressionType contains
- * compression type if valueBuffer is compressed. Finally rowCount has
+ * compression type if valueBuffer is compressed, and valueEncodingType the
+ * encoding applied to the values before compression. Finally rowCount has
  * the number of rows in this chunk.
  */
 typedef struct ColumnChunkBuffers
@@ -164,6 +256,8 @@ typedef struct ColumnChunkBuffers
 	StringInfo existsBuffer;
 	StringInfo valueBuffer;
 	CompressionType valueCompressionType;
+	int valueCompressionLevel;
+	EncodingType valueEncodingType;
 	uint64 decompressedValueSize;
 } ColumnChunkBuffers;
 
@@ -250,8 +344,27 @@ typedef struct ColumnarCacheStatistics
 	uint64 maximumCacheSize;
 	uint64 endingCacheSize;
 	uint64 entries;
+
+	/* compressed tier */
+	uint64 compressedHits;
+	uint64 compressedMisses;
+	uint64 compressedEvictions;
+	uint64 compressedWrites;
+	uint64 compressedMaximumCacheSize;
+	uint64 compressedEndingCacheSize;
+	uint64 compressedEntries;
 } ColumnarCacheStatistics;
 
+/* Key of a chunk in the shared column cache */
+typedef struct ColumnarCachedChunk
+{
+	Oid databaseId;
+	uint64 storageId;
+	uint64 stripeId;
+	uint64 chunkId;
+	uint32 columnId;
+} ColumnarCachedChunk;
+
 /* GUCs */
 extern int columnar_compression;
 extern int columnar_stripe_row_limit;
@@ -263,7 +376,16 @@ extern bool columnar_enable_vectorization;
 extern bool columnar_enable_dml;
 extern bool columnar_enable_page_cache;
 extern int columnar_page_cache_size;
+extern int columnar_compressed_column_cache_size;
 extern bool columnar_index_scan;
+extern bool columnar_enable_encoding;
+extern double columnar_auto_compression_decode_weight;
+extern int columnar_zstd_dictionary_size;
+extern int columnar_zstd_compression_workers;
+extern bool columnar_enable_late_materialization;
+extern int columnar_shared_column_cache_size;
+extern bool columnar_enable_cache_warm_set;
+extern int columnar_cache_warm_set_interval;
 
 
 /* called when the user changes options on the given relation */
@@ -305,6 +427,11 @@ extern bool ColumnarReadNextRow(ColumnarReadState *state, Datum *columnValues,
 extern bool ColumnarReadNextVector(ColumnarReadState *readState, Datum *columnValues,
 								   bool *columnNulls, uint64 *rowNumber,
 								   int *newVectorSize);
+extern void ColumnarReadSetFilterColumns(ColumnarReadState *readState,
+										 List *filterColumnList);
+extern void ColumnarReadMaterializeVector(ColumnarReadState *readState,
+										  Datum *columnValues, bool *keep,
+										  int vectorSize);
 extern int64 ColumnarReadChunkGroupsFiltered(ColumnarReadState *state);
 extern void ColumnarRescan(ColumnarReadState *readState, List *scanQual);
 
@@ -317,6 +444,11 @@ extern bool ColumnarReadRowByRowNumber(ColumnarReadState *readState,
 									   bool *columnNulls);
 extern bool ColumnarSetStripeReadState(ColumnarReadState *readState,
 									   StripeMetadata *startStripeMetadata);
+extern List * ReadColumnValueStreams(Relation relation, AttrNumber attrNum,
+									uint64 maxSampleSize, Snapshot snapshot);
+extern uint64 ColumnarPrewarmStripe(Relation relation, StripeMetadata *stripeMetadata,
+									List *columnList, bool *chunkGroupMask,
+									Snapshot snapshot);
 
 /* Function declarations for common functions */
 extern FmgrInfo * GetFunctionInfoOrNull(Oid typeId, Oid accessMethodId,
@@ -335,11 +467,15 @@ extern void InitColumnarOptions(Oid regclass);
 extern void SetColumnarOptions(Oid regclass, ColumnarOptions *options);
 extern bool DeleteColumnarTableOptions(Oid regclass, bool missingOk);
 extern bool ReadColumnarOptions(Oid regclass, ColumnarOptions *options);
+extern List * ReadColumnarColumnOptions(Oid regclass);
+extern void SetColumnarColumnOptions(Oid regclass, ColumnarColumnOptions *columnOptions);
 extern bool IsColumnarTableAmTable(Oid relationId);
 
 /* columnar_metadata_tables.c */
 extern void DeleteMetadataRows(RelFileLocator relfilelocator);
 extern void DeleteMetadataRowsForStripeId(RelFileLocator relfilelocator, uint64 stripeId);
+extern List * ReadZstdDictionaries(uint64 storageId);
+extern void SaveZstdDictionary(uint64 storageId, ZstdDictionary *dictionary);
 extern uint64 ColumnarMetadataNewStorageId(void);
 extern uint64 GetHighestUsedAddress(RelFileLocator relfilelocator);
 extern EmptyStripeReservation * ReserveEmptyStripe(Relation rel, uint64 columnCount,
@@ -353,6 +489,12 @@ extern void SaveStripeSkipList(RelFileLocator relfilelocator, uint64 stripe,
 							   TupleDesc tupleDescriptor);
 extern void SaveChunkGroups(RelFileLocator relfilelocator, uint64 stripe,
 							List *chunkGroupRowCounts);
+extern void SaveStripeZoneMap(RelFileLocator relfilelocator, uint64 stripe,
+							  ColumnZoneMap *columnZoneMapArray,
+							  TupleDesc tupleDescriptor);
+extern HTAB * ReadStripeZoneMaps(RelFileLocator relfilelocator,
+								 TupleDesc tupleDescriptor, int *zoneMapIndexArray,
+								 int zoneMapCount, Snapshot snapshot);
 extern void UpdateChunkGroupDeletedRows(uint64 storageId, uint64 stripe,
 										uint32 chunkGroupId, uint32 deletedRowNumber);
 extern StripeSkipList * ReadStripeSkipList(RelFileLocator relfilelocator, uint64 stripe,
@@ -448,12 +590,38 @@ extern void CleanupReadStateCache(SubTransactionId currentSubXid);
 extern MemoryContext GetColumnarReadStateCache(void);
 
 /* columnar_cache.c */
-extern void ColumnarMarkChunkGroupInUse(uint64 relId, uint64 stripeId, uint32 chunkId);
+extern void ColumnarMarkChunkGroupInUse(uint64 storageId, uint64 stripeId, uint32 chunkId);
 extern void ColumnarAddCacheEntry(uint64, uint64, uint64, uint32, void *);
 extern void *ColumnarRetrieveCache(uint64, uint64, uint64, uint32);
 extern void ColumnarResetCache(void);
 extern ColumnarCacheStatistics *ColumnarGetCacheStatistics(void);
 extern MemoryContext ColumnarCacheMemoryContext(void);
+extern bool ColumnarCompressedCacheEnabled(void);
+extern void ColumnarAddCompressedCacheEntry(uint64 storageId, uint64 stripeId,
+											uint64 chunkId, uint32 columnId,
+											StringInfo existsBuffer,
+											StringInfo valueBuffer);
+extern bool ColumnarRetrieveCompressedCache(uint64 storageId, uint64 stripeId,
+											uint64 chunkId, uint32 columnId,
+											StringInfo existsBuffer,
+											StringInfo valueBuffer);
+extern void ColumnarInvalidateCompressedCache(uint64 storageId);
+extern void ColumnarInvalidateCompressedCacheStripe(uint64 storageId, uint64 stripeId);
+
+/* columnar_shared_cache.c */
+extern void ColumnarSharedCacheInit(void);
+extern bool ColumnarSharedCacheEnabled(void);
+extern StringInfo ColumnarSharedCacheRetrieve(uint64 storageId, uint64 stripeId,
+											  uint64 chunkId, uint32 columnId);
+extern bool ColumnarSharedCacheAdd(uint64 storageId, uint64 stripeId, uint64 chunkId,
+								   uint32 columnId, StringInfo data, int *evictedCount);
+extern bool ColumnarSharedCacheRemove(uint64 storageId, uint64 stripeId, uint64 chunkId,
+									  uint32 columnId);
+extern void ColumnarSharedCacheUsage(uint64 *entries, uint64 *size);
+extern ColumnarCachedChunk * ColumnarSharedCacheChunks(int *chunkCount);
+
+/* columnar_prewarm.c */
+extern void ColumnarWarmSetInit(void);
 
 
 #endif /* COLUMNAR_H */
@@ -0,0 +1,32 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_bloom_filter.h
+ *
+ * Type and function declarations for the per-chunk bloom filters used to
+ * skip chunks on equality quals.
+ *
+ * Copyright (c) Hydra, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef COLUMNAR_BLOOM_FILTER_H
+#define COLUMNAR_BLOOM_FILTER_H
+
+#include "fmgr.h"
+
+/*
+ * Filters get about 10 bits per value, which together with 7 probes gives a
+ * false positive rate of roughly 1%. Filters of chunks with many distinct
+ * values are capped at BLOOM_FILTER_MAX_BITS.
+ */
+#define BLOOM_FILTER_BITS_PER_VALUE 10
+#define BLOOM_FILTER_HASH_COUNT 7
+#define BLOOM_FILTER_MIN_BITS 64
+#define BLOOM_FILTER_MAX_BITS (128 * 1024)
+
+extern bytea * CreateBloomFilter(uint32 valueCount);
+extern void BloomFilterAddHash(bytea *bloomFilter, uint32 hash);
+extern bool BloomFilterMightContainHash(bytea *bloomFilter, uint32 hash);
+
+#endif /* COLUMNAR_BLOOM_FILTER_H */
@@ -12,6 +12,9 @@
 #ifndef COLUMNAR_COMPRESSION_H
 #define COLUMNAR_COMPRESSION_H
 
+#include "lib/stringinfo.h"
+#include "nodes/pg_list.h"
+
 /* Enumaration for columnar table's compression method */
 typedef enum
 {
@@ -21,14 +24,55 @@ typedef enum
 	COMPRESSION_LZ4 = 2,
 	COMPRESSION_ZSTD = 3,
 
+	/* picks one of the above per chunk, never stored in chunk metadata */
+	COMPRESSION_AUTO = 4,
+
 	COMPRESSION_COUNT
 } CompressionType;
 
+/*
+ * ZstdDictionary is a zstd dictionary trained on the value streams of a column's
+ * chunks. Chunks compressed with it carry its id in their zstd frame header. The
+ * zstd objects built from it are freed together with the memory context the
+ * dictionary is allocated in.
+ */
+typedef struct ZstdDictionary
+{
+	int32 attrNum;
+	uint32 dictionaryId;
+	bytea *dictionaryData;
+
+	int compressionLevel;
+	void *compressionDictionary;    /* ZSTD_CDict for compressionLevel */
+	void *compressionContext;       /* ZSTD_CCtx */
+	void *decompressionDictionary;  /* ZSTD_DDict */
+	void *decompressionContext;     /* ZSTD_DCtx */
+
+	MemoryContextCallback resetCallback;
+} ZstdDictionary;
+
 extern bool CompressBuffer(StringInfo inputBuffer,
 						   StringInfo outputBuffer,
 						   CompressionType compressionType,
 						   int compressionLevel);
+extern CompressionType ChooseCompression(StringInfo inputBuffer,
+										 StringInfo outputBuffer,
+										 int maxCompressionLevel,
+										 double decodeCostWeight,
+										 int *compressionLevel,
+										 double *cost);
 extern StringInfo DecompressBuffer(StringInfo buffer, CompressionType compressionType,
 								   uint64 decompressedSize);
 
+extern ZstdDictionary * CreateZstdDictionary(int32 attrNum, bytea *dictionaryData);
+extern bytea * TrainZstdDictionary(List *sampleList, int dictionarySize);
+extern uint32 ZstdFrameDictionaryId(StringInfo buffer);
+extern bool CompressBufferWithZstdDictionary(StringInfo inputBuffer,
+											 StringInfo outputBuffer,
+											 int compressionLevel,
+											 ZstdDictionary *dictionary);
+extern StringInfo DecompressBufferWithZstdDictionary(StringInfo buffer,
+													 uint64 decompressedSize,
+													 ZstdDictionary *dictionary);
+
 #endif /* COLUMNAR_COMPRESSION_H */
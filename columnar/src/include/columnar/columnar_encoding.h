@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------------
+ *
+ * columnar_encoding.h
+ *
+ * Type and function declarations for lightweight chunk encodings.
+ *
+ * Copyright (c) Hydra, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef COLUMNAR_ENCODING_H
+#define COLUMNAR_ENCODING_H
+
+#include "access/tupdesc.h"
+#include "lib/stringinfo.h"
+
+/*
+ * Enumeration for the encoding applied to a chunk's serialized value stream
+ * before it is handed to the block compressor.
+ */
+typedef enum
+{
+	ENCODING_TYPE_INVALID = -1,
+	ENCODING_NONE = 0,
+	ENCODING_DICTIONARY = 1,
+	ENCODING_RLE = 2,
+	ENCODING_FOR = 3,
+	ENCODING_DELTA = 4,
+	ENCODING_FLOAT_XOR = 5,
+	ENCODING_FSST = 6,
+	ENCODING_CONSTANT = 7,
+
+	ENCODING_COUNT
+} EncodingType;
+
+/* chunks with fewer values than this are always stored plain */
+#define ENCODING_MIN_VALUE_COUNT 64
+
+extern EncodingType EncodeChunkValues(StringInfo valueBuffer, uint32 valueCount,
+									  Form_pg_attribute attributeForm,
+									  StringInfo encodedBuffer);
+extern StringInfo DecodeChunkValues(StringInfo encodedBuffer, EncodingType encodingType,
+									bool *existsArray, uint32 rowCount,
+									Form_pg_attribute attributeForm, Datum *valueArray,
+									bool *runStartArray);
+extern bool EncodingSupportsRandomAccess(EncodingType encodingType);
+extern Datum DecodeChunkValue(StringInfo encodedBuffer, EncodingType encodingType,
+							  uint32 valueIndex);
+
+#endif /* COLUMNAR_ENCODING_H */
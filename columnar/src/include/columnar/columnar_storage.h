@@ -37,6 +37,15 @@
 #define ColumnarLogicalOffsetIsValid(X) ((X) >= ColumnarFirstLogicalOffset)
 
 
+/* a range of logical offsets to read with ColumnarStorageReadRanges */
+typedef struct ColumnarStorageRange
+{
+	uint64 logicalOffset;
+	uint32 amount;
+	char *data;
+} ColumnarStorageRange;
+
+
 extern void ColumnarStorageInit(SMgrRelation srel, uint64 storageId);
 extern bool ColumnarStorageIsCurrent(Relation rel);
 extern void ColumnarStorageUpdateCurrent(Relation rel, bool upgrade,
@@ -57,6 +66,10 @@ extern uint64 ColumnarStorageReserveStripeId(Relation rel);
 
 extern void ColumnarStorageRead(Relation rel, uint64 logicalOffset,
 								char *data, uint32 amount);
+extern void ColumnarStorageReadRanges(Relation rel, ColumnarStorageRange *ranges,
+									  int rangeCount);
+extern void ColumnarStoragePrefetch(Relation rel, uint64 logicalOffset,
+									uint32 amount);
 extern void ColumnarStorageWrite(Relation rel, uint64 logicalOffset,
 								 char *data, uint32 amount);
 extern bool ColumnarStorageTruncate(Relation rel, uint64 newDataReservation);
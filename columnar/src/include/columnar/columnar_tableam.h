@@ -58,9 +58,12 @@ extern TableScanDesc columnar_beginscan_extended(Relation relation, Snapshot sna
 												 uint32 flags, Bitmapset *attr_needed,
 												 List *scanQual,
 												 ParallelColumnarScan parallelColumnarScan,
-												 bool returnVectorResult);
+												 bool returnVectorResult,
+												 Bitmapset *attr_filter);
 extern IndexFetchTableData * columnar_index_fetch_begin_extended(Relation rel,
 																 Bitmapset *attr_neededs);
+extern void ColumnarScanMaterializeVector(ColumnarScanDesc columnarScanDesc,
+										  TupleTableSlot *slot);
 extern int64 ColumnarScanChunkGroupsFiltered(ColumnarScanDesc columnarScanDesc);
 extern bool ColumnarSupportsIndexAM(char *indexAMName);
 extern bool IsColumnarTableAmTable(Oid relationId);
@@ -44,6 +44,14 @@ typedef struct VectorColumn
 	Datum	*value;
 	bool	isnull[COLUMNAR_VECTOR_COLUMN_SIZE];
 	uint64	*rowNumber;
+	/*
+	 * If hasRuns is set, the column is made of runCount runs of identical
+	 * values (and nullness). Run i spans runLength[i] rows, starting right
+	 * after the previous run.
+	 */
+	bool	hasRuns;
+	uint32	runCount;
+	uint32	*runLength;
 } VectorColumn;
 
 extern VectorColumn * BuildVectorColumn(int16 columnDimension,
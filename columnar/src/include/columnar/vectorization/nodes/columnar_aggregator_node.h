@@ -17,10 +17,17 @@
 
 #include "nodes/execnodes.h"
 
+struct VectorHashBatch;
+struct VectorSortedBatch;
+
 typedef struct VectorAggState
 {
 	CustomScanState css;
 	AggState *aggstate;
+	/* state for hashing vector batches, only set for AGG_HASHED */
+	struct VectorHashBatch *hashBatch;
+	/* state for grouping sorted vector batches, only set for AGG_SORTED */
+	struct VectorSortedBatch *sortedBatch;
 } VectorAggState;
 
 extern CustomScan *columnar_create_aggregator_node(void);
@@ -15,5 +15,8 @@
 
 #include "utils/numeric.h"
 extern Numeric int128_to_numeric(int128 val);
+extern Numeric int128_to_numeric_scaled(int128 val, int scale);
+extern bool numeric_vector_value_dscale(Datum value, int *dscale);
+extern bool numeric_vector_value_to_int64(Datum value, int scale, int64 *result);
 
 #endif
\ No newline at end of file
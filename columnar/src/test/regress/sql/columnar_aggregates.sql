@@ -80,6 +80,178 @@ SET columnar.enable_vectorization TO default;
 
 DROP TABLE t_date;
 
+-- 5. GROUP BY
+
+CREATE TABLE t_group(a INT, b BIGINT, c TEXT) USING columnar;
+
+INSERT INTO t_group SELECT g % 5, g, CASE WHEN g % 7 = 0 THEN NULL ELSE 'k' || (g % 3) END FROM GENERATE_SERIES(0, 99999) g;
+
+ANALYZE t_group;
+
+SET max_parallel_workers_per_gather TO 0;
+
+EXPLAIN (verbose, costs off, timing off, summary off) SELECT a, COUNT(*), SUM(b), MIN(b), MAX(b) FROM t_group GROUP BY a;
+
+SELECT a, COUNT(*), SUM(b), MIN(b), MAX(b) FROM t_group GROUP BY a ORDER BY a;
+
+SELECT c, COUNT(*), SUM(b), MAX(a) FROM t_group GROUP BY c ORDER BY c;
+
+SELECT a, SUM(b) FROM t_group GROUP BY a HAVING SUM(b) > 1000000000 ORDER BY a;
+
+SET columnar.enable_vectorization TO false;
+
+EXPLAIN (verbose, costs off, timing off, summary off) SELECT a, COUNT(*), SUM(b), MIN(b), MAX(b) FROM t_group GROUP BY a;
+
+SELECT a, COUNT(*), SUM(b), MIN(b), MAX(b) FROM t_group GROUP BY a ORDER BY a;
+
+SELECT c, COUNT(*), SUM(b), MAX(a) FROM t_group GROUP BY c ORDER BY c;
+
+SET columnar.enable_vectorization TO default;
+
+-- groups that don't fit in work_mem are spilled and read back in batches
+
+SET work_mem TO '64kB';
+
+SET enable_sort TO false;
+
+SELECT COUNT(*), SUM(s), MIN(s), MAX(s) FROM (SELECT b, SUM(a) s FROM t_group GROUP BY b) q;
+
+RESET enable_sort;
+
+RESET work_mem;
+
+-- sorted input is grouped a run of rows at a time
+
+SET enable_hashagg TO false;
+
+EXPLAIN (verbose, costs off, timing off, summary off) SELECT a, COUNT(*), SUM(b), MIN(b), MAX(b) FROM t_group GROUP BY a;
+
+SELECT a, COUNT(*), SUM(b), MIN(b), MAX(b) FROM t_group GROUP BY a ORDER BY a;
+
+SELECT c, COUNT(*), SUM(b), MAX(a) FROM t_group GROUP BY c ORDER BY c;
+
+RESET enable_hashagg;
+
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE t_group;
+
+-- 6. FLOAT4 / FLOAT8
+
+CREATE TABLE t_float(a FLOAT4, b FLOAT8) USING columnar;
+
+INSERT INTO t_float SELECT g % 100, g * 0.5 FROM GENERATE_SERIES(0, 99999) g;
+
+SET max_parallel_workers_per_gather TO 0;
+
+EXPLAIN (verbose, costs off, timing off, summary off) SELECT SUM(a), AVG(a), MIN(a), MAX(a), STDDEV(a) FROM t_float;
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_float;
+
+SELECT ROUND(VARIANCE(a)::numeric, 4), ROUND(VAR_POP(a)::numeric, 4), ROUND(STDDEV(a)::numeric, 4), ROUND(STDDEV_POP(a)::numeric, 4) FROM t_float;
+
+SELECT SUM(b), AVG(b), MIN(b), MAX(b) FROM t_float;
+
+SELECT ROUND(VARIANCE(b)::numeric, 4), ROUND(VAR_POP(b)::numeric, 4), ROUND(STDDEV(b)::numeric, 4), ROUND(STDDEV_POP(b)::numeric, 4) FROM t_float;
+
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE t_float;
+
+-- NULL, NaN and Infinity are handled like the built-in aggregates do
+
+CREATE TABLE t_float_special(a FLOAT4, b FLOAT8) USING columnar;
+
+INSERT INTO t_float_special VALUES (NULL, NULL);
+
+SELECT SUM(b), AVG(b), MIN(b), MAX(b), VARIANCE(b) FROM t_float_special;
+
+INSERT INTO t_float_special VALUES (1, 1), ('Infinity', 'Infinity'), ('NaN', 'NaN');
+
+SELECT SUM(a), MIN(a), MAX(a), SUM(b), AVG(b), MIN(b), MAX(b), VARIANCE(b) FROM t_float_special;
+
+DROP TABLE t_float_special;
+
+-- sum(float4) rounds each vector's sum to float4 once, where the row aggregate
+-- rounds after every value, so they only agree when no rounding is needed
+CREATE TABLE t_float4_sum(a FLOAT4, b FLOAT4) USING columnar;
+
+INSERT INTO t_float4_sum SELECT 0.1, g % 100 FROM GENERATE_SERIES(0, 99999) g;
+
+SET max_parallel_workers_per_gather TO 0;
+
+SET columnar.enable_vectorization TO false;
+
+SELECT SUM(a) AS row_sum_a, SUM(b) AS row_sum_b FROM t_float4_sum \gset
+
+SET columnar.enable_vectorization TO default;
+
+SELECT SUM(a) AS vector_sum_a, SUM(b) AS vector_sum_b FROM t_float4_sum \gset
+
+SELECT :vector_sum_b = :row_sum_b AS exact_sums_equal,
+       :vector_sum_a <> :row_sum_a AS rounded_sums_differ,
+       abs(:vector_sum_a - 10000) < abs(:row_sum_a - 10000) AS vector_sum_more_accurate,
+       abs(:vector_sum_a - :row_sum_a) < 10000 * 0.001 AS sums_close;
+
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE t_float4_sum;
+
+-- 7. NUMERIC
+
+CREATE TABLE t_numeric(a NUMERIC(12,2)) USING columnar;
+
+INSERT INTO t_numeric SELECT (g % 10000) * 0.01 FROM GENERATE_SERIES(0, 30000) g;
+
+SET max_parallel_workers_per_gather TO 0;
+
+EXPLAIN (verbose, costs off, timing off, summary off) SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric;
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric;
+
+SET columnar.enable_vectorization TO false;
+
+EXPLAIN (verbose, costs off, timing off, summary off) SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric;
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric;
+
+SET columnar.enable_vectorization TO default;
+
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE t_numeric;
+
+-- mixed display scales, values that don't fit 64 bit integers, NULL, NaN and
+-- Infinity are handled like the built-in aggregates do
+
+CREATE TABLE t_numeric_mixed(a NUMERIC) USING columnar;
+
+SET max_parallel_workers_per_gather TO 0;
+
+INSERT INTO t_numeric_mixed VALUES (NULL);
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric_mixed;
+
+INSERT INTO t_numeric_mixed SELECT ROUND(g * 0.001, g % 4) FROM GENERATE_SERIES(0, 99999) g;
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric_mixed;
+
+INSERT INTO t_numeric_mixed VALUES (12345678901234567890.5), (0.000000001);
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric_mixed;
+
+INSERT INTO t_numeric_mixed VALUES ('Infinity');
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric_mixed;
+
+INSERT INTO t_numeric_mixed VALUES ('NaN');
+
+SELECT SUM(a), AVG(a), MIN(a), MAX(a) FROM t_numeric_mixed;
+
+RESET max_parallel_workers_per_gather;
+
+DROP TABLE t_numeric_mixed;
+
 -- Test exception when we fallback to PG aggregator node
 
 SET client_min_messages TO 'DEBUG1';
@@ -0,0 +1,51 @@
+--
+-- Test auto compression, which picks the codec of each chunk by a cost model
+--
+CREATE SCHEMA columnar_auto_compression;
+SET search_path TO columnar_auto_compression;
+
+SET columnar.compression TO 'auto';
+CREATE TABLE t_auto (a int, b text) USING columnar;
+
+SELECT compression FROM columnar.options WHERE regclass = 't_auto'::regclass;
+
+CREATE VIEW t_auto_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_auto';
+
+-- when decompression time is all that counts, nothing is compressed or encoded
+SET columnar.auto_compression_decode_weight TO 1000000;
+INSERT INTO t_auto SELECT i % 10, repeat('x', 200) || i FROM generate_series(1, 20000) i;
+
+SELECT attr_num, value_compression_type, value_encoding_type, count(*) FROM t_auto_chunks
+GROUP BY attr_num, value_compression_type, value_encoding_type ORDER BY attr_num;
+
+-- when only size counts, every chunk of compressible data gets compressed
+SET columnar.auto_compression_decode_weight TO 0;
+TRUNCATE t_auto;
+INSERT INTO t_auto SELECT i % 10, repeat('x', 200) || i FROM generate_series(1, 20000) i;
+
+SELECT attr_num, value_compression_type <> 0 AS compressed, count(*) FROM t_auto_chunks
+GROUP BY attr_num, value_compression_type <> 0 ORDER BY attr_num;
+
+SELECT count(*), sum(a), count(DISTINCT b), min(length(b)), max(length(b)) FROM t_auto;
+
+-- auto can be set for individual columns as well
+SET columnar.compression TO 'none';
+CREATE TABLE t_mixed (a int, b text) USING columnar;
+SELECT columnar.alter_columnar_table_set('t_mixed', compression => 'auto', column_names => '{b}');
+
+INSERT INTO t_mixed SELECT * FROM t_auto;
+
+SELECT attr_num, value_compression_type <> 0 AS compressed, count(*)
+FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_mixed'
+GROUP BY attr_num, value_compression_type <> 0 ORDER BY attr_num;
+
+SELECT count(*) FROM (SELECT * FROM t_auto EXCEPT SELECT * FROM t_mixed) q;
+
+RESET columnar.auto_compression_decode_weight;
+RESET columnar.compression;
+
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_auto_compression CASCADE;
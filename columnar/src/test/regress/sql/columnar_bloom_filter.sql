@@ -0,0 +1,58 @@
+--
+-- Test per-chunk bloom filters on equality and IN quals
+--
+CREATE SCHEMA columnar_bloom_filter;
+SET search_path TO columnar_bloom_filter;
+
+SET columnar.enable_parallel_execution TO false;
+SET columnar.chunk_group_row_limit TO 1000;
+CREATE TABLE t_bloom (id int, name text, other int) USING columnar;
+
+-- bloom filters are set per column
+SELECT columnar.alter_columnar_table_set('t_bloom', bloom_filter => true);
+SELECT columnar.alter_columnar_table_set('t_bloom', bloom_filter => true, column_names => '{id,name}');
+SELECT attr_num, bloom_filter FROM columnar.column_options
+WHERE regclass = 't_bloom'::regclass ORDER BY attr_num;
+
+-- every chunk holds values from the whole range, so min/max can't skip any
+INSERT INTO t_bloom
+  SELECT (i * 7919) % 100000, 'user_' || (i * 7919) % 100000, (i * 7919) % 100000
+  FROM generate_series(0, 99999) i;
+ANALYZE t_bloom;
+
+SELECT count(*) FROM t_bloom WHERE other = 4242;
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_bloom WHERE other = 4242');
+
+SELECT count(*) FROM t_bloom WHERE id = 4242;
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_bloom WHERE id = 4242') >= 95 AS removed;
+
+SELECT count(*) FROM t_bloom WHERE name = 'user_4242';
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_bloom WHERE name = ''user_4242''') >= 95 AS removed;
+
+-- cross-type equality hashes the constant compatibly
+SELECT count(*) FROM t_bloom WHERE id = 4242::bigint;
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_bloom WHERE id = 4242::bigint') >= 95 AS removed;
+
+SELECT count(*) FROM t_bloom WHERE id IN (4242, 5353, NULL);
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_bloom WHERE id IN (4242, 5353, NULL)') >= 90 AS removed;
+
+-- chunks written after the bloom filter is reset don't get one
+SELECT columnar.alter_columnar_table_reset('t_bloom', bloom_filter => true);
+SELECT columnar.alter_columnar_table_reset('t_bloom', bloom_filter => true, column_names => '{name}');
+SELECT attr_num, bloom_filter FROM columnar.column_options
+WHERE regclass = 't_bloom'::regclass ORDER BY attr_num;
+
+INSERT INTO t_bloom VALUES (4242, 'user_4242', 4242);
+
+SELECT attr_num, count(bloom_filter) FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_bloom'
+GROUP BY attr_num ORDER BY attr_num;
+
+SELECT count(*) FROM t_bloom WHERE id = 4242;
+SELECT count(*) FROM t_bloom WHERE name = 'user_4242';
+
+RESET columnar.chunk_group_row_limit;
+RESET columnar.enable_parallel_execution;
+
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_bloom_filter CASCADE;
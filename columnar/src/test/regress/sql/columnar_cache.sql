@@ -114,3 +114,71 @@ CREATE TABLE t1 (i int) USING columnar;
 INSERT INTO t1 SELECT generate_series(1, 1000000, 1);
 EXPLAIN SELECT COUNT(*) FROM t1;
 DROP TABLE t1;
+
+-- a cache smaller than a chunk group evicts everything but the chunk group in use
+SET columnar.enable_parallel_execution TO false;
+SET columnar.stripe_row_limit TO 200000;
+SET columnar.chunk_group_row_limit TO 100000;
+CREATE TABLE pinned_cache (a int, b text) USING columnar;
+INSERT INTO pinned_cache SELECT i, repeat(md5(i::text), 8) FROM generate_series(1, 200000) i;
+RESET columnar.chunk_group_row_limit;
+RESET columnar.stripe_row_limit;
+
+SET columnar.enable_column_cache = 't';
+SET columnar.column_cache_size = '20MB';
+SELECT count(*), sum(a), sum(length(b)) FROM pinned_cache;
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), sum(length(b)) FROM pinned_cache', 'Cache Hits') AS hits,
+       columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), sum(length(b)) FROM pinned_cache', 'Cache Misses') AS misses,
+       columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), sum(length(b)) FROM pinned_cache', 'Cache Evictions') AS evictions;
+
+RESET columnar.column_cache_size;
+SET columnar.enable_column_cache = 'f';
+RESET columnar.enable_parallel_execution;
+DROP TABLE pinned_cache;
+
+-- the compressed tier keeps chunks as they are stored, next to the decompressed tier
+CREATE TABLE compressed_cache (a int, b text) USING columnar;
+INSERT INTO compressed_cache SELECT i, 'value-' || (i % 100) FROM generate_series(1, 100000) i;
+CREATE INDEX compressed_cache_a ON compressed_cache (a);
+
+SET columnar.enable_parallel_execution TO false;
+SET columnar.enable_column_cache = 't';
+SET columnar.compressed_column_cache_size = '16MB';
+SELECT count(*), sum(a), count(DISTINCT b) FROM compressed_cache WHERE a > 50000;
+
+-- the tier outlives scans, so scanning the same chunks again only hits it
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM compressed_cache WHERE a > 50000',
+         'Compressed Cache Hits') > 0 AS hits,
+       columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM compressed_cache WHERE a > 50000',
+         'Compressed Cache Misses') AS misses;
+
+-- index scans read the same chunk groups over and over
+SET enable_seqscan = 'f';
+SELECT count(*), sum(a), count(DISTINCT b) FROM compressed_cache WHERE a BETWEEN 10000 AND 30000;
+RESET enable_seqscan;
+
+-- the entries of removed storage are invalidated
+TRUNCATE compressed_cache;
+INSERT INTO compressed_cache SELECT i, 'value-' || (i % 100) FROM generate_series(1, 100000) i;
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM compressed_cache',
+         'Total Compressed Cache Entries') AS entries;
+
+-- a tier smaller than the chunks read evicts them
+TRUNCATE compressed_cache;
+INSERT INTO compressed_cache SELECT i, md5(i::text) FROM generate_series(1, 100000) i;
+SET columnar.compressed_column_cache_size = '1MB';
+SELECT count(*), sum(a), count(DISTINCT b) FROM compressed_cache;
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM compressed_cache',
+         'Compressed Cache Evictions') > 0 AS evicted;
+
+RESET columnar.compressed_column_cache_size;
+SET columnar.enable_column_cache = 'f';
+RESET columnar.enable_parallel_execution;
+DROP TABLE compressed_cache;
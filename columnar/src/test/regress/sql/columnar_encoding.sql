@@ -0,0 +1,225 @@
+--
+-- Test lightweight encodings of column chunks
+--
+CREATE SCHEMA columnar_encoding;
+SET search_path TO columnar_encoding;
+
+CREATE TABLE t_dict (a int, country text, status varchar(10), hash text) USING columnar;
+INSERT INTO t_dict
+  SELECT i, 'country_' || (i % 7),
+         CASE WHEN i % 3 = 0 THEN NULL ELSE 'status_' || (i % 4) END,
+         md5(i::text)
+  FROM generate_series(1, 20000) i;
+
+CREATE VIEW t_dict_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_dict';
+
+-- low-cardinality text columns are dictionary encoded, the serial column is
+-- delta encoded and the hashes are FSST encoded
+SELECT attr_num, value_encoding_type, count(*) FROM t_dict_chunks
+GROUP BY attr_num, value_encoding_type ORDER BY attr_num;
+
+SELECT country, count(*) FROM t_dict GROUP BY country ORDER BY country;
+
+SELECT status, count(*) FROM t_dict GROUP BY status ORDER BY status;
+
+SELECT count(*), count(DISTINCT hash) FROM t_dict
+WHERE country = 'country_3' AND status = 'status_1';
+
+SELECT sum(a) FROM t_dict WHERE country = 'country_0';
+
+-- dictionary encoded chunks are cached in their encoded form
+SET columnar.enable_column_cache TO true;
+
+SELECT status, count(*) FROM t_dict GROUP BY status ORDER BY status;
+
+SELECT status, count(*) FROM t_dict GROUP BY status ORDER BY status;
+
+RESET columnar.enable_column_cache;
+
+-- long runs of repeated values are run-length encoded, whatever their type
+CREATE TABLE t_rle (a int, b bigint, c text, d int2) USING columnar;
+INSERT INTO t_rle
+  SELECT i / 2500, i / 1000, 'tag_' || (i / 5000),
+         CASE WHEN i % 1000 < 100 THEN NULL ELSE i / 4000 END
+  FROM generate_series(1, 20000) i;
+
+CREATE VIEW t_rle_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_rle';
+
+SELECT attr_num, value_encoding_type, count(*) FROM t_rle_chunks
+GROUP BY attr_num, value_encoding_type ORDER BY attr_num;
+
+-- vectorized aggregates consume whole runs at once
+SELECT count(*), sum(a), sum(b), count(d), sum(d) FROM t_rle;
+
+SELECT c, count(*) FROM t_rle GROUP BY c ORDER BY c;
+
+SELECT count(*), sum(a), sum(b), count(d), sum(d) FROM t_rle WHERE b > 3;
+
+-- deleted rows split runs, including the first row of a run
+DELETE FROM t_rle WHERE b = 7;
+
+SELECT count(*), sum(a), sum(b), count(d), sum(d) FROM t_rle;
+
+SELECT a, count(*), sum(b), count(d) FROM t_rle GROUP BY a ORDER BY a;
+
+-- integer, date and timestamp columns are bit-packed, either relative to the
+-- chunk minimum or to the previous value
+CREATE TABLE t_int (a int2, b int4, c int8, d date, e timestamp) USING columnar;
+INSERT INTO t_int
+  SELECT i % 1000, (i * 7919) % 100000 - 50000,
+         CASE WHEN i % 10 = 0 THEN NULL ELSE i * 1000000000000 + i % 3 END,
+         date '2020-01-01' + i % 365,
+         timestamp '2024-01-01' + i * interval '1 second'
+  FROM generate_series(1, 20000) i;
+
+CREATE VIEW t_int_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_int';
+
+SELECT attr_num, value_encoding_type, count(*) FROM t_int_chunks
+GROUP BY attr_num, value_encoding_type ORDER BY attr_num;
+
+SELECT sum(a), sum(b), min(b), max(b), count(c), sum(c), min(c), max(c),
+       sum(d - date '2020-01-01') FROM t_int;
+
+SELECT sum(a), sum(b), min(b), max(b), count(c), sum(c), min(c), max(c),
+       sum(d - date '2020-01-01') FROM t_int
+WHERE e >= timestamp '2024-01-01 01:00:00' AND e < timestamp '2024-01-01 04:00:00';
+
+SET columnar.enable_encoding TO false;
+CREATE TABLE t_int_plain (LIKE t_int) USING columnar;
+INSERT INTO t_int_plain SELECT * FROM t_int;
+RESET columnar.enable_encoding;
+
+SELECT count(*) FROM (SELECT * FROM t_int EXCEPT SELECT * FROM t_int_plain) q;
+
+SELECT count(*) FROM (SELECT * FROM t_int_plain EXCEPT SELECT * FROM t_int) q;
+
+-- float columns are XOR encoded, special values keep their exact bit patterns
+CREATE TABLE t_float (a float8, b float4, c float8, d float8) USING columnar;
+INSERT INTO t_float
+  SELECT CASE WHEN i % 7 = 0 THEN NULL ELSE 20 + (i % 100) * 0.5 END,
+         (i % 50) / 4.0, i * 0.1,
+         CASE i % 4 WHEN 0 THEN 'NaN' WHEN 1 THEN '-0'
+                    WHEN 2 THEN 'Infinity' ELSE '-Infinity' END::float8
+  FROM generate_series(1, 20000) i;
+
+CREATE VIEW t_float_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_float';
+
+SELECT attr_num, value_encoding_type, count(*) FROM t_float_chunks
+GROUP BY attr_num, value_encoding_type ORDER BY attr_num;
+
+SELECT count(a), sum(a), sum(b::float8), min(c), max(c) FROM t_float;
+
+SELECT d, count(*) FROM t_float GROUP BY d ORDER BY d;
+
+SET columnar.enable_encoding TO false;
+CREATE TABLE t_float_plain (LIKE t_float) USING columnar;
+INSERT INTO t_float_plain SELECT * FROM t_float;
+RESET columnar.enable_encoding;
+
+SELECT count(*) FROM (SELECT * FROM t_float EXCEPT SELECT * FROM t_float_plain) q;
+
+SELECT count(*) FROM (SELECT * FROM t_float_plain EXCEPT SELECT * FROM t_float) q;
+
+-- high-cardinality strings are FSST encoded
+CREATE TABLE t_url (id int, url text) USING columnar;
+INSERT INTO t_url
+  SELECT i, 'https://www.example.com/products/' || (i * 7919 % 100003) ||
+            '/reviews?page=' || (i % 17) || '&ref=' || substr(md5(i::text), 1, 8)
+  FROM generate_series(1, 20000) i;
+
+CREATE VIEW t_url_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_url';
+
+SELECT attr_num, value_encoding_type, count(*) FROM t_url_chunks
+GROUP BY attr_num, value_encoding_type ORDER BY attr_num;
+
+SELECT count(*) FROM t_url WHERE url LIKE '%/reviews?page=3&%';
+
+SELECT id, url FROM t_url WHERE id IN (1, 10000, 10001, 20000) ORDER BY id;
+
+-- index lookups only decode the values of the rows they read
+CREATE INDEX t_url_id_idx ON t_url (id);
+BEGIN;
+  SET LOCAL enable_seqscan TO off;
+  SET LOCAL columnar.enable_custom_scan TO off;
+  EXPLAIN (COSTS OFF) SELECT url FROM t_url WHERE id = 12345;
+
+  SELECT url FROM t_url WHERE id = 12345;
+
+  SELECT url FROM t_url WHERE id = 12346;
+
+  SELECT url FROM t_url WHERE id = 3;
+
+COMMIT;
+
+-- chunks without NULLs or without values store no exists stream, and chunks
+-- of a single repeated value store that value once
+CREATE TABLE t_sparse (a int, b text, c int, d text, e int) USING columnar;
+INSERT INTO t_sparse
+  SELECT i, 'same', NULL, CASE WHEN i > 10000 THEN 'tail' END,
+         CASE WHEN i % 2 = 0 THEN 7 END
+  FROM generate_series(1, 20000) i;
+
+CREATE VIEW t_sparse_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_sparse';
+
+SELECT attr_num, value_encoding_type, exists_stream_length, value_stream_length = 0 AS no_values,
+       count(*)
+FROM t_sparse_chunks GROUP BY 1, 2, 3, 4 ORDER BY 1, 2;
+
+SELECT count(*), count(a), count(b), count(c), count(d), count(e), sum(a), sum(e),
+       min(b), max(d)
+FROM t_sparse;
+
+SELECT d, count(*) FROM t_sparse GROUP BY d ORDER BY d;
+
+SELECT count(*) FROM t_sparse WHERE b = 'same' AND e = 7 AND c IS NULL;
+
+SELECT * FROM t_sparse WHERE a IN (9999, 10000, 10001, 10002) ORDER BY a;
+
+SET columnar.enable_encoding TO false;
+CREATE TABLE t_sparse_plain (LIKE t_sparse) USING columnar;
+INSERT INTO t_sparse_plain SELECT * FROM t_sparse;
+RESET columnar.enable_encoding;
+
+SELECT count(*) FROM (SELECT * FROM t_sparse EXCEPT ALL SELECT * FROM t_sparse_plain) q;
+
+SELECT count(*) FROM (SELECT * FROM t_sparse_plain EXCEPT ALL SELECT * FROM t_sparse) q;
+
+-- compare against plain chunks, without compression so sizes are deterministic
+SET columnar.compression TO 'none';
+CREATE TABLE t_dict_none (LIKE t_dict) USING columnar;
+INSERT INTO t_dict_none SELECT * FROM t_dict;
+SET columnar.enable_encoding TO false;
+CREATE TABLE t_plain (LIKE t_dict) USING columnar;
+INSERT INTO t_plain SELECT * FROM t_dict;
+RESET columnar.enable_encoding;
+
+CREATE VIEW t_plain_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_plain';
+CREATE VIEW t_dict_none_chunks AS
+SELECT a.* FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 't_dict_none';
+
+SELECT count(*) FROM t_plain_chunks WHERE value_encoding_type <> 0;
+
+SELECT (SELECT sum(value_stream_length) FROM t_dict_none_chunks WHERE attr_num = 2) <
+       (SELECT sum(value_stream_length) FROM t_plain_chunks WHERE attr_num = 2) AS smaller;
+
+SELECT count(*) FROM (SELECT * FROM t_dict_none EXCEPT SELECT * FROM t_plain) q;
+
+SELECT count(*) FROM (SELECT * FROM t_plain EXCEPT SELECT * FROM t_dict) q;
+
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_encoding CASCADE;
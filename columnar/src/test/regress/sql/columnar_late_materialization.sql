@@ -0,0 +1,32 @@
+--
+-- Test late materialization of vectorized scans
+--
+CREATE SCHEMA columnar_late_materialization;
+SET search_path TO columnar_late_materialization;
+
+SET columnar.chunk_group_row_limit TO 1000;
+CREATE TABLE t_late (a int, b text, c int, d bigint) USING columnar;
+INSERT INTO t_late SELECT i, 'value ' || (i % 7), i / 100, CASE WHEN i % 3 <> 0 THEN i * 2 END
+FROM generate_series(1, 20000) i;
+DELETE FROM t_late WHERE a % 1000 = 500;
+
+-- only a is read into the vectors, b, c and d for the rows that pass
+EXPLAIN (costs off) SELECT * FROM t_late WHERE a > 19990;
+
+-- rows of two chunk groups, one of them deleted
+SELECT * FROM t_late WHERE a BETWEEN 3495 AND 3505 ORDER BY a;
+
+SELECT count(*), count(d), sum(d), min(b), max(c) FROM t_late WHERE a > 19990;
+
+-- quals that aren't vectorized run on the materialized rows
+SELECT a, b, d FROM t_late WHERE a BETWEEN 100 AND 120 AND b = 'value 3' ORDER BY a;
+
+SELECT count(*) FROM t_late WHERE a < 0;
+
+SET columnar.enable_late_materialization TO false;
+SELECT * FROM t_late WHERE a BETWEEN 3495 AND 3505 ORDER BY a;
+
+RESET columnar.enable_late_materialization;
+RESET columnar.chunk_group_row_limit;
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_late_materialization CASCADE;
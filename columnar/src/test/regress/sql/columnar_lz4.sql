@@ -8,6 +8,8 @@ CREATE SCHEMA am_alz4;
 SET search_path TO am_alz4;
 
 SET columnar.compression TO 'lz4';
+-- compare block compression only, without lightweight encodings
+SET columnar.enable_encoding TO false;
 CREATE TABLE test_lz4 (a int, b text, c int) USING columnar;
 
 INSERT INTO test_lz4 SELECT floor(i / 1000), floor(i / 10)::text, 4 FROM generate_series(1, 10000) i;
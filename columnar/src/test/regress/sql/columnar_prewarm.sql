@@ -0,0 +1,44 @@
+--
+-- Test loading chunks into the shared column cache with columnar.prewarm
+--
+CREATE SCHEMA columnar_prewarm;
+SET search_path TO columnar_prewarm;
+
+-- two stripes of three chunk groups
+CREATE TABLE prewarm_table (a int, b text) USING columnar;
+INSERT INTO prewarm_table SELECT i, 'value-' || (i % 100) FROM generate_series(1, 30000) i;
+INSERT INTO prewarm_table SELECT i, 'value-' || (i % 100) FROM generate_series(30001, 60000) i;
+
+-- chunks of the chosen columns from a stripe on, or in all stripes, of which
+-- only those that weren't cached yet are counted
+SELECT columnar.prewarm('prewarm_table', ARRAY['b'], 2);
+SELECT columnar.prewarm('prewarm_table', ARRAY['b']);
+SELECT columnar.prewarm('prewarm_table', ARRAY['b']);
+SELECT columnar.prewarm('prewarm_table', ARRAY['b'], 3);
+SELECT columnar.prewarm('prewarm_table', ARRAY[]::text[]);
+
+-- all columns, of which uncompressed chunks are skipped
+SELECT columnar.prewarm('prewarm_table');
+
+-- scans read the prewarmed chunks
+SET columnar.enable_column_cache = 't';
+SET columnar.enable_parallel_execution TO false;
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM prewarm_table',
+         'Cache Hits') > 0 AS hits,
+       columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM prewarm_table',
+         'Cache Misses') AS misses;
+RESET columnar.enable_parallel_execution;
+SELECT count(*), sum(a), count(DISTINCT b) FROM prewarm_table;
+SELECT count(*), sum(a), count(DISTINCT b) FROM prewarm_table WHERE a > 45000;
+SET columnar.enable_column_cache = 'f';
+
+SELECT columnar.prewarm('prewarm_table', ARRAY['c']);
+SELECT columnar.prewarm('prewarm_table', ARRAY[NULL]);
+
+CREATE TABLE prewarm_heap (a int);
+SELECT columnar.prewarm('prewarm_heap');
+
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_prewarm CASCADE;
@@ -0,0 +1,58 @@
+--
+-- Test the column cache in shared memory
+--
+CREATE SCHEMA columnar_shared_cache;
+SET search_path TO columnar_shared_cache;
+
+SHOW columnar.shared_column_cache_size;
+
+-- with a shared column cache, chunks cached by one backend are used by others
+CREATE TABLE shared_cache (a int, b text) USING columnar;
+INSERT INTO shared_cache SELECT i, 'value-' || (i % 100) FROM generate_series(1, 100000) i;
+
+SET columnar.enable_parallel_execution TO false;
+SET columnar.enable_column_cache = 't';
+SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000;
+
+\c - - - -
+SET search_path TO columnar_shared_cache;
+SET columnar.enable_parallel_execution TO false;
+SET columnar.enable_column_cache = 't';
+
+-- all chunks the scan reads were cached by the previous session
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000',
+         'Cache Hits') > 0 AS hits,
+       columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000',
+         'Cache Misses') AS misses;
+SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000;
+
+-- cache entries don't depend on the chunk groups a scan filters out
+SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a < 20000;
+SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache;
+
+-- evicting a chunk removes it for all backends
+SELECT columnar_test_helpers.columnar_relation_storageid('shared_cache'::regclass) AS storage_id \gset
+SELECT min(stripe_num) AS stripe_num FROM columnar.stripe WHERE storage_id = :storage_id \gset
+SELECT columnar_test_helpers.cache_evict(:storage_id, :stripe_num, 9, 1);
+SELECT columnar_test_helpers.cache_evict(:storage_id, :stripe_num, 9, 1);
+
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000',
+         'Cache Misses') AS misses;
+SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000;
+
+-- new storage gets new cache entries
+TRUNCATE shared_cache;
+INSERT INTO shared_cache SELECT i, 'other-' || (i % 10) FROM generate_series(1, 100000) i;
+SELECT columnar_test_helpers.explain_analyze_counter(
+         'SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000',
+         'Cache Hits') AS hits;
+SELECT count(*), sum(a), count(DISTINCT b) FROM shared_cache WHERE a > 50000;
+
+SET columnar.enable_column_cache = 'f';
+RESET columnar.enable_parallel_execution;
+
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_shared_cache CASCADE;
@@ -0,0 +1,84 @@
+--
+-- Test stripe zone maps, which skip whole stripes without reading their chunks
+--
+CREATE SCHEMA columnar_stripe_zone_map;
+SET search_path TO columnar_stripe_zone_map;
+
+SET columnar.enable_parallel_execution TO false;
+SET columnar.chunk_group_row_limit TO 1000;
+CREATE TABLE t_zone (a int, b int) USING columnar;
+
+-- every INSERT writes a stripe of 5 chunk groups, b is NULL in the whole
+-- second stripe and in half of the rows of the third one
+INSERT INTO t_zone SELECT i, i FROM generate_series(1, 5000) i;
+INSERT INTO t_zone SELECT i, NULL FROM generate_series(5001, 10000) i;
+INSERT INTO t_zone SELECT i, CASE WHEN i % 2 = 0 THEN i END FROM generate_series(10001, 15000) i;
+ANALYZE t_zone;
+
+SELECT columnar_test_helpers.columnar_relation_storageid('t_zone'::regclass) AS t_zone_storage_id \gset
+
+SELECT dense_rank() OVER (ORDER BY stripe_num) AS stripe, attr_num,
+       minimum_value IS NOT NULL AS has_min_max, null_count
+FROM columnar.stripe_zone_map WHERE storage_id = :t_zone_storage_id
+ORDER BY stripe_num, attr_num;
+
+-- the first two stripes are skipped as a whole, two chunk groups of the third
+-- one by their own min/max
+SELECT count(*) FROM t_zone WHERE a > 12000;
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE a > 12000');
+
+-- the stripe with only NULLs in b can't match a strict qual on b
+SELECT count(*) FROM t_zone WHERE b > 4000 AND b < 11000;
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE b > 4000 AND b < 11000');
+
+SELECT count(*) FROM t_zone WHERE b = 7000;
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE b = 7000');
+
+SELECT count(*) FROM t_zone WHERE a IN (3, 14000);
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE a IN (3, 14000)');
+
+-- constants on the left and of other integer types bound the column as well
+SELECT count(*) FROM t_zone WHERE 12000 < a;
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE 12000 < a');
+
+SELECT count(*) FROM t_zone WHERE a BETWEEN 2500::bigint AND 2600::smallint;
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE a BETWEEN 2500::bigint AND 2600::smallint');
+
+-- quals on the same column are combined before they are checked
+SELECT count(*) FROM t_zone WHERE a > 100 AND a < 50;
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE a > 100 AND a < 50');
+
+SELECT count(*) FROM t_zone WHERE a IN (3, 14000) AND a < 10;
+
+SELECT columnar_test_helpers.chunk_groups_removed('SELECT count(*) FROM t_zone WHERE a IN (3, 14000) AND a < 10');
+
+-- parallel workers skip the stripes they claim as well
+RESET columnar.enable_parallel_execution;
+SET parallel_setup_cost TO 0;
+SET parallel_tuple_cost TO 0;
+SET min_parallel_table_scan_size TO 0;
+SET max_parallel_workers_per_gather TO 2;
+
+SELECT count(*) FROM t_zone WHERE a > 12000;
+
+SELECT count(*) FROM t_zone WHERE b > 4000 AND b < 11000;
+
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+
+-- zone maps are removed together with the table
+DROP TABLE t_zone;
+SELECT count(*) FROM columnar.stripe_zone_map WHERE storage_id = :t_zone_storage_id;
+
+RESET columnar.chunk_group_row_limit;
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_stripe_zone_map CASCADE;
@@ -155,5 +155,57 @@ DROP TABLE table_options;
 -- we expect no entries in columnar.options for anything not found in pg_class
 SELECT * FROM columnar.options o WHERE o.regclass NOT IN (SELECT oid FROM pg_class);
 
+-- per-column compression settings override the table wide ones
+SET columnar.enable_encoding TO false;
+CREATE TABLE column_options (a int, b text, c text) USING columnar;
+
+SELECT columnar.alter_columnar_table_set('column_options', compression => 'pglz', compression_level => 5);
+
+SELECT columnar.alter_columnar_table_set('column_options', compression => 'none', column_names => '{b}');
+
+SELECT columnar.alter_columnar_table_set('column_options', compression_level => 9, column_names => ARRAY['c', 'b']);
+
+SELECT * FROM columnar.column_options
+WHERE regclass = 'column_options'::regclass ORDER BY attr_num;
+
+-- table wide settings are not changed
+SELECT * FROM columnar.options
+WHERE regclass = 'column_options'::regclass;
+
+INSERT INTO column_options
+  SELECT i % 10, repeat('b', 100), repeat('c', 100) FROM generate_series(1, 20000) i;
+
+SELECT attr_num, value_compression_type, value_compression_level, count(*)
+FROM columnar.chunk a, pg_class b
+WHERE a.storage_id = columnar_test_helpers.columnar_relation_storageid(b.oid) AND b.relname = 'column_options'
+GROUP BY attr_num, value_compression_type, value_compression_level ORDER BY attr_num;
+
+SELECT count(*), sum(a), count(DISTINCT b), count(DISTINCT c) FROM column_options;
+
+RESET columnar.enable_encoding;
+
+-- resetting a column falls back to the table wide setting
+SELECT columnar.alter_columnar_table_reset('column_options', compression => true, column_names => '{b}');
+
+SELECT * FROM columnar.column_options
+WHERE regclass = 'column_options'::regclass ORDER BY attr_num;
+
+SELECT columnar.alter_columnar_table_reset('column_options', compression_level => true, column_names => '{b,c}');
+
+SELECT * FROM columnar.column_options
+WHERE regclass = 'column_options'::regclass ORDER BY attr_num;
+
+-- verify edge cases of per-column settings
+SELECT columnar.alter_columnar_table_set('column_options', chunk_group_row_limit => 2000, column_names => '{a}');
+SELECT columnar.alter_columnar_table_reset('column_options', stripe_row_limit => true, column_names => '{a}');
+SELECT columnar.alter_columnar_table_set('column_options', compression => 'none', column_names => '{d}');
+SELECT columnar.alter_columnar_table_set('column_options', compression => 'foobar', column_names => '{a}');
+
+SELECT columnar.alter_columnar_table_set('column_options', compression => 'none', column_names => '{a}');
+
+-- verify column options are removed when table is dropped
+DROP TABLE column_options;
+SELECT * FROM columnar.column_options o WHERE o.regclass NOT IN (SELECT oid FROM pg_class);
+
 SET client_min_messages TO warning;
 DROP SCHEMA am_tableoptions CASCADE;
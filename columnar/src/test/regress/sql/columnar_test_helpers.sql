@@ -16,6 +16,11 @@ CREATE OR REPLACE FUNCTION columnar_storage_info(
   STRICT
   LANGUAGE c AS 'columnar', $$columnar_storage_info$$;
 
+CREATE FUNCTION cache_evict(storage_id bigint, stripe_id bigint, chunk_group_id bigint,
+                            column_index int) RETURNS boolean
+    LANGUAGE C STRICT
+    AS 'columnar', $$cache_evict$$;
+
 CREATE FUNCTION compression_type_supported(type text) RETURNS boolean
 AS $$
 BEGIN
@@ -64,7 +69,8 @@ BEGIN
    (
    SELECT storage_id FROM columnar.stripe UNION ALL
    SELECT storage_id FROM columnar.chunk UNION ALL
-   SELECT storage_id FROM columnar.chunk_group
+   SELECT storage_id FROM columnar.chunk_group UNION ALL
+   SELECT storage_id FROM columnar.stripe_zone_map
    ) AS union_storage_id
    WHERE storage_id=input_storage_id;
 
@@ -140,3 +146,41 @@ BEGIN
     PERFORM pg_sleep(0.001);
   END LOOP;
 END; $$ language plpgsql;
+
+-- chunk_groups_removed returns the number of chunk groups skipped by the scan
+CREATE FUNCTION chunk_groups_removed (query text) RETURNS bigint AS
+$$
+    DECLARE
+        result bigint;
+        rec text;
+    BEGIN
+        result := 0;
+
+        FOR rec IN EXECUTE 'EXPLAIN ANALYZE ' || query LOOP
+            IF rec ~ '^\s+Columnar Chunk Groups Removed by Filter' then
+                result := regexp_replace(rec, '[^0-9]*', '', 'g');
+            END IF;
+        END LOOP;
+
+        RETURN result;
+    END;
+$$ LANGUAGE PLPGSQL;
+
+-- explain_analyze_counter returns the sum of the given counter over the plan nodes
+CREATE FUNCTION explain_analyze_counter (query text, counter text) RETURNS bigint AS
+$$
+    DECLARE
+        result bigint;
+        rec text;
+    BEGIN
+        result := 0;
+
+        FOR rec IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query LOOP
+            IF rec ~ ('^\s+' || counter || ':') then
+                result := result + regexp_replace(rec, '[^0-9]*', '', 'g')::bigint;
+            END IF;
+        END LOOP;
+
+        RETURN result;
+    END;
+$$ LANGUAGE PLPGSQL;
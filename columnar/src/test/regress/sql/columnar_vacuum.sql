@@ -1,4 +1,6 @@
 SET columnar.compression TO 'none';
+-- relation sizes below are for plain, unencoded chunks
+SET columnar.enable_encoding TO false;
 
 SELECT count(distinct storage_id) AS columnar_table_count FROM columnar.stripe \gset
 
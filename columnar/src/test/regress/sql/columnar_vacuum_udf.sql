@@ -1,3 +1,5 @@
+-- stripe data lengths below are for plain, unencoded chunks
+SET columnar.enable_encoding TO false;
 CREATE TABLE t1(a int, b int) USING columnar;
 
 CREATE TABLE t2(a int, b int) USING columnar;
@@ -8,6 +8,8 @@ CREATE SCHEMA am_zstd;
 SET search_path TO am_zstd;
 
 SET columnar.compression TO 'zstd';
+-- compare block compression only, without lightweight encodings
+SET columnar.enable_encoding TO false;
 CREATE TABLE test_zstd (a int, b text, c int) USING columnar;
 
 INSERT INTO test_zstd SELECT i % 1000, (i % 10)::text, 4 FROM generate_series(1, 10000) i;
@@ -58,5 +60,31 @@ TRUNCATE test_zstd;
 
 SELECT count(DISTINCT test_zstd.*) FROM test_zstd;
 
+-- large chunks are split across zstd worker threads when enabled
+SET columnar.compression TO 'zstd';
+SET columnar.zstd_compression_workers TO 4;
+CREATE TABLE test_zstd_workers (a int, b text) USING columnar;
+SET client_min_messages TO DEBUG1;
+INSERT INTO test_zstd_workers SELECT i, repeat(md5(i::text), 8) FROM generate_series(1, 20000) i;
+-- chunks of narrow values only reach the worker threshold with larger chunk groups
+SET columnar.chunk_group_row_limit TO 131072;
+CREATE TABLE test_zstd_workers_bigint (a bigint) USING columnar;
+INSERT INTO test_zstd_workers_bigint SELECT i FROM generate_series(1, 131072) i;
+RESET columnar.chunk_group_row_limit;
+RESET client_min_messages;
+RESET columnar.zstd_compression_workers;
+
+CREATE TABLE test_zstd_serial (LIKE test_zstd_workers) USING columnar;
+INSERT INTO test_zstd_serial SELECT * FROM test_zstd_workers;
+
+SELECT value_compression_type, count(*) FROM columnar.chunk
+WHERE storage_id = columnar_test_helpers.columnar_relation_storageid('test_zstd_workers'::regclass)
+  AND attr_num = 2
+GROUP BY value_compression_type;
+
+SELECT count(*), sum(a) FROM test_zstd_workers_bigint;
+SELECT count(*), sum(a), count(DISTINCT b) FROM test_zstd_workers;
+SELECT count(*) FROM (SELECT * FROM test_zstd_workers EXCEPT SELECT * FROM test_zstd_serial) q;
+
 SET client_min_messages TO WARNING;
 DROP SCHEMA am_zstd CASCADE;
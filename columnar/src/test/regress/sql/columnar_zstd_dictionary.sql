@@ -0,0 +1,90 @@
+SELECT columnar_test_helpers.compression_type_supported('zstd') AS zstd_supported \gset
+\if :zstd_supported
+\else
+\q
+\endif
+
+--
+-- Test zstd dictionaries trained per column
+--
+CREATE SCHEMA columnar_zstd_dictionary;
+SET search_path TO columnar_zstd_dictionary;
+
+-- small chunks without encodings, so that the dictionary is what makes the difference
+SET columnar.compression TO 'zstd';
+SET columnar.chunk_group_row_limit TO 1000;
+SET columnar.enable_encoding TO false;
+
+CREATE TABLE t_nodict (doc text) USING columnar;
+INSERT INTO t_nodict
+  SELECT '{"user_id": ' || i || ', "event": "page_view", "url": "https://www.example.com/products/' ||
+         (i % 97) || '", "agent": "Mozilla/5.0"}'
+  FROM generate_series(1, 20000) i;
+
+-- the first stripe written with columnar.zstd_dictionary_size set trains a dictionary
+SET columnar.zstd_dictionary_size TO '16kB';
+CREATE TABLE t_dict (doc text) USING columnar;
+INSERT INTO t_dict SELECT * FROM t_nodict;
+
+SELECT columnar_test_helpers.columnar_relation_storageid('t_dict'::regclass) AS t_dict_storage_id \gset
+SELECT columnar_test_helpers.columnar_relation_storageid('t_nodict'::regclass) AS t_nodict_storage_id \gset
+
+SELECT attr_num, version, dictionary_id <> 0 AS has_id, length(dictionary) <= 16384 AS fits
+FROM columnar.zstd_dictionary WHERE storage_id = :t_dict_storage_id;
+
+SELECT value_compression_type, count(*) FROM columnar.chunk
+WHERE storage_id = :t_dict_storage_id GROUP BY value_compression_type;
+
+SELECT (SELECT sum(value_stream_length) FROM columnar.chunk WHERE storage_id = :t_dict_storage_id) <
+       (SELECT sum(value_stream_length) FROM columnar.chunk WHERE storage_id = :t_nodict_storage_id) AS smaller;
+
+SELECT count(*) FROM (SELECT * FROM t_dict EXCEPT SELECT * FROM t_nodict) q;
+
+SELECT count(*) FROM (SELECT * FROM t_nodict EXCEPT SELECT * FROM t_dict) q;
+
+SELECT count(*) FROM t_dict WHERE doc LIKE '%/products/5"%';
+
+-- later writes reuse the dictionary instead of training another one
+INSERT INTO t_dict SELECT * FROM t_nodict WHERE doc LIKE '%/products/1_"%';
+
+SELECT count(*) FROM columnar.zstd_dictionary WHERE storage_id = :t_dict_storage_id;
+
+SELECT count(*), count(DISTINCT doc) FROM t_dict;
+
+RESET columnar.zstd_dictionary_size;
+
+-- dictionaries can also be trained on the data a table already holds
+SELECT columnar.train_zstd_dictionaries('t_nodict', 16);
+
+SELECT attr_num, version FROM columnar.zstd_dictionary WHERE storage_id = :t_nodict_storage_id;
+
+INSERT INTO t_nodict SELECT * FROM t_dict WHERE doc LIKE '%/products/1_"%';
+
+SELECT count(*), count(DISTINCT doc) FROM t_nodict;
+
+SELECT columnar.train_zstd_dictionaries('t_nodict', 16);
+
+SELECT attr_num, version FROM columnar.zstd_dictionary WHERE storage_id = :t_nodict_storage_id
+ORDER BY version;
+
+-- chunks compressed with either dictionary are still readable
+SELECT count(*) FROM (SELECT * FROM t_nodict EXCEPT ALL SELECT * FROM t_dict) q;
+
+-- only zstd compressed columns get a dictionary
+CREATE TABLE t_pglz (doc text) USING columnar;
+SELECT columnar.alter_columnar_table_set('t_pglz', compression => 'pglz');
+
+INSERT INTO t_pglz SELECT * FROM t_nodict;
+SELECT columnar.train_zstd_dictionaries('t_pglz');
+
+CREATE TABLE t_heap (doc text);
+SELECT columnar.train_zstd_dictionaries('t_heap');
+SELECT columnar.train_zstd_dictionaries('t_dict', 0);
+
+-- dictionaries are removed together with the table
+DROP TABLE t_dict, t_nodict;
+SELECT count(*) FROM columnar.zstd_dictionary
+WHERE storage_id IN (:t_dict_storage_id, :t_nodict_storage_id);
+
+SET client_min_messages TO WARNING;
+DROP SCHEMA columnar_zstd_dictionary CASCADE;
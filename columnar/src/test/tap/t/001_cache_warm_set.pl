@@ -0,0 +1,76 @@
+# Test that the columnar cache warm set is reloaded after a restart
+
+use strict;
+use warnings;
+
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('warm_set');
+$node->init;
+$node->append_conf('postgresql.conf', q{
+shared_preload_libraries = 'columnar'
+columnar.shared_column_cache_size = 64MB
+columnar.enable_cache_warm_set = on
+});
+$node->start;
+
+$node->safe_psql('postgres', q{
+CREATE EXTENSION columnar;
+
+-- two stripes of three chunk groups
+CREATE TABLE warm_set_table (a int, b text) USING columnar;
+INSERT INTO warm_set_table SELECT i, 'value-' || (i % 100) FROM generate_series(1, 30000) i;
+INSERT INTO warm_set_table SELECT i, 'value-' || (i % 100) FROM generate_series(30001, 60000) i;
+
+-- sums a counter of the columnar scans in the plan of a query
+CREATE FUNCTION explain_counter(query text, counter text, analyze bool)
+RETURNS bigint LANGUAGE plpgsql
+SET columnar.enable_column_cache TO true
+SET columnar.enable_parallel_execution TO false
+AS $$
+DECLARE
+  line text;
+  total bigint := 0;
+BEGIN
+  FOR line IN EXECUTE format('EXPLAIN (ANALYZE %s, COSTS OFF, TIMING %s, SUMMARY OFF) %s',
+                             analyze, analyze, query)
+  LOOP
+    IF line ~ ('^\s+' || counter || ':') THEN
+      total := total + substring(line FROM ':\s*(\d+)')::bigint;
+    END IF;
+  END LOOP;
+  RETURN total;
+END;
+$$;
+});
+
+is($node->safe_psql('postgres', q{SELECT columnar.prewarm('warm_set_table')}),
+	'12', 'prewarm loads the chunks of the table');
+
+my $scan = 'SELECT count(*), sum(a), count(DISTINCT b) FROM warm_set_table';
+
+# the warm set is recorded when the server shuts down
+$node->restart;
+
+ok(-f $node->data_dir . '/columnar_cache_warm_set',
+	'the warm set is recorded at shutdown');
+
+# EXPLAIN without ANALYZE doesn't read the table, so it doesn't add to the
+# cache while polling
+$node->poll_query_until('postgres', qq{
+SELECT explain_counter('$scan', 'Total Cache Entries', false) = 12;
+}) or die 'timed out waiting for the warm set to be loaded';
+
+is($node->safe_psql('postgres', qq{
+SELECT explain_counter('$scan', 'Cache Hits', true) > 0,
+       explain_counter('$scan', 'Cache Misses', true);
+}), 't|0', 'scans read the reloaded chunks after the restart');
+
+is($node->safe_psql('postgres', $scan), '60000|1800030000|100',
+	'scans return the same results after the restart');
+
+$node->stop;
+
+done_testing();